@@ -30,7 +30,9 @@
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <arpa/inet.h>
+#include <sys/inotify.h>
 
 #include <glib.h>
 #include <glib-unix.h>
@@ -45,6 +47,7 @@
 static GMainLoop *loop = NULL;
 static gboolean debug = FALSE;
 static gboolean persist = FALSE;
+static gint max_parallel = 4;
 static guint quit_id;
 
 typedef struct Request Request;
@@ -55,8 +58,13 @@ typedef struct {
 	/* Private data */
 	NMDBusDispatcher *dbus_dispatcher;
 
-	Request *current_request;
+	/* Requests run in parallel up to max_parallel, but at most one per
+	 * interface at a time, so that each interface sees its actions in
+	 * order.  Requests without an interface share one lane.
+	 */
 	GQueue *pending_requests;
+	GHashTable *busy_ifaces;   /* iface -> running Request */
+	guint num_running;
 } Handler;
 
 typedef struct {
@@ -92,6 +100,7 @@ static void
 handler_init (Handler *h)
 {
 	h->pending_requests = g_queue_new ();
+	h->busy_ifaces = g_hash_table_new (g_str_hash, g_str_equal);
 	h->dbus_dispatcher = nmdbus_dispatcher_skeleton_new ();
 	g_signal_connect (h->dbus_dispatcher, "handle-action",
 	                  G_CALLBACK (handle_action), h);
@@ -147,6 +156,7 @@ request_free (Request *request)
 	g_strfreev (request->envp);
 	if (request->scripts)
 		g_ptr_array_free (request->scripts, TRUE);
+	g_free (request);
 }
 
 static gboolean
@@ -173,37 +183,68 @@ quit_timeout_reschedule (void)
 		quit_id = g_timeout_add_seconds (10, quit_timeout_cb, NULL);
 }
 
+static const char *
+request_lane (Request *request)
+{
+	return request->iface ? request->iface : "";
+}
+
 static void
 start_request (Request *request)
 {
+	Handler *h = request->handler;
+
 	if (request->iface)
 		g_message ("Dispatching action '%s' for %s", request->action, request->iface);
 	else
 		g_message ("Dispatching action '%s'", request->action);
 
-	request->handler->current_request = request;
+	g_hash_table_insert (h->busy_ifaces, (gpointer) request_lane (request), request);
+	h->num_running++;
 	dispatch_one_script (request);
 }
 
+/* Starts the oldest pending requests whose interface is idle.  Skipping a
+ * busy interface's requests keeps them in order behind the running one.
+ */
 static void
-next_request (Handler *h)
+schedule_requests (Handler *h)
 {
-	Request *request = g_queue_pop_head (h->pending_requests);
+	GList *iter, *next;
 
-	if (request) {
+	for (iter = h->pending_requests->head; iter; iter = next) {
+		Request *request = iter->data;
+
+		next = iter->next;
+		if (h->num_running >= (guint) max_parallel)
+			break;
+		if (g_hash_table_lookup (h->busy_ifaces, request_lane (request)))
+			continue;
+
+		g_queue_delete_link (h->pending_requests, iter);
 		start_request (request);
-		return;
 	}
 
-	h->current_request = NULL;
-	quit_timeout_reschedule ();
+	if (!h->num_running)
+		quit_timeout_reschedule ();
+}
+
+static void
+finish_request (Request *request)
+{
+	Handler *h = request->handler;
+
+	g_hash_table_remove (h->busy_ifaces, request_lane (request));
+	h->num_running--;
+	request_free (request);
+
+	schedule_requests (h);
 }
 
 static gboolean
 next_script (gpointer user_data)
 {
 	Request *request = user_data;
-	Handler *h = request->handler;
 	GVariantBuilder results;
 	GVariant *ret;
 	guint i;
@@ -234,9 +275,8 @@ next_script (gpointer user_data)
 		else
 			g_message ("Dispatch '%s' complete", request->action);
 	}
-	request_free (request);
 
-	next_request (h);
+	finish_request (request);
 	return FALSE;
 }
 
@@ -393,23 +433,94 @@ dispatch_one_script (Request *request)
 	}
 }
 
+/* Sorted script lists are cached per directory and dropped on any inotify
+ * event in the dispatcher directories.  Directories that cannot be watched
+ * are scanned on every request.
+ */
+typedef struct {
+	const char *dirname;
+	int wd;
+	gboolean valid;
+	GSList *scripts;
+} ScriptDir;
+
+static ScriptDir script_dirs[] = {
+	{ NMD_SCRIPT_DIR_DEFAULT,  -1 },
+	{ NMD_SCRIPT_DIR_PRE_UP,   -1 },
+	{ NMD_SCRIPT_DIR_PRE_DOWN, -1 },
+};
+
+static int inotify_fd = -1;
+
+static void
+script_dirs_invalidate (void)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (script_dirs); i++) {
+		g_slist_free_full (script_dirs[i].scripts, g_free);
+		script_dirs[i].scripts = NULL;
+		script_dirs[i].valid = FALSE;
+	}
+}
+
+static gboolean
+inotify_event_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+	char buf[4096] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+	const struct inotify_event *event;
+	ssize_t len;
+	char *ptr;
+	guint i;
+
+	while ((len = read (inotify_fd, buf, sizeof (buf))) > 0) {
+		for (ptr = buf; ptr < buf + len; ptr += sizeof (*event) + event->len) {
+			event = (const struct inotify_event *) ptr;
+			if (!(event->mask & IN_IGNORED))
+				continue;
+			/* The directory went away; stop caching it */
+			for (i = 0; i < G_N_ELEMENTS (script_dirs); i++) {
+				if (script_dirs[i].wd == event->wd)
+					script_dirs[i].wd = -1;
+			}
+		}
+	}
+
+	script_dirs_invalidate ();
+	return TRUE;
+}
+
+static void
+script_dirs_watch (void)
+{
+	GIOChannel *channel;
+	guint i;
+
+	inotify_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+	if (inotify_fd < 0) {
+		g_message ("Failed to watch dispatcher directories: %s", g_strerror (errno));
+		return;
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (script_dirs); i++) {
+		script_dirs[i].wd = inotify_add_watch (inotify_fd, script_dirs[i].dirname,
+		                                       IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+		                                       IN_ATTRIB | IN_CLOSE_WRITE |
+		                                       IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+	}
+
+	channel = g_io_channel_unix_new (inotify_fd);
+	g_io_add_watch (channel, G_IO_IN, inotify_event_cb, NULL);
+	g_io_channel_unref (channel);
+}
+
 static GSList *
-find_scripts (const char *str_action)
+scan_script_dir (const char *dirname)
 {
 	GDir *dir;
 	const char *filename;
 	GSList *sorted = NULL;
 	GError *error = NULL;
-	const char *dirname;
-
-	if (   strcmp (str_action, NMD_ACTION_PRE_UP) == 0
-	    || strcmp (str_action, NMD_ACTION_VPN_PRE_UP) == 0)
-		dirname = NMD_SCRIPT_DIR_PRE_UP;
-	else if (   strcmp (str_action, NMD_ACTION_PRE_DOWN) == 0
-	         || strcmp (str_action, NMD_ACTION_VPN_PRE_DOWN) == 0)
-		dirname = NMD_SCRIPT_DIR_PRE_DOWN;
-	else
-		dirname = NMD_SCRIPT_DIR_DEFAULT;
 
 	if (!(dir = g_dir_open (dirname, 0, &error))) {
 		g_message ("Failed to open dispatcher directory '%s': (%d) %s",
@@ -448,6 +559,34 @@ find_scripts (const char *str_action)
 	return sorted;
 }
 
+static GSList *
+find_scripts (const char *str_action)
+{
+	ScriptDir *dir;
+	GSList *sorted = NULL, *iter;
+
+	if (   strcmp (str_action, NMD_ACTION_PRE_UP) == 0
+	    || strcmp (str_action, NMD_ACTION_VPN_PRE_UP) == 0)
+		dir = &script_dirs[1];
+	else if (   strcmp (str_action, NMD_ACTION_PRE_DOWN) == 0
+	         || strcmp (str_action, NMD_ACTION_VPN_PRE_DOWN) == 0)
+		dir = &script_dirs[2];
+	else
+		dir = &script_dirs[0];
+
+	if (dir->wd < 0)
+		return scan_script_dir (dir->dirname);
+
+	if (!dir->valid) {
+		dir->scripts = scan_script_dir (dir->dirname);
+		dir->valid = TRUE;
+	}
+
+	for (iter = dir->scripts; iter; iter = iter->next)
+		sorted = g_slist_prepend (sorted, g_strdup (iter->data));
+	return g_slist_reverse (sorted);
+}
+
 static gboolean
 handle_action (NMDBusDispatcher *dbus_dispatcher,
                GDBusMethodInvocation *context,
@@ -522,10 +661,8 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 	}
 	g_slist_free (sorted_scripts);
 
-	if (h->current_request)
-		g_queue_push_tail (h->pending_requests, request);
-	else
-		start_request (request);
+	g_queue_push_tail (h->pending_requests, request);
+	schedule_requests (h);
 
 	return TRUE;
 }
@@ -629,6 +766,7 @@ main (int argc, char **argv)
 	GOptionEntry entries[] = {
 		{ "debug", 0, 0, G_OPTION_ARG_NONE, &debug, "Output to console rather than syslog", NULL },
 		{ "persist", 0, 0, G_OPTION_ARG_NONE, &persist, "Don't quit after a short timeout", NULL },
+		{ "max-parallel", 0, 0, G_OPTION_ARG_INT, &max_parallel, "Run scripts for up to this many interfaces at once (default 4)", "N" },
 		{ NULL }
 	};
 
@@ -644,6 +782,9 @@ main (int argc, char **argv)
 
 	g_option_context_free (opt_ctx);
 
+	if (max_parallel < 1)
+		max_parallel = 1;
+
 #if !GLIB_CHECK_VERSION (2, 35, 0)
 	g_type_init ();
 #endif
@@ -656,6 +797,8 @@ main (int argc, char **argv)
 
 	loop = g_main_loop_new (NULL, FALSE);
 
+	script_dirs_watch ();
+
 	bus = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
 	if (!bus) {
 		g_warning ("Could not get the system bus (%s).  Make sure the message bus daemon is running!",
@@ -689,6 +832,8 @@ main (int argc, char **argv)
 	g_main_loop_run (loop);
 
 	g_queue_free (handler->pending_requests);
+	g_hash_table_destroy (handler->busy_ifaces);
+	script_dirs_invalidate ();
 	g_object_unref (handler);
 
 	if (!debug)
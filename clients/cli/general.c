@@ -94,7 +94,8 @@ usage_general (void)
 	              "  status\n\n"
 	              "  hostname [<hostname>]\n\n"
 	              "  permissions\n\n"
-	              "  logging [level <log level>] [domains <log domains>]\n\n"));
+	              "  logging [level <log level>] [domains <log domains>]\n\n"
+	              "  logging dump [follow]\n\n"));
 }
 
 static void
@@ -136,7 +137,12 @@ usage_general_logging (void)
 	              "Get or change NetworkManager logging level and domains.\n"
 	              "Without any argument current logging level and domains are shown. In order to\n"
 	              "change logging state, provide level and/or domain. Please refer to the man page\n"
-	              "for the list of possible logging domains.\n\n"));
+	              "for the list of possible logging domains.\n"
+	              "\n"
+	              "ARGUMENTS := dump [follow]\n"
+	              "\n"
+	              "Print the messages kept in NetworkManager's in-memory debug log buffer.\n"
+	              "With 'follow', keep printing new messages as they are logged.\n\n"));
 }
 
 static void
@@ -551,6 +557,41 @@ save_hostname_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 	quit ();
 }
 
+static guint32 debug_log_next;
+
+static gboolean
+print_debug_log (NmCli *nmc)
+{
+	GError *error = NULL;
+	char **messages, **iter;
+
+	messages = nm_client_get_debug_log (nmc->client, debug_log_next, &debug_log_next, &error);
+	if (!messages) {
+		g_string_printf (nmc->return_text, _("Error: failed to read the debug log: %s"),
+		                 error->message);
+		nmc->return_value = NMC_RESULT_ERROR_UNKNOWN;
+		g_error_free (error);
+		return FALSE;
+	}
+
+	for (iter = messages; *iter; iter++)
+		g_print ("%s\n", *iter);
+	g_strfreev (messages);
+	return TRUE;
+}
+
+static gboolean
+follow_debug_log_cb (gpointer user_data)
+{
+	NmCli *nmc = user_data;
+
+	if (!print_debug_log (nmc)) {
+		quit ();
+		return G_SOURCE_REMOVE;
+	}
+	return G_SOURCE_CONTINUE;
+}
+
 /*
  * Entry point function for general operations 'nmcli general'
  */
@@ -639,6 +680,25 @@ do_general (NmCli *nmc, int argc, char **argv)
 					goto finish;
 				}
 				show_general_logging (nmc);
+			} else if (matches (*argv, "dump") == 0) {
+				gboolean follow = FALSE;
+
+				if (next_arg (&argc, &argv) == 0) {
+					if (matches (*argv, "follow") != 0) {
+						g_string_printf (nmc->return_text, _("Error: invalid argument '%s'."), *argv);
+						nmc->return_value = NMC_RESULT_ERROR_USER_INPUT;
+						goto finish;
+					}
+					follow = TRUE;
+				}
+
+				nmc->get_client (nmc); /* create NMClient */
+				if (!print_debug_log (nmc))
+					goto finish;
+				if (follow) {
+					nmc->should_wait = TRUE;
+					g_timeout_add_seconds (1, follow_debug_log_cb, nmc);
+				}
 			} else {
 				/* arguments provided -> set logging level and domains */
 				const char *level = NULL;
@@ -564,6 +564,108 @@ __nmtst_spawn_sync (const char *working_directory, char **standard_out, char **s
 
 /*******************************************************************************/
 
+/* Benchmarks print one line per measurement:
+ *
+ *   benchmark operation size rounds value unit
+ *
+ * "make check-perf" runs all benchmarks and collects these lines, so the
+ * format must stay stable. */
+
+inline static void
+nmtst_perf_init (int argc, char **argv)
+{
+	char *name = g_path_get_basename (argv[0]);
+
+	/* Strip the libtool wrapper prefix */
+	g_set_prgname (g_str_has_prefix (name, "lt-") ? name + 3 : name);
+	g_free (name);
+
+#if !GLIB_CHECK_VERSION (2, 35, 0)
+	g_type_init ();
+#endif
+
+	g_print ("# benchmark operation size rounds value unit\n");
+}
+
+inline static void
+nmtst_perf_report (const char *operation, guint size, guint rounds, double value, const char *unit)
+{
+	g_print ("%s %s %u %u %.3f %s\n", g_get_prgname (), operation, size, rounds, value, unit);
+}
+
+/* Reports the time since @start, in nanoseconds per item for @size
+ * items handled @rounds times. */
+inline static void
+nmtst_perf_report_time (const char *operation, guint size, guint rounds, gint64 start)
+{
+	double usec = g_get_monotonic_time () - start;
+
+	nmtst_perf_report (operation, size, rounds, usec * 1000 / ((double) MAX (size, 1) * MAX (rounds, 1)), "nsec/item");
+}
+
+inline static guint
+nmtst_perf_arg (int argc, char **argv, int i, guint defval)
+{
+	return argc > i ? (guint) atoi (argv[i]) : defval;
+}
+
+#if defined (__NM_SIMPLE_CONNECTION_H__) && defined (__NM_SETTING_IP4_CONFIG_H__)
+
+inline static NMConnection *nmtst_create_minimal_connection (const char *id, const char *uuid, const char *type, NMSettingConnection **out_s_con);
+
+/* Builds the @n-th wired connection with a manual IPv4 setting of 8
+ * addresses and 8 routes.  With @rand, autoconnect and its priority are
+ * randomized too. */
+inline static NMConnection *
+nmtst_perf_create_connection (GRand *rand, guint n)
+{
+	NMConnection *connection;
+	NMSettingConnection *s_con;
+	NMSettingIPConfig *s_ip4;
+	char *id, *uuid;
+	guint i;
+
+	id = g_strdup_printf ("bench-%u", n);
+	uuid = g_strdup_printf ("%08x-0000-4000-8000-000000000000", n);
+	connection = nmtst_create_minimal_connection (id, uuid, NM_SETTING_WIRED_SETTING_NAME, &s_con);
+	g_free (id);
+	g_free (uuid);
+
+	if (rand) {
+		g_object_set (s_con,
+		              NM_SETTING_CONNECTION_AUTOCONNECT, g_rand_boolean (rand),
+		              NM_SETTING_CONNECTION_AUTOCONNECT_PRIORITY, g_rand_int_range (rand, -10, 10),
+		              NULL);
+	}
+
+	s_ip4 = (NMSettingIPConfig *) nm_setting_ip4_config_new ();
+	g_object_set (s_ip4,
+	              NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP4_CONFIG_METHOD_MANUAL,
+	              NULL);
+	for (i = 0; i < 8; i++) {
+		NMIPAddress *address;
+		NMIPRoute *route;
+		char buf[NM_UTILS_INET_ADDRSTRLEN];
+
+		g_snprintf (buf, sizeof (buf), "10.%u.%u.1", n & 0xFF, i);
+		address = nm_ip_address_new (AF_INET, buf, 24, NULL);
+		nm_setting_ip_config_add_address (s_ip4, address);
+		nm_ip_address_unref (address);
+
+		g_snprintf (buf, sizeof (buf), "172.%u.%u.0", 16 + i, n & 0xFF);
+		route = nm_ip_route_new (AF_INET, buf, 24, NULL, 100, NULL);
+		nm_setting_ip_config_add_route (s_ip4, route);
+		nm_ip_route_unref (route);
+	}
+	nm_connection_add_setting (connection, NM_SETTING (s_ip4));
+
+	return connection;
+}
+
+#endif
+
+/*******************************************************************************/
+
 #ifdef __NETWORKMANAGER_PLATFORM_H__
 
 inline static NMPlatformIP6Address *
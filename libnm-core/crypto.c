@@ -28,6 +28,7 @@
 #include <strings.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #include <glib/gi18n-lib.h>
 
 #include "crypto.h"
@@ -635,6 +636,160 @@ crypto_load_and_verify_certificate (const char *file,
 	return contents;
 }
 
+/*****************************************************************************/
+
+/* Results of crypto_is_pkcs12_file() and crypto_verify_private_key() are
+ * cached, since 802.1X settings ask for them on every verify() and
+ * need_secrets() call.  An entry is only valid for the exact file it was
+ * computed for, identified by device, inode, size and modification time.
+ * Passwords only enter the key as a salted hash.
+ */
+
+#define FILE_CACHE_MAX 256
+
+typedef enum {
+	FILE_CACHE_IS_PKCS12,
+	FILE_CACHE_VERIFY_KEY,
+} FileCacheOp;
+
+typedef struct {
+	NMCryptoFileFormat format;
+	gboolean is_pkcs12;
+	gboolean is_encrypted;
+	GError *error;
+} FileCacheResult;
+
+G_LOCK_DEFINE_STATIC (file_cache);
+static GHashTable *file_cache;
+static char *file_cache_salt;
+static guint file_cache_hits;
+static guint file_cache_misses;
+
+static void
+file_cache_result_free (gpointer data)
+{
+	FileCacheResult *result = data;
+
+	g_clear_error (&result->error);
+	g_slice_free (FileCacheResult, result);
+}
+
+static char *
+file_cache_key (FileCacheOp op, const char *filename, const char *password)
+{
+	struct stat st;
+	char *password_hash = NULL;
+	char *key;
+
+	if (stat (filename, &st) != 0 || !S_ISREG (st.st_mode))
+		return NULL;
+
+	if (password) {
+		GChecksum *sum = g_checksum_new (G_CHECKSUM_SHA256);
+
+		g_checksum_update (sum, (const guchar *) file_cache_salt, -1);
+		g_checksum_update (sum, (const guchar *) password, -1);
+		password_hash = g_strdup (g_checksum_get_string (sum));
+		g_checksum_free (sum);
+	}
+
+	key = g_strdup_printf ("%d:%llu:%llu:%lld.%09ld:%lld:%s:%s",
+	                       op,
+	                       (unsigned long long) st.st_dev,
+	                       (unsigned long long) st.st_ino,
+	                       (long long) st.st_mtim.tv_sec,
+	                       (long) st.st_mtim.tv_nsec,
+	                       (long long) st.st_size,
+	                       password_hash ? password_hash : "-",
+	                       filename);
+	g_free (password_hash);
+	return key;
+}
+
+/* Returns %TRUE and copies the cached result to @out_result on a hit; the
+ * caller owns the copied error.  On a miss, @out_key is set to the key to
+ * store the result under, or to %NULL if the file cannot be cached. */
+static gboolean
+file_cache_lookup (FileCacheOp op,
+                   const char *filename,
+                   const char *password,
+                   char **out_key,
+                   FileCacheResult *out_result)
+{
+	FileCacheResult *result = NULL;
+	char *key;
+
+	G_LOCK (file_cache);
+
+	if (!file_cache) {
+		file_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, file_cache_result_free);
+		file_cache_salt = g_strdup_printf ("%08x%08x", g_random_int (), g_random_int ());
+	}
+
+	key = file_cache_key (op, filename, password);
+	if (key)
+		result = g_hash_table_lookup (file_cache, key);
+	if (result) {
+		*out_result = *result;
+		out_result->error = result->error ? g_error_copy (result->error) : NULL;
+		file_cache_hits++;
+		g_free (key);
+		key = NULL;
+	} else
+		file_cache_misses++;
+
+	G_UNLOCK (file_cache);
+
+	*out_key = key;
+	return result != NULL;
+}
+
+/* Takes ownership of @key */
+static void
+file_cache_store (char *key, const FileCacheResult *result, const GError *error)
+{
+	FileCacheResult *copy;
+
+	/* Reading errors are usually transient and are not cached */
+	if (!key || (error && error->domain != NM_CRYPTO_ERROR)) {
+		g_free (key);
+		return;
+	}
+
+	copy = g_slice_new (FileCacheResult);
+	*copy = *result;
+	copy->error = error ? g_error_copy (error) : NULL;
+
+	G_LOCK (file_cache);
+	/* Entries of modified files are never hit again; drop them in bulk */
+	if (g_hash_table_size (file_cache) >= FILE_CACHE_MAX)
+		g_hash_table_remove_all (file_cache);
+	g_hash_table_insert (file_cache, key, copy);
+	G_UNLOCK (file_cache);
+}
+
+void
+crypto_file_cache_get_stats (guint *out_hits, guint *out_misses)
+{
+	G_LOCK (file_cache);
+	if (out_hits)
+		*out_hits = file_cache_hits;
+	if (out_misses)
+		*out_misses = file_cache_misses;
+	G_UNLOCK (file_cache);
+}
+
+void
+crypto_file_cache_clear (void)
+{
+	G_LOCK (file_cache);
+	if (file_cache)
+		g_hash_table_remove_all (file_cache);
+	G_UNLOCK (file_cache);
+}
+
+/*****************************************************************************/
+
 gboolean
 crypto_is_pkcs12_data (const guint8 *data,
                        gsize data_len,
@@ -666,19 +821,31 @@ gboolean
 crypto_is_pkcs12_file (const char *file, GError **error)
 {
 	GByteArray *contents;
-	gboolean success = FALSE;
+	FileCacheResult result = { 0 };
+	GError *local = NULL;
+	char *key;
 
 	g_return_val_if_fail (file != NULL, FALSE);
 
 	if (!crypto_init (error))
 		return FALSE;
 
-	contents = file_to_g_byte_array (file, error);
+	if (file_cache_lookup (FILE_CACHE_IS_PKCS12, file, NULL, &key, &result)) {
+		if (result.error)
+			g_propagate_error (error, result.error);
+		return result.is_pkcs12;
+	}
+
+	contents = file_to_g_byte_array (file, &local);
 	if (contents) {
-		success = crypto_is_pkcs12_data (contents->data, contents->len, error);
+		result.is_pkcs12 = crypto_is_pkcs12_data (contents->data, contents->len, &local);
 		g_byte_array_free (contents, TRUE);
 	}
-	return success;
+	file_cache_store (key, &result, local);
+
+	if (local)
+		g_propagate_error (error, local);
+	return result.is_pkcs12;
 }
 
 /* Verifies that a private key can be read, and if a password is given, that
@@ -746,19 +913,33 @@ crypto_verify_private_key (const char *filename,
                            GError **error)
 {
 	GByteArray *contents;
-	NMCryptoFileFormat format = NM_CRYPTO_FILE_FORMAT_UNKNOWN;
+	FileCacheResult result = { 0 };
+	GError *local = NULL;
+	char *key;
 
 	g_return_val_if_fail (filename != NULL, NM_CRYPTO_FILE_FORMAT_UNKNOWN);
+	g_return_val_if_fail (out_is_encrypted == NULL || *out_is_encrypted == FALSE, NM_CRYPTO_FILE_FORMAT_UNKNOWN);
 
 	if (!crypto_init (error))
 		return NM_CRYPTO_FILE_FORMAT_UNKNOWN;
 
-	contents = file_to_g_byte_array (filename, error);
-	if (contents) {
-		format = crypto_verify_private_key_data (contents->data, contents->len, password, out_is_encrypted, error);
-		g_byte_array_free (contents, TRUE);
+	if (file_cache_lookup (FILE_CACHE_VERIFY_KEY, filename, password, &key, &result))
+		local = result.error;
+	else {
+		contents = file_to_g_byte_array (filename, &local);
+		if (contents) {
+			result.format = crypto_verify_private_key_data (contents->data, contents->len, password,
+			                                                &result.is_encrypted, &local);
+			g_byte_array_free (contents, TRUE);
+		}
+		file_cache_store (key, &result, local);
 	}
-	return format;
+
+	if (local)
+		g_propagate_error (error, local);
+	if (out_is_encrypted)
+		*out_is_encrypted = result.is_encrypted;
+	return result.format;
 }
 
 void
@@ -76,6 +76,10 @@ NMCryptoFileFormat crypto_verify_private_key (const char *file,
                                               gboolean *out_is_encrypted,
                                               GError **error);
 
+void crypto_file_cache_get_stats (guint *out_hits, guint *out_misses);
+
+void crypto_file_cache_clear (void);
+
 /* Internal utils API bits for crypto providers */
 
 void crypto_md5_hash (const char *salt,
@@ -32,4 +32,13 @@ const char *_nm_connection_detect_slave_type              (NMConnection *connect
 gboolean    _nm_connection_verify_required_interface_name (NMConnection *connection,
                                                            GError **error);
 
+void        _nm_connection_share_settings                 (NMConnection *connection,
+                                                           NMConnection *source);
+
+NMSetting  *_nm_connection_peek_setting                   (NMConnection *connection,
+                                                           GType setting_type);
+
+NMSetting  *_nm_connection_peek_setting_by_name           (NMConnection *connection,
+                                                           const char *name);
+
 #endif  /* __NM_CONNECTION_PRIVATE_H__ */
@@ -90,10 +90,17 @@ setting_changed_cb (NMSetting *setting,
 static gboolean
 _setting_release (gpointer key, gpointer value, gpointer user_data)
 {
-	g_signal_handlers_disconnect_by_func (user_data, setting_changed_cb, value);
+	g_signal_handlers_disconnect_by_func (value, setting_changed_cb, user_data);
 	return TRUE;
 }
 
+static void
+_setting_unref (gpointer setting)
+{
+	_nm_setting_remove_owner (setting);
+	g_object_unref (setting);
+}
+
 static void
 _nm_connection_add_setting (NMConnection *connection, NMSetting *setting)
 {
@@ -103,11 +110,108 @@ _nm_connection_add_setting (NMConnection *connection, NMSetting *setting)
 
 	if ((s_old = g_hash_table_lookup (priv->settings, (gpointer) name)))
 		g_signal_handlers_disconnect_by_func (s_old, setting_changed_cb, connection);
+	_nm_setting_add_owner (setting);
 	g_hash_table_insert (priv->settings, (gpointer) name, setting);
 	/* Listen for property changes so we can emit the 'changed' signal */
 	g_signal_connect (setting, "notify", (GCallback) setting_changed_cb, connection);
 }
 
+/* Settings of a clone from _nm_simple_connection_new_clone_shared() are
+ * shared with the connection they were cloned from.  Before either one hands
+ * out a setting that may be modified, it replaces the setting with its own
+ * copy.
+ */
+static NMSetting *
+_setting_unshare (NMConnection *connection, NMSetting *setting)
+{
+	NMSetting *copy;
+
+	if (!setting || !_nm_setting_is_shared (setting))
+		return setting;
+
+	copy = nm_setting_duplicate (setting);
+	_nm_connection_add_setting (connection, copy);
+	return copy;
+}
+
+static void
+_unshare_all_settings (NMConnection *connection)
+{
+	GHashTableIter iter;
+	GSList *shared = NULL, *l;
+	NMSetting *setting;
+
+	g_hash_table_iter_init (&iter, NM_CONNECTION_GET_PRIVATE (connection)->settings);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &setting)) {
+		if (_nm_setting_is_shared (setting))
+			shared = g_slist_prepend (shared, setting);
+	}
+	for (l = shared; l; l = l->next)
+		_setting_unshare (connection, l->data);
+	g_slist_free (shared);
+}
+
+/**
+ * _nm_connection_peek_setting:
+ * @connection: a #NMConnection
+ * @setting_type: the #GType of the setting
+ *
+ * Like nm_connection_get_setting(), but does not replace a setting that is
+ * shared with a clone by a copy.  For read-only paths like verify() and
+ * to_dbus(); the returned setting must not be modified.
+ *
+ * Returns: (transfer none): the #NMSetting, or %NULL
+ */
+NMSetting *
+_nm_connection_peek_setting (NMConnection *connection, GType setting_type)
+{
+	return g_hash_table_lookup (NM_CONNECTION_GET_PRIVATE (connection)->settings,
+	                            g_type_name (setting_type));
+}
+
+/**
+ * _nm_connection_peek_setting_by_name:
+ * @connection: a #NMConnection
+ * @name: a setting name
+ *
+ * Like nm_connection_get_setting_by_name(), without unsharing the setting;
+ * see _nm_connection_peek_setting().
+ *
+ * Returns: (transfer none): the #NMSetting, or %NULL
+ */
+NMSetting *
+_nm_connection_peek_setting_by_name (NMConnection *connection, const char *name)
+{
+	GType type = nm_setting_lookup_type (name);
+
+	return type ? _nm_connection_peek_setting (connection, type) : NULL;
+}
+
+/**
+ * _nm_connection_share_settings:
+ * @connection: a connection without settings
+ * @source: the connection to take the settings from
+ *
+ * Adds the setting objects of @source to @connection without copying them.
+ * Both connections copy a shared setting as soon as it is requested with
+ * nm_connection_get_setting() or its secrets are updated or cleared, so
+ * neither sees changes made through the other.
+ */
+void
+_nm_connection_share_settings (NMConnection *connection, NMConnection *source)
+{
+	GHashTableIter iter;
+	NMSetting *setting;
+
+	g_return_if_fail (NM_IS_CONNECTION (connection));
+	g_return_if_fail (NM_IS_CONNECTION (source));
+	g_return_if_fail (g_hash_table_size (NM_CONNECTION_GET_PRIVATE (connection)->settings) == 0);
+
+	g_hash_table_iter_init (&iter, NM_CONNECTION_GET_PRIVATE (source)->settings);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &setting))
+		_nm_connection_add_setting (connection, g_object_ref (setting));
+}
+
 /**
  * nm_connection_add_setting:
  * @connection: a #NMConnection
@@ -173,8 +277,7 @@ nm_connection_get_setting (NMConnection *connection, GType setting_type)
 	g_return_val_if_fail (NM_IS_CONNECTION (connection), NULL);
 	g_return_val_if_fail (g_type_is_a (setting_type, NM_TYPE_SETTING), NULL);
 
-	return (NMSetting *) g_hash_table_lookup (NM_CONNECTION_GET_PRIVATE (connection)->settings,
-	                                          g_type_name (setting_type));
+	return _setting_unshare (connection, _nm_connection_peek_setting (connection, setting_type));
 }
 
 /**
@@ -410,7 +513,7 @@ nm_connection_compare (NMConnection *a,
 	/* A / B: ensure all settings in A match corresponding ones in B */
 	g_hash_table_iter_init (&iter, NM_CONNECTION_GET_PRIVATE (a)->settings);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &src)) {
-		NMSetting *cmp = nm_connection_get_setting (b, G_OBJECT_TYPE (src));
+		NMSetting *cmp = _nm_connection_peek_setting (b, G_OBJECT_TYPE (src));
 
 		if (!cmp || !nm_setting_compare (src, cmp, flags))
 			return FALSE;
@@ -439,7 +542,7 @@ diff_one_connection (NMConnection *a,
 		gboolean new_results = TRUE;
 
 		if (b)
-			b_setting = nm_connection_get_setting (b, G_OBJECT_TYPE (a_setting));
+			b_setting = _nm_connection_peek_setting (b, G_OBJECT_TYPE (a_setting));
 
 		results = g_hash_table_lookup (diffs, setting_name);
 		if (results)
@@ -794,7 +897,7 @@ _nm_connection_verify (NMConnection *connection, GError **error)
 	priv = NM_CONNECTION_GET_PRIVATE (connection);
 
 	/* First, make sure there's at least 'connection' setting */
-	s_con = nm_connection_get_setting_connection (connection);
+	s_con = (NMSettingConnection *) _nm_connection_peek_setting (connection, NM_TYPE_SETTING_CONNECTION);
 	if (!s_con) {
 		g_set_error_literal (error,
 		                     NM_CONNECTION_ERROR,
@@ -853,8 +956,8 @@ _nm_connection_verify (NMConnection *connection, GError **error)
 	}
 	g_slist_free (all_settings);
 
-	s_ip4 = nm_connection_get_setting_ip4_config (connection);
-	s_ip6 = nm_connection_get_setting_ip6_config (connection);
+	s_ip4 = (NMSettingIPConfig *) _nm_connection_peek_setting (connection, NM_TYPE_SETTING_IP4_CONFIG);
+	s_ip6 = (NMSettingIPConfig *) _nm_connection_peek_setting (connection, NM_TYPE_SETTING_IP6_CONFIG);
 
 	if (nm_setting_connection_get_master (s_con)) {
 		if ((normalizable_error_type == NM_SETTING_VERIFY_SUCCESS ||
@@ -952,6 +1055,8 @@ nm_connection_normalize (NMConnection *connection,
 	 * We only do this, after verifying that the connection contains no un-normalizable
 	 * errors, because in that case we rather fail without touching the settings. */
 
+	_unshare_all_settings (connection);
+
 	was_modified |= _normalize_connection_uuid (connection);
 	was_modified |= _normalize_connection_type (connection);
 	was_modified |= _normalize_connection_slave_type (connection);
@@ -1184,6 +1289,14 @@ nm_connection_clear_secrets (NMConnection *connection)
 
 	g_hash_table_iter_init (&iter, NM_CONNECTION_GET_PRIVATE (connection)->settings);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &setting)) {
+		if (_nm_setting_is_shared (setting) && _nm_setting_has_secret_properties (setting)) {
+			g_signal_handlers_disconnect_by_func (setting, setting_changed_cb, connection);
+			setting = nm_setting_duplicate (setting);
+			_nm_setting_add_owner (setting);
+			g_hash_table_iter_replace (&iter, setting);
+			g_signal_connect (setting, "notify", (GCallback) setting_changed_cb, connection);
+		}
+
 		g_signal_handlers_block_by_func (setting, (GCallback) setting_changed_cb, connection);
 		changed |= _nm_setting_clear_secrets (setting);
 		g_signal_handlers_unblock_by_func (setting, (GCallback) setting_changed_cb, connection);
@@ -1216,6 +1329,14 @@ nm_connection_clear_secrets_with_flags (NMConnection *connection,
 
 	g_hash_table_iter_init (&iter, NM_CONNECTION_GET_PRIVATE (connection)->settings);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &setting)) {
+		if (_nm_setting_is_shared (setting) && _nm_setting_has_secret_properties (setting)) {
+			g_signal_handlers_disconnect_by_func (setting, setting_changed_cb, connection);
+			setting = nm_setting_duplicate (setting);
+			_nm_setting_add_owner (setting);
+			g_hash_table_iter_replace (&iter, setting);
+			g_signal_connect (setting, "notify", (GCallback) setting_changed_cb, connection);
+		}
+
 		g_signal_handlers_block_by_func (setting, (GCallback) setting_changed_cb, connection);
 		changed |= _nm_setting_clear_secrets_with_flags (setting, func, user_data);
 		g_signal_handlers_unblock_by_func (setting, (GCallback) setting_changed_cb, connection);
@@ -1259,8 +1380,10 @@ nm_connection_to_dbus (NMConnection *connection,
 		NMSetting *setting = NM_SETTING (data);
 
 		setting_dict = _nm_setting_to_dbus (setting, connection, flags);
-		if (setting_dict)
+		if (setting_dict) {
 			g_variant_builder_add (&builder, "{s@a{sv}}", nm_setting_get_name (setting), setting_dict);
+			g_variant_unref (setting_dict);
+		}
 	}
 
 	ret = g_variant_builder_end (&builder);
@@ -1295,7 +1418,7 @@ nm_connection_is_type (NMConnection *connection, const char *type)
 	g_return_val_if_fail (NM_IS_CONNECTION (connection), FALSE);
 	g_return_val_if_fail (type != NULL, FALSE);
 
-	s_con = nm_connection_get_setting_connection (connection);
+	s_con = (NMSettingConnection *) _nm_connection_peek_setting (connection, NM_TYPE_SETTING_CONNECTION);
 	if (!s_con)
 		return FALSE;
 
@@ -1419,7 +1542,7 @@ nm_connection_get_interface_name (NMConnection *connection)
 
 	g_return_val_if_fail (NM_IS_CONNECTION (connection), NULL);
 
-	s_con = nm_connection_get_setting_connection (connection);
+	s_con = (NMSettingConnection *) _nm_connection_peek_setting (connection, NM_TYPE_SETTING_CONNECTION);
 
 	return s_con ? nm_setting_connection_get_interface_name (s_con) : NULL;
 }
@@ -1457,7 +1580,7 @@ nm_connection_get_uuid (NMConnection *connection)
 
 	g_return_val_if_fail (NM_IS_CONNECTION (connection), NULL);
 
-	s_con = nm_connection_get_setting_connection (connection);
+	s_con = (NMSettingConnection *) _nm_connection_peek_setting (connection, NM_TYPE_SETTING_CONNECTION);
 	g_return_val_if_fail (s_con != NULL, NULL);
 
 	return nm_setting_connection_get_uuid (s_con);
@@ -1478,7 +1601,7 @@ nm_connection_get_id (NMConnection *connection)
 
 	g_return_val_if_fail (NM_IS_CONNECTION (connection), NULL);
 
-	s_con = nm_connection_get_setting_connection (connection);
+	s_con = (NMSettingConnection *) _nm_connection_peek_setting (connection, NM_TYPE_SETTING_CONNECTION);
 	g_return_val_if_fail (s_con != NULL, NULL);
 
 	return nm_setting_connection_get_id (s_con);
@@ -1499,7 +1622,7 @@ nm_connection_get_connection_type (NMConnection *connection)
 
 	g_return_val_if_fail (NM_IS_CONNECTION (connection), NULL);
 
-	s_con = nm_connection_get_setting_connection (connection);
+	s_con = (NMSettingConnection *) _nm_connection_peek_setting (connection, NM_TYPE_SETTING_CONNECTION);
 	g_return_val_if_fail (s_con != NULL, NULL);
 
 	return nm_setting_connection_get_connection_type (s_con);
@@ -2034,7 +2157,7 @@ nm_connection_get_private (NMConnection *connection)
 		                        priv, (GDestroyNotify) nm_connection_private_free);
 
 		priv->self = connection;
-		priv->settings = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+		priv->settings = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, _setting_unref);
 	}
 
 	return priv;
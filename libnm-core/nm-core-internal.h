@@ -124,6 +124,13 @@ char *nm_utils_uuid_generate_from_string (const char *s, gssize slen, int uuid_t
 
 void _nm_dbus_errors_init (void);
 
+NMConnection *_nm_simple_connection_new_clone_shared (NMConnection *connection);
+
+gboolean _nm_setting_wired_mac_address_matches        (NMSettingWired *setting, const guint8 *hwaddr);
+gboolean _nm_setting_wired_mac_address_blacklisted    (NMSettingWired *setting, const guint8 *hwaddr);
+gboolean _nm_setting_wireless_mac_address_matches     (NMSettingWireless *setting, const guint8 *hwaddr);
+gboolean _nm_setting_wireless_mac_address_blacklisted (NMSettingWireless *setting, const guint8 *hwaddr);
+
 extern gboolean _nm_utils_is_manager_process;
 
 GByteArray *nm_utils_rsa_key_encrypt (const guint8 *data,
@@ -30,6 +30,7 @@
 #include "nm-setting-cdma.h"
 #include "nm-setting-gsm.h"
 #include "nm-setting-private.h"
+#include "nm-connection-private.h"
 #include "nm-utils.h"
 #include "nm-utils-private.h"
 
@@ -155,8 +156,8 @@ verify (NMSetting *setting, NMConnection *connection, GError **error)
 	    && !strcmp (priv->type, NM_SETTING_BLUETOOTH_TYPE_DUN)) {
 		gboolean gsm = FALSE, cdma = FALSE;
 
-		gsm = !!nm_connection_get_setting_gsm (connection);
-		cdma = !!nm_connection_get_setting_cdma (connection);
+		gsm = !!_nm_connection_peek_setting (connection, NM_TYPE_SETTING_GSM);
+		cdma = !!_nm_connection_peek_setting (connection, NM_TYPE_SETTING_CDMA);
 
 		if (!gsm && !cdma) {
 			/* We can't return MISSING_SETTING here, because we don't know
@@ -538,7 +538,7 @@ verify (NMSetting *setting, NMConnection *connection, GError **error)
 		}
 	}
 
-	if (nm_connection_get_setting_infiniband (connection)) {
+	if (_nm_connection_peek_setting (connection, NM_TYPE_SETTING_INFINIBAND)) {
 		if (strcmp (value, "active-backup") != 0) {
 			g_set_error (error,
 			             NM_CONNECTION_ERROR,
@@ -768,4 +768,5 @@ nm_setting_bond_class_init (NMSettingBondClass *setting_class)
 	                                           G_VARIANT_TYPE_STRING,
 	                                           _nm_setting_get_deprecated_virtual_interface_name,
 	                                           NULL);
+	_nm_setting_class_set_dbus_uses_connection (parent_class);
 }
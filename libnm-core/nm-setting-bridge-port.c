@@ -147,7 +147,7 @@ verify (NMSetting *setting, NMConnection *connection, GError **error)
 		NMSettingConnection *s_con;
 		const char *slave_type;
 
-		s_con = nm_connection_get_setting_connection (connection);
+		s_con = (NMSettingConnection *) _nm_connection_peek_setting (connection, NM_TYPE_SETTING_CONNECTION);
 		if (!s_con) {
 			g_set_error (error,
 			             NM_CONNECTION_ERROR,
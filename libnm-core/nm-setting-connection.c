@@ -833,7 +833,7 @@ verify (NMSetting *setting, NMConnection *connection, GError **error)
 
 		/* Make sure the corresponding 'type' item is present */
 		if (   connection
-		    && !nm_connection_get_setting_by_name (connection, priv->type)) {
+		    && !_nm_connection_peek_setting_by_name (connection, priv->type)) {
 			NMSetting *s_base;
 			NMConnection *connection2;
 
@@ -876,7 +876,7 @@ verify (NMSetting *setting, NMConnection *connection, GError **error)
 		}
 		if (   slave_setting_type
 		    && connection
-		    && !nm_connection_get_setting_by_name (connection, slave_setting_type))
+		    && !_nm_connection_peek_setting_by_name (connection, slave_setting_type))
 			normerr_slave_setting_type = slave_setting_type;
 	} else {
 		if (priv->master) {
@@ -28,6 +28,7 @@
 #include "nm-utils.h"
 #include "nm-utils-private.h"
 #include "nm-setting-private.h"
+#include "nm-connection-private.h"
 #include "nm-setting-connection.h"
 
 /**
@@ -239,7 +240,7 @@ verify (NMSetting *setting, NMConnection *connection, GError **error)
 		}
 	}
 
-	s_con = nm_connection_get_setting_connection (connection);
+	s_con = (NMSettingConnection *) _nm_connection_peek_setting (connection, NM_TYPE_SETTING_CONNECTION);
 	if (s_con) {
 		const char *interface_name = nm_setting_connection_get_interface_name (s_con);
 
@@ -71,16 +71,31 @@ canonicalize_ip (int family, const char *ip, gboolean null_any)
 	return g_strdup (inet_ntop (family, addr_bytes, addr_str, sizeof (addr_str)));
 }
 
+/* Parses @ip into @addr_bytes, which must be large enough for @family. */
 static gboolean
-valid_ip (int family, const char *ip, GError **error)
+parse_ip (int family, const char *ip, gpointer addr_bytes, GError **error)
 {
-	if (!nm_utils_ipaddr_valid (family, ip)) {
+	if (!ip || inet_pton (family, ip, addr_bytes) != 1) {
 		g_set_error (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_FAILED,
 		             family == AF_INET ? _("Invalid IPv4 address '%s'") : _("Invalid IPv6 address '%s"),
 		             ip);
 		return FALSE;
-	} else
-		return TRUE;
+	}
+	return TRUE;
+}
+
+static inline gsize
+addr_len (int family)
+{
+	return family == AF_INET ? sizeof (struct in_addr) : sizeof (struct in6_addr);
+}
+
+static char *
+addr_to_string (int family, gconstpointer addr_bytes)
+{
+	char string[NM_UTILS_INET_ADDRSTRLEN];
+
+	return g_strdup (inet_ntop (family, addr_bytes, string, sizeof (string)));
 }
 
 static gboolean
@@ -119,11 +134,17 @@ valid_metric (gint64 metric, GError **error)
 
 G_DEFINE_BOXED_TYPE (NMIPAddress, nm_ip_address, nm_ip_address_dup, nm_ip_address_unref)
 
+/* The address is stored in binary form; the string returned by
+ * nm_ip_address_get_address() is only formatted when first asked for. */
 struct NMIPAddress {
 	guint refcount;
 
-	char *address;
 	int prefix, family;
+	union {
+		struct in_addr addr4;
+		struct in6_addr addr6;
+	} address;
+	char *address_str;
 
 	GHashTable *attributes;
 };
@@ -146,11 +167,12 @@ nm_ip_address_new (int family,
                    GError **error)
 {
 	NMIPAddress *address;
+	guint8 addr_bytes[sizeof (struct in6_addr)];
 
 	g_return_val_if_fail (family == AF_INET || family == AF_INET6, NULL);
 	g_return_val_if_fail (addr != NULL, NULL);
 
-	if (!valid_ip (family, addr, error))
+	if (!parse_ip (family, addr, addr_bytes, error))
 		return NULL;
 	if (!valid_prefix (family, prefix, error, FALSE))
 		return NULL;
@@ -159,7 +181,7 @@ nm_ip_address_new (int family,
 	address->refcount = 1;
 
 	address->family = family;
-	address->address = canonicalize_ip (family, addr, FALSE);
+	memcpy (&address->address, addr_bytes, addr_len (family));
 	address->prefix = prefix;
 
 	return address;
@@ -184,7 +206,6 @@ nm_ip_address_new_binary (int family,
                           GError **error)
 {
 	NMIPAddress *address;
-	char string[NM_UTILS_INET_ADDRSTRLEN];
 
 	g_return_val_if_fail (family == AF_INET || family == AF_INET6, NULL);
 	g_return_val_if_fail (addr != NULL, NULL);
@@ -196,7 +217,7 @@ nm_ip_address_new_binary (int family,
 	address->refcount = 1;
 
 	address->family = family;
-	address->address = g_strdup (inet_ntop (family, addr, string, sizeof (string)));
+	memcpy (&address->address, addr, addr_len (family));
 	address->prefix = prefix;
 
 	return address;
@@ -232,7 +253,7 @@ nm_ip_address_unref (NMIPAddress *address)
 
 	address->refcount--;
 	if (address->refcount == 0) {
-		g_free (address->address);
+		g_free (address->address_str);
 		if (address->attributes)
 			g_hash_table_unref (address->attributes);
 		g_slice_free (NMIPAddress, address);
@@ -260,7 +281,7 @@ nm_ip_address_equal (NMIPAddress *address, NMIPAddress *other)
 
 	if (   address->family != other->family
 	    || address->prefix != other->prefix
-	    || strcmp (address->address, other->address) != 0)
+	    || memcmp (&address->address, &other->address, addr_len (address->family)) != 0)
 		return FALSE;
 	return TRUE;
 }
@@ -281,9 +302,9 @@ nm_ip_address_dup (NMIPAddress *address)
 	g_return_val_if_fail (address != NULL, NULL);
 	g_return_val_if_fail (address->refcount > 0, NULL);
 
-	copy = nm_ip_address_new (address->family,
-	                          address->address, address->prefix,
-	                          NULL);
+	copy = nm_ip_address_new_binary (address->family,
+	                                 &address->address, address->prefix,
+	                                 NULL);
 	if (address->attributes) {
 		GHashTableIter iter;
 		const char *key;
@@ -329,7 +350,9 @@ nm_ip_address_get_address (NMIPAddress *address)
 	g_return_val_if_fail (address != NULL, NULL);
 	g_return_val_if_fail (address->refcount > 0, NULL);
 
-	return address->address;
+	if (!address->address_str)
+		address->address_str = addr_to_string (address->family, &address->address);
+	return address->address_str;
 }
 
 /**
@@ -346,12 +369,14 @@ void
 nm_ip_address_set_address (NMIPAddress *address,
                            const char *addr)
 {
+	guint8 addr_bytes[sizeof (struct in6_addr)];
+
 	g_return_if_fail (address != NULL);
 	g_return_if_fail (addr != NULL);
-	g_return_if_fail (nm_utils_ipaddr_valid (address->family, addr));
+	if (!parse_ip (address->family, addr, addr_bytes, NULL))
+		g_return_if_reached ();
 
-	g_free (address->address);
-	address->address = canonicalize_ip (address->family, addr, FALSE);
+	nm_ip_address_set_address_binary (address, addr_bytes);
 }
 
 /**
@@ -370,7 +395,7 @@ nm_ip_address_get_address_binary (NMIPAddress *address,
 	g_return_if_fail (address != NULL);
 	g_return_if_fail (addr != NULL);
 
-	inet_pton (address->family, address->address, addr);
+	memcpy (addr, &address->address, addr_len (address->family));
 }
 
 /**
@@ -386,13 +411,11 @@ void
 nm_ip_address_set_address_binary (NMIPAddress *address,
                                   gconstpointer addr)
 {
-	char string[NM_UTILS_INET_ADDRSTRLEN];
-
 	g_return_if_fail (address != NULL);
 	g_return_if_fail (addr != NULL);
 
-	g_free (address->address);
-	address->address = g_strdup (inet_ntop (address->family, addr, string, sizeof (string)));
+	memcpy (&address->address, addr, addr_len (address->family));
+	g_clear_pointer (&address->address_str, g_free);
 }
 
 /**
@@ -510,14 +533,21 @@ nm_ip_address_set_attribute (NMIPAddress *address, const char *name, GVariant *v
 
 G_DEFINE_BOXED_TYPE (NMIPRoute, nm_ip_route, nm_ip_route_dup, nm_ip_route_unref)
 
+/* Like NMIPAddress, destination and next hop are stored in binary form
+ * and their strings are formatted on demand. */
 struct NMIPRoute {
 	guint refcount;
 
 	int family;
-	char *dest;
 	guint prefix;
-	char *next_hop;
+	gboolean has_next_hop;
 	gint64 metric;
+	union {
+		struct in_addr addr4;
+		struct in6_addr addr6;
+	} dest, next_hop;
+	char *dest_str;
+	char *next_hop_str;
 
 	GHashTable *attributes;
 };
@@ -545,25 +575,34 @@ nm_ip_route_new (int family,
                  GError **error)
 {
 	NMIPRoute *route;
+	guint8 dest_bytes[sizeof (struct in6_addr)];
+	guint8 next_hop_bytes[sizeof (struct in6_addr)];
 
 	g_return_val_if_fail (family == AF_INET || family == AF_INET6, NULL);
 
-	if (!valid_ip (family, dest, error))
+	if (!parse_ip (family, dest, dest_bytes, error))
 		return NULL;
 	if (!valid_prefix (family, prefix, error, TRUE))
 		return NULL;
-	if (next_hop && !valid_ip (family, next_hop, error))
+	if (next_hop && !parse_ip (family, next_hop, next_hop_bytes, error))
 		return NULL;
 	if (!valid_metric (metric, error))
 		return NULL;
 
+	/* A next hop of "any" means no next hop */
+	if (next_hop && !memcmp (next_hop_bytes, &in6addr_any, addr_len (family)))
+		next_hop = NULL;
+
 	route = g_slice_new0 (NMIPRoute);
 	route->refcount = 1;
 
 	route->family = family;
-	route->dest = canonicalize_ip (family, dest, FALSE);
+	memcpy (&route->dest, dest_bytes, addr_len (family));
 	route->prefix = prefix;
-	route->next_hop = canonicalize_ip (family, next_hop, TRUE);
+	if (next_hop) {
+		memcpy (&route->next_hop, next_hop_bytes, addr_len (family));
+		route->has_next_hop = TRUE;
+	}
 	route->metric = metric;
 
 	return route;
@@ -593,7 +632,6 @@ nm_ip_route_new_binary (int family,
                         GError **error)
 {
 	NMIPRoute *route;
-	char string[NM_UTILS_INET_ADDRSTRLEN];
 
 	g_return_val_if_fail (family == AF_INET || family == AF_INET6, NULL);
 
@@ -606,10 +644,12 @@ nm_ip_route_new_binary (int family,
 	route->refcount = 1;
 
 	route->family = family;
-	route->dest = g_strdup (inet_ntop (family, dest, string, sizeof (string)));
+	memcpy (&route->dest, dest, addr_len (family));
 	route->prefix = prefix;
-	if (next_hop)
-		route->next_hop = g_strdup (inet_ntop (family, next_hop, string, sizeof (string)));
+	if (next_hop) {
+		memcpy (&route->next_hop, next_hop, addr_len (family));
+		route->has_next_hop = TRUE;
+	}
 	route->metric = metric;
 
 	return route;
@@ -645,8 +685,8 @@ nm_ip_route_unref (NMIPRoute *route)
 
 	route->refcount--;
 	if (route->refcount == 0) {
-		g_free (route->dest);
-		g_free (route->next_hop);
+		g_free (route->dest_str);
+		g_free (route->next_hop_str);
 		if (route->attributes)
 			g_hash_table_unref (route->attributes);
 		g_slice_free (NMIPRoute, route);
@@ -674,8 +714,10 @@ nm_ip_route_equal (NMIPRoute *route, NMIPRoute *other)
 
 	if (   route->prefix != other->prefix
 	    || route->metric != other->metric
-	    || strcmp (route->dest, other->dest) != 0
-	    || g_strcmp0 (route->next_hop, other->next_hop) != 0)
+	    || route->has_next_hop != other->has_next_hop
+	    || memcmp (&route->dest, &other->dest, addr_len (route->family)) != 0
+	    || (   route->has_next_hop
+	        && memcmp (&route->next_hop, &other->next_hop, addr_len (route->family)) != 0))
 		return FALSE;
 	return TRUE;
 }
@@ -696,10 +738,11 @@ nm_ip_route_dup (NMIPRoute *route)
 	g_return_val_if_fail (route != NULL, NULL);
 	g_return_val_if_fail (route->refcount > 0, NULL);
 
-	copy = nm_ip_route_new (route->family,
-	                        route->dest, route->prefix,
-	                        route->next_hop, route->metric,
-	                        NULL);
+	copy = nm_ip_route_new_binary (route->family,
+	                               &route->dest, route->prefix,
+	                               route->has_next_hop ? &route->next_hop : NULL,
+	                               route->metric,
+	                               NULL);
 	if (route->attributes) {
 		GHashTableIter iter;
 		const char *key;
@@ -745,7 +788,9 @@ nm_ip_route_get_dest (NMIPRoute *route)
 	g_return_val_if_fail (route != NULL, NULL);
 	g_return_val_if_fail (route->refcount > 0, NULL);
 
-	return route->dest;
+	if (!route->dest_str)
+		route->dest_str = addr_to_string (route->family, &route->dest);
+	return route->dest_str;
 }
 
 /**
@@ -762,12 +807,14 @@ void
 nm_ip_route_set_dest (NMIPRoute *route,
                       const char *dest)
 {
+	guint8 dest_bytes[sizeof (struct in6_addr)];
+
 	g_return_if_fail (route != NULL);
 	g_return_if_fail (dest != NULL);
-	g_return_if_fail (nm_utils_ipaddr_valid (route->family, dest));
+	if (!parse_ip (route->family, dest, dest_bytes, NULL))
+		g_return_if_reached ();
 
-	g_free (route->dest);
-	route->dest = canonicalize_ip (route->family, dest, FALSE);
+	nm_ip_route_set_dest_binary (route, dest_bytes);
 }
 
 /**
@@ -786,7 +833,7 @@ nm_ip_route_get_dest_binary (NMIPRoute *route,
 	g_return_if_fail (route != NULL);
 	g_return_if_fail (dest != NULL);
 
-	inet_pton (route->family, route->dest, dest);
+	memcpy (dest, &route->dest, addr_len (route->family));
 }
 
 /**
@@ -802,13 +849,11 @@ void
 nm_ip_route_set_dest_binary (NMIPRoute *route,
                              gconstpointer dest)
 {
-	char string[NM_UTILS_INET_ADDRSTRLEN];
-
 	g_return_if_fail (route != NULL);
 	g_return_if_fail (dest != NULL);
 
-	g_free (route->dest);
-	route->dest = g_strdup (inet_ntop (route->family, dest, string, sizeof (string)));
+	memcpy (&route->dest, dest, addr_len (route->family));
+	g_clear_pointer (&route->dest_str, g_free);
 }
 
 /**
@@ -860,7 +905,11 @@ nm_ip_route_get_next_hop (NMIPRoute *route)
 	g_return_val_if_fail (route != NULL, NULL);
 	g_return_val_if_fail (route->refcount > 0, NULL);
 
-	return route->next_hop;
+	if (!route->has_next_hop)
+		return NULL;
+	if (!route->next_hop_str)
+		route->next_hop_str = addr_to_string (route->family, &route->next_hop);
+	return route->next_hop_str;
 }
 
 /**
@@ -878,11 +927,17 @@ void
 nm_ip_route_set_next_hop (NMIPRoute *route,
                           const char *next_hop)
 {
+	guint8 next_hop_bytes[sizeof (struct in6_addr)];
+
 	g_return_if_fail (route != NULL);
-	g_return_if_fail (!next_hop || nm_utils_ipaddr_valid (route->family, next_hop));
+	if (next_hop && !parse_ip (route->family, next_hop, next_hop_bytes, NULL))
+		g_return_if_reached ();
 
-	g_free (route->next_hop);
-	route->next_hop = canonicalize_ip (route->family, next_hop, TRUE);
+	/* A next hop of "any" means no next hop */
+	if (next_hop && !memcmp (next_hop_bytes, &in6addr_any, addr_len (route->family)))
+		next_hop = NULL;
+
+	nm_ip_route_set_next_hop_binary (route, next_hop ? next_hop_bytes : NULL);
 }
 
 /**
@@ -904,12 +959,11 @@ nm_ip_route_get_next_hop_binary (NMIPRoute *route,
 	g_return_val_if_fail (route != NULL, FALSE);
 	g_return_val_if_fail (next_hop != NULL, FALSE);
 
-	if (route->next_hop) {
-		inet_pton (route->family, route->next_hop, next_hop);
+	if (route->has_next_hop) {
+		memcpy (next_hop, &route->next_hop, addr_len (route->family));
 		return TRUE;
 	} else {
-		memset (next_hop, 0,
-		        route->family == AF_INET ? sizeof (struct in_addr) : sizeof (struct in6_addr));
+		memset (next_hop, 0, addr_len (route->family));
 		return FALSE;
 	}
 }
@@ -928,15 +982,16 @@ void
 nm_ip_route_set_next_hop_binary (NMIPRoute *route,
                                  gconstpointer next_hop)
 {
-	char string[NM_UTILS_INET_ADDRSTRLEN];
-
 	g_return_if_fail (route != NULL);
 
-	g_free (route->next_hop);
-	if (next_hop)
-		route->next_hop = g_strdup (inet_ntop (route->family, next_hop, string, sizeof (string)));
-	else
-		route->next_hop = NULL;
+	g_clear_pointer (&route->next_hop_str, g_free);
+	if (next_hop) {
+		memcpy (&route->next_hop, next_hop, addr_len (route->family));
+		route->has_next_hop = TRUE;
+	} else {
+		memset (&route->next_hop, 0, sizeof (route->next_hop));
+		route->has_next_hop = FALSE;
+	}
 }
 
 /**
@@ -108,6 +108,12 @@ GVariant   *_nm_setting_to_dbus       (NMSetting *setting,
                                        NMConnection *connection,
                                        NMConnectionSerializationFlags flags);
 
+void        _nm_setting_add_owner     (NMSetting *setting);
+void        _nm_setting_remove_owner  (NMSetting *setting);
+gboolean    _nm_setting_is_shared     (NMSetting *setting);
+
+gboolean    _nm_setting_has_secret_properties (NMSetting *setting);
+
 NMSetting  *_nm_setting_new_from_dbus (GType setting_type,
                                        GVariant *setting_dict,
                                        GVariant *connection_dict,
@@ -132,6 +138,8 @@ void _nm_setting_class_add_dbus_only_property (NMSettingClass *setting_class,
                                                NMSettingPropertySynthFunc synth_func,
                                                NMSettingPropertySetFunc set_func);
 
+void _nm_setting_class_set_dbus_uses_connection (NMSettingClass *setting_class);
+
 void _nm_setting_class_override_property (NMSettingClass *setting_class,
                                           const char *property_name,
                                           const GVariantType *dbus_type,
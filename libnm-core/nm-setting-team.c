@@ -183,4 +183,5 @@ nm_setting_team_class_init (NMSettingTeamClass *setting_class)
 	                                          G_VARIANT_TYPE_STRING,
 	                                          _nm_setting_get_deprecated_virtual_interface_name,
 	                                          NULL);
+	_nm_setting_class_set_dbus_uses_connection (parent_class);
 }
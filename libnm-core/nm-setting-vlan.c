@@ -490,8 +490,8 @@ verify (NMSetting *setting, NMConnection *connection, GError **error)
 	NMSettingWired *s_wired;
 
 	if (connection) {
-		s_con = nm_connection_get_setting_connection (connection);
-		s_wired = nm_connection_get_setting_wired (connection);
+		s_con = (NMSettingConnection *) _nm_connection_peek_setting (connection, NM_TYPE_SETTING_CONNECTION);
+		s_wired = (NMSettingWired *) _nm_connection_peek_setting (connection, NM_TYPE_SETTING_WIRED);
 	} else {
 		s_con = NULL;
 		s_wired = NULL;
@@ -819,4 +819,5 @@ nm_setting_vlan_class_init (NMSettingVlanClass *setting_class)
 	                                          G_VARIANT_TYPE_STRING,
 	                                          _nm_setting_get_deprecated_virtual_interface_name,
 	                                          NULL);
+	_nm_setting_class_set_dbus_uses_connection (parent_class);
 }
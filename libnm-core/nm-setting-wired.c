@@ -53,6 +53,7 @@ typedef struct {
 	char *device_mac_address;
 	char *cloned_mac_address;
 	GArray *mac_address_blacklist;
+	NMUtilsHwaddrCache hwaddr_cache;
 	guint32 mtu;
 	char **s390_subchannels;
 	char *s390_nettype;
@@ -267,6 +268,7 @@ nm_setting_wired_add_mac_blacklist_item (NMSettingWired *setting, const char *ma
 
 	mac = nm_utils_hwaddr_canonical (mac, ETH_ALEN);
 	g_array_append_val (priv->mac_address_blacklist, mac);
+	_nm_utils_hwaddr_cache_clear (&priv->hwaddr_cache);
 	g_object_notify (G_OBJECT (setting), NM_SETTING_WIRED_MAC_ADDRESS_BLACKLIST);
 	return TRUE;
 }
@@ -289,6 +291,7 @@ nm_setting_wired_remove_mac_blacklist_item (NMSettingWired *setting, guint32 idx
 	g_return_if_fail (idx < priv->mac_address_blacklist->len);
 
 	g_array_remove_index (priv->mac_address_blacklist, idx);
+	_nm_utils_hwaddr_cache_clear (&priv->hwaddr_cache);
 	g_object_notify (G_OBJECT (setting), NM_SETTING_WIRED_MAC_ADDRESS_BLACKLIST);
 }
 
@@ -317,6 +320,7 @@ nm_setting_wired_remove_mac_blacklist_item_by_value (NMSettingWired *setting, co
 		candidate = g_array_index (priv->mac_address_blacklist, char *, i);
 		if (!nm_utils_hwaddr_matches (mac, -1, candidate, -1)) {
 			g_array_remove_index (priv->mac_address_blacklist, i);
+			_nm_utils_hwaddr_cache_clear (&priv->hwaddr_cache);
 			g_object_notify (G_OBJECT (setting), NM_SETTING_WIRED_MAC_ADDRESS_BLACKLIST);
 			return TRUE;
 		}
@@ -333,12 +337,47 @@ nm_setting_wired_remove_mac_blacklist_item_by_value (NMSettingWired *setting, co
 void
 nm_setting_wired_clear_mac_blacklist_items (NMSettingWired *setting)
 {
+	NMSettingWiredPrivate *priv;
+
 	g_return_if_fail (NM_IS_SETTING_WIRED (setting));
 
-	g_array_set_size (NM_SETTING_WIRED_GET_PRIVATE (setting)->mac_address_blacklist, 0);
+	priv = NM_SETTING_WIRED_GET_PRIVATE (setting);
+	g_array_set_size (priv->mac_address_blacklist, 0);
+	_nm_utils_hwaddr_cache_clear (&priv->hwaddr_cache);
 	g_object_notify (G_OBJECT (setting), NM_SETTING_WIRED_MAC_ADDRESS_BLACKLIST);
 }
 
+static const NMUtilsHwaddrCache *
+hwaddr_cache_get (NMSettingWired *setting)
+{
+	NMSettingWiredPrivate *priv = NM_SETTING_WIRED_GET_PRIVATE (setting);
+
+	_nm_utils_hwaddr_cache_ensure (&priv->hwaddr_cache, ETH_ALEN,
+	                               priv->device_mac_address,
+	                               (const char * const *) priv->mac_address_blacklist->data);
+	return &priv->hwaddr_cache;
+}
+
+/* Returns %TRUE if #NMSettingWired:mac-address is unset or equal to the
+ * binary address @hwaddr.  The setting's address is parsed only once. */
+gboolean
+_nm_setting_wired_mac_address_matches (NMSettingWired *setting, const guint8 *hwaddr)
+{
+	g_return_val_if_fail (NM_IS_SETTING_WIRED (setting), FALSE);
+
+	return _nm_utils_hwaddr_cache_mac_matches (hwaddr_cache_get (setting), ETH_ALEN, hwaddr);
+}
+
+/* Returns %TRUE if the binary address @hwaddr is in
+ * #NMSettingWired:mac-address-blacklist. */
+gboolean
+_nm_setting_wired_mac_address_blacklisted (NMSettingWired *setting, const guint8 *hwaddr)
+{
+	g_return_val_if_fail (NM_IS_SETTING_WIRED (setting), TRUE);
+
+	return _nm_utils_hwaddr_cache_blacklisted (hwaddr_cache_get (setting), ETH_ALEN, hwaddr);
+}
+
 /**
  * nm_setting_wired_get_mtu:
  * @setting: the #NMSettingWired
@@ -692,6 +731,7 @@ finalize (GObject *object)
 	g_free (priv->device_mac_address);
 	g_free (priv->cloned_mac_address);
 	g_array_unref (priv->mac_address_blacklist);
+	_nm_utils_hwaddr_cache_clear (&priv->hwaddr_cache);
 
 	if (priv->s390_subchannels)
 		g_strfreev (priv->s390_subchannels);
@@ -727,6 +767,7 @@ set_property (GObject *object, guint prop_id,
 		g_free (priv->device_mac_address);
 		priv->device_mac_address = _nm_utils_hwaddr_canonical_or_invalid (g_value_get_string (value),
 		                                                                  ETH_ALEN);
+		_nm_utils_hwaddr_cache_clear (&priv->hwaddr_cache);
 		break;
 	case PROP_CLONED_MAC_ADDRESS:
 		g_free (priv->cloned_mac_address);
@@ -736,6 +777,7 @@ set_property (GObject *object, guint prop_id,
 	case PROP_MAC_ADDRESS_BLACKLIST:
 		blacklist = g_value_get_boxed (value);
 		g_array_set_size (priv->mac_address_blacklist, 0);
+		_nm_utils_hwaddr_cache_clear (&priv->hwaddr_cache);
 		if (blacklist && *blacklist) {
 			for (i = 0; blacklist[i]; i++) {
 				mac = _nm_utils_hwaddr_canonical_or_invalid (blacklist[i], ETH_ALEN);
@@ -30,6 +30,7 @@
 #include "nm-utils.h"
 #include "nm-utils-private.h"
 #include "nm-setting-private.h"
+#include "nm-connection-private.h"
 #include "nm-setting-wireless.h"
 
 /**
@@ -905,7 +906,7 @@ verify (NMSetting *setting, NMConnection *connection, GError **error)
 		if (   (strcmp (priv->key_mgmt, "ieee8021x") == 0)
 		    || (strcmp (priv->key_mgmt, "wpa-eap") == 0)) {
 			/* Need an 802.1x setting too */
-			if (connection && !nm_connection_get_setting_802_1x (connection)) {
+			if (connection && !_nm_connection_peek_setting (connection, NM_TYPE_SETTING_802_1X)) {
 				g_set_error (error,
 				             NM_CONNECTION_ERROR,
 				             NM_CONNECTION_ERROR_MISSING_SETTING,
@@ -31,6 +31,7 @@
 #include "nm-utils.h"
 #include "nm-utils-private.h"
 #include "nm-setting-private.h"
+#include "nm-connection-private.h"
 
 /**
  * SECTION:nm-setting-wireless
@@ -57,6 +58,7 @@ typedef struct {
 	char *device_mac_address;
 	char *cloned_mac_address;
 	GArray *mac_address_blacklist;
+	NMUtilsHwaddrCache hwaddr_cache;
 	guint32 mtu;
 	GSList *seen_bssids;
 	gboolean hidden;
@@ -503,6 +505,7 @@ nm_setting_wireless_add_mac_blacklist_item (NMSettingWireless *setting, const ch
 
 	mac = nm_utils_hwaddr_canonical (mac, ETH_ALEN);
 	g_array_append_val (priv->mac_address_blacklist, mac);
+	_nm_utils_hwaddr_cache_clear (&priv->hwaddr_cache);
 	g_object_notify (G_OBJECT (setting), NM_SETTING_WIRELESS_MAC_ADDRESS_BLACKLIST);
 	return TRUE;
 }
@@ -525,6 +528,7 @@ nm_setting_wireless_remove_mac_blacklist_item (NMSettingWireless *setting, guint
 	g_return_if_fail (idx < priv->mac_address_blacklist->len);
 
 	g_array_remove_index (priv->mac_address_blacklist, idx);
+	_nm_utils_hwaddr_cache_clear (&priv->hwaddr_cache);
 	g_object_notify (G_OBJECT (setting), NM_SETTING_WIRELESS_MAC_ADDRESS_BLACKLIST);
 }
 
@@ -553,6 +557,7 @@ nm_setting_wireless_remove_mac_blacklist_item_by_value (NMSettingWireless *setti
 		candidate = g_array_index (priv->mac_address_blacklist, char *, i);
 		if (!nm_utils_hwaddr_matches (mac, -1, candidate, -1)) {
 			g_array_remove_index (priv->mac_address_blacklist, i);
+			_nm_utils_hwaddr_cache_clear (&priv->hwaddr_cache);
 			g_object_notify (G_OBJECT (setting), NM_SETTING_WIRELESS_MAC_ADDRESS_BLACKLIST);
 			return TRUE;
 		}
@@ -569,12 +574,47 @@ nm_setting_wireless_remove_mac_blacklist_item_by_value (NMSettingWireless *setti
 void
 nm_setting_wireless_clear_mac_blacklist_items (NMSettingWireless *setting)
 {
+	NMSettingWirelessPrivate *priv;
+
 	g_return_if_fail (NM_IS_SETTING_WIRELESS (setting));
 
-	g_array_set_size (NM_SETTING_WIRELESS_GET_PRIVATE (setting)->mac_address_blacklist, 0);
+	priv = NM_SETTING_WIRELESS_GET_PRIVATE (setting);
+	g_array_set_size (priv->mac_address_blacklist, 0);
+	_nm_utils_hwaddr_cache_clear (&priv->hwaddr_cache);
 	g_object_notify (G_OBJECT (setting), NM_SETTING_WIRELESS_MAC_ADDRESS_BLACKLIST);
 }
 
+static const NMUtilsHwaddrCache *
+hwaddr_cache_get (NMSettingWireless *setting)
+{
+	NMSettingWirelessPrivate *priv = NM_SETTING_WIRELESS_GET_PRIVATE (setting);
+
+	_nm_utils_hwaddr_cache_ensure (&priv->hwaddr_cache, ETH_ALEN,
+	                               priv->device_mac_address,
+	                               (const char * const *) priv->mac_address_blacklist->data);
+	return &priv->hwaddr_cache;
+}
+
+/* Returns %TRUE if #NMSettingWireless:mac-address is unset or equal to the
+ * binary address @hwaddr.  The setting's address is parsed only once. */
+gboolean
+_nm_setting_wireless_mac_address_matches (NMSettingWireless *setting, const guint8 *hwaddr)
+{
+	g_return_val_if_fail (NM_IS_SETTING_WIRELESS (setting), FALSE);
+
+	return _nm_utils_hwaddr_cache_mac_matches (hwaddr_cache_get (setting), ETH_ALEN, hwaddr);
+}
+
+/* Returns %TRUE if the binary address @hwaddr is in
+ * #NMSettingWireless:mac-address-blacklist. */
+gboolean
+_nm_setting_wireless_mac_address_blacklisted (NMSettingWireless *setting, const guint8 *hwaddr)
+{
+	g_return_val_if_fail (NM_IS_SETTING_WIRELESS (setting), TRUE);
+
+	return _nm_utils_hwaddr_cache_blacklisted (hwaddr_cache_get (setting), ETH_ALEN, hwaddr);
+}
+
 /**
  * nm_setting_wireless_get_mtu:
  * @setting: the #NMSettingWireless
@@ -827,7 +867,7 @@ nm_setting_wireless_get_security (NMSetting    *setting,
                                   NMConnection *connection,
                                   const char   *property_name)
 {
-	if (nm_connection_get_setting_wireless_security (connection))
+	if (_nm_connection_peek_setting (connection, NM_TYPE_SETTING_WIRELESS_SECURITY))
 		return g_variant_new_string (NM_SETTING_WIRELESS_SECURITY_SETTING_NAME);
 	else
 		return NULL;
@@ -863,6 +903,7 @@ finalize (GObject *object)
 	g_free (priv->device_mac_address);
 	g_free (priv->cloned_mac_address);
 	g_array_unref (priv->mac_address_blacklist);
+	_nm_utils_hwaddr_cache_clear (&priv->hwaddr_cache);
 	g_slist_free_full (priv->seen_bssids, g_free);
 
 	G_OBJECT_CLASS (nm_setting_wireless_parent_class)->finalize (object);
@@ -908,6 +949,7 @@ set_property (GObject *object, guint prop_id,
 		g_free (priv->device_mac_address);
 		priv->device_mac_address = _nm_utils_hwaddr_canonical_or_invalid (g_value_get_string (value),
 		                                                                  ETH_ALEN);
+		_nm_utils_hwaddr_cache_clear (&priv->hwaddr_cache);
 		break;
 	case PROP_CLONED_MAC_ADDRESS:
 		g_free (priv->cloned_mac_address);
@@ -917,6 +959,7 @@ set_property (GObject *object, guint prop_id,
 	case PROP_MAC_ADDRESS_BLACKLIST:
 		blacklist = g_value_get_boxed (value);
 		g_array_set_size (priv->mac_address_blacklist, 0);
+		_nm_utils_hwaddr_cache_clear (&priv->hwaddr_cache);
 		if (blacklist && *blacklist) {
 			for (i = 0; blacklist[i]; i++) {
 				mac = _nm_utils_hwaddr_canonical_or_invalid (blacklist[i], ETH_ALEN);
@@ -1373,4 +1416,5 @@ nm_setting_wireless_class_init (NMSettingWirelessClass *setting_class)
 	_nm_setting_class_add_dbus_only_property (parent_class, "security",
 	                                          G_VARIANT_TYPE_STRING,
 	                                          nm_setting_wireless_get_security, NULL);
+	_nm_setting_class_set_dbus_uses_connection (parent_class);
 }
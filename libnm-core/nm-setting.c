@@ -28,6 +28,7 @@
 
 #include "nm-setting.h"
 #include "nm-setting-private.h"
+#include "nm-connection-private.h"
 #include "nm-utils.h"
 #include "nm-core-internal.h"
 #include "nm-utils-private.h"
@@ -66,6 +67,14 @@ typedef struct {
 
 typedef struct {
 	const SettingInfo *info;
+
+	/* Number of connections holding the setting; more than one for
+	 * settings shared with a copy-on-write clone. */
+	guint n_owners;
+
+	/* _nm_setting_to_dbus() result per serialization mode, dropped
+	 * whenever a property changes. */
+	GVariant *dbus_cache[NM_CONNECTION_SERIALIZE_ONLY_SECRETS + 1];
 } NMSettingPrivate;
 
 enum {
@@ -303,6 +312,7 @@ typedef struct {
 
 static GQuark setting_property_overrides_quark;
 static GQuark setting_properties_quark;
+static GQuark setting_dbus_uses_connection_quark;
 
 static NMSettingProperty *
 find_property (GArray *properties, const char *name)
@@ -401,6 +411,24 @@ _nm_setting_class_add_dbus_only_property (NMSettingClass *setting_class,
 	                       NULL, NULL);
 }
 
+/**
+ * _nm_setting_class_set_dbus_uses_connection:
+ * @setting_class: the setting class
+ *
+ * Marks @setting_class as having a D-Bus only property whose synth_func
+ * looks at other settings of the connection.  The D-Bus representation of
+ * such settings cannot be cached on the setting itself.
+ */
+void
+_nm_setting_class_set_dbus_uses_connection (NMSettingClass *setting_class)
+{
+	g_return_if_fail (NM_IS_SETTING_CLASS (setting_class));
+
+	g_type_set_qdata (G_TYPE_FROM_CLASS (setting_class),
+	                  setting_dbus_uses_connection_quark,
+	                  GUINT_TO_POINTER (TRUE));
+}
+
 /**
  * _nm_setting_class_override_property:
  * @setting_class: the setting class
@@ -707,19 +735,30 @@ set_property_from_dbus (const NMSettingProperty *property,
  * mapping each setting property name to a value describing that property,
  * suitable for marshalling over D-Bus or serializing.
  *
- * Returns: (transfer none): a new floating #GVariant describing the setting's
- * properties
+ * The result is cached on @setting until one of its properties changes,
+ * unless the setting class synthesizes properties from @connection.
+ *
+ * Returns: (transfer full): a #GVariant describing the setting's properties
  **/
 GVariant *
 _nm_setting_to_dbus (NMSetting *setting, NMConnection *connection, NMConnectionSerializationFlags flags)
 {
+	NMSettingPrivate *priv;
 	GVariantBuilder builder;
-	GVariant *dbus_value;
+	GVariant *dbus_value, **cached = NULL;
 	const NMSettingProperty *properties;
 	guint n_properties, i;
 
 	g_return_val_if_fail (NM_IS_SETTING (setting), NULL);
 
+	priv = NM_SETTING_GET_PRIVATE (setting);
+	if (   flags < G_N_ELEMENTS (priv->dbus_cache)
+	    && !g_type_get_qdata (G_OBJECT_TYPE (setting), setting_dbus_uses_connection_quark)) {
+		cached = &priv->dbus_cache[flags];
+		if (*cached)
+			return g_variant_ref (*cached);
+	}
+
 	properties = nm_setting_class_get_properties (NM_SETTING_GET_CLASS (setting), &n_properties);
 
 	g_variant_builder_init (&builder, NM_VARIANT_TYPE_SETTING);
@@ -761,7 +800,10 @@ _nm_setting_to_dbus (NMSetting *setting, NMConnection *connection, NMConnectionS
 		}
 	}
 
-	return g_variant_builder_end (&builder);
+	dbus_value = g_variant_ref_sink (g_variant_builder_end (&builder));
+	if (cached)
+		*cached = g_variant_ref (dbus_value);
+	return dbus_value;
 }
 
 /**
@@ -1773,7 +1815,7 @@ _nm_setting_get_deprecated_virtual_interface_name (NMSetting *setting,
 {
 	NMSettingConnection *s_con;
 
-	s_con = nm_connection_get_setting_connection (connection);
+	s_con = (NMSettingConnection *) _nm_connection_peek_setting (connection, NM_TYPE_SETTING_CONNECTION);
 	g_return_val_if_fail (s_con != NULL, NULL);
 
 	if (nm_setting_connection_get_interface_name (s_con))
@@ -1784,6 +1826,54 @@ _nm_setting_get_deprecated_virtual_interface_name (NMSetting *setting,
 
 /*****************************************************************************/
 
+/* Copy-on-write bookkeeping for NMConnection */
+void
+_nm_setting_add_owner (NMSetting *setting)
+{
+	NM_SETTING_GET_PRIVATE (setting)->n_owners++;
+}
+
+void
+_nm_setting_remove_owner (NMSetting *setting)
+{
+	NMSettingPrivate *priv = NM_SETTING_GET_PRIVATE (setting);
+
+	g_return_if_fail (priv->n_owners > 0);
+	priv->n_owners--;
+}
+
+gboolean
+_nm_setting_is_shared (NMSetting *setting)
+{
+	return NM_SETTING_GET_PRIVATE (setting)->n_owners > 1;
+}
+
+gboolean
+_nm_setting_has_secret_properties (NMSetting *setting)
+{
+	const NMSettingProperty *properties;
+	guint n_properties, i;
+
+	properties = nm_setting_class_get_properties (NM_SETTING_GET_CLASS (setting), &n_properties);
+	for (i = 0; i < n_properties; i++) {
+		if (   properties[i].param_spec
+		    && (properties[i].param_spec->flags & NM_SETTING_PARAM_SECRET))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+dbus_cache_clear (NMSettingPrivate *priv)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (priv->dbus_cache); i++)
+		g_clear_pointer (&priv->dbus_cache[i], g_variant_unref);
+}
+
+/*****************************************************************************/
+
 static void
 nm_setting_init (NMSetting *setting)
 {
@@ -1797,6 +1887,22 @@ constructed (GObject *object)
 	G_OBJECT_CLASS (nm_setting_parent_class)->constructed (object);
 }
 
+static void
+dispatch_properties_changed (GObject *object, guint n_pspecs, GParamSpec **pspecs)
+{
+	dbus_cache_clear (NM_SETTING_GET_PRIVATE (object));
+
+	G_OBJECT_CLASS (nm_setting_parent_class)->dispatch_properties_changed (object, n_pspecs, pspecs);
+}
+
+static void
+finalize (GObject *object)
+{
+	dbus_cache_clear (NM_SETTING_GET_PRIVATE (object));
+
+	G_OBJECT_CLASS (nm_setting_parent_class)->finalize (object);
+}
+
 static void
 get_property (GObject *object, guint prop_id,
               GValue *value, GParamSpec *pspec)
@@ -1822,12 +1928,16 @@ nm_setting_class_init (NMSettingClass *setting_class)
 		setting_property_overrides_quark = g_quark_from_static_string ("nm-setting-property-overrides");
 	if (!setting_properties_quark)
 		setting_properties_quark = g_quark_from_static_string ("nm-setting-properties");
+	if (!setting_dbus_uses_connection_quark)
+		setting_dbus_uses_connection_quark = g_quark_from_static_string ("nm-setting-dbus-uses-connection");
 
 	g_type_class_add_private (setting_class, sizeof (NMSettingPrivate));
 
 	/* virtual methods */
 	object_class->constructed  = constructed;
 	object_class->get_property = get_property;
+	object_class->dispatch_properties_changed = dispatch_properties_changed;
+	object_class->finalize     = finalize;
 
 	setting_class->update_one_secret = update_one_secret;
 	setting_class->get_secret_flags = get_secret_flags;
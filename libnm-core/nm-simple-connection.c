@@ -23,6 +23,7 @@
 
 #include "nm-simple-connection.h"
 #include "nm-setting-private.h"
+#include "nm-connection-private.h"
 
 static void nm_simple_connection_interface_init (NMConnectionInterface *iface);
 
@@ -101,6 +102,40 @@ nm_simple_connection_new_clone (NMConnection *connection)
 	return clone;
 }
 
+/**
+ * _nm_simple_connection_new_clone_shared:
+ * @connection: the #NMConnection to clone
+ *
+ * Like nm_simple_connection_new_clone(), but the clone initially shares
+ * @connection's setting objects instead of copying them.  A setting is only
+ * copied once it is requested through nm_connection_get_setting() (on either
+ * connection), or its secrets are updated or cleared.  Callers must not keep
+ * setting pointers of @connection from before the clone and modify them
+ * afterwards.
+ *
+ * This makes it cheap to clone a connection only to strip its secrets and
+ * serialize it.  The clone should be short-lived: while it exists, reading
+ * a setting of @connection through nm_connection_get_setting() replaces it
+ * with a copy.  Use nm_simple_connection_new_clone() for copies that are
+ * kept around.
+ *
+ * Returns: (transfer full): a new #NMConnection sharing the settings of
+ * @connection
+ **/
+NMConnection *
+_nm_simple_connection_new_clone_shared (NMConnection *connection)
+{
+	NMConnection *clone;
+
+	g_return_val_if_fail (NM_IS_CONNECTION (connection), NULL);
+
+	clone = nm_simple_connection_new ();
+	nm_connection_set_path (clone, nm_connection_get_path (connection));
+	_nm_connection_share_settings (clone, connection);
+
+	return clone;
+}
+
 static void
 dispose (GObject *object)
 {
@@ -48,4 +48,28 @@ char **     _nm_utils_ptrarray_to_strv (GPtrArray *ptrarray);
 
 char *      _nm_utils_hwaddr_canonical_or_invalid (const char *mac, gssize length);
 
+/* Binary form of a setting's MAC address and MAC address blacklist, so
+ * that matching devices against connections does not parse strings. */
+typedef struct {
+	gboolean parsed;
+	gboolean has_mac;
+	gboolean mac_invalid;
+	gboolean blacklist_invalid;
+	guint8 mac[NM_UTILS_HWADDR_LEN_MAX];
+	guint8 *blacklist;
+	guint n_blacklist;
+} NMUtilsHwaddrCache;
+
+void        _nm_utils_hwaddr_cache_clear       (NMUtilsHwaddrCache *cache);
+void        _nm_utils_hwaddr_cache_ensure      (NMUtilsHwaddrCache *cache,
+                                                gsize addr_len,
+                                                const char *mac,
+                                                const char * const *blacklist);
+gboolean    _nm_utils_hwaddr_cache_mac_matches (const NMUtilsHwaddrCache *cache,
+                                                gsize addr_len,
+                                                const guint8 *hwaddr);
+gboolean    _nm_utils_hwaddr_cache_blacklisted (const NMUtilsHwaddrCache *cache,
+                                                gsize addr_len,
+                                                const guint8 *hwaddr);
+
 #endif
@@ -2794,6 +2794,86 @@ _nm_utils_hwaddr_canonical_or_invalid (const char *mac, gssize length)
 		return g_strdup (mac);
 }
 
+void
+_nm_utils_hwaddr_cache_clear (NMUtilsHwaddrCache *cache)
+{
+	g_free (cache->blacklist);
+	memset (cache, 0, sizeof (*cache));
+}
+
+void
+_nm_utils_hwaddr_cache_ensure (NMUtilsHwaddrCache *cache,
+                               gsize addr_len,
+                               const char *mac,
+                               const char * const *blacklist)
+{
+	guint i, n;
+
+	g_return_if_fail (addr_len > 0 && addr_len <= NM_UTILS_HWADDR_LEN_MAX);
+
+	if (cache->parsed)
+		return;
+
+	_nm_utils_hwaddr_cache_clear (cache);
+	cache->parsed = TRUE;
+
+	if (mac) {
+		cache->has_mac = TRUE;
+		cache->mac_invalid = !nm_utils_hwaddr_aton (mac, cache->mac, addr_len);
+	}
+
+	n = blacklist ? g_strv_length ((char **) blacklist) : 0;
+	if (n) {
+		cache->blacklist = g_malloc (n * addr_len);
+		for (i = 0; i < n; i++) {
+			if (nm_utils_hwaddr_aton (blacklist[i], &cache->blacklist[cache->n_blacklist * addr_len], addr_len))
+				cache->n_blacklist++;
+			else
+				cache->blacklist_invalid = TRUE;
+		}
+	}
+}
+
+/* Returns %TRUE if the setting has no MAC address or it is @hwaddr */
+gboolean
+_nm_utils_hwaddr_cache_mac_matches (const NMUtilsHwaddrCache *cache,
+                                    gsize addr_len,
+                                    const guint8 *hwaddr)
+{
+	g_return_val_if_fail (cache->parsed, FALSE);
+
+	if (!cache->has_mac)
+		return TRUE;
+	if (cache->mac_invalid || !hwaddr)
+		return FALSE;
+	return memcmp (cache->mac, hwaddr, addr_len) == 0;
+}
+
+/* Returns %TRUE if @hwaddr is on the blacklist.  A blacklist with invalid
+ * entries should not pass verify() and blacklists everything. */
+gboolean
+_nm_utils_hwaddr_cache_blacklisted (const NMUtilsHwaddrCache *cache,
+                                    gsize addr_len,
+                                    const guint8 *hwaddr)
+{
+	guint i;
+
+	g_return_val_if_fail (cache->parsed, TRUE);
+
+	if (cache->blacklist_invalid) {
+		g_warn_if_reached ();
+		return TRUE;
+	}
+	if (!hwaddr)
+		return FALSE;
+
+	for (i = 0; i < cache->n_blacklist; i++) {
+		if (memcmp (&cache->blacklist[i * addr_len], hwaddr, addr_len) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
 /**
  * nm_utils_hwaddr_matches:
  * @hwaddr1: pointer to a binary or ASCII hardware address, or %NULL
@@ -0,0 +1,112 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2015 Red Hat, Inc.
+ *
+ */
+
+/* Memory use and throughput of NMIPRoute for profiles with many static
+ * routes.
+ *
+ * Usage: benchmark-setting-ip-config [N_ROUTES] [N_ROUNDS]
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "nm-setting-ip4-config.h"
+#include "nm-utils.h"
+
+#include "nm-test-utils.h"
+
+/* Resident set size in kB, from /proc/self/statm */
+static gint64
+rss_kb (void)
+{
+	char *contents = NULL;
+	gint64 pages = 0;
+	char **fields;
+
+	if (!g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+		return 0;
+	fields = g_strsplit (contents, " ", 0);
+	if (fields[0] && fields[1])
+		pages = g_ascii_strtoll (fields[1], NULL, 10);
+	g_strfreev (fields);
+	g_free (contents);
+	return pages * sysconf (_SC_PAGESIZE) / 1024;
+}
+
+int
+main (int argc, char **argv)
+{
+	guint n_routes = nmtst_perf_arg (argc, argv, 1, 20000);
+	guint n_rounds = nmtst_perf_arg (argc, argv, 2, 50);
+	GPtrArray *routes;
+	char dest[NM_UTILS_INET_ADDRSTRLEN], next_hop[NM_UTILS_INET_ADDRSTRLEN];
+	gint64 rss_before, start;
+	guint32 sum = 0;
+	guint i, r;
+
+	nmtst_perf_init (argc, argv);
+
+	rss_before = rss_kb ();
+	start = g_get_monotonic_time ();
+	routes = g_ptr_array_new_with_free_func ((GDestroyNotify) nm_ip_route_unref);
+	for (i = 0; i < n_routes; i++) {
+		g_snprintf (dest, sizeof (dest), "10.%u.%u.0", (i >> 8) & 0xFF, i & 0xFF);
+		g_snprintf (next_hop, sizeof (next_hop), "192.168.%u.1", i & 0xFF);
+		g_ptr_array_add (routes, nm_ip_route_new (AF_INET, dest, 24, next_hop, 100, NULL));
+	}
+	nmtst_perf_report_time ("parse", n_routes, 1, start);
+	nmtst_perf_report ("memory", n_routes, 1, (double) (rss_kb () - rss_before) * 1024 / n_routes, "bytes/item");
+
+	/* What nm_ip4_config_merge_setting() does on every activation */
+	start = g_get_monotonic_time ();
+	for (r = 0; r < n_rounds; r++) {
+		for (i = 0; i < routes->len; i++) {
+			NMIPRoute *route = routes->pdata[i];
+			guint32 d, n = 0;
+
+			nm_ip_route_get_dest_binary (route, &d);
+			nm_ip_route_get_next_hop_binary (route, &n);
+			sum += d ^ n;
+		}
+	}
+	nmtst_perf_report_time ("get-binary", n_routes, n_rounds, start);
+
+	start = g_get_monotonic_time ();
+	for (r = 0; r < n_rounds; r++) {
+		for (i = 1; i < routes->len; i++)
+			sum += nm_ip_route_equal (routes->pdata[i - 1], routes->pdata[i]);
+	}
+	nmtst_perf_report_time ("equal", n_routes, n_rounds, start);
+
+	start = g_get_monotonic_time ();
+	for (i = 0; i < routes->len; i++)
+		sum += strlen (nm_ip_route_get_dest (routes->pdata[i]));
+	nmtst_perf_report_time ("get-string", n_routes, 1, start);
+
+	g_ptr_array_unref (routes);
+
+	/* Keep the loops from being optimized away */
+	return sum == 0xFFFFFFFF ? EXIT_FAILURE : EXIT_SUCCESS;
+}
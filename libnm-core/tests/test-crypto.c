@@ -376,6 +376,78 @@ test_pkcs8 (gconstpointer test_data)
 	g_strfreev (parts);
 }
 
+static void
+copy_cert_file (const char *file, const char *dest)
+{
+	char *path, *contents;
+	gsize len;
+
+	path = g_build_filename (TEST_CERT_DIR, file, NULL);
+	if (!g_file_get_contents (path, &contents, &len, NULL))
+		g_assert_not_reached ();
+	if (!g_file_set_contents (dest, contents, len, NULL))
+		g_assert_not_reached ();
+	g_free (contents);
+	g_free (path);
+}
+
+static void
+test_file_cache (void)
+{
+	char *tmp = g_build_filename (g_get_tmp_dir (), "nm-test-crypto-cache-XXXXXX", NULL);
+	NMCryptoFileFormat format;
+	gboolean is_encrypted;
+	guint hits, hits_before, misses, misses_before;
+	GError *error = NULL;
+	int i, fd;
+
+	fd = g_mkstemp (tmp);
+	g_assert (fd >= 0);
+	close (fd);
+
+	copy_cert_file ("test-cert.p12", tmp);
+	crypto_file_cache_get_stats (&hits_before, &misses_before);
+
+	for (i = 0; i < 3; i++) {
+		g_assert (crypto_is_pkcs12_file (tmp, &error));
+		g_assert_no_error (error);
+
+		is_encrypted = FALSE;
+		format = crypto_verify_private_key (tmp, "test", &is_encrypted, &error);
+		g_assert_no_error (error);
+		g_assert_cmpint (format, ==, NM_CRYPTO_FILE_FORMAT_PKCS12);
+		g_assert (is_encrypted);
+
+		/* Failures are cached per password, including their error */
+		format = crypto_verify_private_key (tmp, "wrong", NULL, &error);
+		g_assert_error (error, NM_CRYPTO_ERROR, NM_CRYPTO_ERROR_DECRYPTION_FAILED);
+		g_assert_cmpint (format, ==, NM_CRYPTO_FILE_FORMAT_UNKNOWN);
+		g_clear_error (&error);
+	}
+
+	crypto_file_cache_get_stats (&hits, &misses);
+	g_assert_cmpint (misses - misses_before, ==, 3);
+	g_assert_cmpint (hits - hits_before, ==, 6);
+
+	/* Replacing the file invalidates the results */
+	copy_cert_file ("test-key-only-decrypted.pem", tmp);
+	g_assert (!crypto_is_pkcs12_file (tmp, &error));
+	g_assert_error (error, NM_CRYPTO_ERROR, NM_CRYPTO_ERROR_INVALID_DATA);
+	g_clear_error (&error);
+
+	is_encrypted = FALSE;
+	format = crypto_verify_private_key (tmp, NULL, &is_encrypted, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (format, ==, NM_CRYPTO_FILE_FORMAT_RAW_KEY);
+	g_assert (!is_encrypted);
+
+	crypto_file_cache_get_stats (&hits, &misses);
+	g_assert_cmpint (misses - misses_before, ==, 5);
+
+	unlink (tmp);
+	g_free (tmp);
+}
+
 #define SALT "sodium chloride"
 #define SHORT_PASSWORD "short"
 #define LONG_PASSWORD "this is a longer password than the short one"
@@ -493,6 +565,7 @@ main (int argc, char **argv)
 	                      test_pkcs8);
 
 	g_test_add_func ("/libnm/crypto/md5", test_md5);
+	g_test_add_func ("/libnm/crypto/file-cache", test_file_cache);
 
 	ret = g_test_run ();
 
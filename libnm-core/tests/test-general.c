@@ -23,10 +23,12 @@
 
 #include <glib.h>
 #include <string.h>
+#include <arpa/inet.h>
 
 #include <nm-utils.h>
 
 #include "nm-setting-private.h"
+#include "nm-connection-private.h"
 #include "nm-utils.h"
 #include "nm-core-internal.h"
 
@@ -527,6 +529,47 @@ test_setting_ip4_config_labels (void)
 	g_object_unref (conn);
 }
 
+static void
+test_setting_ip_route_binary (void)
+{
+	NMIPRoute *route, *copy;
+	NMIPAddress *addr;
+	guint32 bin;
+	struct in6_addr bin6;
+	GError *error = NULL;
+
+	/* Strings are canonicalized and follow binary updates */
+	addr = nm_ip_address_new (AF_INET6, "1234:0:0::5678", 64, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (nm_ip_address_get_address (addr), ==, "1234::5678");
+	inet_pton (AF_INET6, "abcd::1", &bin6);
+	nm_ip_address_set_address_binary (addr, &bin6);
+	g_assert_cmpstr (nm_ip_address_get_address (addr), ==, "abcd::1");
+	nm_ip_address_unref (addr);
+
+	/* An unspecified next hop from a string means no next hop */
+	route = nm_ip_route_new (AF_INET, "10.1.0.0", 16, "0.0.0.0", 100, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (nm_ip_route_get_next_hop (route), ==, NULL);
+	g_assert (!nm_ip_route_get_next_hop_binary (route, &bin));
+	g_assert_cmpuint (bin, ==, 0);
+
+	nm_ip_route_set_next_hop (route, "192.168.1.1");
+	g_assert (nm_ip_route_get_next_hop_binary (route, &bin));
+	g_assert_cmpuint (bin, ==, inet_addr ("192.168.1.1"));
+	g_assert_cmpstr (nm_ip_route_get_next_hop (route), ==, "192.168.1.1");
+
+	copy = nm_ip_route_dup (route);
+	g_assert (nm_ip_route_equal (route, copy));
+	nm_ip_route_set_next_hop_binary (copy, NULL);
+	g_assert (!nm_ip_route_equal (route, copy));
+	nm_ip_route_get_dest_binary (copy, &bin);
+	g_assert_cmpuint (bin, ==, inet_addr ("10.1.0.0"));
+
+	nm_ip_route_unref (route);
+	nm_ip_route_unref (copy);
+}
+
 static void
 test_setting_ip4_config_address_data (void)
 {
@@ -1500,6 +1543,61 @@ test_connection_replace_settings_from_connection (void)
 	g_object_unref (connection);
 }
 
+static void
+test_connection_clone_shared (void)
+{
+	NMConnection *connection, *clone;
+	NMSettingConnection *s_con;
+	NMSettingWired *s_wired;
+	GVariant *dict, *clone_dict, *setting_dict;
+	const char *id = NULL;
+
+	connection = new_test_connection ();
+	clone = _nm_simple_connection_new_clone_shared (connection);
+
+	dict = nm_connection_to_dbus (connection, NM_CONNECTION_SERIALIZE_ALL);
+	clone_dict = nm_connection_to_dbus (clone, NM_CONNECTION_SERIALIZE_ALL);
+	g_assert (g_variant_equal (dict, clone_dict));
+	g_variant_unref (dict);
+	g_variant_unref (clone_dict);
+
+	/* Verifying does not copy the shared settings either */
+	g_assert (nm_connection_verify (clone, NULL));
+	g_assert (   _nm_connection_peek_setting (clone, NM_TYPE_SETTING_CONNECTION)
+	          == _nm_connection_peek_setting (connection, NM_TYPE_SETTING_CONNECTION));
+	g_assert (   _nm_connection_peek_setting (clone, NM_TYPE_SETTING_WIRED)
+	          == _nm_connection_peek_setting (connection, NM_TYPE_SETTING_WIRED));
+	g_assert (   _nm_connection_peek_setting (clone, NM_TYPE_SETTING_IP4_CONFIG)
+	          == _nm_connection_peek_setting (connection, NM_TYPE_SETTING_IP4_CONFIG));
+
+	/* Requesting a setting gives the clone its own copy */
+	s_wired = nm_connection_get_setting_wired (clone);
+	g_assert (s_wired);
+	g_assert (s_wired != nm_connection_get_setting_wired (connection));
+	g_object_set (s_wired, NM_SETTING_WIRED_MTU, 1400, NULL);
+	g_assert_cmpint (nm_setting_wired_get_mtu (nm_connection_get_setting_wired (connection)), ==, 1592);
+	g_assert (!nm_connection_compare (connection, clone, NM_SETTING_COMPARE_FLAG_EXACT));
+
+	/* The cached D-Bus representation follows property changes */
+	s_con = nm_connection_get_setting_connection (connection);
+	dict = nm_connection_to_dbus (connection, NM_CONNECTION_SERIALIZE_ALL);
+	g_variant_unref (dict);
+	g_object_set (s_con, NM_SETTING_CONNECTION_ID, "changed", NULL);
+
+	dict = nm_connection_to_dbus (connection, NM_CONNECTION_SERIALIZE_ALL);
+	setting_dict = g_variant_lookup_value (dict, NM_SETTING_CONNECTION_SETTING_NAME, NM_VARIANT_TYPE_SETTING);
+	g_assert (setting_dict);
+	g_assert (g_variant_lookup (setting_dict, NM_SETTING_CONNECTION_ID, "&s", &id));
+	g_assert_cmpstr (id, ==, "changed");
+	g_variant_unref (setting_dict);
+	g_variant_unref (dict);
+
+	g_assert_cmpstr (nm_connection_get_id (clone), ==, "foobar");
+
+	g_object_unref (clone);
+	g_object_unref (connection);
+}
+
 static void
 test_connection_replace_settings_bad (void)
 {
@@ -2620,6 +2718,88 @@ test_hwaddr_equal (void)
 	g_assert (nm_utils_hwaddr_matches (null_binary, sizeof (null_binary), NULL, ETH_ALEN));
 }
 
+static void
+test_setting_wired_mac_binary (void)
+{
+	const guint8 addr1[ETH_ALEN] = { 0x00, 0x1A, 0x2B, 0x03, 0x44, 0x05 };
+	const guint8 addr2[ETH_ALEN] = { 0x1A, 0x2B, 0x03, 0x44, 0x05, 0x00 };
+	const char *blacklist[] = { "1a:2b:03:44:05:00", NULL };
+	NMSettingWired *s_wired;
+
+	s_wired = (NMSettingWired *) nm_setting_wired_new ();
+
+	/* No MAC address matches any device */
+	g_assert (_nm_setting_wired_mac_address_matches (s_wired, addr1));
+	g_assert (!_nm_setting_wired_mac_address_blacklisted (s_wired, addr1));
+
+	g_object_set (s_wired, NM_SETTING_WIRED_MAC_ADDRESS, "00:1A:2B:03:44:05", NULL);
+	g_assert (_nm_setting_wired_mac_address_matches (s_wired, addr1));
+	g_assert (!_nm_setting_wired_mac_address_matches (s_wired, addr2));
+
+	/* Changing the properties invalidates the binary form */
+	g_object_set (s_wired, NM_SETTING_WIRED_MAC_ADDRESS, "1a:2b:03:44:05:00", NULL);
+	g_assert (!_nm_setting_wired_mac_address_matches (s_wired, addr1));
+	g_assert (_nm_setting_wired_mac_address_matches (s_wired, addr2));
+
+	g_object_set (s_wired, NM_SETTING_WIRED_MAC_ADDRESS_BLACKLIST, blacklist, NULL);
+	g_assert (_nm_setting_wired_mac_address_blacklisted (s_wired, addr2));
+	g_assert (!_nm_setting_wired_mac_address_blacklisted (s_wired, addr1));
+
+	g_assert (nm_setting_wired_add_mac_blacklist_item (s_wired, "00:1a:2b:03:44:05"));
+	g_assert (_nm_setting_wired_mac_address_blacklisted (s_wired, addr1));
+
+	nm_setting_wired_clear_mac_blacklist_items (s_wired);
+	g_assert (!_nm_setting_wired_mac_address_blacklisted (s_wired, addr1));
+	g_assert (!_nm_setting_wired_mac_address_blacklisted (s_wired, addr2));
+
+	g_object_unref (s_wired);
+}
+
+static void
+test_setting_wireless_mac_binary (void)
+{
+	const guint8 addr1[ETH_ALEN] = { 0x00, 0x1A, 0x2B, 0x03, 0x44, 0x05 };
+	const guint8 addr2[ETH_ALEN] = { 0x1A, 0x2B, 0x03, 0x44, 0x05, 0x00 };
+	const char *blacklist[] = { "1a:2b:03:44:05:00", NULL };
+	NMSettingWireless *s_wifi;
+
+	s_wifi = (NMSettingWireless *) nm_setting_wireless_new ();
+
+	/* No MAC address matches any device */
+	g_assert (_nm_setting_wireless_mac_address_matches (s_wifi, addr1));
+	g_assert (!_nm_setting_wireless_mac_address_blacklisted (s_wifi, addr1));
+
+	g_object_set (s_wifi, NM_SETTING_WIRELESS_MAC_ADDRESS, "00:1A:2B:03:44:05", NULL);
+	g_assert (_nm_setting_wireless_mac_address_matches (s_wifi, addr1));
+	g_assert (!_nm_setting_wireless_mac_address_matches (s_wifi, addr2));
+
+	/* Changing the properties invalidates the binary form */
+	g_object_set (s_wifi, NM_SETTING_WIRELESS_MAC_ADDRESS, "1a:2b:03:44:05:00", NULL);
+	g_assert (!_nm_setting_wireless_mac_address_matches (s_wifi, addr1));
+	g_assert (_nm_setting_wireless_mac_address_matches (s_wifi, addr2));
+
+	g_object_set (s_wifi, NM_SETTING_WIRELESS_MAC_ADDRESS, NULL, NULL);
+	g_assert (_nm_setting_wireless_mac_address_matches (s_wifi, addr1));
+	g_assert (_nm_setting_wireless_mac_address_matches (s_wifi, addr2));
+
+	g_object_set (s_wifi, NM_SETTING_WIRELESS_MAC_ADDRESS_BLACKLIST, blacklist, NULL);
+	g_assert (_nm_setting_wireless_mac_address_blacklisted (s_wifi, addr2));
+	g_assert (!_nm_setting_wireless_mac_address_blacklisted (s_wifi, addr1));
+
+	g_assert (nm_setting_wireless_add_mac_blacklist_item (s_wifi, "00:1a:2b:03:44:05"));
+	g_assert (_nm_setting_wireless_mac_address_blacklisted (s_wifi, addr1));
+
+	nm_setting_wireless_remove_mac_blacklist_item (s_wifi, 0);
+	g_assert (!_nm_setting_wireless_mac_address_blacklisted (s_wifi, addr2));
+	g_assert (_nm_setting_wireless_mac_address_blacklisted (s_wifi, addr1));
+
+	nm_setting_wireless_clear_mac_blacklist_items (s_wifi);
+	g_assert (!_nm_setting_wireless_mac_address_blacklisted (s_wifi, addr1));
+	g_assert (!_nm_setting_wireless_mac_address_blacklisted (s_wifi, addr2));
+
+	g_object_unref (s_wifi);
+}
+
 static void
 test_hwaddr_canonical (void)
 {
@@ -4048,6 +4228,7 @@ int main (int argc, char **argv)
 	g_test_add_func ("/core/general/test_setting_vpn_modify_during_foreach", test_setting_vpn_modify_during_foreach);
 	g_test_add_func ("/core/general/test_setting_ip4_config_labels", test_setting_ip4_config_labels);
 	g_test_add_func ("/core/general/test_setting_ip4_config_address_data", test_setting_ip4_config_address_data);
+	g_test_add_func ("/core/general/test_setting_ip_route_binary", test_setting_ip_route_binary);
 	g_test_add_func ("/core/general/test_setting_gsm_apn_spaces", test_setting_gsm_apn_spaces);
 	g_test_add_func ("/core/general/test_setting_gsm_apn_bad_chars", test_setting_gsm_apn_bad_chars);
 	g_test_add_func ("/core/general/test_setting_gsm_apn_underscore", test_setting_gsm_apn_underscore);
@@ -4082,6 +4263,7 @@ int main (int argc, char **argv)
 	g_test_add_func ("/core/general/test_connection_replace_settings", test_connection_replace_settings);
 	g_test_add_func ("/core/general/test_connection_replace_settings_from_connection", test_connection_replace_settings_from_connection);
 	g_test_add_func ("/core/general/test_connection_replace_settings_bad", test_connection_replace_settings_bad);
+	g_test_add_func ("/core/general/test_connection_clone_shared", test_connection_clone_shared);
 	g_test_add_func ("/core/general/test_connection_new_from_dbus", test_connection_new_from_dbus);
 	g_test_add_func ("/core/general/test_connection_normalize_virtual_iface_name", test_connection_normalize_virtual_iface_name);
 	g_test_add_func ("/core/general/test_connection_normalize_uuid", test_connection_normalize_uuid);
@@ -4112,6 +4294,8 @@ int main (int argc, char **argv)
 	g_test_add_func ("/core/general/test_hwaddr_aton_no_leading_zeros", test_hwaddr_aton_no_leading_zeros);
 	g_test_add_func ("/core/general/test_hwaddr_aton_malformed", test_hwaddr_aton_malformed);
 	g_test_add_func ("/core/general/test_hwaddr_equal", test_hwaddr_equal);
+	g_test_add_func ("/core/general/test_setting_wired_mac_binary", test_setting_wired_mac_binary);
+	g_test_add_func ("/core/general/test_setting_wireless_mac_binary", test_setting_wireless_mac_binary);
 	g_test_add_func ("/core/general/test_hwaddr_canonical", test_hwaddr_canonical);
 
 	g_test_add_func ("/core/general/test_ip4_prefix_to_netmask", test_ip4_prefix_to_netmask);
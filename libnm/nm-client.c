@@ -439,6 +439,35 @@ nm_client_set_logging (NMClient *client, const char *level, const char *domains,
 	                               level, domains, error);
 }
 
+/**
+ * nm_client_get_debug_log:
+ * @client: a #NMClient
+ * @since: only return messages newer than this; 0 for all messages
+ * @out_next: (out) (allow-none): return location for the value to pass as
+ *   @since to get only the messages logged after this call
+ * @error: (allow-none): return location for a #GError, or %NULL
+ *
+ * Gets the messages from NetworkManager's in-memory debug log buffer.
+ * Only root may read it, and it must be enabled in NetworkManager.conf.
+ *
+ * Returns: (transfer full): a %NULL-terminated array of messages, oldest
+ *   first, or %NULL on error
+ *
+ * Since: 1.2
+ **/
+char **
+nm_client_get_debug_log (NMClient *client, guint32 since, guint32 *out_next, GError **error)
+{
+	g_return_val_if_fail (NM_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	if (!_nm_client_check_nm_running (client, error))
+		return NULL;
+
+	return nm_manager_get_debug_log (NM_CLIENT_GET_PRIVATE (client)->manager,
+	                                 since, out_next, error);
+}
+
 /**
  * nm_client_get_permission_result:
  * @client: a #NMClient
@@ -214,6 +214,11 @@ gboolean nm_client_set_logging (NMClient *client,
                                 const char *level,
                                 const char *domains,
                                 GError **error);
+NM_AVAILABLE_IN_1_2
+char   **nm_client_get_debug_log (NMClient *client,
+                                  guint32 since,
+                                  guint32 *out_next,
+                                  GError **error);
 
 NMClientPermissionResult nm_client_get_permission_result (NMClient *client,
                                                           NMClientPermission permission);
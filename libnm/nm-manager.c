@@ -553,6 +553,27 @@ nm_manager_set_logging (NMManager *manager, const char *level, const char *domai
 	return ret;
 }
 
+char **
+nm_manager_get_debug_log (NMManager *manager, guint32 since, guint32 *out_next, GError **error)
+{
+	char **messages = NULL;
+	guint32 next = 0;
+
+	g_return_val_if_fail (NM_IS_MANAGER (manager), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	if (!nmdbus_manager_call_get_debug_log_sync (NM_MANAGER_GET_PRIVATE (manager)->manager_proxy,
+	                                             since, &messages, &next,
+	                                             NULL, error)) {
+		if (error && *error)
+			g_dbus_error_strip_remote_error (*error);
+		return NULL;
+	}
+	if (out_next)
+		*out_next = next;
+	return messages;
+}
+
 NMClientPermissionResult
 nm_manager_get_permission_result (NMManager *manager, NMClientPermission permission)
 {
@@ -100,6 +100,10 @@ gboolean nm_manager_set_logging (NMManager *manager,
                                  const char *level,
                                  const char *domains,
                                  GError **error);
+char   **nm_manager_get_debug_log (NMManager *manager,
+                                   guint32 since,
+                                   guint32 *out_next,
+                                   GError **error);
 
 NMClientPermissionResult nm_manager_get_permission_result (NMManager *manager,
                                                            NMClientPermission permission);
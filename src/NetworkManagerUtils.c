@@ -151,6 +151,448 @@ nm_utils_ip6_address_clear_host_address (struct in6_addr *dst, const struct in6_
 }
 
 
+/*****************************************************************************
+ * Spawning helper processes
+ *
+ * nm_utils_spawn_async() runs a helper without blocking the main loop, with
+ * an optional timeout after which the child is killed, and optional capture
+ * of its stdout and stderr.  At most SPAWN_MAX_RUNNING asynchronous helpers
+ * run at a time; further requests wait in a queue.
+ *
+ * nm_utils_spawn_sync() is for the few callers that must have the result
+ * before returning.  It iterates a private main context, so it still blocks
+ * the caller, but never for longer than the timeout.
+ *****************************************************************************/
+
+#define SPAWN_MAX_RUNNING 4
+
+typedef struct _SpawnData SpawnData;
+
+typedef struct {
+	SpawnData *data;
+	int fd;
+	GIOChannel *channel;
+	GSource *source;
+	GString *buf;
+} SpawnPipe;
+
+struct _SpawnData {
+	guint id;
+	char **argv;
+	NMUtilsSpawnFlags flags;
+	guint32 timeout_msec;
+	guint64 log_domain;
+	NMUtilsSpawnCallback callback;
+	gpointer user_data;
+	GDestroyNotify user_data_destroy;
+
+	GMainContext *context;
+	GPid pid;
+	GSource *child_source;
+	GSource *timeout_source;
+	GSource *idle_source;
+	SpawnPipe out;
+	SpawnPipe err;
+
+	gboolean exited;
+	gboolean done;
+	int child_status;
+	GError *error;
+};
+
+static GQueue spawn_queue = G_QUEUE_INIT;
+static GSList *spawn_running = NULL;
+static guint spawn_last_id = 0;
+
+static void spawn_queue_process (void);
+
+static void
+spawn_pipe_close (SpawnPipe *spipe)
+{
+	if (spipe->source) {
+		g_source_destroy (spipe->source);
+		g_source_unref (spipe->source);
+		spipe->source = NULL;
+	}
+	if (spipe->channel) {
+		g_io_channel_unref (spipe->channel);
+		spipe->channel = NULL;
+	}
+	if (spipe->fd >= 0) {
+		close (spipe->fd);
+		spipe->fd = -1;
+	}
+}
+
+static SpawnData *
+spawn_data_new (const char *const *argv,
+                NMUtilsSpawnFlags flags,
+                guint32 timeout_msec,
+                guint64 log_domain,
+                GMainContext *context)
+{
+	SpawnData *data;
+
+	data = g_slice_new0 (SpawnData);
+	data->argv = g_strdupv ((char **) argv);
+	data->flags = flags;
+	data->timeout_msec = timeout_msec;
+	data->log_domain = log_domain;
+	data->context = context ? g_main_context_ref (context) : NULL;
+	data->pid = -1;
+	data->out.data = data;
+	data->out.fd = -1;
+	data->err.data = data;
+	data->err.fd = -1;
+	data->child_status = -1;
+	return data;
+}
+
+static void
+spawn_data_free (SpawnData *data)
+{
+	spawn_pipe_close (&data->out);
+	spawn_pipe_close (&data->err);
+	if (data->out.buf)
+		g_string_free (data->out.buf, TRUE);
+	if (data->err.buf)
+		g_string_free (data->err.buf, TRUE);
+	if (data->context)
+		g_main_context_unref (data->context);
+	if (data->user_data_destroy)
+		data->user_data_destroy (data->user_data);
+	g_clear_error (&data->error);
+	g_strfreev (data->argv);
+	g_slice_free (SpawnData, data);
+}
+
+static void
+spawn_source_clear (GSource **source)
+{
+	if (*source) {
+		g_source_destroy (*source);
+		g_source_unref (*source);
+		*source = NULL;
+	}
+}
+
+static void
+spawn_finish (SpawnData *data)
+{
+	spawn_source_clear (&data->timeout_source);
+	spawn_source_clear (&data->idle_source);
+	spawn_source_clear (&data->child_source);
+
+	data->done = TRUE;
+	if (data->context) {
+		/* nm_utils_spawn_sync() collects the result */
+		return;
+	}
+
+	spawn_running = g_slist_remove (spawn_running, data);
+	if (data->callback) {
+		data->callback (data->child_status,
+		                data->out.buf ? data->out.buf->str : NULL,
+		                data->err.buf ? data->err.buf->str : NULL,
+		                data->error,
+		                data->user_data);
+	}
+	spawn_data_free (data);
+
+	spawn_queue_process ();
+}
+
+static void
+spawn_check_finished (SpawnData *data)
+{
+	if (data->exited && data->out.fd < 0 && data->err.fd < 0)
+		spawn_finish (data);
+}
+
+static gboolean
+spawn_pipe_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+	SpawnPipe *spipe = user_data;
+	char buf[4096];
+	ssize_t n;
+
+	n = read (spipe->fd, buf, sizeof (buf));
+	if (n > 0) {
+		g_string_append_len (spipe->buf, buf, n);
+		return TRUE;
+	}
+	if (n < 0 && (errno == EAGAIN || errno == EINTR))
+		return TRUE;
+
+	/* EOF or error */
+	g_source_unref (spipe->source);
+	spipe->source = NULL;
+	spawn_pipe_close (spipe);
+	spawn_check_finished (spipe->data);
+	return FALSE;
+}
+
+static void
+spawn_pipe_watch (SpawnData *data, SpawnPipe *spipe, int fd)
+{
+	spipe->fd = fd;
+	spipe->buf = g_string_new (NULL);
+	fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+
+	spipe->channel = g_io_channel_unix_new (fd);
+	spipe->source = g_io_create_watch (spipe->channel, G_IO_IN | G_IO_HUP | G_IO_ERR);
+	g_source_set_callback (spipe->source, (GSourceFunc) spawn_pipe_cb, spipe, NULL);
+	g_source_attach (spipe->source, data->context);
+}
+
+static void
+spawn_child_cb (GPid pid, gint status, gpointer user_data)
+{
+	SpawnData *data = user_data;
+
+	g_spawn_close_pid (pid);
+	g_source_unref (data->child_source);
+	data->child_source = NULL;
+
+	data->exited = TRUE;
+	data->child_status = status;
+	spawn_check_finished (data);
+}
+
+static gboolean
+spawn_timeout_cb (gpointer user_data)
+{
+	SpawnData *data = user_data;
+
+	g_source_unref (data->timeout_source);
+	data->timeout_source = NULL;
+
+	nm_log_warn (data->log_domain, "spawn: '%s' (%ld) timed out after %u ms",
+	             data->argv[0], (long) data->pid, data->timeout_msec);
+
+	/* Hand reaping of the child over to the kill helper */
+	spawn_source_clear (&data->child_source);
+	nm_utils_kill_child_async (data->pid, SIGKILL, data->log_domain, data->argv[0], 0, NULL, NULL);
+
+	spawn_pipe_close (&data->out);
+	spawn_pipe_close (&data->err);
+	data->exited = TRUE;
+	data->child_status = -1;
+	g_set_error (&data->error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT,
+	             "'%s' timed out after %u ms", data->argv[0], data->timeout_msec);
+	spawn_finish (data);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+spawn_failed_cb (gpointer user_data)
+{
+	SpawnData *data = user_data;
+
+	g_source_unref (data->idle_source);
+	data->idle_source = NULL;
+	spawn_finish (data);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+spawn_start (SpawnData *data)
+{
+	gboolean capture_out = NM_FLAGS_HAS (data->flags, NM_UTILS_SPAWN_FLAGS_CAPTURE_STDOUT);
+	gboolean capture_err = NM_FLAGS_HAS (data->flags, NM_UTILS_SPAWN_FLAGS_CAPTURE_STDERR);
+	int out_fd = -1, err_fd = -1;
+
+	if (nm_logging_enabled (LOGL_DEBUG, data->log_domain)) {
+		gs_free char *cmdline = g_strjoinv (" ", data->argv);
+
+		nm_log_dbg (data->log_domain, "spawn: '%s'", cmdline);
+	}
+
+	if (!g_spawn_async_with_pipes ("/", data->argv, NULL,
+	                               G_SPAWN_DO_NOT_REAP_CHILD,
+	                               NULL, NULL, &data->pid,
+	                               NULL,
+	                               capture_out ? &out_fd : NULL,
+	                               capture_err ? &err_fd : NULL,
+	                               &data->error)) {
+		/* Report the failure from the main loop like any other result */
+		data->exited = TRUE;
+		data->idle_source = g_idle_source_new ();
+		g_source_set_callback (data->idle_source, spawn_failed_cb, data, NULL);
+		g_source_attach (data->idle_source, data->context);
+		return;
+	}
+
+	if (capture_out)
+		spawn_pipe_watch (data, &data->out, out_fd);
+	if (capture_err)
+		spawn_pipe_watch (data, &data->err, err_fd);
+
+	data->child_source = g_child_watch_source_new (data->pid);
+	g_source_set_callback (data->child_source, (GSourceFunc) spawn_child_cb, data, NULL);
+	g_source_attach (data->child_source, data->context);
+
+	if (data->timeout_msec) {
+		data->timeout_source = g_timeout_source_new (data->timeout_msec);
+		g_source_set_callback (data->timeout_source, spawn_timeout_cb, data, NULL);
+		g_source_attach (data->timeout_source, data->context);
+	}
+}
+
+static void
+spawn_queue_process (void)
+{
+	SpawnData *data;
+
+	while (g_slist_length (spawn_running) < SPAWN_MAX_RUNNING) {
+		data = g_queue_pop_head (&spawn_queue);
+		if (!data)
+			break;
+		spawn_running = g_slist_prepend (spawn_running, data);
+		spawn_start (data);
+	}
+}
+
+/**
+ * nm_utils_spawn_async:
+ * @argv: program and arguments; the program must be an absolute path
+ * @flags: which output streams to capture
+ * @timeout_msec: kill the child after this long, or 0 for no timeout
+ * @log_domain: logging domain for messages about the child
+ * @callback: (allow-none): invoked from the main loop once the child exited
+ *   and its captured output was read, or it failed to start or timed out
+ * @user_data: passed to @callback
+ * @user_data_destroy: (allow-none): frees @user_data once @callback was
+ *   invoked or the request was cancelled
+ *
+ * Starts @argv without blocking.  If too many helpers already run, the
+ * request is queued until one of them finishes.
+ *
+ * Returns: an id for nm_utils_spawn_cancel()
+ */
+guint
+nm_utils_spawn_async (const char *const *argv,
+                      NMUtilsSpawnFlags flags,
+                      guint32 timeout_msec,
+                      guint64 log_domain,
+                      NMUtilsSpawnCallback callback,
+                      gpointer user_data,
+                      GDestroyNotify user_data_destroy)
+{
+	SpawnData *data;
+
+	g_return_val_if_fail (argv && argv[0], 0);
+
+	data = spawn_data_new (argv, flags, timeout_msec, log_domain, NULL);
+	data->callback = callback;
+	data->user_data = user_data;
+	data->user_data_destroy = user_data_destroy;
+	data->id = ++spawn_last_id;
+	if (!data->id)
+		data->id = ++spawn_last_id;
+
+	g_queue_push_tail (&spawn_queue, data);
+	spawn_queue_process ();
+	return data->id;
+}
+
+/**
+ * nm_utils_spawn_cancel:
+ * @spawn_id: an id returned by nm_utils_spawn_async()
+ *
+ * The callback of @spawn_id will not be invoked, and its user data is
+ * released right away.  A request that is still queued is dropped; a child
+ * that already runs is left to finish.
+ */
+void
+nm_utils_spawn_cancel (guint spawn_id)
+{
+	GList *link;
+	GSList *iter;
+	SpawnData *data;
+
+	for (link = spawn_queue.head; link; link = link->next) {
+		data = link->data;
+		if (data->id == spawn_id) {
+			g_queue_delete_link (&spawn_queue, link);
+			spawn_data_free (data);
+			return;
+		}
+	}
+
+	for (iter = spawn_running; iter; iter = iter->next) {
+		data = iter->data;
+		if (data->id == spawn_id) {
+			data->callback = NULL;
+			if (data->user_data_destroy) {
+				data->user_data_destroy (data->user_data);
+				data->user_data_destroy = NULL;
+			}
+			data->user_data = NULL;
+			return;
+		}
+	}
+}
+
+/**
+ * nm_utils_spawn_sync:
+ * @argv: program and arguments; the program must be an absolute path
+ * @flags: which output streams to capture
+ * @timeout_msec: kill the child after this long, or 0 for no timeout
+ * @log_domain: logging domain for messages about the child
+ * @out_child_status: (allow-none): the waitpid() status of the child
+ * @out_stdout: (allow-none): captured stdout, with
+ *   %NM_UTILS_SPAWN_FLAGS_CAPTURE_STDOUT
+ * @out_stderr: (allow-none): captured stderr, with
+ *   %NM_UTILS_SPAWN_FLAGS_CAPTURE_STDERR
+ * @error: location for a #GError
+ *
+ * Like nm_utils_spawn_async(), but waits for the result.  Does not
+ * dispatch sources of the default main context while waiting.
+ *
+ * Returns: %TRUE if the child ran and exited before the timeout, whatever
+ * its exit status was
+ */
+gboolean
+nm_utils_spawn_sync (const char *const *argv,
+                     NMUtilsSpawnFlags flags,
+                     guint32 timeout_msec,
+                     guint64 log_domain,
+                     int *out_child_status,
+                     char **out_stdout,
+                     char **out_stderr,
+                     GError **error)
+{
+	GMainContext *context;
+	SpawnData *data;
+	gboolean success;
+
+	g_return_val_if_fail (argv && argv[0], FALSE);
+
+	context = g_main_context_new ();
+	data = spawn_data_new (argv, flags, timeout_msec, log_domain, context);
+	g_main_context_unref (context);
+
+	spawn_start (data);
+	while (!data->done)
+		g_main_context_iteration (data->context, TRUE);
+
+	success = !data->error;
+	if (data->error)
+		g_propagate_error (error, g_error_copy (data->error));
+	if (out_child_status)
+		*out_child_status = data->child_status;
+	if (out_stdout)
+		*out_stdout = data->out.buf ? g_strdup (data->out.buf->str) : NULL;
+	if (out_stderr)
+		*out_stderr = data->err.buf ? g_strdup (data->err.buf->str) : NULL;
+
+	spawn_data_free (data);
+	return success;
+}
+
+#define SPAWN_PROCESS_TIMEOUT_MSEC 20000
+
 int
 nm_spawn_process (const char *args)
 {
@@ -167,15 +609,48 @@ nm_spawn_process (const char *args)
 		return -1;
 	}
 
-	if (!g_spawn_sync ("/", argv, NULL, 0, NULL, NULL, NULL, NULL, &status, &error)) {
+	if (!nm_utils_spawn_sync ((const char *const *) argv, NM_UTILS_SPAWN_FLAGS_NONE,
+	                          SPAWN_PROCESS_TIMEOUT_MSEC, LOGD_CORE,
+	                          &status, NULL, NULL, &error)) {
 		nm_log_warn (LOGD_CORE, "could not spawn process '%s': %s", args, error->message);
 		g_error_free (error);
+		status = -1;
 	}
 
 	g_strfreev (argv);
 	return status;
 }
 
+#define MODPROBE_TIMEOUT_MSEC 10000
+
+static GPtrArray *
+modprobe_argv (const char *arg1, va_list ap)
+{
+	GPtrArray *argv;
+
+	argv = g_ptr_array_sized_new (4);
+	g_ptr_array_add (argv, "/sbin/modprobe");
+	g_ptr_array_add (argv, (char *) arg1);
+
+	while ((arg1 = va_arg (ap, const char *)))
+		g_ptr_array_add (argv, (char *) arg1);
+
+	g_ptr_array_add (argv, NULL);
+	return argv;
+}
+
+static void
+modprobe_log_status (const char *cmdline, int status)
+{
+	if (WIFEXITED (status)) {
+		if (WEXITSTATUS (status) != 0)
+			nm_log_err (LOGD_CORE, "modprobe: '%s' exited with error %d", cmdline, WEXITSTATUS (status));
+	} else if (WIFSIGNALED (status))
+		nm_log_err (LOGD_CORE, "modprobe: '%s' died with signal %d", cmdline, WTERMSIG (status));
+	else
+		nm_log_err (LOGD_CORE, "modprobe: '%s' died from an unknown cause", cmdline);
+}
+
 int
 nm_utils_modprobe (GError **error, const char *arg1, ...)
 {
@@ -190,28 +665,62 @@ nm_utils_modprobe (GError **error, const char *arg1, ...)
 	g_return_val_if_fail (arg1, -1);
 
 	/* construct the argument list */
-	argv = g_ptr_array_sized_new (4);
-	g_ptr_array_add (argv, "/sbin/modprobe");
-	g_ptr_array_add (argv, (char *) arg1);
-
 	va_start (ap, arg1);
-	while ((arg1 = va_arg (ap, const char *)))
-		g_ptr_array_add (argv, (char *) arg1);
+	argv = modprobe_argv (arg1, ap);
 	va_end (ap);
 
-	g_ptr_array_add (argv, NULL);
-
 	nm_log_dbg (LOGD_CORE, "modprobe: '%s'", ARGV_TO_STR (argv));
-	if (!g_spawn_sync (NULL, (char **) argv->pdata, NULL, 0, NULL, NULL, NULL, NULL, &exit_status, &local)) {
+	if (!nm_utils_spawn_sync ((const char *const *) argv->pdata, NM_UTILS_SPAWN_FLAGS_NONE,
+	                          MODPROBE_TIMEOUT_MSEC, LOGD_CORE,
+	                          &exit_status, NULL, NULL, &local)) {
 		nm_log_err (LOGD_CORE, "modprobe: '%s' failed: %s", ARGV_TO_STR (argv), local->message);
 		g_propagate_error (error, local);
 		return -1;
-	} else if (exit_status != 0)
-		nm_log_err (LOGD_CORE, "modprobe: '%s' exited with error %d", ARGV_TO_STR (argv), exit_status);
+	}
 
+	modprobe_log_status (ARGV_TO_STR (argv), exit_status);
 	return exit_status;
 }
 
+static void
+modprobe_async_cb (int child_status, const char *out, const char *err,
+                   GError *error, gpointer user_data)
+{
+	char *cmdline = user_data;
+
+	if (error)
+		nm_log_err (LOGD_CORE, "modprobe: '%s' failed: %s", cmdline, error->message);
+	else
+		modprobe_log_status (cmdline, child_status);
+}
+
+/**
+ * nm_utils_modprobe_async:
+ * @arg1: first argument to modprobe, followed by more and %NULL
+ *
+ * Like nm_utils_modprobe(), but for callers that do not depend on the
+ * module being loaded once this returns.  Failures are only logged.
+ */
+void
+nm_utils_modprobe_async (const char *arg1, ...)
+{
+	gs_unref_ptrarray GPtrArray *argv = NULL;
+	char *cmdline;
+	va_list ap;
+
+	g_return_if_fail (arg1);
+
+	va_start (ap, arg1);
+	argv = modprobe_argv (arg1, ap);
+	va_end (ap);
+
+	cmdline = g_strjoinv (" ", (char **) argv->pdata);
+	nm_log_dbg (LOGD_CORE, "modprobe: '%s'", cmdline);
+	nm_utils_spawn_async ((const char *const *) argv->pdata, NM_UTILS_SPAWN_FLAGS_NONE,
+	                      MODPROBE_TIMEOUT_MSEC, LOGD_CORE,
+	                      modprobe_async_cb, cmdline, g_free);
+}
+
 /**
  * nm_utils_get_start_time_for_pid:
  * @pid: the process identifier
@@ -52,6 +52,40 @@ nm_utils_ip6_route_metric_normalize (guint32 metric)
 int nm_spawn_process (const char *args);
 
 int nm_utils_modprobe (GError **error, const char *arg1, ...) G_GNUC_NULL_TERMINATED;
+void nm_utils_modprobe_async (const char *arg1, ...) G_GNUC_NULL_TERMINATED;
+
+typedef enum {
+	NM_UTILS_SPAWN_FLAGS_NONE           = 0,
+	NM_UTILS_SPAWN_FLAGS_CAPTURE_STDOUT = (1LL << 0),
+	NM_UTILS_SPAWN_FLAGS_CAPTURE_STDERR = (1LL << 1),
+} NMUtilsSpawnFlags;
+
+/* @child_status is the waitpid() status, or -1 together with @error when
+ * the process could not be started or timed out.  @out and @err are %NULL
+ * unless capturing was requested.
+ */
+typedef void (*NMUtilsSpawnCallback) (int child_status,
+                                      const char *out,
+                                      const char *err,
+                                      GError *error,
+                                      gpointer user_data);
+
+guint nm_utils_spawn_async (const char *const *argv,
+                            NMUtilsSpawnFlags flags,
+                            guint32 timeout_msec,
+                            guint64 log_domain,
+                            NMUtilsSpawnCallback callback,
+                            gpointer user_data,
+                            GDestroyNotify user_data_destroy);
+void nm_utils_spawn_cancel (guint spawn_id);
+gboolean nm_utils_spawn_sync (const char *const *argv,
+                              NMUtilsSpawnFlags flags,
+                              guint32 timeout_msec,
+                              guint64 log_domain,
+                              int *out_child_status,
+                              char **out_stdout,
+                              char **out_stderr,
+                              GError **error);
 
 /* check if @flags has exactly one flag (@check) set. You should call this
  * only with @check being a compile time constant and a power of two. */
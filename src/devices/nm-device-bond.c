@@ -169,18 +169,25 @@ update_connection (NMDevice *device, NMConnection *connection)
 	NMSettingBond *s_bond = nm_connection_get_setting_bond (connection);
 	int ifindex = nm_device_get_ifindex (device);
 	const char **options;
+	GHashTable *kernel_options;
 
 	if (!s_bond) {
 		s_bond = (NMSettingBond *) nm_setting_bond_new ();
 		nm_connection_add_setting (connection, (NMSetting *) s_bond);
 	}
 
-	/* Read bond options from sysfs and update the Bond setting to match */
+	/* Read bond options from the kernel and update the Bond setting to match */
+	kernel_options = nm_platform_master_get_options (ifindex);
 	options = nm_setting_bond_get_valid_options (s_bond);
 	while (options && *options) {
-		gs_free char *value = nm_platform_master_get_option (ifindex, *options);
+		gs_free char *value = NULL;
 		const char *defvalue = nm_setting_bond_get_option_default (s_bond, *options);
 
+		if (kernel_options)
+			value = g_strdup (g_hash_table_lookup (kernel_options, *options));
+		if (!value)
+			value = nm_platform_master_get_option (ifindex, *options);
+
 		if (value && !ignore_if_zero (*options, value) && (g_strcmp0 (value, defvalue) != 0)) {
 			/* Replace " " with "," for arp_ip_targets from the kernel */
 			if (strcmp (*options, "arp_ip_target") == 0) {
@@ -197,6 +204,9 @@ update_connection (NMDevice *device, NMConnection *connection)
 		}
 		options++;
 	}
+
+	if (kernel_options)
+		g_hash_table_unref (kernel_options);
 }
 
 static gboolean
@@ -235,7 +245,15 @@ set_arp_targets (NMDevice *device,
 }
 
 static void
-set_simple_option (NMDevice *device,
+add_option (GArray *options, const char *attr, const char *value)
+{
+	NMPlatformLinkOption option = { .option = attr, .value = value };
+
+	g_array_append_val (options, option);
+}
+
+static void
+add_simple_option (GArray *options,
                    const char *attr,
                    NMSettingBond *s_bond,
                    const char *opt)
@@ -245,50 +263,69 @@ set_simple_option (NMDevice *device,
 	value = nm_setting_bond_get_option_by_name (s_bond, opt);
 	if (!value)
 		value = nm_setting_bond_get_option_default (s_bond, opt);
-	set_bond_attr (device, attr, value);
+	add_option (options, attr, value);
 }
 
-static NMActStageReturn
-apply_bonding_config (NMDevice *device)
+/**
+ * nm_device_bond_build_options:
+ * @s_bond: the bond setting to apply
+ *
+ * Collects the sysfs bonding options for @s_bond in the order they have to
+ * be programmed.  The values are owned by @s_bond or static.
+ *
+ * Option restrictions:
+ *
+ * arp_interval conflicts miimon > 0
+ * arp_interval conflicts [ alb, tlb, 802.3ad ]
+ * arp_validate needs [ active-backup ]
+ * downdelay needs miimon
+ * updelay needs miimon
+ * primary needs [ active-backup, tlb, alb ]
+ *
+ * clearing miimon requires that arp_interval be 0, but clearing
+ *     arp_interval doesn't require miimon to be 0
+ *
+ * The options are handed to the platform in one go, so that they can be
+ * programmed with a single netlink request.  The kernel rejects such a
+ * request as a whole if any option in it is not supported in the bond's
+ * mode, so options that the kernel would refuse anyway are left out.
+ * In particular, in the modes without ARP monitoring even writing 0 to
+ * arp_interval or arp_validate fails.
+ *
+ * Returns: (transfer full): a #GArray of #NMPlatformLinkOption
+ */
+GArray *
+nm_device_bond_build_options (NMSettingBond *s_bond)
 {
-	NMConnection *connection;
-	NMSettingBond *s_bond;
-	int ifindex = nm_device_get_ifindex (device);
 	const char *mode, *value;
-	char *contents;
+	int mode_num;
 	gboolean set_arp_interval = TRUE;
+	gboolean arp_supported;
+	GArray *options;
 
-	/* Option restrictions:
-	 *
-	 * arp_interval conflicts miimon > 0
-	 * arp_interval conflicts [ alb, tlb ]
-	 * arp_validate needs [ active-backup ]
-	 * downdelay needs miimon
-	 * updelay needs miimon
-	 * primary needs [ active-backup, tlb, alb ]
-	 *
-	 * clearing miimon requires that arp_interval be 0, but clearing
-	 *     arp_interval doesn't require miimon to be 0
-	 */
-
-	connection = nm_device_get_connection (device);
-	g_assert (connection);
-	s_bond = nm_connection_get_setting_bond (connection);
-	g_assert (s_bond);
+	g_return_val_if_fail (NM_IS_SETTING_BOND (s_bond), NULL);
 
 	mode = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_MODE);
 	if (mode == NULL)
 		mode = "balance-rr";
+	/* The mode may be given by name or by number */
+	mode_num = nm_utils_bond_mode_string_to_int (mode);
+	arp_supported = (   mode_num != 4   /* 802.3ad */
+	                 && mode_num != 5   /* balance-tlb */
+	                 && mode_num != 6); /* balance-alb */
+
+	options = g_array_new (FALSE, FALSE, sizeof (NMPlatformLinkOption));
 
 	value = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_MIIMON);
 	if (value && atoi (value)) {
 		/* clear arp interval */
-		set_bond_attr (device, "arp_interval", "0");
+		if (arp_supported)
+			add_option (options, "arp_interval", "0");
 		set_arp_interval = FALSE;
 
-		set_bond_attr (device, "miimon", value);
-		set_simple_option (device, "updelay", s_bond, NM_SETTING_BOND_OPTION_UPDELAY);
-		set_simple_option (device, "downdelay", s_bond, NM_SETTING_BOND_OPTION_DOWNDELAY);
+		add_option (options, "miimon", value);
+		add_simple_option (options, "updelay", s_bond, NM_SETTING_BOND_OPTION_UPDELAY);
+		add_simple_option (options, "downdelay", s_bond, NM_SETTING_BOND_OPTION_DOWNDELAY);
 	} else if (!value) {
 		/* If not given, and arp_interval is not given, default to 100 */
 		long int val_int;
@@ -298,18 +335,18 @@ apply_bonding_config (NMDevice *device)
 		errno = 0;
 		val_int = strtol (value ? value : "0", &end, 10);
 		if (!value || (val_int == 0 && errno == 0 && *end == '\0'))
-			set_bond_attr (device, "miimon", "100");
+			add_option (options, "miimon", "100");
 	}
 
 	/* The stuff after 'mode' requires the given mode or doesn't care */
-	set_bond_attr (device, "mode", mode);
+	add_option (options, "mode", mode);
 
-	/* arp_interval not compatible with ALB, TLB */
-	if (g_strcmp0 (mode, "balance-alb") == 0 || g_strcmp0 (mode, "balance-tlb") == 0)
+	/* arp_interval not compatible with ALB, TLB, 802.3ad */
+	if (!arp_supported)
 		set_arp_interval = FALSE;
 
 	if (set_arp_interval) {
-		set_simple_option (device, "arp_interval", s_bond, NM_SETTING_BOND_OPTION_ARP_INTERVAL);
+		add_simple_option (options, "arp_interval", s_bond, NM_SETTING_BOND_OPTION_ARP_INTERVAL);
 
 		/* Just let miimon get cleared automatically; even setting miimon to
 		 * 0 (disabled) clears arp_interval.
@@ -321,18 +358,52 @@ apply_bonding_config (NMDevice *device)
 	if (   value
 	    && g_strcmp0 (value, "0") != 0
 	    && g_strcmp0 (value, "none") != 0
-	    && g_strcmp0 (mode, "active-backup") == 0)
-		set_bond_attr (device, "arp_validate", value);
-	else
-		set_bond_attr (device, "arp_validate", "0");
-
-	if (   g_strcmp0 (mode, "active-backup") == 0
-	    || g_strcmp0 (mode, "balance-alb") == 0
-	    || g_strcmp0 (mode, "balance-tlb") == 0) {
+	    && mode_num == 1)
+		add_option (options, "arp_validate", value);
+	else if (arp_supported)
+		add_option (options, "arp_validate", "0");
+
+	if (mode_num == 1 || mode_num == 5 || mode_num == 6) {
 		value = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_PRIMARY);
-		set_bond_attr (device, "primary", value ? value : "");
+		add_option (options, "primary", value ? value : "");
 	}
 
+	add_simple_option (options, "primary_reselect", s_bond, NM_SETTING_BOND_OPTION_PRIMARY_RESELECT);
+	add_simple_option (options, "fail_over_mac", s_bond, NM_SETTING_BOND_OPTION_FAIL_OVER_MAC);
+	add_simple_option (options, "use_carrier", s_bond, NM_SETTING_BOND_OPTION_USE_CARRIER);
+	add_simple_option (options, "ad_select", s_bond, NM_SETTING_BOND_OPTION_AD_SELECT);
+	add_simple_option (options, "xmit_hash_policy", s_bond, NM_SETTING_BOND_OPTION_XMIT_HASH_POLICY);
+	add_simple_option (options, "resend_igmp", s_bond, NM_SETTING_BOND_OPTION_RESEND_IGMP);
+
+	if (mode_num == 4)
+		add_simple_option (options, "lacp_rate", s_bond, NM_SETTING_BOND_OPTION_LACP_RATE);
+
+	return options;
+}
+
+static NMActStageReturn
+apply_bonding_config (NMDevice *device)
+{
+	NMDeviceBond *self = NM_DEVICE_BOND (device);
+	NMConnection *connection;
+	NMSettingBond *s_bond;
+	int ifindex = nm_device_get_ifindex (device);
+	const char *value;
+	char *contents;
+	GArray *options;
+
+	connection = nm_device_get_connection (device);
+	g_assert (connection);
+	s_bond = nm_connection_get_setting_bond (connection);
+	g_assert (s_bond);
+
+	options = nm_device_bond_build_options (s_bond);
+	if (!nm_platform_master_set_options (ifindex,
+	                                     (const NMPlatformLinkOption *) options->data,
+	                                     options->len))
+		_LOGW (LOGD_HW, "failed to set some bonding attributes");
+	g_array_free (options, TRUE);
+
 	/* Clear ARP targets */
 	contents = nm_platform_master_get_option (ifindex, "arp_ip_target");
 	set_arp_targets (device, contents, " \n", "-");
@@ -342,21 +413,9 @@ apply_bonding_config (NMDevice *device)
 	value = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_ARP_IP_TARGET);
 	set_arp_targets (device, value, ",", "+");
 
-	set_simple_option (device, "primary_reselect", s_bond, NM_SETTING_BOND_OPTION_PRIMARY_RESELECT);
-	set_simple_option (device, "fail_over_mac", s_bond, NM_SETTING_BOND_OPTION_FAIL_OVER_MAC);
-	set_simple_option (device, "use_carrier", s_bond, NM_SETTING_BOND_OPTION_USE_CARRIER);
-	set_simple_option (device, "ad_select", s_bond, NM_SETTING_BOND_OPTION_AD_SELECT);
-	set_simple_option (device, "xmit_hash_policy", s_bond, NM_SETTING_BOND_OPTION_XMIT_HASH_POLICY);
-	set_simple_option (device, "resend_igmp", s_bond, NM_SETTING_BOND_OPTION_RESEND_IGMP);
-
-	if (   g_strcmp0 (mode, "4") == 0
-	    || g_strcmp0 (mode, "802.3ad") == 0)
-		set_simple_option (device, "lacp_rate", s_bond, NM_SETTING_BOND_OPTION_LACP_RATE);
-
 	return NM_ACT_STAGE_RETURN_SUCCESS;
 }
 
-
 static NMActStageReturn
 act_stage1_prepare (NMDevice *dev, NMDeviceStateReason *reason)
 {
@@ -41,6 +41,9 @@ typedef NMDeviceClass NMDeviceBondClass;
 
 GType nm_device_bond_get_type (void);
 
+/* exported for the unit tests */
+GArray *nm_device_bond_build_options (NMSettingBond *s_bond);
+
 G_END_DECLS
 
 #endif	/* NM_DEVICE_BOND_H */
@@ -167,14 +167,12 @@ static const Option slave_options[] = {
 	{ NULL, NULL }
 };
 
-static void
-commit_option (NMDevice *device, NMSetting *setting, const Option *option, gboolean slave)
+static char *
+get_option_value (NMSetting *setting, const Option *option)
 {
-	int ifindex = nm_device_get_ifindex (device);
 	GParamSpec *pspec;
 	GValue val = G_VALUE_INIT;
 	guint32 uval = 0;
-	gs_free char *value = NULL;
 
 	g_assert (setting);
 
@@ -210,27 +208,52 @@ commit_option (NMDevice *device, NMSetting *setting, const Option *option, gbool
 		g_assert_not_reached ();
 	g_value_unset (&val);
 
-	value = g_strdup_printf ("%u", uval);
+	return g_strdup_printf ("%u", uval);
+}
+
+/* Hands all options of @setting to the platform at once, so that they can
+ * be programmed with a single netlink request.
+ */
+static void
+commit_options (NMDevice *device, NMSetting *setting, const Option *options, gboolean slave)
+{
+	int ifindex = nm_device_get_ifindex (device);
+	NMPlatformLinkOption platform_options[G_N_ELEMENTS (master_options)];
+	char *values[G_N_ELEMENTS (master_options)];
+	const Option *option;
+	gboolean success;
+	guint i, n = 0;
+
+	G_STATIC_ASSERT (G_N_ELEMENTS (master_options) >= G_N_ELEMENTS (slave_options));
+
+	for (option = options; option->name; option++) {
+		values[n] = get_option_value (setting, option);
+		platform_options[n].option = option->sysname;
+		platform_options[n].value = values[n];
+		n++;
+	}
+
 	if (slave)
-		nm_platform_slave_set_option (ifindex, option->sysname, value);
+		success = nm_platform_slave_set_options (ifindex, platform_options, n);
 	else
-		nm_platform_master_set_option (ifindex, option->sysname, value);
+		success = nm_platform_master_set_options (ifindex, platform_options, n);
+	if (!success)
+		nm_log_warn (LOGD_BRIDGE, "(%s): failed to set some bridge%s options",
+		             nm_device_get_iface (device), slave ? " port" : "");
+
+	for (i = 0; i < n; i++)
+		g_free (values[i]);
 }
 
 static void
 commit_master_options (NMDevice *device, NMSettingBridge *setting)
 {
-	const Option *option;
-	NMSetting *s = NM_SETTING (setting);
-
-	for (option = master_options; option->name; option++)
-		commit_option (device, s, option, FALSE);
+	commit_options (device, NM_SETTING (setting), master_options, FALSE);
 }
 
 static void
 commit_slave_options (NMDevice *device, NMSettingBridgePort *setting)
 {
-	const Option *option;
 	NMSetting *s, *s_clear = NULL;
 
 	if (setting)
@@ -238,8 +261,7 @@ commit_slave_options (NMDevice *device, NMSettingBridgePort *setting)
 	else
 		s = s_clear = nm_setting_bridge_port_new ();
 
-	for (option = slave_options; option->name; option++)
-		commit_option (device, s, option, TRUE);
+	commit_options (device, s, slave_options, TRUE);
 
 	g_clear_object (&s_clear);
 }
@@ -251,16 +273,23 @@ update_connection (NMDevice *device, NMConnection *connection)
 	NMSettingBridge *s_bridge = nm_connection_get_setting_bridge (connection);
 	int ifindex = nm_device_get_ifindex (device);
 	const Option *option;
+	GHashTable *kernel_options;
 
 	if (!s_bridge) {
 		s_bridge = (NMSettingBridge *) nm_setting_bridge_new ();
 		nm_connection_add_setting (connection, (NMSetting *) s_bridge);
 	}
 
+	kernel_options = nm_platform_master_get_options (ifindex);
 	for (option = master_options; option->name; option++) {
-		gs_free char *str = nm_platform_master_get_option (ifindex, option->sysname);
+		gs_free char *str = NULL;
 		int value;
 
+		if (kernel_options)
+			str = g_strdup (g_hash_table_lookup (kernel_options, option->sysname));
+		if (!str)
+			str = nm_platform_master_get_option (ifindex, option->sysname);
+
 		if (str) {
 			value = strtol (str, NULL, 10);
 
@@ -272,6 +301,9 @@ update_connection (NMDevice *device, NMConnection *connection)
 		} else
 			_LOGW (LOGD_BRIDGE, "failed to read bridge setting '%s'", option->sysname);
 	}
+
+	if (kernel_options)
+		g_hash_table_unref (kernel_options);
 }
 
 static gboolean
@@ -286,6 +318,7 @@ master_update_slave_connection (NMDevice *device,
 	int ifindex_slave = nm_device_get_ifindex (slave);
 	const char *iface = nm_device_get_iface (device);
 	const Option *option;
+	GHashTable *kernel_options;
 
 	g_return_val_if_fail (ifindex_slave > 0, FALSE);
 
@@ -296,10 +329,16 @@ master_update_slave_connection (NMDevice *device,
 		nm_connection_add_setting (connection, NM_SETTING (s_port));
 	}
 
+	kernel_options = nm_platform_slave_get_options (ifindex_slave);
 	for (option = slave_options; option->name; option++) {
-		gs_free char *str = nm_platform_slave_get_option (ifindex_slave, option->sysname);
+		gs_free char *str = NULL;
 		int value;
 
+		if (kernel_options)
+			str = g_strdup (g_hash_table_lookup (kernel_options, option->sysname));
+		if (!str)
+			str = nm_platform_slave_get_option (ifindex_slave, option->sysname);
+
 		if (str) {
 			value = strtol (str, NULL, 10);
 
@@ -312,6 +351,9 @@ master_update_slave_connection (NMDevice *device,
 			_LOGW (LOGD_BRIDGE, "failed to read bridge port setting '%s'", option->sysname);
 	}
 
+	if (kernel_options)
+		g_hash_table_unref (kernel_options);
+
 	g_object_set (s_con,
 	              NM_SETTING_CONNECTION_MASTER, iface,
 	              NM_SETTING_CONNECTION_SLAVE_TYPE, NM_SETTING_BRIDGE_SETTING_NAME,
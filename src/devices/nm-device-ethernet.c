@@ -100,6 +100,7 @@ typedef enum {
 
 typedef struct {
 	char *              perm_hw_addr;    /* Permanent MAC address */
+	guint8              perm_hw_addr_bin[ETH_ALEN];
 	char *              initial_hw_addr; /* Initial MAC address (as seen when NM starts) */
 
 	guint32             speed;
@@ -125,6 +126,7 @@ typedef struct {
 	DcbWait       dcb_wait;
 	guint         dcb_timeout_id;
 	guint         dcb_carrier_id;
+	NMDcbCall    *dcb_call;
 } NMDeviceEthernetPrivate;
 
 enum {
@@ -351,6 +353,7 @@ update_permanent_hw_address (NMDevice *dev)
 	}
 
 	priv->perm_hw_addr = nm_utils_hwaddr_ntoa (epaddr->data, ETH_ALEN);
+	memcpy (priv->perm_hw_addr_bin, epaddr->data, ETH_ALEN);
 
 	g_free (epaddr);
 	close (fd);
@@ -438,29 +441,18 @@ check_connection_compatible (NMDevice *device, NMConnection *connection)
 		return FALSE;
 
 	if (s_wired) {
-		const char *mac;
 		gboolean try_mac = TRUE;
-		const char * const *mac_blacklist;
-		int i;
 
 		if (!match_subchans (self, s_wired, &try_mac))
 			return FALSE;
 
-		mac = nm_setting_wired_get_mac_address (s_wired);
-		if (try_mac && mac && !nm_utils_hwaddr_matches (mac, -1, priv->perm_hw_addr, -1))
+		/* Compare binary addresses; this runs for every device and connection */
+		if (try_mac && !_nm_setting_wired_mac_address_matches (s_wired, priv->perm_hw_addr_bin))
 			return FALSE;
 
 		/* Check for MAC address blacklist */
-		mac_blacklist = nm_setting_wired_get_mac_address_blacklist (s_wired);
-		for (i = 0; mac_blacklist[i]; i++) {
-			if (!nm_utils_hwaddr_valid (mac_blacklist[i], ETH_ALEN)) {
-				g_warn_if_reached ();
-				return FALSE;
-			}
-
-			if (nm_utils_hwaddr_matches (mac_blacklist[i], -1, priv->perm_hw_addr, -1))
-				return FALSE;
-		}
+		if (_nm_setting_wired_mac_address_blacklisted (s_wired, priv->perm_hw_addr_bin))
+			return FALSE;
 	}
 
 	return TRUE;
@@ -1074,6 +1066,17 @@ dcb_carrier_cleanup (NMDevice *device)
 	}
 }
 
+static void
+dcb_call_cleanup (NMDevice *device)
+{
+	NMDeviceEthernetPrivate *priv = NM_DEVICE_ETHERNET_GET_PRIVATE (device);
+
+	if (priv->dcb_call) {
+		nm_dcb_cancel (priv->dcb_call);
+		priv->dcb_call = NULL;
+	}
+}
+
 static void dcb_state (NMDevice *device, gboolean timeout);
 
 static gboolean
@@ -1094,6 +1097,40 @@ dcb_carrier_timeout (gpointer user_data)
 	return G_SOURCE_REMOVE;
 }
 
+static void
+dcb_helpers_failed (NMDevice *device, GError *error)
+{
+	NMDeviceEthernet *self = NM_DEVICE_ETHERNET (device);
+
+	_LOGW (LOGD_DCB, "Activation: (ethernet) failed to enable DCB/FCoE: %s",
+	       error->message);
+	dcb_carrier_cleanup (device);
+	nm_device_state_changed (device,
+	                         NM_DEVICE_STATE_FAILED,
+	                         NM_DEVICE_STATE_REASON_DCB_FCOE_FAILED);
+}
+
+static void
+dcb_configure_done (GError *error, gpointer user_data)
+{
+	NMDevice *device = NM_DEVICE (user_data);
+	NMDeviceEthernet *self = NM_DEVICE_ETHERNET (device);
+	NMDeviceEthernetPrivate *priv = NM_DEVICE_ETHERNET_GET_PRIVATE (self);
+
+	priv->dcb_call = NULL;
+	if (error) {
+		dcb_helpers_failed (device, error);
+		return;
+	}
+
+	/* Pause again just in case the device takes the carrier down when
+	 * setting specific DCB attributes.
+	 */
+	_LOGD (LOGD_DCB, "waiting for carrier (postconfig down)");
+	priv->dcb_wait = DCB_WAIT_CARRIER_POSTCONFIG_DOWN;
+	priv->dcb_timeout_id = g_timeout_add_seconds (3, dcb_carrier_timeout, device);
+}
+
 static gboolean
 dcb_configure (NMDevice *device)
 {
@@ -1103,38 +1140,34 @@ dcb_configure (NMDevice *device)
 	GError *error = NULL;
 
 	dcb_timeout_cleanup (device);
+	dcb_call_cleanup (device);
 
 	s_dcb = (NMSettingDcb *) device_get_setting (device, NM_TYPE_SETTING_DCB);
 	g_assert (s_dcb);
-	if (!nm_dcb_setup (nm_device_get_iface (device), s_dcb, &error)) {
+	priv->dcb_call = nm_dcb_setup (nm_device_get_iface (device), s_dcb,
+	                               dcb_configure_done, device, &error);
+	if (!priv->dcb_call) {
 		_LOGW (LOGD_DCB, "Activation: (ethernet) failed to enable DCB/FCoE: %s",
 		       error->message);
 		g_clear_error (&error);
 		return FALSE;
 	}
 
-	/* Pause again just in case the device takes the carrier down when
-	 * setting specific DCB attributes.
-	 */
-	_LOGD (LOGD_DCB, "waiting for carrier (postconfig down)");
-	priv->dcb_wait = DCB_WAIT_CARRIER_POSTCONFIG_DOWN;
-	priv->dcb_timeout_id = g_timeout_add_seconds (3, dcb_carrier_timeout, device);
+	/* Stay in the current state until the helpers are done */
 	return TRUE;
 }
 
-static gboolean
-dcb_enable (NMDevice *device)
+static void
+dcb_enable_done (GError *error, gpointer user_data)
 {
+	NMDevice *device = NM_DEVICE (user_data);
 	NMDeviceEthernet *self = NM_DEVICE_ETHERNET (device);
 	NMDeviceEthernetPrivate *priv = NM_DEVICE_ETHERNET_GET_PRIVATE (self);
-	GError *error = NULL;
 
-	dcb_timeout_cleanup (device);
-	if (!nm_dcb_enable (nm_device_get_iface (device), TRUE, &error)) {
-		_LOGW (LOGD_DCB, "Activation: (ethernet) failed to enable DCB/FCoE: %s",
-		       error->message);
-		g_clear_error (&error);
-		return FALSE;
+	priv->dcb_call = NULL;
+	if (error) {
+		dcb_helpers_failed (device, error);
+		return;
 	}
 
 	/* Pause for 3 seconds after enabling DCB to let the card reconfigure
@@ -1147,6 +1180,28 @@ dcb_enable (NMDevice *device)
 	_LOGD (LOGD_DCB, "waiting for carrier (preconfig down)");
 	priv->dcb_wait = DCB_WAIT_CARRIER_PRECONFIG_DOWN;
 	priv->dcb_timeout_id = g_timeout_add_seconds (3, dcb_carrier_timeout, device);
+}
+
+static gboolean
+dcb_enable (NMDevice *device)
+{
+	NMDeviceEthernet *self = NM_DEVICE_ETHERNET (device);
+	NMDeviceEthernetPrivate *priv = NM_DEVICE_ETHERNET_GET_PRIVATE (self);
+	GError *error = NULL;
+
+	dcb_timeout_cleanup (device);
+	dcb_call_cleanup (device);
+
+	priv->dcb_call = nm_dcb_enable (nm_device_get_iface (device), TRUE,
+	                                dcb_enable_done, device, &error);
+	if (!priv->dcb_call) {
+		_LOGW (LOGD_DCB, "Activation: (ethernet) failed to enable DCB/FCoE: %s",
+		       error->message);
+		g_clear_error (&error);
+		return FALSE;
+	}
+
+	/* dcb_enable_done() continues once dcbtool has finished */
 	return TRUE;
 }
 
@@ -1259,6 +1314,7 @@ act_stage2_config (NMDevice *device, NMDeviceStateReason *reason)
 
 	dcb_timeout_cleanup (device);
 	dcb_carrier_cleanup (device);
+	dcb_call_cleanup (device);
 
 	/* 802.1x has to run before any IP configuration since the 802.1x auth
 	 * process opens the port up for normal traffic.
@@ -1375,11 +1431,15 @@ deactivate (NMDevice *device)
 	priv->dcb_wait = DCB_WAIT_UNKNOWN;
 	dcb_timeout_cleanup (device);
 	dcb_carrier_cleanup (device);
+	dcb_call_cleanup (device);
 
-	/* Tear down DCB/FCoE if it was enabled */
+	/* Tear down DCB/FCoE if it was enabled.  The helpers run in the
+	 * background; nm-dcb makes a new activation wait for them, and logs
+	 * their failures.
+	 */
 	s_dcb = (NMSettingDcb *) device_get_setting (device, NM_TYPE_SETTING_DCB);
 	if (s_dcb) {
-		if (!nm_dcb_cleanup (nm_device_get_iface (device), &error)) {
+		if (!nm_dcb_cleanup (nm_device_get_iface (device), NULL, NULL, &error)) {
 			_LOGW (LOGD_DEVICE | LOGD_HW, "failed to disable DCB/FCoE: %s",
 			       error->message);
 			g_clear_error (&error);
@@ -1624,6 +1684,7 @@ dispose (GObject *object)
 
 	dcb_timeout_cleanup (NM_DEVICE (self));
 	dcb_carrier_cleanup (NM_DEVICE (self));
+	dcb_call_cleanup (NM_DEVICE (self));
 
 	G_OBJECT_CLASS (nm_device_ethernet_parent_class)->dispose (object);
 }
@@ -31,11 +31,40 @@ _nm_device_log_self_to_device (t *self) \
     return (NMDevice *) self; \
 }
 
+static inline const char *
+_nm_device_log_con_uuid (NMDevice *device)
+{
+	NMConnection *connection = device ? nm_device_get_connection (device) : NULL;
+
+	return connection ? nm_connection_get_uuid (connection) : NULL;
+}
+
+/* Like nm_log_obj(), but passes the device's interface and connection
+ * along so that the journal backend can store them as fields. */
 #define _LOG(level, domain, ...) \
-    nm_log_obj ((level), (domain), (self), \
-                "(%s): " _NM_UTILS_MACRO_FIRST(__VA_ARGS__), \
-                (self) ? str_if_set (nm_device_get_iface (_nm_device_log_self_to_device (self)), "(null)") : "(none)" \
-                _NM_UTILS_MACRO_REST(__VA_ARGS__))
+    G_STMT_START { \
+        const NMLogLevel _level = (level); \
+        const NMLogDomain _domain = (domain); \
+        \
+        if (nm_logging_enabled (_level, _domain)) { \
+            NMDevice *_device = (self) ? _nm_device_log_self_to_device (self) : NULL; \
+            const char *_iface = _device ? nm_device_get_iface (_device) : NULL; \
+            const char *_uuid = _nm_device_log_con_uuid (_device); \
+            const int _ifindex = _device ? nm_device_get_ifindex (_device) : 0; \
+            \
+            if (_level <= LOGL_DEBUG) { \
+                _nm_log_full (__FILE__, __LINE__, G_STRFUNC, _level, _domain, _iface, _ifindex, _uuid, \
+                              "[%p] (%s): " _NM_UTILS_MACRO_FIRST(__VA_ARGS__), (self), \
+                              _device ? str_if_set (_iface, "(null)") : "(none)" \
+                              _NM_UTILS_MACRO_REST(__VA_ARGS__)); \
+            } else { \
+                _nm_log_full (__FILE__, __LINE__, G_STRFUNC, _level, _domain, _iface, _ifindex, _uuid, \
+                              "(%s): " _NM_UTILS_MACRO_FIRST(__VA_ARGS__), \
+                              _device ? str_if_set (_iface, "(null)") : "(none)" \
+                              _NM_UTILS_MACRO_REST(__VA_ARGS__)); \
+            } \
+        } \
+    } G_STMT_END
 
 #define _LOGT(domain, ...)      _LOG (LOGL_TRACE, domain, __VA_ARGS__)
 #define _LOGD(domain, ...)      _LOG (LOGL_DEBUG, domain, __VA_ARGS__)
@@ -199,6 +199,7 @@ typedef struct {
 	GHashTable *  available_connections;
 	char *        hw_addr;
 	guint         hw_addr_len;
+	guint8        hw_addr_bin[NM_UTILS_HWADDR_LEN_MAX]; /* valid if hw_addr is set */
 	char *        physical_port_id;
 
 	NMUnmanagedFlags        unmanaged_flags;
@@ -288,6 +289,9 @@ typedef struct {
 	NMSettingIP6ConfigPrivacy rdisc_use_tempaddr;
 	/* IP6 config from autoconf */
 	NMIP6Config *  ac_ip6_config;
+	/* ac_ip6_config lost rdisc addresses or routes, or a change set of
+	 * rdisc was not applied; rebuild them from the whole rdisc cache */
+	gboolean       ac_ip6_config_rebuild;
 
 	guint          linklocal6_timeout_id;
 
@@ -4070,6 +4074,7 @@ rdisc_config_changed (NMRDisc *rdisc, NMRDiscConfigMap changed, NMDevice *self)
 	int i;
 	static int system_support = -1;
 	guint ifa_flags = 0x00;
+	NMRDiscConfigMap incremental;
 
 	if (system_support == -1) {
 		/*
@@ -4092,10 +4097,23 @@ rdisc_config_changed (NMRDisc *rdisc, NMRDiscConfigMap changed, NMDevice *self)
 		ifa_flags |= IFA_F_MANAGETEMPADDR;
 	}
 
-	g_return_if_fail (priv->act_request);
+	if (!priv->act_request) {
+		/* rdisc does not keep the changes of this signal */
+		priv->ac_ip6_config_rebuild = TRUE;
+		g_return_if_reached ();
+	}
 
-	if (!priv->ac_ip6_config)
+	/* A new or outdated config has to be filled from the whole cache */
+	if (!priv->ac_ip6_config) {
 		priv->ac_ip6_config = nm_ip6_config_new ();
+		priv->ac_ip6_config_rebuild = TRUE;
+	}
+	if (priv->ac_ip6_config_rebuild) {
+		changed |= NM_RDISC_CONFIG_ADDRESSES | NM_RDISC_CONFIG_ROUTES;
+		incremental = 0;
+		priv->ac_ip6_config_rebuild = FALSE;
+	} else
+		incremental = rdisc->changes.tracked;
 
 	if (changed & NM_RDISC_CONFIG_GATEWAYS) {
 		/* Use the first gateway as ordered in router discovery cache. */
@@ -4108,56 +4126,15 @@ rdisc_config_changed (NMRDisc *rdisc, NMRDiscConfigMap changed, NMDevice *self)
 	}
 
 	if (changed & NM_RDISC_CONFIG_ADDRESSES) {
-		/* Rebuild address list from router discovery cache. */
-		nm_ip6_config_reset_addresses (priv->ac_ip6_config);
-
-		/* rdisc->addresses contains at most max_addresses entries.
-		 * This is different from what the kernel does, which
-		 * also counts static and temporary addresses when checking
-		 * max_addresses.
-		 **/
-		for (i = 0; i < rdisc->addresses->len; i++) {
-			NMRDiscAddress *discovered_address = &g_array_index (rdisc->addresses, NMRDiscAddress, i);
-			NMPlatformIP6Address address;
-
-			memset (&address, 0, sizeof (address));
-			address.address = discovered_address->address;
-			address.plen = system_support ? 64 : 128;
-			address.timestamp = discovered_address->timestamp;
-			address.lifetime = discovered_address->lifetime;
-			address.preferred = discovered_address->preferred;
-			if (address.preferred > address.lifetime)
-				address.preferred = address.lifetime;
-			address.source = NM_IP_CONFIG_SOURCE_RDISC;
-			address.flags = ifa_flags;
-
-			nm_ip6_config_add_address (priv->ac_ip6_config, &address);
-		}
+		nm_rdisc_apply_addresses (rdisc, priv->ac_ip6_config,
+		                          NM_FLAGS_HAS (incremental, NM_RDISC_CONFIG_ADDRESSES),
+		                          system_support, ifa_flags);
 	}
 
 	if (changed & NM_RDISC_CONFIG_ROUTES) {
-		/* Rebuild route list from router discovery cache. */
-		nm_ip6_config_reset_routes (priv->ac_ip6_config);
-
-		for (i = 0; i < rdisc->routes->len; i++) {
-			NMRDiscRoute *discovered_route = &g_array_index (rdisc->routes, NMRDiscRoute, i);
-			NMPlatformIP6Route route;
-
-			/* Only accept non-default routes.  The router has no idea what the
-			 * local configuration or user preferences are, so sending routes
-			 * with a prefix length of 0 is quite rude and thus ignored.
-			 */
-			if (discovered_route->plen > 0) {
-				memset (&route, 0, sizeof (route));
-				route.network = discovered_route->network;
-				route.plen = discovered_route->plen;
-				route.gateway = discovered_route->gateway;
-				route.source = NM_IP_CONFIG_SOURCE_RDISC;
-				route.metric = nm_device_get_ip6_route_metric (self);
-
-				nm_ip6_config_add_route (priv->ac_ip6_config, &route);
-			}
-		}
+		nm_rdisc_apply_routes (rdisc, priv->ac_ip6_config,
+		                       NM_FLAGS_HAS (incremental, NM_RDISC_CONFIG_ROUTES),
+		                       nm_device_get_ip6_route_metric (self));
 	}
 
 	if (changed & NM_RDISC_CONFIG_DNS_SERVERS) {
@@ -5049,7 +5026,7 @@ share_init (void)
 	}
 
 	for (iter = modules; *iter; iter++)
-		nm_utils_modprobe (NULL, *iter, NULL);
+		nm_utils_modprobe_async (*iter, NULL);
 
 	return TRUE;
 }
@@ -6634,8 +6611,18 @@ update_ip_config (NMDevice *self, gboolean initial)
 		 * by the user. */
 		if (priv->con_ip6_config)
 			nm_ip6_config_intersect (priv->con_ip6_config, priv->ext_ip6_config);
-		if (priv->ac_ip6_config)
+		if (priv->ac_ip6_config) {
+			guint num = nm_ip6_config_get_num_addresses (priv->ac_ip6_config)
+			            + nm_ip6_config_get_num_routes (priv->ac_ip6_config);
+
 			nm_ip6_config_intersect (priv->ac_ip6_config, priv->ext_ip6_config);
+
+			/* Router discovery only reports what changed in its own cache,
+			 * so the removed items come back with the next full rebuild. */
+			if (   nm_ip6_config_get_num_addresses (priv->ac_ip6_config)
+			     + nm_ip6_config_get_num_routes (priv->ac_ip6_config) != num)
+				priv->ac_ip6_config_rebuild = TRUE;
+		}
 		if (priv->dhcp6_ip6_config)
 			nm_ip6_config_intersect (priv->dhcp6_ip6_config, priv->ext_ip6_config);
 		if (priv->wwan_ip6_config)
@@ -7362,29 +7349,27 @@ find_dhcp4_address (NMDevice *self)
 	return NULL;
 }
 
-void
-nm_device_spawn_iface_helper (NMDevice *self)
+/* Appends the nm-iface-helper options needed to keep managing @self
+ * after NetworkManager quits to @argv.  Returns %FALSE if there is nothing
+ * for the helper to do for this device.
+ */
+static gboolean
+iface_helper_add_args (NMDevice *self, GPtrArray *argv)
 {
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
 	gboolean configured = FALSE;
 	NMConnection *connection;
-	GError *error = NULL;
 	const char *method;
-	GPtrArray *argv;
 	gs_free char *dhcp4_address = NULL;
 
 	if (priv->state != NM_DEVICE_STATE_ACTIVATED)
-		return;
+		return FALSE;
 	if (!nm_device_can_assume_connections (self))
-		return;
+		return FALSE;
 
 	connection = nm_device_get_connection (self);
 	g_assert (connection);
 
-	argv = g_ptr_array_sized_new (10);
-	g_ptr_array_set_free_func (argv, g_free);
-
-	g_ptr_array_add (argv, g_strdup (LIBEXECDIR "/nm-iface-helper"));
 	g_ptr_array_add (argv, g_strdup ("--ifname"));
 	g_ptr_array_add (argv, g_strdup (nm_device_get_ip_iface (self)));
 	g_ptr_array_add (argv, g_strdup ("--uuid"));
@@ -7464,9 +7449,21 @@ nm_device_spawn_iface_helper (NMDevice *self)
 		configured = TRUE;
 	}
 
-	if (configured) {
-		GPid pid;
+	return configured;
+}
 
+void
+nm_device_spawn_iface_helper (NMDevice *self)
+{
+	GError *error = NULL;
+	GPtrArray *argv;
+	GPid pid;
+
+	argv = g_ptr_array_sized_new (10);
+	g_ptr_array_set_free_func (argv, g_free);
+
+	g_ptr_array_add (argv, g_strdup (LIBEXECDIR "/nm-iface-helper"));
+	if (iface_helper_add_args (self, argv)) {
 		g_ptr_array_add (argv, NULL);
 
 		if (nm_logging_enabled (LOGL_DEBUG, LOGD_DEVICE)) {
@@ -7489,6 +7486,39 @@ nm_device_spawn_iface_helper (NMDevice *self)
 	g_ptr_array_unref (argv);
 }
 
+/**
+ * nm_device_add_iface_helper_config:
+ * @self: the #NMDevice
+ * @keyfile: the interface list for a shared nm-iface-helper
+ *
+ * Like nm_device_spawn_iface_helper(), but instead of spawning a dedicated
+ * helper for @self, adds the device to @keyfile so that a single
+ * "nm-iface-helper --interfaces" process can manage it along with others.
+ *
+ * Returns: %TRUE if the device was added
+ */
+gboolean
+nm_device_add_iface_helper_config (NMDevice *self, GKeyFile *keyfile)
+{
+	GPtrArray *args;
+	gboolean configured;
+
+	args = g_ptr_array_sized_new (10);
+	g_ptr_array_set_free_func (args, g_free);
+
+	configured = iface_helper_add_args (self, args);
+	if (configured) {
+		g_key_file_set_string_list (keyfile,
+		                            nm_device_get_ip_iface (self),
+		                            "args",
+		                            (const char * const *) args->pdata,
+		                            args->len);
+	}
+
+	g_ptr_array_unref (args);
+	return configured;
+}
+
 /***********************************************************/
 
 static gboolean
@@ -7972,6 +8002,29 @@ nm_device_get_hw_address (NMDevice *self)
 	return priv->hw_addr_len ? priv->hw_addr : NULL;
 }
 
+/**
+ * nm_device_get_hw_address_bin:
+ * @self: the #NMDevice
+ * @out_len: (allow-none): on return, the length of the address
+ *
+ * Returns: the binary form of nm_device_get_hw_address(), for comparing
+ * against addresses without parsing strings, or %NULL.
+ */
+const guint8 *
+nm_device_get_hw_address_bin (NMDevice *self, gsize *out_len)
+{
+	NMDevicePrivate *priv;
+
+	g_return_val_if_fail (NM_IS_DEVICE (self), NULL);
+	priv = NM_DEVICE_GET_PRIVATE (self);
+
+	if (!priv->hw_addr_len || !priv->hw_addr)
+		return NULL;
+	if (out_len)
+		*out_len = priv->hw_addr_len;
+	return priv->hw_addr_bin;
+}
+
 static void
 nm_device_update_hw_address (NMDevice *self)
 {
@@ -7984,11 +8037,16 @@ nm_device_update_hw_address (NMDevice *self)
 		return;
 
 	hwaddr = nm_platform_link_get_address (ifindex, &hwaddrlen);
+	if (hwaddrlen > NM_UTILS_HWADDR_LEN_MAX)
+		hwaddrlen = 0;
 
 	if (hwaddrlen) {
-		if (!priv->hw_addr || !nm_utils_hwaddr_matches (priv->hw_addr, -1, hwaddr, hwaddrlen)) {
+		if (   !priv->hw_addr
+		    || priv->hw_addr_len != hwaddrlen
+		    || memcmp (priv->hw_addr_bin, hwaddr, hwaddrlen) != 0) {
 			g_free (priv->hw_addr);
 			priv->hw_addr = nm_utils_hwaddr_ntoa (hwaddr, hwaddrlen);
+			memcpy (priv->hw_addr_bin, hwaddr, hwaddrlen);
 
 			_LOGD (LOGD_HW | LOGD_DEVICE, "hardware address now %s", priv->hw_addr);
 			g_object_notify (G_OBJECT (self), NM_DEVICE_HW_ADDRESS);
@@ -8479,7 +8537,7 @@ set_property (GObject *object, guint prop_id,
 
 		priv->hw_addr_len = count;
 		g_free (priv->hw_addr);
-		if (nm_utils_hwaddr_valid (hw_addr, priv->hw_addr_len))
+		if (nm_utils_hwaddr_aton (hw_addr, priv->hw_addr_bin, priv->hw_addr_len))
 			priv->hw_addr = g_strdup (hw_addr);
 		else {
 			_LOGW (LOGD_DEVICE, "could not parse hw-address '%s'", hw_addr);
@@ -245,6 +245,7 @@ guint32     nm_device_get_ip4_route_metric (NMDevice *dev);
 guint32     nm_device_get_ip6_route_metric (NMDevice *dev);
 
 const char *    nm_device_get_hw_address   (NMDevice *dev);
+const guint8 *  nm_device_get_hw_address_bin (NMDevice *dev, gsize *out_len);
 
 NMDhcp4Config * nm_device_get_dhcp4_config (NMDevice *dev);
 NMDhcp6Config * nm_device_get_dhcp6_config (NMDevice *dev);
@@ -385,6 +386,7 @@ const NMPlatformIP4Route *nm_device_get_ip4_default_route (NMDevice *self, gbool
 const NMPlatformIP6Route *nm_device_get_ip6_default_route (NMDevice *self, gboolean *out_is_assumed);
 
 void nm_device_spawn_iface_helper (NMDevice *self);
+gboolean nm_device_add_iface_helper_config (NMDevice *self, GKeyFile *keyfile);
 
 G_END_DECLS
 
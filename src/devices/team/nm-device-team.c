@@ -54,6 +54,10 @@ typedef struct {
 	struct teamdctl *tdc;
 	GPid teamd_pid;
 	guint teamd_process_watch;
+	GPid teamd_kill_pid;
+	guint teamd_kill_watch;
+	guint teamd_kill_timeout;
+	char *teamd_config;
 	guint teamd_timeout;
 	guint teamd_dbus_watch;
 } NMDeviceTeamPrivate;
@@ -141,6 +145,9 @@ complete_connection (NMDevice *device,
 	return TRUE;
 }
 
+/* The teamdctl handle is kept for as long as teamd runs, and is shared by
+ * the master and its slaves instead of connecting again for every query.
+ */
 static gboolean
 ensure_teamd_connection (NMDevice *device)
 {
@@ -163,6 +170,18 @@ ensure_teamd_connection (NMDevice *device)
 	return !!priv->tdc;
 }
 
+static void
+teamd_connection_drop (NMDevice *device)
+{
+	NMDeviceTeamPrivate *priv = NM_DEVICE_TEAM_GET_PRIVATE (device);
+
+	if (priv->tdc) {
+		teamdctl_disconnect (priv->tdc);
+		teamdctl_free (priv->tdc);
+		priv->tdc = NULL;
+	}
+}
+
 static void
 update_connection (NMDevice *device, NMConnection *connection)
 {
@@ -197,38 +216,25 @@ master_update_slave_connection (NMDevice *self,
                                    NMConnection *connection,
                                    GError **error)
 {
+	NMDeviceTeamPrivate *priv = NM_DEVICE_TEAM_GET_PRIVATE (self);
 	NMSettingTeamPort *s_port;
 	char *port_config = NULL;
 	int err = 0;
-	struct teamdctl *tdc;
 	const char *team_port_config = NULL;
 	const char *iface = nm_device_get_iface (self);
 	const char *iface_slave = nm_device_get_iface (slave);
 
-	tdc = teamdctl_alloc ();
-	if (!tdc) {
+	if (!ensure_teamd_connection (self)) {
 		g_set_error (error,
 		             NM_DEVICE_ERROR,
 		             NM_DEVICE_ERROR_FAILED,
-		             "update slave connection for slave '%s' failed to connect to teamd for master %s (out of memory?)",
+		             "update slave connection for slave '%s' failed to connect to teamd for master %s",
 		             iface_slave, iface);
-		g_return_val_if_reached (FALSE);
-	}
-
-	err = teamdctl_connect (tdc, iface, NULL, NULL);
-	if (err) {
-		teamdctl_free (tdc);
-		g_set_error (error,
-		             NM_DEVICE_ERROR,
-		             NM_DEVICE_ERROR_FAILED,
-		             "update slave connection for slave '%s' failed to connect to teamd for master %s (err=%d)",
-		             iface_slave, iface, err);
 		return FALSE;
 	}
 
-	err = teamdctl_port_config_get_raw_direct (tdc, iface_slave, (char **)&team_port_config);
+	err = teamdctl_port_config_get_raw_direct (priv->tdc, iface_slave, (char **)&team_port_config);
 	port_config = g_strdup (team_port_config);
-	teamdctl_free (tdc);
 	if (err) {
 		g_set_error (error,
 		             NM_DEVICE_ERROR,
@@ -236,6 +242,8 @@ master_update_slave_connection (NMDevice *self,
 		             "update slave connection for slave '%s' failed to get configuration from teamd master %s (err=%d)",
 		             iface_slave, iface, err);
 		g_free (port_config);
+		/* teamd may have been restarted; reconnect next time */
+		teamd_connection_drop (self);
 		return FALSE;
 	}
 
@@ -268,11 +276,38 @@ teamd_timeout_remove (NMDevice *device)
 	}
 }
 
+static void
+teamd_kill_timeout_remove (NMDevice *device)
+{
+	NMDeviceTeamPrivate *priv = NM_DEVICE_TEAM_GET_PRIVATE (device);
+
+	if (priv->teamd_kill_timeout) {
+		g_source_remove (priv->teamd_kill_timeout);
+		priv->teamd_kill_timeout = 0;
+	}
+}
+
+static void
+teamd_kill_reap_cb (GPid pid, gint status, gpointer user_data)
+{
+	g_spawn_close_pid (pid);
+}
+
 static void
 teamd_cleanup (NMDevice *device, gboolean device_state_failed)
 {
 	NMDeviceTeamPrivate *priv = NM_DEVICE_TEAM_GET_PRIVATE (device);
 
+	if (priv->teamd_kill_watch) {
+		/* Let "teamd -k" finish on its own, but stop waiting for it */
+		g_source_remove (priv->teamd_kill_watch);
+		priv->teamd_kill_watch = 0;
+		g_child_watch_add (priv->teamd_kill_pid, teamd_kill_reap_cb, NULL);
+		priv->teamd_kill_pid = 0;
+	}
+	teamd_kill_timeout_remove (device);
+	g_clear_pointer (&priv->teamd_config, g_free);
+
 	if (priv->teamd_process_watch) {
 		g_source_remove (priv->teamd_process_watch);
 		priv->teamd_process_watch = 0;
@@ -283,11 +318,7 @@ teamd_cleanup (NMDevice *device, gboolean device_state_failed)
 		priv->teamd_pid = 0;
 	}
 
-	if (priv->tdc) {
-		teamdctl_disconnect (priv->tdc);
-		teamdctl_free (priv->tdc);
-		priv->tdc = NULL;
-	}
+	teamd_connection_drop (device);
 
 	teamd_timeout_remove (device);
 
@@ -326,6 +357,12 @@ teamd_dbus_appeared (GDBusConnection *connection,
 
 	g_return_if_fail (priv->teamd_dbus_watch);
 
+	if (priv->teamd_kill_watch) {
+		/* Still waiting for the previous teamd to go away */
+		_LOGD (LOGD_TEAM, "teamd appeared on D-Bus (ignored while killing old teamd)");
+		return;
+	}
+
 	_LOGI (LOGD_TEAM, "teamd appeared on D-Bus");
 	teamd_timeout_remove (device);
 	nm_device_queue_recheck_assume (device);
@@ -399,28 +436,16 @@ nm_device_team_watch_dbus (NMDeviceTeam *self)
 }
 
 static gboolean
-teamd_start (NMDevice *device, NMSettingTeam *s_team)
+teamd_spawn (NMDevice *device)
 {
 	NMDeviceTeam *self = NM_DEVICE_TEAM (device);
 	NMDeviceTeamPrivate *priv = NM_DEVICE_TEAM_GET_PRIVATE (self);
 	const char *iface = nm_device_get_ip_iface (device);
 	char *tmp_str = NULL;
-	const char *config;
 	const char *teamd_binary;
 	GPtrArray *argv;
 	GError *error = NULL;
 	gboolean ret;
-	int status;
-
-	if (priv->teamd_process_watch ||
-	    priv->teamd_pid > 0 ||
-	    priv->tdc ||
-	    priv->teamd_timeout)
-	{
-		/* FIXME g_assert that this never hits. For now, be more reluctant, and try to recover. */
-		g_warn_if_reached ();
-		teamd_cleanup (device, FALSE);
-	}
 
 	teamd_binary = nm_utils_find_helper ("teamd", NULL, NULL);
 	if (!teamd_binary) {
@@ -428,22 +453,6 @@ teamd_start (NMDevice *device, NMSettingTeam *s_team)
 		return FALSE;
 	}
 
-	/* Kill teamd for same named device first if it is there */
-	argv = g_ptr_array_new ();
-	g_ptr_array_add (argv, (gpointer) teamd_binary);
-	g_ptr_array_add (argv, (gpointer) "-k");
-	g_ptr_array_add (argv, (gpointer) "-t");
-	g_ptr_array_add (argv, (gpointer) iface);
-	g_ptr_array_add (argv, NULL);
-
-	_LOGD (LOGD_TEAM, "running: %s",
-	       (tmp_str = g_strjoinv (" ", (gchar **) argv->pdata)));
-	g_clear_pointer (&tmp_str, g_free);
-
-	ret = g_spawn_sync ("/", (char **) argv->pdata, NULL, 0, NULL, NULL, NULL, NULL, &status, &error);
-	g_ptr_array_free (argv, TRUE);
-
-	/* Start teamd now */
 	argv = g_ptr_array_new ();
 	g_ptr_array_add (argv, (gpointer) teamd_binary);
 	g_ptr_array_add (argv, (gpointer) "-o");
@@ -454,10 +463,9 @@ teamd_start (NMDevice *device, NMSettingTeam *s_team)
 	g_ptr_array_add (argv, (gpointer) "-t");
 	g_ptr_array_add (argv, (gpointer) iface);
 
-	config = nm_setting_team_get_config(s_team);
-	if (config) {
+	if (priv->teamd_config) {
 		g_ptr_array_add (argv, (gpointer) "-c");
-		g_ptr_array_add (argv, (gpointer) config);
+		g_ptr_array_add (argv, (gpointer) priv->teamd_config);
 	}
 
 	if (nm_logging_enabled (LOGL_DEBUG, LOGD_TEAM))
@@ -474,10 +482,10 @@ teamd_start (NMDevice *device, NMSettingTeam *s_team)
 	ret = g_spawn_async ("/", (char **) argv->pdata, NULL, G_SPAWN_DO_NOT_REAP_CHILD,
 	                    nm_utils_setpgid, NULL, &priv->teamd_pid, &error);
 	g_ptr_array_free (argv, TRUE);
+	g_clear_pointer (&priv->teamd_config, g_free);
 	if (!ret) {
 		_LOGW (LOGD_TEAM, "Activation: (team) failed to start teamd: %s", error->message);
 		g_clear_error (&error);
-		teamd_cleanup (device, FALSE);
 		return FALSE;
 	}
 
@@ -490,6 +498,124 @@ teamd_start (NMDevice *device, NMSettingTeam *s_team)
 	return TRUE;
 }
 
+static void
+teamd_kill_cb (GPid pid, gint status, gpointer user_data)
+{
+	NMDeviceTeam *self = NM_DEVICE_TEAM (user_data);
+	NMDeviceTeamPrivate *priv = NM_DEVICE_TEAM_GET_PRIVATE (self);
+	NMDevice *device = NM_DEVICE (self);
+
+	g_spawn_close_pid (pid);
+	priv->teamd_kill_watch = 0;
+	priv->teamd_kill_pid = 0;
+	teamd_kill_timeout_remove (device);
+
+	_LOGD (LOGD_TEAM, "killing old teamd finished with status %d", status);
+
+	if (!teamd_spawn (device))
+		teamd_cleanup (device, TRUE);
+}
+
+static gboolean
+teamd_kill_timeout_cb (gpointer user_data)
+{
+	NMDeviceTeam *self = NM_DEVICE_TEAM (user_data);
+	NMDeviceTeamPrivate *priv = NM_DEVICE_TEAM_GET_PRIVATE (self);
+	NMDevice *device = NM_DEVICE (self);
+
+	g_return_val_if_fail (priv->teamd_kill_timeout, FALSE);
+	priv->teamd_kill_timeout = 0;
+
+	/* A hanging "teamd -k" must not stall the activation; the new teamd
+	 * fails on its own if the old one is really still around.
+	 */
+	_LOGW (LOGD_TEAM, "killing old teamd timed out");
+	if (priv->teamd_kill_watch) {
+		g_source_remove (priv->teamd_kill_watch);
+		priv->teamd_kill_watch = 0;
+		nm_utils_kill_child_async (priv->teamd_kill_pid, SIGKILL, LOGD_TEAM, "teamd -k", 0, NULL, NULL);
+		priv->teamd_kill_pid = 0;
+	}
+
+	if (!teamd_spawn (device))
+		teamd_cleanup (device, TRUE);
+	return FALSE;
+}
+
+/* Kills a teamd left over for the same interface and then starts a new
+ * one.  Both steps run asynchronously, so bringing up many teams does not
+ * block the main loop on each "teamd -k".
+ */
+static gboolean
+teamd_start (NMDevice *device, NMSettingTeam *s_team)
+{
+	NMDeviceTeam *self = NM_DEVICE_TEAM (device);
+	NMDeviceTeamPrivate *priv = NM_DEVICE_TEAM_GET_PRIVATE (self);
+	const char *iface = nm_device_get_ip_iface (device);
+	char *tmp_str = NULL;
+	const char *teamd_binary;
+	GPtrArray *argv;
+	GError *error = NULL;
+	gboolean ret;
+
+	/* A teamdctl handle may be left from querying an external teamd on
+	 * behalf of a slave; it is not a sign of a running activation.
+	 */
+	teamd_connection_drop (device);
+
+	if (priv->teamd_process_watch ||
+	    priv->teamd_pid > 0 ||
+	    priv->teamd_kill_watch ||
+	    priv->teamd_timeout)
+	{
+		/* FIXME g_assert that this never hits. For now, be more reluctant, and try to recover. */
+		g_warn_if_reached ();
+		teamd_cleanup (device, FALSE);
+	}
+
+	teamd_binary = nm_utils_find_helper ("teamd", NULL, NULL);
+	if (!teamd_binary) {
+		_LOGW (LOGD_TEAM, "Activation: (team) failed to start teamd: teamd binary not found");
+		return FALSE;
+	}
+
+	priv->teamd_config = g_strdup (nm_setting_team_get_config (s_team));
+
+	/* Kill teamd for same named device first if it is there */
+	argv = g_ptr_array_new ();
+	g_ptr_array_add (argv, (gpointer) teamd_binary);
+	g_ptr_array_add (argv, (gpointer) "-k");
+	g_ptr_array_add (argv, (gpointer) "-t");
+	g_ptr_array_add (argv, (gpointer) iface);
+	g_ptr_array_add (argv, NULL);
+
+	_LOGD (LOGD_TEAM, "running: %s",
+	       (tmp_str = g_strjoinv (" ", (gchar **) argv->pdata)));
+	g_clear_pointer (&tmp_str, g_free);
+
+	ret = g_spawn_async ("/", (char **) argv->pdata, NULL,
+	                     G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL,
+	                     NULL, NULL, &priv->teamd_kill_pid, &error);
+	g_ptr_array_free (argv, TRUE);
+	if (ret) {
+		priv->teamd_kill_watch = g_child_watch_add (priv->teamd_kill_pid,
+		                                            teamd_kill_cb,
+		                                            device);
+		priv->teamd_kill_timeout = g_timeout_add_seconds (5, teamd_kill_timeout_cb, device);
+		return TRUE;
+	}
+
+	/* Not fatal; start teamd right away */
+	_LOGD (LOGD_TEAM, "failed to kill old teamd: %s", error->message);
+	g_clear_error (&error);
+
+	if (!teamd_spawn (device)) {
+		teamd_cleanup (device, FALSE);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static void
 teamd_stop (NMDevice *device)
 {
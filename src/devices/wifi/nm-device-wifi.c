@@ -61,6 +61,7 @@
 #include "nm-dbus-glib-types.h"
 #include "nm-wifi-enum-types.h"
 #include "nm-connection-provider.h"
+#include "nm-core-internal.h"
 
 
 static gboolean impl_device_get_access_points (NMDeviceWifi *device,
@@ -119,6 +120,7 @@ struct _NMDeviceWifiPrivate {
 	gboolean          disposed;
 
 	char *            perm_hw_addr;    /* Permanent MAC address */
+	guint8            perm_hw_addr_bin[ETH_ALEN];
 	char *            initial_hw_addr; /* Initial MAC address (as seen when NM starts) */
 
 	gint8             invalid_strength_counter;
@@ -344,39 +346,38 @@ get_ap_by_supplicant_path (NMDeviceWifi *self, const char *path)
 	return NULL;
 }
 
+/* @link_info is a snapshot from nm_platform_wifi_get_link_info(), so that
+ * callers which also need the quality or bitrate only query the driver once.
+ */
 static NMAccessPoint *
 find_active_ap (NMDeviceWifi *self,
+                const NMPlatformWifiLinkInfo *link_info,
                 NMAccessPoint *ignore_ap,
                 gboolean match_hidden)
 {
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
-	int ifindex = nm_device_get_ifindex (NM_DEVICE (self));
-	guint8 bssid[ETH_ALEN];
-	GByteArray *ssid;
+	const guint8 *bssid = link_info->bssid;
+	const guint8 *ssid = link_info->ssid_len ? link_info->ssid : NULL;
+	guint32 ssid_len = link_info->ssid_len;
 	GSList *iter;
 	int i = 0;
 	NMAccessPoint *match_nofreq = NULL, *active_ap = NULL;
 	gboolean found_a_band = FALSE;
 	gboolean found_bg_band = FALSE;
-	NM80211Mode devmode;
-	guint32 devfreq;
+	NM80211Mode devmode = link_info->mode;
+	guint32 devfreq = link_info->frequency;
 
-	nm_platform_wifi_get_bssid (ifindex, bssid);
 	_LOGT (LOGD_WIFI, "active BSSID: %02x:%02x:%02x:%02x:%02x:%02x",
 	       bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5]);
 
-	if (!nm_ethernet_address_is_valid (bssid, ETH_ALEN))
+	if (!link_info->associated || !nm_ethernet_address_is_valid (bssid, ETH_ALEN))
 		return NULL;
 
-	ssid = nm_platform_wifi_get_ssid (ifindex);
 	_LOGT (LOGD_WIFI, "active SSID: %s%s%s",
 	       ssid ? "'" : "",
-	       ssid ? nm_utils_escape_ssid (ssid->data, ssid->len) : "(none)",
+	       ssid ? nm_utils_escape_ssid (ssid, ssid_len) : "(none)",
 	       ssid ? "'" : "");
 
-	devmode = nm_platform_wifi_get_mode (ifindex);
-	devfreq = nm_platform_wifi_get_frequency (ifindex);
-
 	/* When matching hidden APs, do a second pass that ignores the SSID check,
 	 * because NM might not yet know the SSID of the hidden AP in the scan list
 	 * and therefore it won't get matched the first time around.
@@ -411,7 +412,7 @@ find_active_ap (NMDeviceWifi *self,
 			if (i == 0) {
 				if (   (ssid && !ap_ssid)
 				    || (ap_ssid && !ssid)
-				    || (ssid && ap_ssid && !nm_utils_same_ssid (ssid->data, ssid->len,
+				    || (ssid && ap_ssid && !nm_utils_same_ssid (ssid, ssid_len,
 				                                                ap_ssid->data, ap_ssid->len,
 				                                                TRUE))) {
 					_LOGT (LOGD_WIFI, "      SSID mismatch");
@@ -476,8 +477,6 @@ find_active_ap (NMDeviceWifi *self,
 	_LOGT (LOGD_WIFI, "  No matching AP found.");
 
 done:
-	if (ssid)
-		g_byte_array_free (ssid, TRUE);
 	return active_ap;
 }
 
@@ -552,8 +551,8 @@ periodic_update (NMDeviceWifi *self, NMAccessPoint *ignore_ap)
 {
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	int ifindex = nm_device_get_ifindex (NM_DEVICE (self));
+	NMPlatformWifiLinkInfo link_info;
 	NMAccessPoint *new_ap;
-	guint32 new_rate;
 	int percent;
 	NMDeviceState state;
 	guint32 supplicant_state;
@@ -579,6 +578,12 @@ periodic_update (NMDeviceWifi *self, NMAccessPoint *ignore_ap)
 	if (priv->mode == NM_802_11_MODE_AP)
 		return;
 
+	/* Everything below is taken from a single snapshot rather than asking
+	 * the driver separately for each value.
+	 */
+	if (!nm_platform_wifi_get_link_info (ifindex, &link_info))
+		return;
+
 	/* In IBSS mode, most newer firmware/drivers do "BSS coalescing" where
 	 * multiple IBSS stations using the same SSID will eventually switch to
 	 * using the same BSSID to avoid network segmentation.  When this happens,
@@ -588,9 +593,8 @@ periodic_update (NMDeviceWifi *self, NMAccessPoint *ignore_ap)
 	 * current AP with it, if the current AP is adhoc.
 	 */
 	if (priv->current_ap && (nm_ap_get_mode (priv->current_ap) == NM_802_11_MODE_ADHOC)) {
-		guint8 bssid[ETH_ALEN] = { 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 };
+		const guint8 *bssid = link_info.bssid;
 
-		nm_platform_wifi_get_bssid (ifindex, bssid);
 		/* 0x02 means "locally administered" and should be OR-ed into
 		 * the first byte of IBSS BSSIDs.
 		 */
@@ -601,12 +605,12 @@ periodic_update (NMDeviceWifi *self, NMAccessPoint *ignore_ap)
 		}
 	}
 
-	new_ap = find_active_ap (self, ignore_ap, FALSE);
+	new_ap = find_active_ap (self, &link_info, ignore_ap, FALSE);
 	if (new_ap) {
 		/* Try to smooth out the strength.  Atmel cards, for example, will give no strength
 		 * one second and normal strength the next.
 		 */
-		percent = nm_platform_wifi_get_quality (ifindex);
+		percent = link_info.quality;
 		if (percent >= 0 || ++priv->invalid_strength_counter > 3) {
 			nm_ap_set_strength (new_ap, (gint8) percent);
 			priv->invalid_strength_counter = 0;
@@ -638,9 +642,8 @@ periodic_update (NMDeviceWifi *self, NMAccessPoint *ignore_ap)
 		set_current_ap (self, new_ap, TRUE, FALSE);
 	}
 
-	new_rate = nm_platform_wifi_get_rate (ifindex);
-	if (new_rate != priv->rate) {
-		priv->rate = new_rate;
+	if (link_info.rate != priv->rate) {
+		priv->rate = link_info.rate;
 		g_object_notify (G_OBJECT (self), NM_DEVICE_WIFI_BITRATE);
 	}
 }
@@ -803,9 +806,6 @@ check_connection_compatible (NMDevice *device, NMConnection *connection)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	NMSettingConnection *s_con;
 	NMSettingWireless *s_wireless;
-	const char *mac;
-	const char * const *mac_blacklist;
-	int i;
 	const char *mode;
 
 	if (!NM_DEVICE_CLASS (nm_device_wifi_parent_class)->check_connection_compatible (device, connection))
@@ -821,21 +821,13 @@ check_connection_compatible (NMDevice *device, NMConnection *connection)
 	if (!s_wireless)
 		return FALSE;
 
-	mac = nm_setting_wireless_get_mac_address (s_wireless);
-	if (mac && !nm_utils_hwaddr_matches (mac, -1, priv->perm_hw_addr, -1))
+	/* Compare binary addresses; this runs for every device and connection */
+	if (!_nm_setting_wireless_mac_address_matches (s_wireless, priv->perm_hw_addr_bin))
 		return FALSE;
 
 	/* Check for MAC address blacklist */
-	mac_blacklist = nm_setting_wireless_get_mac_address_blacklist (s_wireless);
-	for (i = 0; mac_blacklist[i]; i++) {
-		if (!nm_utils_hwaddr_valid (mac_blacklist[i], ETH_ALEN)) {
-			g_warn_if_reached ();
-			return FALSE;
-		}
-
-		if (nm_utils_hwaddr_matches (mac_blacklist[i], -1, priv->perm_hw_addr, -1))
-			return FALSE;
-	}
+	if (_nm_setting_wireless_mac_address_blacklisted (s_wireless, priv->perm_hw_addr_bin))
+		return FALSE;
 
 	if (is_adhoc_wpa (connection))
 		return FALSE;
@@ -2542,6 +2534,7 @@ update_permanent_hw_address (NMDevice *device)
 	}
 
 	priv->perm_hw_addr = nm_utils_hwaddr_ntoa (epaddr->data, ETH_ALEN);
+	memcpy (priv->perm_hw_addr_bin, epaddr->data, ETH_ALEN);
 
 	g_free (epaddr);
 	close (fd);
@@ -2989,7 +2982,7 @@ activation_success_handler (NMDevice *device)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	int ifindex = nm_device_get_ifindex (device);
 	NMAccessPoint *ap;
-	guint8 bssid[ETH_ALEN] = { 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 };
+	NMPlatformWifiLinkInfo link_info;
 	NMAccessPoint *tmp_ap = NULL;
 	NMActRequest *req;
 	NMConnection *connection;
@@ -3020,18 +3013,18 @@ activation_success_handler (NMDevice *device)
 	 * But if activation was successful, the card will know the BSSID.  Grab
 	 * the BSSID off the card and fill in the BSSID of the activation AP.
 	 */
-	nm_platform_wifi_get_bssid (ifindex, bssid);
+	nm_platform_wifi_get_link_info (ifindex, &link_info);
 	if (!nm_ap_get_address (ap)) {
-		char *bssid_str = nm_utils_hwaddr_ntoa (bssid, ETH_ALEN);
+		char *bssid_str = nm_utils_hwaddr_ntoa (link_info.bssid, ETH_ALEN);
 		nm_ap_set_address (ap, bssid_str);
 		g_free (bssid_str);
 	}
 	if (!nm_ap_get_freq (ap))
-		nm_ap_set_freq (ap, nm_platform_wifi_get_frequency (ifindex));
+		nm_ap_set_freq (ap, link_info.frequency);
 	if (!nm_ap_get_max_bitrate (ap))
-		nm_ap_set_max_bitrate (ap, nm_platform_wifi_get_rate (ifindex));
+		nm_ap_set_max_bitrate (ap, link_info.rate);
 
-	tmp_ap = find_active_ap (self, ap, TRUE);
+	tmp_ap = find_active_ap (self, &link_info, ap, TRUE);
 	if (tmp_ap) {
 		const GByteArray *ssid = nm_ap_get_ssid (tmp_ap);
 
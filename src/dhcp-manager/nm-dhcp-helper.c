@@ -24,10 +24,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include <gio/gio.h>
 
 #define NM_DHCP_CLIENT_DBUS_IFACE   "org.freedesktop.nm_dhcp_client"
+#define EVENT_SOCK_PATH             NMRUNDIR "/private-dhcp-event"
 
 static const char * ignore[] = {"PATH", "SHLVL", "_", "PWD", "dhc_dbus", NULL};
 
@@ -138,6 +142,40 @@ shared_connection_init (void)
 }
 #endif
 
+/* Hands the event to NetworkManager as a single datagram on its event
+ * socket.  This is much cheaper than setting up and authenticating a
+ * D-Bus connection per event, which matters when many leases renew at
+ * once.  Returns FALSE if the socket isn't available (eg, an older
+ * NetworkManager is running), in which case D-Bus is used instead.
+ */
+static gboolean
+send_event_datagram (GVariant *parameters)
+{
+	struct sockaddr_un addr;
+	ssize_t len;
+	int fd;
+
+	fd = socket (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return FALSE;
+
+	memset (&addr, 0, sizeof (addr));
+	addr.sun_family = AF_UNIX;
+	g_strlcpy (addr.sun_path, EVENT_SOCK_PATH, sizeof (addr.sun_path));
+
+	do {
+		len = sendto (fd,
+		              g_variant_get_data (parameters),
+		              g_variant_get_size (parameters),
+		              0,
+		              (struct sockaddr *) &addr,
+		              sizeof (addr));
+	} while (len < 0 && errno == EINTR);
+
+	close (fd);
+	return len == (ssize_t) g_variant_get_size (parameters);
+}
+
 static void
 fatal_error (void)
 {
@@ -158,8 +196,15 @@ int
 main (int argc, char *argv[])
 {
 	GDBusConnection *connection;
+	GVariant *parameters;
 	GError *error = NULL;
 
+	parameters = g_variant_ref_sink (build_signal_parameters ());
+	if (send_event_datagram (parameters)) {
+		g_variant_unref (parameters);
+		return 0;
+	}
+
 	connection = g_dbus_connection_new_for_address_sync ("unix:path=" NMRUNDIR "/private-dhcp",
 	                                                     G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
 	                                                     NULL, NULL, &error);
@@ -181,7 +226,7 @@ main (int argc, char *argv[])
 	                                    "/",
 	                                    NM_DHCP_CLIENT_DBUS_IFACE,
 	                                    "Event",
-	                                    build_signal_parameters (),
+	                                    parameters,
 	                                    &error)) {
 		g_dbus_error_strip_remote_error (error);
 		g_printerr ("Error: Could not send DHCP Event signal: %s\n", error->message);
@@ -196,6 +241,7 @@ main (int argc, char *argv[])
 		fatal_error ();
 	}
 
+	g_variant_unref (parameters);
 	g_object_unref (connection);
 	return 0;
 }
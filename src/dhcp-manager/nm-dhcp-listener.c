@@ -23,6 +23,8 @@
 #include <glib/gi18n.h>
 #include <dbus/dbus.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <string.h>
@@ -41,12 +43,27 @@
 #define PRIV_SOCK_PATH            NMRUNDIR "/private-dhcp"
 #define PRIV_SOCK_TAG             "dhcp"
 
+/* Datagram socket nm-dhcp-helper sends its events to without setting up
+ * a D-Bus connection; see nm-dhcp-helper.c.
+ */
+#define EVENT_SOCK_PATH           NMRUNDIR "/private-dhcp-event"
+
+/* Max datagrams handled per main loop wakeup, and the size of one */
+#define EVENT_BATCH_MAX           64
+#define EVENT_BUF_SIZE            (64 * 1024)
+#define EVENT_RCVBUF_SIZE         (1024 * 1024)
+
 typedef struct {
 	NMDBusManager *     dbus_mgr;
 	guint               new_conn_id;
 	guint               dis_conn_id;
 	GHashTable *        proxies;
 	DBusGProxy *        proxy;
+
+	int                 event_fd;
+	GIOChannel *        event_channel;
+	guint               event_id;
+	guint8 *            event_buf;
 } NMDhcpListenerPrivate;
 
 #define NM_DHCP_LISTENER_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_DHCP_LISTENER, NMDhcpListenerPrivate))
@@ -114,11 +131,8 @@ get_option (GHashTable *hash, const char *key)
 }
 
 static void
-handle_event (DBusGProxy *proxy,
-              GHashTable *options,
-              gpointer user_data)
+process_event (NMDhcpListener *self, GHashTable *options)
 {
-	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
 	char *iface = NULL;
 	char *pid_str = NULL;
 	char *reason = NULL;
@@ -159,6 +173,178 @@ out:
 	g_free (reason);
 }
 
+static void
+handle_event (DBusGProxy *proxy,
+              GHashTable *options,
+              gpointer user_data)
+{
+	process_event (NM_DHCP_LISTENER (user_data), options);
+}
+
+/***************************************************/
+
+static void
+gvalue_destroy (gpointer data)
+{
+	GValue *value = (GValue *) data;
+
+	g_value_unset (value);
+	g_slice_free (GValue, value);
+}
+
+/* Converts the helper's a{sv} of byte arrays into the same option hash
+ * dbus-glib hands to handle_event().
+ */
+static GHashTable *
+options_from_variant (GVariant *parameters)
+{
+	GHashTable *options;
+	GVariantIter *iter;
+	const char *name;
+	GVariant *value;
+
+	options = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, gvalue_destroy);
+
+	g_variant_get (parameters, "(a{sv})", &iter);
+	while (g_variant_iter_next (iter, "{&sv}", &name, &value)) {
+		if (g_variant_is_of_type (value, G_VARIANT_TYPE_BYTESTRING)) {
+			const guint8 *data;
+			gsize len = 0;
+			GArray *array;
+			GValue *gvalue;
+
+			data = g_variant_get_fixed_array (value, &len, 1);
+			array = g_array_sized_new (FALSE, FALSE, 1, len);
+			g_array_append_vals (array, data, len);
+
+			gvalue = g_slice_new0 (GValue);
+			g_value_init (gvalue, DBUS_TYPE_G_UCHAR_ARRAY);
+			g_value_take_boxed (gvalue, array);
+			g_hash_table_insert (options, g_strdup (name), gvalue);
+		} else
+			nm_log_warn (LOGD_DHCP, "DHCP event: option '%s' is not a byte array", name);
+		g_variant_unref (value);
+	}
+	g_variant_iter_free (iter);
+
+	return options;
+}
+
+static void
+handle_event_datagram (NMDhcpListener *self, const guint8 *data, gsize len)
+{
+	GVariant *parameters;
+	GHashTable *options;
+
+	parameters = g_variant_new_from_data (G_VARIANT_TYPE ("(a{sv})"),
+	                                      data, len, FALSE, NULL, NULL);
+	g_variant_ref_sink (parameters);
+
+	options = options_from_variant (parameters);
+	process_event (self, options);
+
+	g_hash_table_destroy (options);
+	g_variant_unref (parameters);
+}
+
+static gboolean
+event_socket_ready (GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	guint n = 0;
+
+	/* Drain whatever is queued (up to EVENT_BATCH_MAX) in one wakeup, so a
+	 * burst of renewals doesn't cost a main loop iteration per event.
+	 */
+	while (n < EVENT_BATCH_MAX) {
+		ssize_t len;
+
+		len = recv (priv->event_fd, priv->event_buf, EVENT_BUF_SIZE, MSG_DONTWAIT | MSG_TRUNC);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				nm_log_warn (LOGD_DHCP, "DHCP event socket: read failed: %s", g_strerror (errno));
+			break;
+		}
+
+		n++;
+		if (len > EVENT_BUF_SIZE) {
+			nm_log_warn (LOGD_DHCP, "DHCP event socket: dropping oversized event (%zd bytes)", len);
+			continue;
+		}
+		if (len > 0)
+			handle_event_datagram (self, priv->event_buf, len);
+	}
+
+	if (n > 1)
+		nm_log_dbg (LOGD_DHCP, "DHCP event socket: processed %u events in one batch", n);
+
+	return TRUE;
+}
+
+static gboolean
+event_socket_open (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	struct sockaddr_un addr;
+	int fd, rcvbuf = EVENT_RCVBUF_SIZE;
+	mode_t old_umask;
+
+	fd = socket (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (fd < 0) {
+		nm_log_warn (LOGD_DHCP, "DHCP event socket: could not create: %s", g_strerror (errno));
+		return FALSE;
+	}
+
+	memset (&addr, 0, sizeof (addr));
+	addr.sun_family = AF_UNIX;
+	g_strlcpy (addr.sun_path, EVENT_SOCK_PATH, sizeof (addr.sun_path));
+
+	unlink (EVENT_SOCK_PATH);
+
+	/* Only root (ie, the DHCP client) may send events */
+	old_umask = umask (0077);
+	if (bind (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0) {
+		umask (old_umask);
+		nm_log_warn (LOGD_DHCP, "DHCP event socket: could not bind %s: %s",
+		             EVENT_SOCK_PATH, g_strerror (errno));
+		close (fd);
+		return FALSE;
+	}
+	umask (old_umask);
+
+	/* Leave room for bursts of renewals queueing up between wakeups */
+	if (setsockopt (fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof (rcvbuf)) < 0)
+		setsockopt (fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof (rcvbuf));
+
+	priv->event_fd = fd;
+	priv->event_buf = g_malloc (EVENT_BUF_SIZE);
+	priv->event_channel = g_io_channel_unix_new (fd);
+	priv->event_id = g_io_add_watch (priv->event_channel, G_IO_IN, event_socket_ready, self);
+	return TRUE;
+}
+
+static void
+event_socket_close (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+
+	if (priv->event_id) {
+		g_source_remove (priv->event_id);
+		priv->event_id = 0;
+	}
+	g_clear_pointer (&priv->event_channel, g_io_channel_unref);
+	g_clear_pointer (&priv->event_buf, g_free);
+
+	if (priv->event_fd >= 0) {
+		close (priv->event_fd);
+		priv->event_fd = -1;
+		unlink (EVENT_SOCK_PATH);
+	}
+}
+
 #if HAVE_DBUS_GLIB_100
 static void
 new_connection_cb (NMDBusManager *mgr,
@@ -206,6 +392,9 @@ nm_dhcp_listener_init (NMDhcpListener *self)
 	/* Maps DBusGConnection :: DBusGProxy */
 	priv->proxies = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_object_unref);
 
+	priv->event_fd = -1;
+	event_socket_open (self);
+
 	priv->dbus_mgr = nm_dbus_manager_get ();
 
 #if HAVE_DBUS_GLIB_100
@@ -246,6 +435,8 @@ dispose (GObject *object)
 	}
 	priv->dbus_mgr = NULL;
 
+	event_socket_close (NM_DHCP_LISTENER (object));
+
 	if (priv->proxies) {
 		g_hash_table_destroy (priv->proxies);
 		priv->proxies = NULL;
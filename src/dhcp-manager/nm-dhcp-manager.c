@@ -53,7 +53,7 @@ typedef GSList * (*GetLeaseConfigFunc) (const char *iface, const char *uuid, gbo
 
 typedef struct {
 	GType               client_type;
-	GHashTable *        clients;
+	GHashTable *        clients;  /* CLIENT_KEY (ifindex, ipv6) :: NMDhcpClient */
 	char *              default_hostname;
 } NMDhcpManagerPrivate;
 
@@ -134,28 +134,20 @@ is_client_enabled (const char *name, GError **error)
 
 /***************************************************/
 
+/* There is at most one client per (ifindex, address family) */
+#define CLIENT_KEY(ifindex, ipv6) GUINT_TO_POINTER ((((guint) (ifindex)) << 1) | !!(ipv6))
+
 static NMDhcpClient *
 get_client_for_ifindex (NMDhcpManager *manager, int ifindex, gboolean ip6)
 {
 	NMDhcpManagerPrivate *priv;
-	GHashTableIter iter;
-	gpointer value;
 
 	g_return_val_if_fail (NM_IS_DHCP_MANAGER (manager), NULL);
 	g_return_val_if_fail (ifindex > 0, NULL);
 
 	priv = NM_DHCP_MANAGER_GET_PRIVATE (manager);
 
-	g_hash_table_iter_init (&iter, priv->clients);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
-		NMDhcpClient *candidate = NM_DHCP_CLIENT (value);
-
-		if (   nm_dhcp_client_get_ifindex (candidate) == ifindex
-		    && nm_dhcp_client_get_ipv6 (candidate) == ip6)
-			return candidate;
-	}
-
-	return NULL;
+	return g_hash_table_lookup (priv->clients, CLIENT_KEY (ifindex, ip6));
 }
 
 static GType
@@ -189,6 +181,9 @@ static void client_state_changed (NMDhcpClient *client,
 static void
 remove_client (NMDhcpManager *self, NMDhcpClient *client)
 {
+	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
+	gpointer key;
+
 	g_signal_handlers_disconnect_by_func (client, client_state_changed, self);
 
 	/* Stopping the client is left up to the controlling device
@@ -196,7 +191,9 @@ remove_client (NMDhcpManager *self, NMDhcpClient *client)
 	 * the DHCP client.
 	 */
 
-	g_hash_table_remove (NM_DHCP_MANAGER_GET_PRIVATE (self)->clients, client);
+	key = CLIENT_KEY (nm_dhcp_client_get_ifindex (client), nm_dhcp_client_get_ipv6 (client));
+	if (g_hash_table_lookup (priv->clients, key) == client)
+		g_hash_table_remove (priv->clients, key);
 }
 
 static void
@@ -259,7 +256,7 @@ client_start (NMDhcpManager *self,
 	                       NM_DHCP_CLIENT_PRIORITY, priority,
 	                       NM_DHCP_CLIENT_TIMEOUT, timeout ? timeout : DHCP_TIMEOUT,
 	                       NULL);
-	g_hash_table_insert (NM_DHCP_MANAGER_GET_PRIVATE (self)->clients, client, g_object_ref (client));
+	g_hash_table_insert (priv->clients, CLIENT_KEY (ifindex, ipv6), g_object_ref (client));
 	g_signal_connect (client, NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED, G_CALLBACK (client_state_changed), self);
 
 	if (ipv6)
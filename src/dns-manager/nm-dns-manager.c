@@ -82,6 +82,16 @@ typedef struct {
 	guint8 hash[HASH_LEN];  /* SHA1 hash of current DNS config */
 	guint8 prev_hash[HASH_LEN];  /* Hash when begin_updates() was called */
 
+	/* NMIP4Config/NMIP6Config -> NMDnsConfigHash, the cached DNS-only
+	 * hash of each registered config. */
+	GHashTable *config_hashes;
+
+	/* Rendered resolv.conf last handed to resolvconf/netconfig */
+	char *last_dispatched;
+
+	guint updates_performed;
+	guint updates_skipped;
+
 	NMDnsManagerResolvConfMode resolv_conf_mode;
 	NMDnsPlugin *plugin;
 
@@ -96,6 +106,10 @@ enum {
 
 static guint signals[LAST_SIGNAL] = { 0 };
 
+typedef struct {
+	guint8 hash[HASH_LEN];
+	gboolean valid;
+} NMDnsConfigHash;
 
 typedef struct {
 	GPtrArray *nameservers;
@@ -321,37 +335,25 @@ dispatch_netconfig (char **searches,
 #endif
 
 
-static gboolean
-write_resolv_conf (FILE *f,
-                   char **searches,
-                   char **nameservers,
-                   GError **error)
+static char *
+create_resolv_conf (char **searches,
+                    char **nameservers)
 {
-	char *searches_str = NULL;
-	char *nameservers_str = NULL;
-	int i;
-	gboolean retval = FALSE;
 	GString *str;
+	int i;
 
-	if (fprintf (f, "%s","# Generated by NetworkManager\n") < 0) {
-		g_set_error (error,
-		             NM_MANAGER_ERROR,
-		             NM_MANAGER_ERROR_FAILED,
-		             "Could not write " _PATH_RESCONF ": %s\n",
-		             g_strerror (errno));
-		return FALSE;
-	}
+	str = g_string_new ("# Generated by NetworkManager\n");
 
 	if (searches) {
 		char *tmp_str;
 
 		tmp_str = g_strjoinv (" ", searches);
-		searches_str = g_strconcat ("search ", tmp_str, "\n", NULL);
+		g_string_append (str, "search ");
+		g_string_append (str, tmp_str);
+		g_string_append_c (str, '\n');
 		g_free (tmp_str);
 	}
 
-	str = g_string_new ("");
-
 	if (nameservers) {
 		int num = g_strv_length (nameservers);
 
@@ -370,23 +372,31 @@ write_resolv_conf (FILE *f,
 		}
 	}
 
-	nameservers_str = g_string_free (str, FALSE);
-
-	if (fprintf (f, "%s%s",
-	             searches_str ? searches_str : "",
-	             strlen (nameservers_str) ? nameservers_str : "") != -1)
-		retval = TRUE;
+	return g_string_free (str, FALSE);
+}
 
-	g_free (searches_str);
-	g_free (nameservers_str);
+static gboolean
+write_resolv_conf (FILE *f,
+                   const char *content,
+                   GError **error)
+{
+	if (fputs (content, f) < 0) {
+		g_set_error (error,
+		             NM_MANAGER_ERROR,
+		             NM_MANAGER_ERROR_FAILED,
+		             "Could not write " _PATH_RESCONF ": %s\n",
+		             g_strerror (errno));
+		return FALSE;
+	}
 
-	return retval;
+	return TRUE;
 }
 
 #ifdef RESOLVCONF_PATH
 static gboolean
 dispatch_resolvconf (char **searches,
                      char **nameservers,
+                     const char *content,
                      GError **error)
 {
 	char *cmd;
@@ -407,7 +417,7 @@ dispatch_resolvconf (char **searches,
 			             RESOLVCONF_PATH,
 			             g_strerror (errno));
 		else {
-			retval = write_resolv_conf (f, searches, nameservers, error);
+			retval = write_resolv_conf (f, content, error);
 			retval &= (pclose (f) == 0);
 		}
 	} else {
@@ -428,8 +438,21 @@ dispatch_resolvconf (char **searches,
 #define RESOLV_CONF_TMP "/etc/.resolv.conf.NetworkManager"
 
 static gboolean
-update_resolv_conf (char **searches,
-                    char **nameservers,
+resolv_conf_content_equal (const char *path, const char *content)
+{
+	char *old_content = NULL;
+	gboolean equal;
+
+	if (!g_file_get_contents (path, &old_content, NULL, NULL))
+		return FALSE;
+	equal = (strcmp (old_content, content) == 0);
+	g_free (old_content);
+	return equal;
+}
+
+static gboolean
+update_resolv_conf (const char *content,
+                    gboolean *out_written,
                     GError **error)
 {
 	FILE *f;
@@ -437,6 +460,14 @@ update_resolv_conf (char **searches,
 
 	g_return_val_if_fail (error != NULL, FALSE);
 
+	*out_written = FALSE;
+
+	/* Leave MY_RESOLV_CONF (and its mtime) alone if the rendered content
+	 * is byte-for-byte what is already there.
+	 */
+	if (resolv_conf_content_equal (MY_RESOLV_CONF, content))
+		goto check_link;
+
 	if ((f = fopen (MY_RESOLV_CONF_TMP, "w")) == NULL) {
 		g_set_error (error,
 		             NM_MANAGER_ERROR,
@@ -447,7 +478,7 @@ update_resolv_conf (char **searches,
 		return FALSE;
 	}
 
-	write_resolv_conf (f, searches, nameservers, error);
+	write_resolv_conf (f, content, error);
 
 	if (fclose (f) < 0) {
 		if (*error == NULL) {
@@ -475,18 +506,18 @@ update_resolv_conf (char **searches,
 		             g_strerror (errno));
 		return FALSE;
 	}
+	*out_written = TRUE;
 
+check_link:
 	/* Don't overwrite a symbolic link unless it points to MY_RESOLV_CONF. */
 	if (lstat (_PATH_RESCONF, &st) != -1) {
 		/* Don't overwrite a symbolic link. */
 		if (S_ISLNK (st.st_mode)) {
 			if (stat (_PATH_RESCONF, &st) != -1) {
-				char *path = g_file_read_link (_PATH_RESCONF, NULL);
-				gboolean not_ours = g_strcmp0 (path, MY_RESOLV_CONF) != 0;
-
-				g_free (path);
-				if (not_ours)
-					return TRUE;
+				/* If it is not ours we must not touch it, and if it already
+				 * points to MY_RESOLV_CONF there is nothing left to do.
+				 */
+				return TRUE;
 			} else {
 				if (errno != ENOENT)
 					return TRUE;
@@ -541,9 +572,89 @@ update_resolv_conf (char **searches,
 		return FALSE;
 	}
 
+	*out_written = TRUE;
 	return TRUE;
 }
 
+static void
+config_notify_cb (GObject *config, GParamSpec *pspec, gpointer user_data)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (user_data);
+	NMDnsConfigHash *data;
+
+	/* Only properties covered by the DNS-only config hash matter here */
+	if (   strcmp (pspec->name, NM_IP4_CONFIG_NAMESERVERS)
+	    && strcmp (pspec->name, NM_IP4_CONFIG_DOMAINS)
+	    && strcmp (pspec->name, NM_IP4_CONFIG_SEARCHES)
+	    && strcmp (pspec->name, NM_IP4_CONFIG_WINS_SERVERS))
+		return;
+
+	data = g_hash_table_lookup (priv->config_hashes, config);
+	if (data)
+		data->valid = FALSE;
+}
+
+static void
+config_track (NMDnsManager *self, gpointer config)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	NMDnsConfigHash *data;
+
+	data = g_hash_table_lookup (priv->config_hashes, config);
+	if (!data) {
+		data = g_slice_new0 (NMDnsConfigHash);
+		g_hash_table_insert (priv->config_hashes, config, data);
+		g_signal_connect (config, "notify", G_CALLBACK (config_notify_cb), self);
+	}
+
+	/* The interface name may have changed, so always rehash on (re-)add */
+	data->valid = FALSE;
+}
+
+static void
+config_untrack (NMDnsManager *self, gpointer config)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+
+	if (g_hash_table_remove (priv->config_hashes, config))
+		g_signal_handlers_disconnect_by_func (config, config_notify_cb, self);
+}
+
+static void
+config_hash_free (gpointer data)
+{
+	g_slice_free (NMDnsConfigHash, data);
+}
+
+static void
+hash_one_config (NMDnsManager *self, GChecksum *sum, gpointer config)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	NMDnsConfigHash *data;
+
+	data = g_hash_table_lookup (priv->config_hashes, config);
+	g_return_if_fail (data != NULL);
+
+	if (!data->valid) {
+		GChecksum *one;
+		gsize len = HASH_LEN;
+
+		one = g_checksum_new (G_CHECKSUM_SHA1);
+		if (NM_IS_IP4_CONFIG (config))
+			nm_ip4_config_hash (NM_IP4_CONFIG (config), one, TRUE);
+		else if (NM_IS_IP6_CONFIG (config))
+			nm_ip6_config_hash (NM_IP6_CONFIG (config), one, TRUE);
+		g_checksum_get_digest (one, data->hash, &len);
+		g_checksum_free (one);
+		data->valid = TRUE;
+	}
+
+	g_checksum_update (sum, data->hash, HASH_LEN);
+}
+
+/* Combines the cached per-config hashes; only configs whose DNS properties
+ * changed since the last call are walked again.
+ */
 static void
 compute_hash (NMDnsManager *self, guint8 buffer[HASH_LEN])
 {
@@ -556,33 +667,46 @@ compute_hash (NMDnsManager *self, guint8 buffer[HASH_LEN])
 	g_assert (len == g_checksum_type_get_length (G_CHECKSUM_SHA1));
 
 	if (priv->ip4_vpn_config)
-		nm_ip4_config_hash (priv->ip4_vpn_config, sum, TRUE);
+		hash_one_config (self, sum, priv->ip4_vpn_config);
 	if (priv->ip4_device_config)
-		nm_ip4_config_hash (priv->ip4_device_config, sum, TRUE);
+		hash_one_config (self, sum, priv->ip4_device_config);
 
 	if (priv->ip6_vpn_config)
-		nm_ip6_config_hash (priv->ip6_vpn_config, sum, TRUE);
+		hash_one_config (self, sum, priv->ip6_vpn_config);
 	if (priv->ip6_device_config)
-		nm_ip6_config_hash (priv->ip6_device_config, sum, TRUE);
+		hash_one_config (self, sum, priv->ip6_device_config);
 
 	/* add any other configs we know about */
 	for (iter = priv->configs; iter; iter = g_slist_next (iter)) {
 		if (   (iter->data == priv->ip4_vpn_config)
-		    && (iter->data == priv->ip4_device_config)
-		    && (iter->data == priv->ip6_vpn_config)
-		    && (iter->data == priv->ip6_device_config))
+		    || (iter->data == priv->ip4_device_config)
+		    || (iter->data == priv->ip6_vpn_config)
+		    || (iter->data == priv->ip6_device_config))
 			continue;
 
-		if (NM_IS_IP4_CONFIG (iter->data))
-			nm_ip4_config_hash (NM_IP4_CONFIG (iter->data), sum, TRUE);
-		else if (NM_IS_IP6_CONFIG (iter->data))
-			nm_ip6_config_hash (NM_IP6_CONFIG (iter->data), sum, TRUE);
+		hash_one_config (self, sum, iter->data);
 	}
 
 	g_checksum_get_digest (sum, buffer, &len);
 	g_checksum_free (sum);
 }
 
+#if defined(RESOLVCONF_PATH) || defined(NETCONFIG_PATH)
+static char *
+create_dispatch_key (const char *content, const char *nis_domain, char **nis_servers)
+{
+	char *servers, *key;
+
+	servers = nis_servers ? g_strjoinv (" ", nis_servers) : NULL;
+	key = g_strdup_printf ("%s%s\n%s\n",
+	                       content,
+	                       nis_domain ? nis_domain : "",
+	                       servers ? servers : "");
+	g_free (servers);
+	return key;
+}
+#endif
+
 static gboolean
 update_dns (NMDnsManager *self,
             gboolean no_caching,
@@ -595,8 +719,12 @@ update_dns (NMDnsManager *self,
 	char **searches = NULL;
 	char **nameservers = NULL;
 	char **nis_servers = NULL;
+	char *content;
+#if defined(RESOLVCONF_PATH) || defined(NETCONFIG_PATH)
+	char *dispatch_key;
+#endif
 	int num, i, len;
-	gboolean success = FALSE, caching = FALSE;
+	gboolean success = FALSE, caching = FALSE, written = FALSE;
 
 	g_return_val_if_fail (error != NULL, FALSE);
 	g_return_val_if_fail (*error == NULL, FALSE);
@@ -765,24 +893,54 @@ update_dns (NMDnsManager *self,
 		nameservers[0] = g_strdup ("127.0.0.1");
 	}
 
+	content = create_resolv_conf (searches, nameservers);
+
+#if defined(RESOLVCONF_PATH) || defined(NETCONFIG_PATH)
+	dispatch_key = create_dispatch_key (content, nis_domain, nis_servers);
+	if (!g_strcmp0 (dispatch_key, priv->last_dispatched)) {
+		nm_log_dbg (LOGD_DNS, "DNS: configuration already dispatched; not spawning helper");
+		success = TRUE;
+	}
+#endif
+
 #ifdef RESOLVCONF_PATH
-	success = dispatch_resolvconf (searches, nameservers, error);
+	if (success == FALSE)
+		success = written = dispatch_resolvconf (searches, nameservers, content, error);
 #endif
 
 #ifdef NETCONFIG_PATH
 	if (success == FALSE) {
-		success = dispatch_netconfig (searches, nameservers,
-		                              nis_domain, nis_servers, error);
+		success = written = dispatch_netconfig (searches, nameservers,
+		                                        nis_domain, nis_servers, error);
 	}
 #endif
 
+#if defined(RESOLVCONF_PATH) || defined(NETCONFIG_PATH)
+	if (written) {
+		g_free (priv->last_dispatched);
+		priv->last_dispatched = dispatch_key;
+		dispatch_key = NULL;
+	} else if (success == FALSE)
+		g_clear_pointer (&priv->last_dispatched, g_free);
+	g_free (dispatch_key);
+#endif
+
 	if (success == FALSE)
-		success = update_resolv_conf (searches, nameservers, error);
+		success = update_resolv_conf (content, &written, error);
+
+	if (success) {
+		if (written)
+			priv->updates_performed++;
+		else {
+			priv->updates_skipped++;
+			nm_log_dbg (LOGD_DNS, "DNS: resolv.conf unchanged; skipped write");
+		}
 
-	/* signal that resolv.conf was changed */
-	if (success)
+		/* signal that resolv.conf was changed */
 		g_signal_emit (self, signals[CONFIG_CHANGED], 0);
+	}
 
+	g_free (content);
 	if (searches)
 		g_strfreev (searches);
 	if (nameservers)
@@ -842,6 +1000,7 @@ nm_dns_manager_add_ip4_config (NMDnsManager *mgr,
 	/* Don't allow the same zone added twice */
 	if (!g_slist_find (priv->configs, config))
 		priv->configs = g_slist_append (priv->configs, g_object_ref (config));
+	config_track (mgr, config);
 
 	if (!priv->updates_queue && !update_dns (mgr, FALSE, &error)) {
 		nm_log_warn (LOGD_DNS, "could not commit DNS changes: (%d) %s",
@@ -869,6 +1028,7 @@ nm_dns_manager_remove_ip4_config (NMDnsManager *mgr, NMIP4Config *config)
 		return FALSE;
 
 	priv->configs = g_slist_remove (priv->configs, config);
+	config_untrack (mgr, config);
 
 	if (config == priv->ip4_vpn_config)
 		priv->ip4_vpn_config = NULL;
@@ -919,6 +1079,7 @@ nm_dns_manager_add_ip6_config (NMDnsManager *mgr,
 	/* Don't allow the same zone added twice */
 	if (!g_slist_find (priv->configs, config))
 		priv->configs = g_slist_append (priv->configs, g_object_ref (config));
+	config_track (mgr, config);
 
 	if (!priv->updates_queue && !update_dns (mgr, FALSE, &error)) {
 		nm_log_warn (LOGD_DNS, "could not commit DNS changes: (%d) %s",
@@ -946,6 +1107,7 @@ nm_dns_manager_remove_ip6_config (NMDnsManager *mgr, NMIP6Config *config)
 		return FALSE;
 
 	priv->configs = g_slist_remove (priv->configs, config);
+	config_untrack (mgr, config);
 
 	if (config == priv->ip6_vpn_config)
 		priv->ip6_vpn_config = NULL;
@@ -1012,6 +1174,30 @@ nm_dns_manager_get_resolv_conf_mode (NMDnsManager *mgr)
 	return NM_DNS_MANAGER_GET_PRIVATE (mgr)->resolv_conf_mode;
 }
 
+/**
+ * nm_dns_manager_get_update_counters:
+ * @mgr: the #NMDnsManager
+ * @out_performed: (allow-none): on return, the number of DNS updates that
+ *   actually rewrote resolv.conf or invoked resolvconf/netconfig
+ * @out_skipped: (allow-none): on return, the number of DNS updates that
+ *   were dropped because the resulting configuration was unchanged
+ */
+void
+nm_dns_manager_get_update_counters (NMDnsManager *mgr,
+                                    guint *out_performed,
+                                    guint *out_skipped)
+{
+	NMDnsManagerPrivate *priv;
+
+	g_return_if_fail (NM_IS_DNS_MANAGER (mgr));
+
+	priv = NM_DNS_MANAGER_GET_PRIVATE (mgr);
+	if (out_performed)
+		*out_performed = priv->updates_performed;
+	if (out_skipped)
+		*out_skipped = priv->updates_skipped;
+}
+
 void
 nm_dns_manager_begin_updates (NMDnsManager *mgr, const char *func)
 {
@@ -1048,6 +1234,8 @@ nm_dns_manager_end_updates (NMDnsManager *mgr, const char *func)
 
 	priv->updates_queue--;
 	if ((priv->updates_queue > 0) || (changed == FALSE)) {
+		if (priv->updates_queue == 0)
+			priv->updates_skipped++;
 		nm_log_dbg (LOGD_DNS, "(%s): no DNS changes to commit (%d)", func, priv->updates_queue);
 		return;
 	}
@@ -1110,6 +1298,9 @@ nm_dns_manager_init (NMDnsManager *self)
 {
 	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 
+	priv->config_hashes = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+	                                             NULL, config_hash_free);
+
 	/* Set the initial hash */
 	compute_hash (self, NM_DNS_MANAGER_GET_PRIVATE (self)->hash);
 
@@ -1127,6 +1318,7 @@ dispose (GObject *object)
 	NMDnsManager *self = NM_DNS_MANAGER (object);
 	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 	GError *error = NULL;
+	GSList *iter;
 
 	g_clear_object (&priv->plugin);
 
@@ -1143,6 +1335,8 @@ dispose (GObject *object)
 		priv->dns_touched = FALSE;
 	}
 
+	for (iter = priv->configs; iter; iter = g_slist_next (iter))
+		config_untrack (self, iter->data);
 	g_slist_free_full (priv->configs, g_object_unref);
 	priv->configs = NULL;
 
@@ -1155,6 +1349,8 @@ finalize (GObject *object)
 	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (object);
 
 	g_free (priv->hostname);
+	g_free (priv->last_dispatched);
+	g_hash_table_unref (priv->config_hashes);
 
 	G_OBJECT_CLASS (nm_dns_manager_parent_class)->finalize (object);
 }
@@ -101,6 +101,10 @@ typedef enum {
 
 NMDnsManagerResolvConfMode nm_dns_manager_get_resolv_conf_mode (NMDnsManager *mgr);
 
+void nm_dns_manager_get_update_counters (NMDnsManager *mgr,
+                                         guint *out_performed,
+                                         guint *out_skipped);
+
 G_END_DECLS
 
 #endif /* __NETWORKMANAGER_DNS_MANAGER_H__ */
@@ -19,13 +19,43 @@
  */
 #include "config.h"
 
+#include <sys/wait.h>
+
 #include "nm-dns-unbound.h"
 #include "NetworkManagerUtils.h"
+#include "nm-logging.h"
 
 G_DEFINE_TYPE (NMDnsUnbound, nm_dns_unbound, NM_TYPE_DNS_PLUGIN)
 
+#define NM_DNS_UNBOUND_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_DNS_UNBOUND, NMDnsUnboundPrivate))
+
+typedef struct {
+	guint spawn_id;
+} NMDnsUnboundPrivate;
+
 /*******************************************/
 
+static void
+trigger_script_done (int child_status, const char *out, const char *err,
+                     GError *error, gpointer user_data)
+{
+	NMDnsPlugin *plugin = NM_DNS_PLUGIN (user_data);
+
+	NM_DNS_UNBOUND_GET_PRIVATE (plugin)->spawn_id = 0;
+
+	if (error)
+		nm_log_warn (LOGD_DNS, "dnssec-trigger-script failed: %s", error->message);
+	else if (!WIFEXITED (child_status) || WEXITSTATUS (child_status))
+		nm_log_warn (LOGD_DNS, "dnssec-trigger-script exited with status %d", child_status);
+	else
+		return;
+
+	/* Unbound was not configured, so resolv.conf must not point at the
+	 * local resolver; NMDnsManager rewrites it without caching.
+	 */
+	g_signal_emit_by_name (plugin, NM_DNS_PLUGIN_FAILED);
+}
+
 static gboolean
 update (NMDnsPlugin *plugin,
         const GSList *vpn_configs,
@@ -42,7 +72,18 @@ update (NMDnsPlugin *plugin,
 	 * without calling custom scripts. The dnssec-trigger functionality
 	 * may be eventually merged into NetworkManager.
 	 */
-	return nm_spawn_process ("/usr/libexec/dnssec-trigger-script --async --update") == 0;
+	NMDnsUnboundPrivate *priv = NM_DNS_UNBOUND_GET_PRIVATE (plugin);
+	const char *argv[] = { "/usr/libexec/dnssec-trigger-script", "--async", "--update", NULL };
+
+	/* The script only notifies dnssec-trigger, so do not wait for it.
+	 * Only the outcome of the latest update matters; if it fails, the
+	 * 'failed' signal makes NMDnsManager drop the caching configuration.
+	 */
+	if (priv->spawn_id)
+		nm_utils_spawn_cancel (priv->spawn_id);
+	priv->spawn_id = nm_utils_spawn_async (argv, NM_UTILS_SPAWN_FLAGS_NONE, 20000, LOGD_DNS,
+	                                       trigger_script_done, plugin, NULL);
+	return TRUE;
 }
 
 static gboolean
@@ -70,10 +111,28 @@ nm_dns_unbound_init (NMDnsUnbound *unbound)
 {
 }
 
+static void
+dispose (GObject *object)
+{
+	NMDnsUnboundPrivate *priv = NM_DNS_UNBOUND_GET_PRIVATE (object);
+
+	if (priv->spawn_id) {
+		nm_utils_spawn_cancel (priv->spawn_id);
+		priv->spawn_id = 0;
+	}
+
+	G_OBJECT_CLASS (nm_dns_unbound_parent_class)->dispose (object);
+}
+
 static void
 nm_dns_unbound_class_init (NMDnsUnboundClass *klass)
 {
 	NMDnsPluginClass *plugin_class = NM_DNS_PLUGIN_CLASS (klass);
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (NMDnsUnboundPrivate));
+
+	object_class->dispose = dispose;
 
 	plugin_class->update = update;
 	plugin_class->is_caching = is_caching;
@@ -317,6 +317,8 @@ main (int argc, char *argv[])
 		}
 	}
 
+	nm_logging_debug_buffer_setup (nm_config_get_log_debug_buffer_size (config));
+
 	/* Parse the state file */
 	if (!parse_state_file (state_file, &net_enabled, &wifi_enabled, &wwan_enabled, &wimax_enabled, &error)) {
 		fprintf (stderr, _("State file %s parsing failed: (%d) %s\n"),
@@ -353,7 +355,7 @@ main (int argc, char *argv[])
 		g_log_set_always_fatal (fatal_mask);
 	}
 
-	nm_logging_syslog_openlog (debug);
+	nm_logging_syslog_openlog (nm_config_get_log_backend (config), debug);
 
 #if !GLIB_CHECK_VERSION (2, 35, 0)
 	g_type_init ();
@@ -23,6 +23,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -177,28 +178,354 @@ nm_act_request_cancel_secrets (NMActRequest *self, guint32 call_id)
 
 /********************************************************************/
 
+#define IPTABLES_RESTORE_PATH IPTABLES_PATH "-restore"
+
+static ShareRule *
+share_rule_new (const char *table, const char *rule)
+{
+	ShareRule *share_rule;
+
+	share_rule = g_malloc0 (sizeof (ShareRule));
+	share_rule->table = g_strdup (table);
+	share_rule->rule = g_strdup (rule);
+	return share_rule;
+}
+
+static void
+share_rule_free (ShareRule *rule)
+{
+	g_free (rule->table);
+	g_free (rule->rule);
+	g_free (rule);
+}
+
 static void
 clear_share_rules (NMActRequest *req)
 {
 	NMActRequestPrivate *priv = NM_ACT_REQUEST_GET_PRIVATE (req);
-	GSList *iter;
 
-	for (iter = priv->share_rules; iter; iter = g_slist_next (iter)) {
-		ShareRule *rule = (ShareRule *) iter->data;
+	g_slist_free_full (priv->share_rules, (GDestroyNotify) share_rule_free);
+	priv->share_rules = NULL;
+}
+
+/* Share rules are applied asynchronously, so that bringing up a shared
+ * connection does not block the main loop on one iptables process per rule.
+ * Each batch is normally one "iptables-restore --noflush" transaction; the
+ * batches run one at a time, so that a teardown can never overtake the
+ * insertion of the same rules.  Batches own copies of their rules because
+ * the activation request may be gone by the time they run.
+ */
+typedef struct {
+	GPtrArray *rules;       /* ShareRule, in the order they are applied */
+	gboolean insert;
+	gboolean is_rollback;   /* undoes part of a failed insert */
+	gboolean one_by_one;    /* one iptables process per rule */
+	guint next;             /* one_by_one: index of the rule being applied */
+	guint failed;
+	gint64 start_time;
+} ShareBatch;
+
+static GQueue share_queue = G_QUEUE_INIT;
+static gboolean share_batch_running = FALSE;
+
+static void share_queue_run_next (void);
+
+static ShareBatch *
+share_batch_new (gboolean insert)
+{
+	ShareBatch *batch;
+
+	batch = g_slice_new0 (ShareBatch);
+	batch->rules = g_ptr_array_new_with_free_func ((GDestroyNotify) share_rule_free);
+	batch->insert = insert;
+	return batch;
+}
+
+static void
+share_batch_free (ShareBatch *batch)
+{
+	g_ptr_array_unref (batch->rules);
+	g_slice_free (ShareBatch, batch);
+}
+
+static void
+share_batch_add_rule (ShareBatch *batch, const ShareRule *rule)
+{
+	g_ptr_array_add (batch->rules, share_rule_new (rule->table, rule->rule));
+}
+
+static void
+share_queue_push (ShareBatch *batch, gboolean urgent)
+{
+	if (urgent)
+		g_queue_push_head (&share_queue, batch);
+	else
+		g_queue_push_tail (&share_queue, batch);
+
+	if (!share_batch_running)
+		share_queue_run_next ();
+}
 
-		g_free (rule->table);
-		g_free (rule->rule);
-		g_free (rule);
+static void
+share_batch_done (ShareBatch *batch)
+{
+	gint64 msec = (g_get_monotonic_time () - batch->start_time) / 1000;
+
+	if (batch->is_rollback && batch->failed) {
+		/* Nothing to undo; the table was never committed */
+	} else if (batch->failed) {
+		nm_log_warn (LOGD_SHARING, "%s %u of %u sharing rules failed after %" G_GINT64_FORMAT " ms",
+		             batch->insert ? "inserting" : "removing",
+		             batch->failed, batch->rules->len, msec);
+	} else {
+		nm_log_info (LOGD_SHARING, "%s %u sharing rules took %" G_GINT64_FORMAT " ms",
+		             batch->insert ? "inserting" : "removing",
+		             batch->rules->len, msec);
 	}
 
-	g_slist_free (priv->share_rules);
-	priv->share_rules = NULL;
+	share_batch_free (batch);
+	share_batch_running = FALSE;
+	share_queue_run_next ();
+}
+
+static void share_batch_spawn_one (ShareBatch *batch);
+
+static void
+share_one_done (GPid pid, gint status, gpointer user_data)
+{
+	ShareBatch *batch = user_data;
+
+	g_spawn_close_pid (pid);
+
+	if (!WIFEXITED (status) || WEXITSTATUS (status)) {
+		nm_log_warn (LOGD_SHARING, "** Command returned exit status %d.",
+		             WIFEXITED (status) ? WEXITSTATUS (status) : -1);
+		batch->failed++;
+	}
+
+	batch->next++;
+	share_batch_spawn_one (batch);
+}
+
+/* Fallback for when iptables-restore is unusable, and for teardowns that
+ * failed as a whole because some of the rules were already gone.
+ */
+static void
+share_batch_spawn_one (ShareBatch *batch)
+{
+	char *envp[1] = { NULL };
+
+	while (batch->next < batch->rules->len) {
+		ShareRule *rule = batch->rules->pdata[batch->next];
+		gs_strfreev char **argv = NULL;
+		gs_free char *cmd = NULL;
+		GError *error = NULL;
+		GPid pid;
+
+		cmd = g_strdup_printf ("%s --table %s %s %s",
+		                       IPTABLES_PATH,
+		                       rule->table,
+		                       batch->insert ? "--insert" : "--delete",
+		                       rule->rule);
+		argv = g_strsplit (cmd, " ", 0);
+
+		nm_log_info (LOGD_SHARING, "Executing: %s", cmd);
+		if (g_spawn_async ("/", argv, envp,
+		                   G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL,
+		                   NULL, NULL, &pid, &error)) {
+			g_child_watch_add (pid, share_one_done, batch);
+			return;
+		}
+
+		nm_log_warn (LOGD_SHARING, "Error executing command: (%d) %s",
+		             error ? error->code : -1,
+		             (error && error->message) ? error->message : "(unknown)");
+		g_clear_error (&error);
+		batch->failed++;
+		batch->next++;
+	}
+
+	share_batch_done (batch);
+}
+
+/* Returns the iptables-restore input for @batch.  Rules are grouped by
+ * table, keeping their relative order within each table.
+ */
+static char *
+share_batch_to_restore_input (ShareBatch *batch)
+{
+	GString *str = g_string_sized_new (1024);
+	GPtrArray *tables = g_ptr_array_new ();
+	guint i, j;
+
+	for (i = 0; i < batch->rules->len; i++) {
+		ShareRule *rule = batch->rules->pdata[i];
+
+		for (j = 0; j < tables->len; j++) {
+			if (!strcmp (tables->pdata[j], rule->table))
+				break;
+		}
+		if (j == tables->len)
+			g_ptr_array_add (tables, rule->table);
+	}
+
+	for (j = 0; j < tables->len; j++) {
+		const char *table = tables->pdata[j];
+
+		g_string_append_printf (str, "*%s\n", table);
+		for (i = 0; i < batch->rules->len; i++) {
+			ShareRule *rule = batch->rules->pdata[i];
+
+			if (!strcmp (rule->table, table))
+				g_string_append_printf (str, "%s %s\n", batch->insert ? "-I" : "-D", rule->rule);
+		}
+		g_string_append (str, "COMMIT\n");
+	}
+
+	g_ptr_array_free (tables, TRUE);
+	return g_string_free (str, FALSE);
+}
+
+/* iptables-restore commits each table on its own, so after a failed insert
+ * some tables may hold the new rules and others not.  Queue one delete
+ * transaction per table; those for tables that were never committed fail
+ * harmlessly.
+ */
+static void
+share_batch_rollback (ShareBatch *failed)
+{
+	GHashTable *by_table;
+	GHashTableIter iter;
+	ShareBatch *batch;
+	int i;
+
+	by_table = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = failed->rules->len - 1; i >= 0; i--) {
+		ShareRule *rule = failed->rules->pdata[i];
+
+		batch = g_hash_table_lookup (by_table, rule->table);
+		if (!batch) {
+			batch = share_batch_new (FALSE);
+			batch->is_rollback = TRUE;
+			g_hash_table_insert (by_table, rule->table, batch);
+		}
+		share_batch_add_rule (batch, rule);
+	}
+
+	g_hash_table_iter_init (&iter, by_table);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &batch))
+		g_queue_push_head (&share_queue, batch);
+	g_hash_table_destroy (by_table);
+}
+
+static void
+share_restore_done (GPid pid, gint status, gpointer user_data)
+{
+	ShareBatch *batch = user_data;
+	ShareBatch *retry;
+	guint i;
+
+	g_spawn_close_pid (pid);
+
+	if (WIFEXITED (status) && WEXITSTATUS (status) == 0) {
+		share_batch_done (batch);
+		return;
+	}
+
+	batch->failed = batch->rules->len;
+
+	if (batch->is_rollback) {
+		nm_log_dbg (LOGD_SHARING, "rollback of table '%s' failed; rules were not committed",
+		            ((ShareRule *) batch->rules->pdata[0])->table);
+	} else if (batch->insert) {
+		nm_log_warn (LOGD_SHARING, "iptables-restore failed with status %d; rolling back sharing rules",
+		             WIFEXITED (status) ? WEXITSTATUS (status) : -1);
+		share_batch_rollback (batch);
+	} else {
+		/* A missing rule makes the whole transaction fail; remove the
+		 * remaining ones individually.
+		 */
+		nm_log_warn (LOGD_SHARING, "iptables-restore failed with status %d; removing sharing rules one by one",
+		             WIFEXITED (status) ? WEXITSTATUS (status) : -1);
+		retry = share_batch_new (FALSE);
+		retry->one_by_one = TRUE;
+		for (i = 0; i < batch->rules->len; i++)
+			share_batch_add_rule (retry, batch->rules->pdata[i]);
+		g_queue_push_head (&share_queue, retry);
+	}
+
+	share_batch_done (batch);
+}
+
+static gboolean
+share_batch_spawn_restore (ShareBatch *batch)
+{
+	char *argv[] = { IPTABLES_RESTORE_PATH, "--noflush", NULL };
+	char *envp[1] = { NULL };
+	gs_free char *input = NULL;
+	GError *error = NULL;
+	GPid pid;
+	int fd;
+	gsize len, written = 0;
+
+	input = share_batch_to_restore_input (batch);
+	len = strlen (input);
+
+	nm_log_dbg (LOGD_SHARING, "Executing: %s %s with input:\n%s", argv[0], argv[1], input);
+	if (!g_spawn_async_with_pipes ("/", argv, envp,
+	                               G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL,
+	                               NULL, NULL, &pid, &fd, NULL, NULL, &error)) {
+		nm_log_warn (LOGD_SHARING, "Error executing %s: (%d) %s",
+		             argv[0],
+		             error ? error->code : -1,
+		             (error && error->message) ? error->message : "(unknown)");
+		g_clear_error (&error);
+		return FALSE;
+	}
+
+	/* A few hundred bytes at most; fits in the pipe buffer */
+	while (written < len) {
+		ssize_t n = write (fd, input + written, len - written);
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			/* iptables-restore died; the child watch reports it */
+			break;
+		}
+		written += n;
+	}
+	close (fd);
+
+	g_child_watch_add (pid, share_restore_done, batch);
+	return TRUE;
+}
+
+static void
+share_queue_run_next (void)
+{
+	ShareBatch *batch;
+
+	batch = g_queue_pop_head (&share_queue);
+	if (!batch)
+		return;
+
+	share_batch_running = TRUE;
+	batch->start_time = g_get_monotonic_time ();
+
+	if (!batch->one_by_one) {
+		if (share_batch_spawn_restore (batch))
+			return;
+		batch->one_by_one = TRUE;
+	}
+	share_batch_spawn_one (batch);
 }
 
 void
 nm_act_request_set_shared (NMActRequest *req, gboolean shared)
 {
 	NMActRequestPrivate *priv = NM_ACT_REQUEST_GET_PRIVATE (req);
+	ShareBatch *batch;
 	GSList *list, *iter;
 
 	g_return_if_fail (NM_IS_ACT_REQUEST (req));
@@ -211,37 +538,11 @@ nm_act_request_set_shared (NMActRequest *req, gboolean shared)
 		list = g_slist_reverse (list);
 
 	/* Send the rules to iptables */
-	for (iter = list; iter; iter = g_slist_next (iter)) {
-		ShareRule *rule = (ShareRule *) iter->data;
-		char *envp[1] = { NULL };
-		gs_strfreev char **argv = NULL;
-		gs_free char *cmd = NULL;
-
-		cmd = g_strdup_printf ("%s --table %s %s %s",
-		                       IPTABLES_PATH,
-		                       rule->table,
-		                       shared ? "--insert" : "--delete",
-		                       rule->rule);
-		if (!cmd)
-			continue;
-
-		argv = g_strsplit (cmd, " ", 0);
-		if (argv && argv[0]) {
-			int status;
-			GError *error = NULL;
-
-			nm_log_info (LOGD_SHARING, "Executing: %s", cmd);
-			if (!g_spawn_sync ("/", argv, envp, G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL,
-			                   NULL, NULL, NULL, NULL, &status, &error)) {
-				nm_log_warn (LOGD_SHARING, "Error executing command: (%d) %s",
-				             error ? error->code : -1,
-				             (error && error->message) ? error->message : "(unknown)");
-				g_clear_error (&error);
-			} else if (WEXITSTATUS (status)) {
-				nm_log_warn (LOGD_SHARING, "** Command returned exit status %d.",
-				             WEXITSTATUS (status));
-			}
-		}
+	if (list) {
+		batch = share_batch_new (shared);
+		for (iter = list; iter; iter = g_slist_next (iter))
+			share_batch_add_rule (batch, iter->data);
+		share_queue_push (batch, FALSE);
 	}
 
 	g_slist_free (list);
@@ -271,9 +572,7 @@ nm_act_request_add_share_rule (NMActRequest *req,
 	g_return_if_fail (table != NULL);
 	g_return_if_fail (table_rule != NULL);
 
-	rule = g_malloc0 (sizeof (ShareRule));
-	rule->table = g_strdup (table);
-	rule->rule = g_strdup (table_rule);
+	rule = share_rule_new (table, table_rule);
 	priv->share_rules = g_slist_append (priv->share_rules, rule);
 }
 
@@ -423,7 +423,8 @@ nm_auth_is_subject_in_acl (NMConnection *connection,
                            char **out_error_desc)
 {
 	NMSettingConnection *s_con;
-	const char *user = NULL;
+	char *user = NULL;
+	gboolean allowed;
 	gulong uid;
 
 	g_return_val_if_fail (connection != NULL, FALSE);
@@ -457,11 +458,14 @@ nm_auth_is_subject_in_acl (NMConnection *connection,
 		/* This can only happen when called from AddAndActivate, so we know
 		 * the user will be authorized when the connection is completed.
 		 */
+		g_free (user);
 		return TRUE;
 	}
 
 	/* Match the username returned by the session check to a user in the ACL */
-	if (!nm_setting_connection_permissions_user_allowed (s_con, user)) {
+	allowed = nm_setting_connection_permissions_user_allowed (s_con, user);
+	g_free (user);
+	if (!allowed) {
 		if (out_error_desc)
 			*out_error_desc = g_strdup_printf ("uid %lu has no permission to perform this operation", uid);
 		return FALSE;
@@ -53,6 +53,8 @@ typedef struct {
 
 	char *log_level;
 	char *log_domains;
+	char *log_backend;
+	guint log_debug_buffer_size;
 
 	char *debug;
 
@@ -181,6 +183,22 @@ nm_config_get_log_domains (NMConfig *config)
 	return NM_CONFIG_GET_PRIVATE (config)->log_domains;
 }
 
+const char *
+nm_config_get_log_backend (NMConfig *config)
+{
+	g_return_val_if_fail (config != NULL, NULL);
+
+	return NM_CONFIG_GET_PRIVATE (config)->log_backend;
+}
+
+guint
+nm_config_get_log_debug_buffer_size (NMConfig *config)
+{
+	g_return_val_if_fail (config != NULL, 0);
+
+	return NM_CONFIG_GET_PRIVATE (config)->log_debug_buffer_size;
+}
+
 const char *
 nm_config_get_debug (NMConfig *config)
 {
@@ -600,6 +618,8 @@ nm_config_new (GError **error)
 
 	priv->log_level = g_key_file_get_value (priv->keyfile, "logging", "level", NULL);
 	priv->log_domains = g_key_file_get_value (priv->keyfile, "logging", "domains", NULL);
+	priv->log_backend = g_key_file_get_value (priv->keyfile, "logging", "backend", NULL);
+	priv->log_debug_buffer_size = MAX (g_key_file_get_integer (priv->keyfile, "logging", "debug-buffer-size", NULL), 0);
 
 	priv->debug = g_key_file_get_value (priv->keyfile, "main", "debug", NULL);
 
@@ -650,6 +670,7 @@ finalize (GObject *gobject)
 	g_free (priv->dns_mode);
 	g_free (priv->log_level);
 	g_free (priv->log_domains);
+	g_free (priv->log_backend);
 	g_free (priv->debug);
 	g_free (priv->connectivity_uri);
 	g_free (priv->connectivity_response);
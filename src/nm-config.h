@@ -57,6 +57,8 @@ const char *nm_config_get_dhcp_client (NMConfig *config);
 const char *nm_config_get_dns_mode (NMConfig *config);
 const char *nm_config_get_log_level (NMConfig *config);
 const char *nm_config_get_log_domains (NMConfig *config);
+const char *nm_config_get_log_backend (NMConfig *config);
+guint nm_config_get_log_debug_buffer_size (NMConfig *config);
 const char *nm_config_get_debug (NMConfig *config);
 const char *nm_config_get_connectivity_uri (NMConfig *config);
 guint nm_config_get_connectivity_interval (NMConfig *config);
@@ -21,14 +21,18 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <string.h>
 #if WITH_CONCHECK
+#include <sys/socket.h>
 #include <libsoup/soup.h>
 #endif
 
 #include "nm-connectivity.h"
 #include "nm-logging.h"
 #include "nm-config.h"
+#include "nm-platform.h"
+#include "gsystem-local-alloc.h"
 
 G_DEFINE_TYPE (NMConnectivity, nm_connectivity, G_TYPE_OBJECT)
 
@@ -37,15 +41,57 @@ G_DEFINE_TYPE (NMConnectivity, nm_connectivity, G_TYPE_OBJECT)
 
 #define DEFAULT_RESPONSE "NetworkManager is online" /* NOT LOCALIZED */
 
+/* Per-device checks back off up to this many times the configured
+ * interval while their result doesn't change, but never beyond
+ * BACKOFF_MAX_SECONDS unless the configured interval itself is longer.
+ */
+#define BACKOFF_MAX_FACTOR   8
+#define BACKOFF_MAX_SECONDS  3600
+
+/* Route and link changes tend to come in bursts; wait this long before
+ * re-checking the affected device.
+ */
+#define RECHECK_DELAY_SECONDS 1
+
+#if WITH_CONCHECK
+#ifdef SOUP_CHECK_VERSION
+#if SOUP_CHECK_VERSION (2, 38, 0)
+#define HAVE_SOUP_NETWORK_EVENT 1
+#endif
+#endif
+#endif
+
+typedef struct {
+	NMConnectivity *self;
+	int ifindex;
+	char *iface;
+	gboolean connected;
+
+	NMConnectivityState state;
+	guint interval;
+
+#if WITH_CONCHECK
+	SoupMessage *msg;
+	guint timeout_id;
+#endif
+} DeviceCheck;
+
 typedef struct {
 	char *uri;
 	char *response;
 	guint interval;
+	gboolean online;
+
+	/* int ifindex -> DeviceCheck */
+	GHashTable *devices;
 
 #if WITH_CONCHECK
 	SoupSession *soup_session;
 	guint pending_checks;
 	guint check_id;
+
+	/* GSimpleAsyncResults waiting for the current round of device checks */
+	GSList *waiting;
 #endif
 
 	NMConnectivityState state;
@@ -102,51 +148,64 @@ update_state (NMConnectivity *self, NMConnectivityState state)
 }
 
 #if WITH_CONCHECK
-static void
-nm_connectivity_check_cb (SoupSession *session, SoupMessage *msg, gpointer user_data)
+static NMConnectivityState
+check_response (NMConnectivity *self, SoupMessage *msg, const char *iface)
 {
-	GSimpleAsyncResult *simple = user_data;
-	NMConnectivity *self;
-	NMConnectivityPrivate *priv;
-	NMConnectivityState new_state;
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (self);
 	const char *nm_header;
+	gs_free char *prefix = NULL;
 
-	self = NM_CONNECTIVITY (g_async_result_get_source_object (G_ASYNC_RESULT (simple)));
-	g_object_unref (self);
-	priv = NM_CONNECTIVITY_GET_PRIVATE (self);
-	priv->pending_checks--;
+	/* Prefix log messages of per-device checks with the interface name */
+	prefix = iface ? g_strdup_printf ("(%s) ", iface) : g_strdup ("");
 
 	if (SOUP_STATUS_IS_TRANSPORT_ERROR (msg->status_code)) {
-		nm_log_info (LOGD_CONCHECK, "Connectivity check for uri '%s' failed with '%s'.",
-		             priv->uri, msg->reason_phrase);
-		new_state = NM_CONNECTIVITY_LIMITED;
-		goto done;
+		nm_log_info (LOGD_CONCHECK, "%sConnectivity check for uri '%s' failed with '%s'.",
+		             prefix, priv->uri, msg->reason_phrase);
+		return NM_CONNECTIVITY_LIMITED;
 	}
 
 	/* Check headers; if we find the NM-specific one we're done */
 	nm_header = soup_message_headers_get_one (msg->response_headers, "X-NetworkManager-Status");
 	if (g_strcmp0 (nm_header, "online") == 0) {
-		nm_log_dbg (LOGD_CONCHECK, "Connectivity check for uri '%s' with Status header successful.", priv->uri);
-		new_state = NM_CONNECTIVITY_FULL;
+		nm_log_dbg (LOGD_CONCHECK, "%sConnectivity check for uri '%s' with Status header successful.",
+		            prefix, priv->uri);
+		return NM_CONNECTIVITY_FULL;
 	} else if (msg->status_code == SOUP_STATUS_OK) {
 		/* check response */
 		if (msg->response_body->data &&	(g_str_has_prefix (msg->response_body->data, priv->response))) {
-			nm_log_dbg (LOGD_CONCHECK, "Connectivity check for uri '%s' successful.",
-			            priv->uri);
-			new_state = NM_CONNECTIVITY_FULL;
+			nm_log_dbg (LOGD_CONCHECK, "%sConnectivity check for uri '%s' successful.",
+			            prefix, priv->uri);
+			return NM_CONNECTIVITY_FULL;
 		} else {
-			nm_log_info (LOGD_CONCHECK, "Connectivity check for uri '%s' did not match expected response '%s'; assuming captive portal.",
-			             priv->uri, priv->response);
-			new_state = NM_CONNECTIVITY_PORTAL;
+			nm_log_info (LOGD_CONCHECK, "%sConnectivity check for uri '%s' did not match expected response '%s'; assuming captive portal.",
+			             prefix, priv->uri, priv->response);
+			return NM_CONNECTIVITY_PORTAL;
 		}
 	} else {
-		nm_log_info (LOGD_CONCHECK, "Connectivity check for uri '%s' returned status '%d %s'; assuming captive portal.",
-		             priv->uri, msg->status_code, msg->reason_phrase);
-		new_state = NM_CONNECTIVITY_PORTAL;
+		nm_log_info (LOGD_CONCHECK, "%sConnectivity check for uri '%s' returned status '%d %s'; assuming captive portal.",
+		             prefix, priv->uri, msg->status_code, msg->reason_phrase);
+		return NM_CONNECTIVITY_PORTAL;
 	}
+}
+
+static void
+nm_connectivity_check_cb (SoupSession *session, SoupMessage *msg, gpointer user_data)
+{
+	GSimpleAsyncResult *simple = user_data;
+	NMConnectivity *self;
+	NMConnectivityPrivate *priv;
+	NMConnectivityState new_state;
+
+	self = NM_CONNECTIVITY (g_async_result_get_source_object (G_ASYNC_RESULT (simple)));
+	g_object_unref (self);
+	priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+	priv->pending_checks--;
+
+	new_state = check_response (self, msg, NULL);
 
- done:
-	update_state (self, new_state);
+	/* Once per-device checks are running they own the overall state */
+	if (!priv->devices || !g_hash_table_size (priv->devices))
+		update_state (self, new_state);
 
 	g_simple_async_result_set_op_res_gssize (simple, new_state);
 	g_simple_async_result_complete (simple);
@@ -188,34 +247,427 @@ idle_start_periodic_checks (gpointer user_data)
 
 	return FALSE;
 }
+
+/*****************************************************************************/
+
+static gboolean
+checks_enabled (NMConnectivityPrivate *priv)
+{
+	return priv->online && priv->uri && priv->interval;
+}
+
+static guint
+backoff_max (NMConnectivityPrivate *priv)
+{
+	if (priv->interval >= BACKOFF_MAX_SECONDS / BACKOFF_MAX_FACTOR)
+		return MAX (priv->interval, BACKOFF_MAX_SECONDS);
+	return priv->interval * BACKOFF_MAX_FACTOR;
+}
+
+static NMConnectivityState
+devices_get_best_state (NMConnectivityPrivate *priv)
+{
+	NMConnectivityState best = NM_CONNECTIVITY_UNKNOWN;
+	GHashTableIter iter;
+	DeviceCheck *dc;
+
+	g_hash_table_iter_init (&iter, priv->devices);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &dc)) {
+		if (dc->state > best)
+			best = dc->state;
+	}
+	return best;
+}
+
+static gboolean
+devices_checking (NMConnectivityPrivate *priv)
+{
+	GHashTableIter iter;
+	DeviceCheck *dc;
+
+	g_hash_table_iter_init (&iter, priv->devices);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &dc)) {
+		if (dc->msg)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+complete_waiting (NMConnectivity *self)
+{
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+	GSList *waiting, *iter;
+
+	if (!priv->waiting || devices_checking (priv))
+		return;
+
+	waiting = g_slist_reverse (priv->waiting);
+	priv->waiting = NULL;
+	for (iter = waiting; iter; iter = iter->next) {
+		GSimpleAsyncResult *simple = iter->data;
+
+		g_simple_async_result_set_op_res_gssize (simple, priv->state);
+		g_simple_async_result_complete (simple);
+		g_object_unref (simple);
+	}
+	g_slist_free (waiting);
+}
+
+static void
+device_check_stop (DeviceCheck *dc)
+{
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (dc->self);
+
+	if (dc->timeout_id) {
+		g_source_remove (dc->timeout_id);
+		dc->timeout_id = 0;
+	}
+	if (dc->msg) {
+		SoupMessage *msg = dc->msg;
+
+		/* The completion callback ignores cancelled messages, so it
+		 * never touches @dc after this point.
+		 */
+		dc->msg = NULL;
+		soup_session_cancel_message (priv->soup_session, msg, SOUP_STATUS_CANCELLED);
+	}
+}
+
+#if HAVE_SOUP_NETWORK_EVENT
+static void
+device_check_network_event (SoupMessage *msg,
+                            GSocketClientEvent event,
+                            GIOStream *connection,
+                            gpointer user_data)
+{
+	const char *iface = user_data;
+	GSocket *socket;
+
+	if (event != G_SOCKET_CLIENT_CONNECTING)
+		return;
+
+	/* Bind the not-yet-connected socket to the device so the check
+	 * actually measures connectivity through it and not through
+	 * whatever the default route currently points to.
+	 */
+	socket = g_socket_connection_get_socket (G_SOCKET_CONNECTION (connection));
+	if (setsockopt (g_socket_get_fd (socket), SOL_SOCKET, SO_BINDTODEVICE,
+	                iface, strlen (iface) + 1) < 0) {
+		nm_log_warn (LOGD_CONCHECK, "(%s) failed to bind connectivity check: %s",
+		             iface, g_strerror (errno));
+	}
+}
 #endif
 
+static void device_check_schedule (DeviceCheck *dc, guint delay);
+
+static void
+device_check_cb (SoupSession *session, SoupMessage *msg, gpointer user_data)
+{
+	DeviceCheck *dc = user_data;
+	NMConnectivity *self;
+	NMConnectivityPrivate *priv;
+	NMConnectivityState new_state;
+
+	if (msg->status_code == SOUP_STATUS_CANCELLED)
+		return;
+
+	self = dc->self;
+	priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+	dc->msg = NULL;
+
+	new_state = check_response (self, msg, dc->iface);
+	if (new_state == dc->state) {
+		/* Nothing changed; check less often */
+		dc->interval = MIN (dc->interval * 2, backoff_max (priv));
+	} else {
+		nm_log_dbg (LOGD_CONCHECK, "(%s) connectivity state changed from %s to %s",
+		            dc->iface, state_name (dc->state), state_name (new_state));
+		dc->state = new_state;
+		dc->interval = priv->interval;
+	}
+	device_check_schedule (dc, dc->interval);
+
+	update_state (self, devices_get_best_state (priv));
+	complete_waiting (self);
+}
+
+static void
+device_check_start (DeviceCheck *dc)
+{
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (dc->self);
+	SoupMessage *msg;
+
+	device_check_stop (dc);
+
+	nm_log_dbg (LOGD_CONCHECK, "(%s) connectivity check started with uri '%s' (next in %us).",
+	            dc->iface, priv->uri, dc->interval);
+
+	msg = soup_message_new ("GET", priv->uri);
+	soup_message_set_flags (msg, SOUP_MESSAGE_NO_REDIRECT);
+	/* Checks of different devices share the session; don't let a
+	 * connection bound to one device be reused for another.
+	 */
+	soup_message_headers_replace (msg->request_headers, "Connection", "close");
+#if HAVE_SOUP_NETWORK_EVENT
+	g_signal_connect_data (msg, "network-event",
+	                       G_CALLBACK (device_check_network_event),
+	                       g_strdup (dc->iface), (GClosureNotify) g_free, 0);
+#endif
+
+	dc->msg = msg;
+	soup_session_queue_message (priv->soup_session, msg, device_check_cb, dc);
+}
+
+static gboolean
+device_check_timeout (gpointer user_data)
+{
+	DeviceCheck *dc = user_data;
+
+	dc->timeout_id = 0;
+	device_check_start (dc);
+	return FALSE;
+}
+
+static void
+device_check_schedule (DeviceCheck *dc, guint delay)
+{
+	if (dc->timeout_id)
+		g_source_remove (dc->timeout_id);
+	if (delay)
+		dc->timeout_id = g_timeout_add_seconds (delay, device_check_timeout, dc);
+	else
+		dc->timeout_id = g_idle_add (device_check_timeout, dc);
+}
+
+static void
+device_recheck (DeviceCheck *dc)
+{
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (dc->self);
+
+	if (!checks_enabled (priv))
+		return;
+
+	device_check_stop (dc);
+	dc->interval = priv->interval;
+	device_check_schedule (dc, RECHECK_DELAY_SECONDS);
+}
+
+static void
+platform_link_changed_cb (NMPlatform *platform,
+                          int ifindex,
+                          NMPlatformLink *plink,
+                          NMPlatformSignalChangeType change_type,
+                          NMPlatformReason reason,
+                          gpointer user_data)
+{
+	NMConnectivity *self = NM_CONNECTIVITY (user_data);
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+	DeviceCheck *dc;
+
+	dc = g_hash_table_lookup (priv->devices, GINT_TO_POINTER (ifindex));
+	if (!dc)
+		return;
+
+	if (change_type == NM_PLATFORM_SIGNAL_REMOVED) {
+		nm_connectivity_device_remove (self, ifindex);
+		return;
+	}
+
+	if (plink->connected != dc->connected) {
+		dc->connected = plink->connected;
+		device_recheck (dc);
+	}
+}
+
+static void
+platform_route_changed_cb (NMPlatform *platform,
+                           int ifindex,
+                           gpointer route,
+                           NMPlatformSignalChangeType change_type,
+                           NMPlatformReason reason,
+                           gpointer user_data)
+{
+	NMConnectivity *self = NM_CONNECTIVITY (user_data);
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+	DeviceCheck *dc;
+
+	if (change_type == NM_PLATFORM_SIGNAL_CHANGED)
+		return;
+
+	dc = g_hash_table_lookup (priv->devices, GINT_TO_POINTER (ifindex));
+	if (dc)
+		device_recheck (dc);
+}
+#endif
+
+static void
+device_check_free (gpointer data)
+{
+	DeviceCheck *dc = data;
+
+#if WITH_CONCHECK
+	device_check_stop (dc);
+#endif
+	g_free (dc->iface);
+	g_slice_free (DeviceCheck, dc);
+}
+
+/**
+ * nm_connectivity_device_add:
+ * @self: the #NMConnectivity
+ * @ifindex: the interface index of the device's IP interface
+ * @iface: the name of the device's IP interface
+ *
+ * Starts checking connectivity through @iface.  The checks of all added
+ * devices run concurrently and the overall state becomes the best state
+ * any of them reports.  Each device re-checks on route and link changes
+ * and backs off while its result stays the same.
+ */
+void
+nm_connectivity_device_add (NMConnectivity *self, int ifindex, const char *iface)
+{
+	NMConnectivityPrivate *priv;
+	DeviceCheck *dc;
+
+	g_return_if_fail (NM_IS_CONNECTIVITY (self));
+	g_return_if_fail (ifindex > 0);
+	g_return_if_fail (iface != NULL);
+
+	priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+
+	dc = g_hash_table_lookup (priv->devices, GINT_TO_POINTER (ifindex));
+	if (dc && !strcmp (dc->iface, iface))
+		return;
+
+	dc = g_slice_new0 (DeviceCheck);
+	dc->self = self;
+	dc->ifindex = ifindex;
+	dc->iface = g_strdup (iface);
+	dc->connected = nm_platform_link_is_connected (ifindex);
+	dc->state = NM_CONNECTIVITY_UNKNOWN;
+	dc->interval = priv->interval;
+	g_hash_table_insert (priv->devices, GINT_TO_POINTER (ifindex), dc);
+
+	nm_log_dbg (LOGD_CONCHECK, "(%s) added to connectivity checks", iface);
+
+#if WITH_CONCHECK
+	if (checks_enabled (priv)) {
+		/* The devices take over from the global periodic check */
+		if (priv->check_id) {
+			g_source_remove (priv->check_id);
+			priv->check_id = 0;
+		}
+		device_check_schedule (dc, 0);
+	}
+#endif
+}
+
+/**
+ * nm_connectivity_device_remove:
+ * @self: the #NMConnectivity
+ * @ifindex: the interface index passed to nm_connectivity_device_add()
+ *
+ * Stops checking connectivity through the device.
+ */
+void
+nm_connectivity_device_remove (NMConnectivity *self, int ifindex)
+{
+	NMConnectivityPrivate *priv;
+
+	g_return_if_fail (NM_IS_CONNECTIVITY (self));
+
+	priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+
+	if (!g_hash_table_remove (priv->devices, GINT_TO_POINTER (ifindex)))
+		return;
+
+#if WITH_CONCHECK
+	if (checks_enabled (priv)) {
+		if (g_hash_table_size (priv->devices)) {
+			NMConnectivityState best = devices_get_best_state (priv);
+
+			if (best != NM_CONNECTIVITY_UNKNOWN)
+				update_state (self, best);
+		} else if (!priv->check_id) {
+			/* Fall back to the unbound periodic check */
+			priv->check_id = g_timeout_add (0, idle_start_periodic_checks, self);
+		}
+	}
+	complete_waiting (self);
+#endif
+}
+
+/**
+ * nm_connectivity_device_get_state:
+ * @self: the #NMConnectivity
+ * @ifindex: the interface index passed to nm_connectivity_device_add()
+ *
+ * Returns: the result of the last connectivity check through the device,
+ * or %NM_CONNECTIVITY_UNKNOWN if it was not checked yet.
+ */
+NMConnectivityState
+nm_connectivity_device_get_state (NMConnectivity *self, int ifindex)
+{
+	DeviceCheck *dc;
+
+	g_return_val_if_fail (NM_IS_CONNECTIVITY (self), NM_CONNECTIVITY_UNKNOWN);
+
+	dc = g_hash_table_lookup (NM_CONNECTIVITY_GET_PRIVATE (self)->devices, GINT_TO_POINTER (ifindex));
+	return dc ? dc->state : NM_CONNECTIVITY_UNKNOWN;
+}
+
 void
 nm_connectivity_set_online (NMConnectivity *self,
                             gboolean        online)
 {
-#if WITH_CONCHECK
 	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+#if WITH_CONCHECK
+	GHashTableIter iter;
+	DeviceCheck *dc;
 #endif
 
 	nm_log_dbg (LOGD_CONCHECK, "nm_connectivity_set_online(%s)", online ? "TRUE" : "FALSE");
 
+	priv->online = online;
+
 #if WITH_CONCHECK
 	if (online && priv->uri && priv->interval) {
-		if (!priv->check_id)
+		if (g_hash_table_size (priv->devices)) {
+			/* Start devices that aren't checking yet */
+			g_hash_table_iter_init (&iter, priv->devices);
+			while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &dc)) {
+				if (!dc->msg && !dc->timeout_id)
+					device_check_schedule (dc, 0);
+			}
+		} else if (!priv->check_id)
 			priv->check_id = g_timeout_add (0, idle_start_periodic_checks, self);
 
 		return;
-	} else if (priv->check_id) {
+	}
+
+	if (priv->check_id) {
 		g_source_remove (priv->check_id);
 		priv->check_id = 0;
 	}
+
+	g_hash_table_iter_init (&iter, priv->devices);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &dc)) {
+		device_check_stop (dc);
+		dc->state = NM_CONNECTIVITY_UNKNOWN;
+		dc->interval = priv->interval;
+	}
 #endif
 
 	/* Either @online is %TRUE but we aren't checking connectivity, or
 	 * @online is %FALSE. Either way we can update our status immediately.
 	 */
 	update_state (self, online ? NM_CONNECTIVITY_FULL : NM_CONNECTIVITY_NONE);
+
+#if WITH_CONCHECK
+	complete_waiting (self);
+#endif
 }
 
 void
@@ -226,6 +678,8 @@ nm_connectivity_check_async (NMConnectivity      *self,
 	NMConnectivityPrivate *priv;
 #if WITH_CONCHECK
 	SoupMessage *msg;
+	GHashTableIter iter;
+	DeviceCheck *dc;
 #endif
 	GSimpleAsyncResult *simple;
 
@@ -243,6 +697,19 @@ nm_connectivity_check_async (NMConnectivity      *self,
 	                                    nm_connectivity_check_async);
 
 #if WITH_CONCHECK
+	if (checks_enabled (priv) && g_hash_table_size (priv->devices)) {
+		/* Check all devices now, unless a round is already running,
+		 * and report the overall result once they are all done.
+		 */
+		if (!devices_checking (priv)) {
+			g_hash_table_iter_init (&iter, priv->devices);
+			while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &dc))
+				device_check_start (dc);
+		}
+		priv->waiting = g_slist_prepend (priv->waiting, simple);
+		return;
+	}
+
 	if (priv->uri && priv->interval) {
 		msg = soup_message_new ("GET", priv->uri);
 		soup_message_set_flags (msg, SOUP_MESSAGE_NO_REDIRECT);
@@ -378,10 +845,22 @@ get_property (GObject *object, guint property_id,
 static void
 nm_connectivity_init (NMConnectivity *self)
 {
-#if WITH_CONCHECK
 	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (self);
 
-	priv->soup_session = soup_session_async_new_with_options (SOUP_SESSION_TIMEOUT, 15, NULL);
+	priv->devices = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, device_check_free);
+
+#if WITH_CONCHECK
+	/* Allow the checks of all devices to run concurrently */
+	priv->soup_session = soup_session_async_new_with_options (SOUP_SESSION_TIMEOUT, 15,
+	                                                          SOUP_SESSION_MAX_CONNS_PER_HOST, 16,
+	                                                          NULL);
+
+	g_signal_connect (nm_platform_get (), NM_PLATFORM_SIGNAL_LINK_CHANGED,
+	                  G_CALLBACK (platform_link_changed_cb), self);
+	g_signal_connect (nm_platform_get (), NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED,
+	                  G_CALLBACK (platform_route_changed_cb), self);
+	g_signal_connect (nm_platform_get (), NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED,
+	                  G_CALLBACK (platform_route_changed_cb), self);
 #endif
 }
 
@@ -396,6 +875,17 @@ dispose (GObject *object)
 	g_free (priv->response);
 
 #if WITH_CONCHECK
+	g_signal_handlers_disconnect_by_func (nm_platform_get (), G_CALLBACK (platform_link_changed_cb), self);
+	g_signal_handlers_disconnect_by_func (nm_platform_get (), G_CALLBACK (platform_route_changed_cb), self);
+#endif
+
+	/* Cancels the device checks before the session goes away */
+	g_clear_pointer (&priv->devices, g_hash_table_unref);
+
+#if WITH_CONCHECK
+	g_slist_free_full (priv->waiting, g_object_unref);
+	priv->waiting = NULL;
+
 	if (priv->soup_session) {
 		soup_session_abort (priv->soup_session);
 		g_clear_object (&priv->soup_session);
@@ -58,6 +58,14 @@ void                 nm_connectivity_set_online   (NMConnectivity       *self,
 
 NMConnectivityState  nm_connectivity_get_state    (NMConnectivity       *self);
 
+void                 nm_connectivity_device_add       (NMConnectivity *self,
+                                                       int             ifindex,
+                                                       const char     *iface);
+void                 nm_connectivity_device_remove    (NMConnectivity *self,
+                                                       int             ifindex);
+NMConnectivityState  nm_connectivity_device_get_state (NMConnectivity *self,
+                                                       int             ifindex);
+
 void                 nm_connectivity_check_async  (NMConnectivity       *self,
                                                    GAsyncReadyCallback   callback,
                                                    gpointer              user_data);
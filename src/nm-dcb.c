@@ -28,6 +28,7 @@
 #include "nm-platform.h"
 #include "NetworkManagerUtils.h"
 #include "nm-logging.h"
+#include "gsystem-local-alloc.h"
 
 static const char *helper_names[] = { "dcbtool", "fcoeadm" };
 
@@ -216,7 +217,7 @@ _dcb_setup (const char *iface,
 		/* Ignore disable failure since lldpad <= 0.9.46 does not support disabling
 		 * priority groups without specifying an entire PG config.
 		 */
-		(void) do_helper (iface, DCBTOOL, run_func, user_data, error, "pg e:0");
+		(void) do_helper (iface, DCBTOOL, run_func, user_data, NULL, "pg e:0");
 	}
 
 	return TRUE;
@@ -286,104 +287,316 @@ _fcoe_cleanup (const char *iface,
 	return do_helper (NULL, FCOEADM, run_func, user_data, error, "-d %s", iface);
 }
 
+/* fcoeadm may have to wait for the hardware; do not let it hang NM forever */
+#define DCB_HELPER_TIMEOUT_MSEC 30000
+
+/* A step runs a helper, or waits for the carrier when @argv is %NULL */
+typedef struct {
+	char **argv;
+	gboolean report;      /* whether a failure of the helper is an error */
+	gboolean carrier_up;
+	int carrier_count;    /* polls left, one every 100ms */
+} DcbStep;
+
+struct _NMDcbCall {
+	char *iface;
+	GPtrArray *steps;
+	guint next;
+	gboolean abort_on_error;
+	GError *error;
+	NMDcbCallback callback;
+	gpointer user_data;
+	gboolean running;
+	gboolean cancelled;
+	guint timeout_id;
+};
+
+/* Calls run one after the other, so that the cleanup after a deactivation
+ * is finished before the next activation configures the interface again.
+ */
+static GQueue call_queue = G_QUEUE_INIT;
+
+static void call_run (NMDcbCall *call);
+
+static void
+step_free (gpointer data)
+{
+	DcbStep *step = data;
+
+	g_strfreev (step->argv);
+	g_slice_free (DcbStep, step);
+}
+
+static NMDcbCall *
+call_new (const char *iface, gboolean abort_on_error)
+{
+	NMDcbCall *call;
+
+	call = g_slice_new0 (NMDcbCall);
+	call->iface = g_strdup (iface);
+	call->steps = g_ptr_array_new_with_free_func (step_free);
+	call->abort_on_error = abort_on_error;
+	return call;
+}
+
+static void
+call_free (NMDcbCall *call)
+{
+	if (call->timeout_id)
+		g_source_remove (call->timeout_id);
+	g_clear_error (&call->error);
+	g_ptr_array_unref (call->steps);
+	g_free (call->iface);
+	g_slice_free (NMDcbCall, call);
+}
+
+/* Takes ownership of @call and queues it */
+static NMDcbCall *
+call_start (NMDcbCall *call, NMDcbCallback callback, gpointer user_data)
+{
+	call->callback = callback;
+	call->user_data = user_data;
+
+	g_queue_push_tail (&call_queue, call);
+	if (call_queue.head->data == call)
+		call_run (call);
+	return call;
+}
+
+static void
+call_finish (NMDcbCall *call)
+{
+	g_assert (call_queue.head->data == call);
+	g_queue_pop_head (&call_queue);
+
+	if (call->callback && !call->cancelled)
+		call->callback (call->error, call->user_data);
+	call_free (call);
+
+	/* The callback may already have started the next call */
+	if (call_queue.head && !((NMDcbCall *) call_queue.head->data)->running)
+		call_run (call_queue.head->data);
+}
+
+/* Records the helper in @user_data, a #NMDcbCall, instead of running it */
 static gboolean
-run_helper (char **argv, guint which, gpointer user_data, GError **error)
+collect_helper (char **argv, guint which, gpointer user_data, GError **error)
 {
+	NMDcbCall *call = user_data;
 	const char *helper_path;
-	int exit_status = 0;
-	gboolean success;
-	char *errmsg = NULL, *outmsg = NULL;
-	char *cmdline;
+	DcbStep *step;
+	guint i, len;
 
-	helper_path = nm_utils_find_helper ((which == DCBTOOL) ? "dcbtool" : "fcoeadm", NULL, error);
+	helper_path = nm_utils_find_helper (helper_names[which], NULL, error);
 	if (!helper_path)
 		return FALSE;
 
-	argv[0] = (char *) helper_path;
-	cmdline = g_strjoinv (" ", argv);
-	nm_log_dbg (LOGD_DCB, "%s", cmdline);
+	len = g_strv_length (&argv[1]);
+	step = g_slice_new0 (DcbStep);
+	step->argv = g_new (char *, len + 2);
+	step->argv[0] = g_strdup (helper_path);
+	for (i = 1; i <= len; i++)
+		step->argv[i] = g_strdup (argv[i]);
+	step->argv[i] = NULL;
 
-	success = g_spawn_sync ("/", argv, NULL, 0 /*G_SPAWN_DEFAULT*/,
-	                        NULL, NULL,
-	                        &outmsg, &errmsg, &exit_status, error);
-	/* Log any stderr output */
-	if (success && WIFEXITED (exit_status) && WEXITSTATUS (exit_status) && (errmsg || outmsg)) {
-		gboolean ignore_error = FALSE;
+	/* Callers pass no @error for helpers whose failure they ignore */
+	step->report = (error != NULL);
 
-		/* Ignore fcoeadm "success" errors like when FCoE is already set up */
-		if (errmsg && strstr (errmsg, "Connection already created"))
-			ignore_error = TRUE;
+	g_ptr_array_add (call->steps, step);
+	return TRUE;
+}
 
-		if (ignore_error == FALSE) {
+static void
+add_carrier_wait (NMDcbCall *call, guint secs, gboolean up)
+{
+	DcbStep *step;
+
+	step = g_slice_new0 (DcbStep);
+	step->carrier_up = up;
+	step->carrier_count = secs * 10;
+	g_ptr_array_add (call->steps, step);
+}
+
+static void
+helper_done (int child_status, const char *out, const char *err,
+             GError *error, gpointer user_data)
+{
+	NMDcbCall *call = user_data;
+	DcbStep *step = call->steps->pdata[call->next - 1];
+	gs_free char *cmdline = g_strjoinv (" ", step->argv);
+	GError *local = NULL;
+
+	if (error) {
+		nm_log_warn (LOGD_DCB, "'%s' failed: %s", cmdline, error->message);
+		local = g_error_copy (error);
+	} else if (!WIFEXITED (child_status) || WEXITSTATUS (child_status)) {
+		/* Ignore fcoeadm "success" errors like when FCoE is already set up */
+		if (!err || !strstr (err, "Connection already created")) {
 			nm_log_warn (LOGD_DCB, "'%s' failed: '%s'",
-			             cmdline, (errmsg && strlen (errmsg)) ? errmsg : outmsg);
-			g_set_error (error, NM_MANAGER_ERROR, NM_MANAGER_ERROR_FAILED,
-			             "Failed to run '%s'", cmdline);
-			success = FALSE;
+			             cmdline, (err && strlen (err)) ? err : (out ? out : ""));
+			local = g_error_new (NM_MANAGER_ERROR, NM_MANAGER_ERROR_FAILED,
+			                     "Failed to run '%s'", cmdline);
 		}
 	}
 
-	g_free (outmsg);
-	g_free (errmsg);
-	g_free (cmdline);
-	return success;
+	if (local && step->report) {
+		/* Report the first error */
+		if (!call->error)
+			call->error = local;
+		else
+			g_error_free (local);
+
+		if (call->abort_on_error) {
+			call_finish (call);
+			return;
+		}
+	} else if (local)
+		g_error_free (local);
+
+	call_run (call);
 }
 
-gboolean
-nm_dcb_enable (const char *iface, gboolean enable, GError **error)
+static gboolean
+carrier_wait_cb (gpointer user_data)
 {
-	return _dcb_enable (iface, enable, run_helper, GUINT_TO_POINTER (DCBTOOL), error);
+	NMDcbCall *call = user_data;
+	DcbStep *step = call->steps->pdata[call->next - 1];
+	int ifindex;
+
+	/* To work around driver quirks and lldpad handling of carrier status,
+	 * we must wait a short period of time to see if the carrier goes
+	 * down, and then wait for the carrier to come back up again.  Otherwise
+	 * subsequent lldpad calls may fail with "Device not found, link down
+	 * or DCB not enabled" errors.
+	 */
+	ifindex = nm_platform_link_get_ifindex (call->iface);
+	if (   ifindex > 0
+	    && nm_platform_link_is_connected (ifindex) != step->carrier_up
+	    && step->carrier_count-- > 0) {
+		nm_platform_link_refresh (ifindex);
+		call->timeout_id = g_timeout_add (100, carrier_wait_cb, call);
+		return G_SOURCE_REMOVE;
+	}
+
+	call->timeout_id = 0;
+	call_run (call);
+	return G_SOURCE_REMOVE;
 }
 
-gboolean
-nm_dcb_setup (const char *iface, NMSettingDcb *s_dcb, GError **error)
+static void
+call_run (NMDcbCall *call)
 {
-	gboolean success;
+	DcbStep *step;
 
-	success = _dcb_setup (iface, s_dcb, run_helper, GUINT_TO_POINTER (DCBTOOL), error);
-	if (success)
-		success = _fcoe_setup (iface, s_dcb, run_helper, GUINT_TO_POINTER (FCOEADM), error);
+	call->running = TRUE;
 
-	return success;
+	if (call->next == call->steps->len || call->cancelled) {
+		call_finish (call);
+		return;
+	}
+
+	step = call->steps->pdata[call->next++];
+	if (step->argv) {
+		if (nm_logging_enabled (LOGL_DEBUG, LOGD_DCB)) {
+			gs_free char *cmdline = g_strjoinv (" ", step->argv);
+
+			nm_log_dbg (LOGD_DCB, "%s", cmdline);
+		}
+		nm_utils_spawn_async ((const char *const *) step->argv,
+		                      NM_UTILS_SPAWN_FLAGS_CAPTURE_STDOUT | NM_UTILS_SPAWN_FLAGS_CAPTURE_STDERR,
+		                      DCB_HELPER_TIMEOUT_MSEC, LOGD_DCB,
+		                      helper_done, call, NULL);
+	} else {
+		nm_log_dbg (LOGD_DCB, "(%s): cleanup waiting for carrier %s",
+		            call->iface, step->carrier_up ? "up" : "down");
+		call->timeout_id = g_timeout_add (250, carrier_wait_cb, call);
+	}
 }
 
-static void
-carrier_wait (const char *iface, guint secs, gboolean up)
+/**
+ * nm_dcb_cancel:
+ * @call: a pending call
+ *
+ * The callback of @call will not be invoked.  A call that already runs
+ * a helper does not start any further ones.
+ */
+void
+nm_dcb_cancel (NMDcbCall *call)
 {
-	int ifindex, count = secs * 10;
+	g_return_if_fail (call != NULL);
 
-	g_return_if_fail (iface != NULL);
+	if (!call->running) {
+		g_queue_remove (&call_queue, call);
+		call_free (call);
+		return;
+	}
 
-	ifindex = nm_platform_link_get_ifindex (iface);
-	if (ifindex > 0) {
-		/* To work around driver quirks and lldpad handling of carrier status,
-		 * we must wait a short period of time to see if the carrier goes
-		 * down, and then wait for the carrier to come back up again.  Otherwise
-		 * subsequent lldpad calls may fail with "Device not found, link down
-		 * or DCB not enabled" errors.
-		 */
-		nm_log_dbg (LOGD_DCB, "(%s): cleanup waiting for carrier %s",
-		            iface, up ? "up" : "down");
-		g_usleep (G_USEC_PER_SEC / 4);
-		while (nm_platform_link_is_connected (ifindex) != up && count-- > 0) {
-			g_usleep (G_USEC_PER_SEC / 10);
-			nm_platform_link_refresh (ifindex);
-		}
+	call->cancelled = TRUE;
+	if (call->timeout_id) {
+		g_source_remove (call->timeout_id);
+		call->timeout_id = 0;
+		call_finish (call);
 	}
 }
 
-gboolean
-nm_dcb_cleanup (const char *iface, GError **error)
+/* The nm_dcb_*() functions return %NULL and set @error if the helpers
+ * cannot be found, and otherwise run them asynchronously and in order.
+ * @callback receives the first error of a helper, or %NULL.
+ */
+
+NMDcbCall *
+nm_dcb_enable (const char *iface,
+               gboolean enable,
+               NMDcbCallback callback,
+               gpointer user_data,
+               GError **error)
 {
+	NMDcbCall *call = call_new (iface, TRUE);
+
+	if (!_dcb_enable (iface, enable, collect_helper, call, error)) {
+		call_free (call);
+		return NULL;
+	}
+	return call_start (call, callback, user_data);
+}
+
+NMDcbCall *
+nm_dcb_setup (const char *iface,
+              NMSettingDcb *s_dcb,
+              NMDcbCallback callback,
+              gpointer user_data,
+              GError **error)
+{
+	NMDcbCall *call = call_new (iface, TRUE);
+
+	if (   !_dcb_setup (iface, s_dcb, collect_helper, call, error)
+	    || !_fcoe_setup (iface, s_dcb, collect_helper, call, error)) {
+		call_free (call);
+		return NULL;
+	}
+	return call_start (call, callback, user_data);
+}
+
+NMDcbCall *
+nm_dcb_cleanup (const char *iface,
+                NMDcbCallback callback,
+                gpointer user_data,
+                GError **error)
+{
+	NMDcbCall *call = call_new (iface, FALSE);
+
 	/* Ignore FCoE cleanup errors */
-	_fcoe_cleanup (iface, run_helper, GUINT_TO_POINTER (FCOEADM), NULL);
+	_fcoe_cleanup (iface, collect_helper, call, NULL);
 
 	/* Must pause a bit to wait for carrier-up since disabling FCoE may
 	 * cause the device to take the link down, making lldpad return errors.
 	 */
-	carrier_wait (iface, 2, FALSE);
-	carrier_wait (iface, 4, TRUE);
+	add_carrier_wait (call, 2, FALSE);
+	add_carrier_wait (call, 4, TRUE);
 
-	return _dcb_cleanup (iface, run_helper, GUINT_TO_POINTER (DCBTOOL), error);
+	if (!_dcb_cleanup (iface, collect_helper, call, error)) {
+		call_free (call);
+		return NULL;
+	}
+	return call_start (call, callback, user_data);
 }
-
@@ -24,9 +24,25 @@
 #include <glib.h>
 #include "nm-setting-dcb.h"
 
-gboolean nm_dcb_enable (const char *iface, gboolean enable, GError **error);
-gboolean nm_dcb_setup (const char *iface, NMSettingDcb *s_dcb, GError **error);
-gboolean nm_dcb_cleanup (const char *iface, GError **error);
+typedef struct _NMDcbCall NMDcbCall;
+
+typedef void (*NMDcbCallback) (GError *error, gpointer user_data);
+
+NMDcbCall *nm_dcb_enable (const char *iface,
+                          gboolean enable,
+                          NMDcbCallback callback,
+                          gpointer user_data,
+                          GError **error);
+NMDcbCall *nm_dcb_setup (const char *iface,
+                         NMSettingDcb *s_dcb,
+                         NMDcbCallback callback,
+                         gpointer user_data,
+                         GError **error);
+NMDcbCall *nm_dcb_cleanup (const char *iface,
+                           NMDcbCallback callback,
+                           gpointer user_data,
+                           GError **error);
+void nm_dcb_cancel (NMDcbCall *call);
 
 /* For testcases only! */
 typedef gboolean (*DcbFunc) (char **argv,
@@ -43,6 +43,17 @@ typedef struct {
 		guint idle_handle;
 		gboolean has_v4_changes;
 		gboolean has_v6_changes;
+
+		/* ifindexes (as set) affected by external changes since the last
+		 * resync. Only these need to be checked for missing or superfluous
+		 * default routes. */
+		GHashTable *changed_ifindexes_v4;
+		GHashTable *changed_ifindexes_v6;
+
+		/* ifindexes that had a default route on the last resync. Address
+		 * changes on them can make the kernel silently drop that route. */
+		GHashTable *default_ifindexes_v4;
+		GHashTable *default_ifindexes_v6;
 	} resync;
 } NMDefaultRouteManagerPrivate;
 
@@ -276,7 +287,8 @@ _platform_route_sync_add (const VTableIP *vtable, NMDefaultRouteManager *self, g
 }
 
 static gboolean
-_platform_route_sync_flush (const VTableIP *vtable, NMDefaultRouteManager *self, int ifindex_to_flush)
+_platform_route_sync_flush (const VTableIP *vtable, NMDefaultRouteManager *self, int ifindex_to_flush,
+                            GHashTable *synced_ifindexes, GHashTable *sync_ifindexes)
 {
 	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
 	GPtrArray *entries = vtable->get_entries (priv);
@@ -289,22 +301,30 @@ _platform_route_sync_flush (const VTableIP *vtable, NMDefaultRouteManager *self,
 
 	for (i = 0; i < routes->len; i++) {
 		const NMPlatformIPRoute *route;
-		gboolean has_ifindex_synced = FALSE;
+		gboolean has_ifindex_synced;
 		Entry *entry = NULL;
 
 		route = _vt_route_index (vtable, routes, i);
 
+		/* routes on interfaces that didn't change are already in sync. */
+		if (   sync_ifindexes
+		    && route->ifindex != ifindex_to_flush
+		    && !g_hash_table_contains (sync_ifindexes, GINT_TO_POINTER (route->ifindex)))
+			continue;
+
+		has_ifindex_synced = g_hash_table_contains (synced_ifindexes, GINT_TO_POINTER (route->ifindex));
+
 		/* look at all entires and see if the route for this ifindex pair is
 		 * a known entry. */
-		for (j = 0; j < entries->len; j++) {
+		for (j = 0; has_ifindex_synced && j < entries->len; j++) {
 			Entry *e = g_ptr_array_index (entries, j);
 
 			if (   e->route.rx.ifindex == route->ifindex
-			    && e->synced) {
-				has_ifindex_synced = TRUE;
-				if (   !e->never_default
-				    && e->effective_metric == route->metric)
-					entry = e;
+			    && e->synced
+			    && !e->never_default
+			    && e->effective_metric == route->metric) {
+				entry = e;
+				break;
 			}
 		}
 
@@ -368,11 +388,27 @@ _sort_entries_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
 }
 
 static GHashTable *
-_get_assumed_interface_metrics (const VTableIP *vtable, NMDefaultRouteManager *self, GArray *routes)
+_get_synced_ifindexes (GPtrArray *entries)
 {
-	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
-	GPtrArray *entries;
-	guint i, j;
+	GHashTable *result;
+	guint i;
+
+	/* the set of ifindexes that have at least one synced entry,
+	 * i.e. the interfaces whose default routes we manage. */
+	result = g_hash_table_new (NULL, NULL);
+	for (i = 0; i < entries->len; i++) {
+		Entry *e = g_ptr_array_index (entries, i);
+
+		if (e->synced)
+			g_hash_table_add (result, GINT_TO_POINTER (e->route.rx.ifindex));
+	}
+	return result;
+}
+
+static GHashTable *
+_get_assumed_interface_metrics (const VTableIP *vtable, GArray *routes, GHashTable *synced_ifindexes)
+{
+	guint i;
 	GHashTable *result;
 
 	/* create a list of all metrics that are currently assigned on an interface
@@ -380,33 +416,32 @@ _get_assumed_interface_metrics (const VTableIP *vtable, NMDefaultRouteManager *s
 	 * IOW, returns the metrics that are in use by assumed interfaces
 	 * that we want to preserve. */
 
-	entries = vtable->get_entries (priv);
-
 	result = g_hash_table_new (NULL, NULL);
 
 	for (i = 0; i < routes->len; i++) {
-		gboolean ifindex_has_synced_entry = FALSE;
 		const NMPlatformIPRoute *route;
 
 		route = _vt_route_index (vtable, routes, i);
 
-		for (j = 0; j < entries->len; j++) {
-			Entry *e = g_ptr_array_index (entries, j);
-
-			if (   e->synced
-			    && e->route.rx.ifindex == route->ifindex) {
-				ifindex_has_synced_entry = TRUE;
-				break;
-			}
-		}
-
-		if (!ifindex_has_synced_entry)
+		if (!g_hash_table_contains (synced_ifindexes, GINT_TO_POINTER (route->ifindex)))
 			g_hash_table_add (result, GUINT_TO_POINTER (vtable->route_metric_normalize (route->metric)));
 	}
 
 	return result;
 }
 
+static GHashTable **
+_vt_changed_ifindexes (const VTableIP *vtable, NMDefaultRouteManagerPrivate *priv)
+{
+	return VTABLE_IS_IP4 ? &priv->resync.changed_ifindexes_v4 : &priv->resync.changed_ifindexes_v6;
+}
+
+static GHashTable **
+_vt_default_ifindexes (const VTableIP *vtable, NMDefaultRouteManagerPrivate *priv)
+{
+	return VTABLE_IS_IP4 ? &priv->resync.default_ifindexes_v4 : &priv->resync.default_ifindexes_v6;
+}
+
 static int
 _sort_metrics_ascending_fcn (gconstpointer a, gconstpointer b)
 {
@@ -418,8 +453,15 @@ _sort_metrics_ascending_fcn (gconstpointer a, gconstpointer b)
 	return m_a == m_b ? 0 : 1;
 }
 
+/* Resync the default routes of one address family.
+ *
+ * @sync_ifindexes is the set of ifindexes that changed externally, or %NULL
+ * to check all of them. Effective metrics are always re-evaluated for all
+ * entries, but only entries on @sync_ifindexes (and those whose effective
+ * metric changes) are checked against the platform routes.
+ */
 static gboolean
-_resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *changed_entry, const Entry *old_entry, gboolean external_change)
+_resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *changed_entry, const Entry *old_entry, GHashTable *sync_ifindexes)
 {
 	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
 	Entry *entry;
@@ -429,6 +471,8 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 	GPtrArray *entries;
 	GArray *changed_metrics = g_array_new (FALSE, FALSE, sizeof (guint32));
 	GHashTable *assumed_metrics;
+	GHashTable *synced_ifindexes;
+	GHashTable **default_ifindexes;
 	GArray *routes;
 	gboolean changed = FALSE;
 	int ifindex_to_flush = 0;
@@ -436,20 +480,34 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 	g_assert (priv->resync.guard == 0);
 	priv->resync.guard++;
 
-	if (!external_change) {
+	if (!sync_ifindexes) {
+		/* a full resync covers all pending external changes too. */
 		if (VTABLE_IS_IP4)
 			priv->resync.has_v4_changes = FALSE;
 		else
 			priv->resync.has_v6_changes = FALSE;
+		g_clear_pointer (_vt_changed_ifindexes (vtable, priv), g_hash_table_unref);
 		if (!priv->resync.has_v4_changes && !priv->resync.has_v6_changes)
 			_resync_idle_cancel (self);
+	} else {
+		/* metric changes below add more ifindexes to check. */
+		sync_ifindexes = g_hash_table_ref (sync_ifindexes);
 	}
 
 	entries = vtable->get_entries (priv);
 
 	routes = vtable->platform_route_get_all (0, NM_PLATFORM_GET_ROUTE_MODE_ONLY_DEFAULT);
 
-	assumed_metrics = _get_assumed_interface_metrics (vtable, self, routes);
+	default_ifindexes = _vt_default_ifindexes (vtable, priv);
+	if (*default_ifindexes)
+		g_hash_table_remove_all (*default_ifindexes);
+	else
+		*default_ifindexes = g_hash_table_new (NULL, NULL);
+	for (i = 0; i < routes->len; i++)
+		g_hash_table_add (*default_ifindexes, GINT_TO_POINTER (_vt_route_index (vtable, routes, i)->ifindex));
+
+	synced_ifindexes = _get_synced_ifindexes (entries);
+	assumed_metrics = _get_assumed_interface_metrics (vtable, routes, synced_ifindexes);
 
 	if (old_entry && old_entry->synced && !old_entry->never_default) {
 		/* The old version obviously changed. */
@@ -466,22 +524,11 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 			continue;
 
 		if (!entry->synced) {
-			gboolean has_synced_entry = FALSE;
-
 			/* A non synced entry is completely ignored, if we have
 			 * a synced entry for the same if index.
 			 * Otherwise the metric of the entry is still remembered as
 			 * last_metric to avoid reusing it. */
-			for (j = 0; j < entries->len; j++) {
-				const Entry *e = g_ptr_array_index (entries, j);
-
-				if (   e->synced
-					&& e->route.rx.ifindex == entry->route.rx.ifindex) {
-					has_synced_entry = TRUE;
-					break;
-				}
-			}
-			if (!has_synced_entry)
+			if (!g_hash_table_contains (synced_ifindexes, GINT_TO_POINTER (entry->route.rx.ifindex)))
 				last_metric = MAX (last_metric, (gint64) entry->effective_metric);
 			continue;
 		}
@@ -499,7 +546,7 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 
 			/* However, if there is a matching route (ifindex+metric) for our current entry, we are done. */
 			for (j = 0; j < routes->len; j++) {
-				const NMPlatformIPRoute *r = _vt_route_index (vtable, routes, i);
+				const NMPlatformIPRoute *r = _vt_route_index (vtable, routes, j);
 
 				if (   r->metric == expected_metric
 				    && r->ifindex == entry->route.rx.ifindex) {
@@ -530,7 +577,8 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 			_LOGD (vtable->addr_family, LOG_ENTRY_FMT": resync metric %s (%u -> %u)", LOG_ENTRY_ARGS (i, entry),
 			       vtable->platform_route_to_string (&entry->route.rx), (guint) entry->effective_metric,
 			       (guint) expected_metric);
-		} else {
+		} else if (   !sync_ifindexes
+		           || g_hash_table_contains (sync_ifindexes, GINT_TO_POINTER (entry->route.rx.ifindex))) {
 			if (!_vt_routes_has_entry (vtable, routes, entry)) {
 				g_array_append_val (changed_metrics, entry->effective_metric);
 				_LOGD (vtable->addr_family, LOG_ENTRY_FMT": readd route %s (%u -> %u)", LOG_ENTRY_ARGS (i, entry),
@@ -542,6 +590,8 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 		if (entry->effective_metric != expected_metric) {
 			entry->effective_metric = expected_metric;
 			changed = TRUE;
+			if (sync_ifindexes)
+				g_hash_table_add (sync_ifindexes, GINT_TO_POINTER (entry->route.rx.ifindex));
 		}
 		last_metric = expected_metric;
 	}
@@ -571,10 +621,13 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 		ifindex_to_flush = old_entry->route.rx.ifindex;
 	}
 
-	changed |= _platform_route_sync_flush (vtable, self, ifindex_to_flush);
+	changed |= _platform_route_sync_flush (vtable, self, ifindex_to_flush, synced_ifindexes, sync_ifindexes);
 
 	g_array_free (changed_metrics, TRUE);
 	g_hash_table_unref (assumed_metrics);
+	g_hash_table_unref (synced_ifindexes);
+	if (sync_ifindexes)
+		g_hash_table_unref (sync_ifindexes);
 
 	priv->resync.guard--;
 	return changed;
@@ -605,7 +658,7 @@ _entry_at_idx_update (const VTableIP *vtable, NMDefaultRouteManager *self, guint
 
 	g_ptr_array_sort_with_data (entries, _sort_entries_cmp, NULL);
 
-	_resync_all (vtable, self, entry, old_entry, FALSE);
+	_resync_all (vtable, self, entry, old_entry, NULL);
 }
 
 static void
@@ -628,7 +681,7 @@ _entry_at_idx_remove (const VTableIP *vtable, NMDefaultRouteManager *self, guint
 	g_ptr_array_index (entries, entry_idx) = NULL;
 	g_ptr_array_remove_index (entries, entry_idx);
 
-	_resync_all (vtable, self, NULL, entry, FALSE);
+	_resync_all (vtable, self, NULL, entry, NULL);
 
 	_entry_free (entry);
 }
@@ -1187,18 +1240,23 @@ static gboolean
 _resync_idle_now (NMDefaultRouteManager *self)
 {
 	gboolean has_v4_changes, has_v6_changes;
+	GHashTable *changed_ifindexes_v4, *changed_ifindexes_v6;
 	gboolean changed = FALSE;
 
 	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
 
 	has_v4_changes = priv->resync.has_v4_changes;
 	has_v6_changes = priv->resync.has_v6_changes;
+	changed_ifindexes_v4 = priv->resync.changed_ifindexes_v4;
+	changed_ifindexes_v6 = priv->resync.changed_ifindexes_v6;
 
 	_LOGD (0, "resync: sync now (%u) (IPv4 changes: %s, IPv6 changes: %s)", priv->resync.idle_handle,
 	       has_v4_changes ? "yes" : "no", has_v6_changes ? "yes" : "no");
 
 	priv->resync.has_v4_changes = FALSE;
 	priv->resync.has_v6_changes = FALSE;
+	priv->resync.changed_ifindexes_v4 = NULL;
+	priv->resync.changed_ifindexes_v6 = NULL;
 	priv->resync.idle_handle = 0;
 	priv->resync.backoff_wait_time_ms =
 	    priv->resync.backoff_wait_time_ms == 0
@@ -1206,10 +1264,15 @@ _resync_idle_now (NMDefaultRouteManager *self)
 	    : priv->resync.backoff_wait_time_ms * 2;
 
 	if (has_v4_changes)
-		changed |= _resync_all (&vtable_ip4, self, NULL, NULL, TRUE);
+		changed |= _resync_all (&vtable_ip4, self, NULL, NULL, changed_ifindexes_v4);
 
 	if (has_v6_changes)
-		changed |= _resync_all (&vtable_ip6, self, NULL, NULL, TRUE);
+		changed |= _resync_all (&vtable_ip6, self, NULL, NULL, changed_ifindexes_v6);
+
+	if (changed_ifindexes_v4)
+		g_hash_table_unref (changed_ifindexes_v4);
+	if (changed_ifindexes_v6)
+		g_hash_table_unref (changed_ifindexes_v6);
 
 	if (!changed) {
 		/* Nothing changed: reset the backoff wait time */
@@ -1232,6 +1295,8 @@ _resync_idle_cancel (NMDefaultRouteManager *self)
 	priv->resync.backoff_wait_time_ms = 0;
 	priv->resync.has_v4_changes = FALSE;
 	priv->resync.has_v6_changes = FALSE;
+	g_clear_pointer (&priv->resync.changed_ifindexes_v4, g_hash_table_unref);
+	g_clear_pointer (&priv->resync.changed_ifindexes_v6, g_hash_table_unref);
 }
 
 static void
@@ -1258,17 +1323,59 @@ _resync_idle_reschedule (NMDefaultRouteManager *self)
 	}
 }
 
+static gboolean
+_address_change_is_relevant (const VTableIP *vtable,
+                             NMDefaultRouteManager *self,
+                             int ifindex,
+                             NMPlatformSignalChangeType change_type)
+{
+	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
+	GPtrArray *entries = vtable->get_entries (priv);
+	GHashTable *default_ifindexes;
+	guint i;
+
+	/* Address changes only matter for default routes on the same interface:
+	 * removing an address can make the kernel drop them without notification,
+	 * and adding one can make a gateway reachable so that a route we failed to
+	 * add before can be added now. */
+	for (i = 0; i < entries->len; i++) {
+		const Entry *e = g_ptr_array_index (entries, i);
+
+		if (e->route.rx.ifindex != ifindex)
+			continue;
+		if (change_type != NM_PLATFORM_SIGNAL_ADDED)
+			return TRUE;
+		if (e->synced && !e->never_default)
+			return TRUE;
+	}
+
+	if (change_type != NM_PLATFORM_SIGNAL_ADDED) {
+		default_ifindexes = *_vt_default_ifindexes (vtable, priv);
+		if (   default_ifindexes
+		    && g_hash_table_contains (default_ifindexes, GINT_TO_POINTER (ifindex)))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
 static void
-_platform_ipx_route_changed_cb (const VTableIP *vtable,
-                                NMDefaultRouteManager *self,
-                                const NMPlatformIPRoute *route)
+_platform_ipx_changed_cb (const VTableIP *vtable,
+                          NMDefaultRouteManager *self,
+                          int ifindex,
+                          const NMPlatformIPRoute *route,
+                          NMPlatformSignalChangeType change_type)
 {
 	NMDefaultRouteManagerPrivate *priv;
+	GHashTable **changed_ifindexes;
 
-	if (route && !NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route)) {
-		/* we only care about address changes or changes of default route. */
+	if (route) {
+		if (!NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route)) {
+			/* we only care about address changes or changes of default route. */
+			return;
+		}
+	} else if (!_address_change_is_relevant (vtable, self, ifindex, change_type))
 		return;
-	}
 
 	priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
 
@@ -1282,6 +1389,11 @@ _platform_ipx_route_changed_cb (const VTableIP *vtable,
 	else
 		priv->resync.has_v6_changes = TRUE;
 
+	changed_ifindexes = _vt_changed_ifindexes (vtable, priv);
+	if (!*changed_ifindexes)
+		*changed_ifindexes = g_hash_table_new (NULL, NULL);
+	g_hash_table_add (*changed_ifindexes, GINT_TO_POINTER (ifindex));
+
 	_resync_idle_reschedule (self);
 }
 
@@ -1293,7 +1405,7 @@ _platform_ip4_address_changed_cb (NMPlatform *platform,
                                   NMPlatformReason reason,
                                   NMDefaultRouteManager *self)
 {
-	_platform_ipx_route_changed_cb (&vtable_ip4, self, NULL);
+	_platform_ipx_changed_cb (&vtable_ip4, self, ifindex, NULL, change_type);
 }
 
 static void
@@ -1304,7 +1416,7 @@ _platform_ip6_address_changed_cb (NMPlatform *platform,
                                   NMPlatformReason reason,
                                   NMDefaultRouteManager *self)
 {
-	_platform_ipx_route_changed_cb (&vtable_ip6, self, NULL);
+	_platform_ipx_changed_cb (&vtable_ip6, self, ifindex, NULL, change_type);
 }
 
 static void
@@ -1315,7 +1427,7 @@ _platform_ip4_route_changed_cb (NMPlatform *platform,
                                 NMPlatformReason reason,
                                 NMDefaultRouteManager *self)
 {
-	_platform_ipx_route_changed_cb (&vtable_ip4, self, platform_object);
+	_platform_ipx_changed_cb (&vtable_ip4, self, ifindex, platform_object, change_type);
 }
 
 static void
@@ -1326,7 +1438,7 @@ _platform_ip6_route_changed_cb (NMPlatform *platform,
                                 NMPlatformReason reason,
                                 NMDefaultRouteManager *self)
 {
-	_platform_ipx_route_changed_cb (&vtable_ip6, self, platform_object);
+	_platform_ipx_changed_cb (&vtable_ip6, self, ifindex, platform_object, change_type);
 }
 
 /***********************************************************************************/
@@ -1363,6 +1475,8 @@ dispose (GObject *object)
 	}
 
 	_resync_idle_cancel (self);
+	g_clear_pointer (&priv->resync.default_ifindexes_v4, g_hash_table_unref);
+	g_clear_pointer (&priv->resync.default_ifindexes_v6, g_hash_table_unref);
 
 	g_signal_handlers_disconnect_by_data (nm_platform_get (), self);
 
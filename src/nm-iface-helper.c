@@ -33,6 +33,7 @@
 #include <sys/resource.h>
 #include <sys/stat.h>
 #include <signal.h>
+#include <net/if.h>
 
 #include "gsystem-local-alloc.h"
 #include "NetworkManagerUtils.h"
@@ -49,15 +50,84 @@
 #endif
 
 #define NMIH_PID_FILE_FMT NMRUNDIR "/nm-iface-helper-%d.pid"
+#define NMIH_SHARED_PID_FILE NMRUNDIR "/nm-iface-helper.pid"
+
+/* State of one interface managed by this helper.  In the default mode the
+ * helper manages exactly one; with --interfaces it manages every interface
+ * listed in the file, sharing one platform cache, netlink event socket
+ * and DHCP manager between them.
+ */
+typedef struct {
+	char *ifname;
+	int ifindex;
+	gboolean slaac_required;
+	gboolean dhcp4_required;
+	int tempaddr;
+	guint32 priority_v4;
+	guint32 priority_v6;
+
+	NMDhcpClient *dhcp4_client;
+	NMRDisc *rdisc;
+	NMIP4Config *last_config4;
+	NMIP6Config *last_config6;
+	guint remove_id;
+} ManagedIface;
 
 static GMainLoop *main_loop = NULL;
-static char *ifname = NULL;
-static int ifindex = -1;
-static gboolean slaac_required = FALSE;
-static gboolean dhcp4_required = FALSE;
-static int tempaddr = NM_SETTING_IP6_CONFIG_PRIVACY_UNKNOWN;
-static guint32 priority_v4 = NM_PLATFORM_ROUTE_METRIC_DEFAULT_IP4;
-static guint32 priority_v6 = NM_PLATFORM_ROUTE_METRIC_DEFAULT_IP6;
+static GSList *ifaces = NULL;
+
+/* Per-interface command line options; in --interfaces mode these are
+ * parsed once for every interface listed in the file.
+ */
+static struct {
+	char *ifname;
+	char *uuid;
+	gboolean slaac;
+	gboolean slaac_required;
+	int tempaddr;
+	char *dhcp4_address;
+	gboolean dhcp4_required;
+	char *dhcp4_clientid;
+	char *dhcp4_hostname;
+	gint64 priority64_v4;
+	gint64 priority64_v6;
+	char *iid_str;
+} opt;
+
+static GOptionEntry iface_options[] = {
+	{ "ifname", 'i', 0, G_OPTION_ARG_STRING, &opt.ifname, N_("The interface to manage"), N_("eth0") },
+	{ "uuid", 'u', 0, G_OPTION_ARG_STRING, &opt.uuid, N_("Connection UUID"), N_("661e8cd0-b618-46b8-9dc9-31a52baaa16b") },
+	{ "slaac", 's', 0, G_OPTION_ARG_NONE, &opt.slaac, N_("Whether to manage IPv6 SLAAC"), NULL },
+	{ "slaac-required", '6', 0, G_OPTION_ARG_NONE, &opt.slaac_required, N_("Whether SLAAC must be successful"), NULL },
+	{ "slaac-tempaddr", 't', 0, G_OPTION_ARG_INT, &opt.tempaddr, N_("Use an IPv6 temporary privacy address"), NULL },
+	{ "dhcp4", 'd', 0, G_OPTION_ARG_STRING, &opt.dhcp4_address, N_("Current DHCPv4 address"), NULL },
+	{ "dhcp4-required", '4', 0, G_OPTION_ARG_NONE, &opt.dhcp4_required, N_("Whether DHCPv4 must be successful"), NULL },
+	{ "dhcp4-clientid", 'c', 0, G_OPTION_ARG_STRING, &opt.dhcp4_clientid, N_("Hex-encoded DHCPv4 client ID"), NULL },
+	{ "dhcp4-hostname", 'h', 0, G_OPTION_ARG_STRING, &opt.dhcp4_hostname, N_("Hostname to send to DHCP server"), N_("barbar") },
+	{ "priority4", '\0', 0, G_OPTION_ARG_INT64, &opt.priority64_v4, N_("Route priority for IPv4"), N_("0") },
+	{ "priority6", '\0', 0, G_OPTION_ARG_INT64, &opt.priority64_v6, N_("Route priority for IPv6"), N_("1024") },
+	{ "iid", 'e', 0, G_OPTION_ARG_STRING, &opt.iid_str, N_("Hex-encoded Interface Identifier"), N_("") },
+	{NULL}
+};
+
+static void
+iface_options_reset (void)
+{
+	g_clear_pointer (&opt.ifname, g_free);
+	g_clear_pointer (&opt.uuid, g_free);
+	g_clear_pointer (&opt.dhcp4_address, g_free);
+	g_clear_pointer (&opt.dhcp4_clientid, g_free);
+	g_clear_pointer (&opt.dhcp4_hostname, g_free);
+	g_clear_pointer (&opt.iid_str, g_free);
+	opt.slaac = FALSE;
+	opt.slaac_required = FALSE;
+	opt.dhcp4_required = FALSE;
+	opt.tempaddr = NM_SETTING_IP6_CONFIG_PRIVACY_UNKNOWN;
+	opt.priority64_v4 = -1;
+	opt.priority64_v6 = -1;
+}
+
+static void managed_iface_schedule_remove (ManagedIface *iface);
 
 static void
 dhcp4_state_changed (NMDhcpClient *client,
@@ -66,38 +136,38 @@ dhcp4_state_changed (NMDhcpClient *client,
                      GHashTable *options,
                      gpointer user_data)
 {
-	static NMIP4Config *last_config = NULL;
+	ManagedIface *iface = user_data;
 	NMIP4Config *existing;
 
 	g_return_if_fail (!ip4_config || NM_IS_IP4_CONFIG (ip4_config));
 
-	nm_log_dbg (LOGD_DHCP4, "(%s): new DHCPv4 client state %d", ifname, state);
+	nm_log_dbg (LOGD_DHCP4, "(%s): new DHCPv4 client state %d", iface->ifname, state);
 
 	switch (state) {
 	case NM_DHCP_STATE_BOUND:
 		g_assert (ip4_config);
-		existing = nm_ip4_config_capture (ifindex, FALSE);
-		if (last_config)
-			nm_ip4_config_subtract (existing, last_config);
+		existing = nm_ip4_config_capture (iface->ifindex, FALSE);
+		if (iface->last_config4)
+			nm_ip4_config_subtract (existing, iface->last_config4);
 
 		nm_ip4_config_merge (existing, ip4_config);
-		if (!nm_ip4_config_commit (existing, ifindex, priority_v4))
-			nm_log_warn (LOGD_DHCP4, "(%s): failed to apply DHCPv4 config", ifname);
+		if (!nm_ip4_config_commit (existing, iface->ifindex, iface->priority_v4))
+			nm_log_warn (LOGD_DHCP4, "(%s): failed to apply DHCPv4 config", iface->ifname);
 
-		if (last_config) {
-			g_object_unref (last_config);
-			last_config = nm_ip4_config_new ();
-			nm_ip4_config_replace (last_config, ip4_config, NULL);
+		if (iface->last_config4) {
+			g_object_unref (iface->last_config4);
+			iface->last_config4 = nm_ip4_config_new ();
+			nm_ip4_config_replace (iface->last_config4, ip4_config, NULL);
 		}
 		break;
 	case NM_DHCP_STATE_TIMEOUT:
 	case NM_DHCP_STATE_DONE:
 	case NM_DHCP_STATE_FAIL:
-		if (dhcp4_required) {
-			nm_log_warn (LOGD_DHCP4, "(%s): DHCPv4 timed out or failed, quitting...", ifname);
-			g_main_loop_quit (main_loop);
+		if (iface->dhcp4_required) {
+			nm_log_warn (LOGD_DHCP4, "(%s): DHCPv4 timed out or failed, giving up on interface", iface->ifname);
+			managed_iface_schedule_remove (iface);
 		} else
-			nm_log_warn (LOGD_DHCP4, "(%s): DHCPv4 timed out or failed", ifname);
+			nm_log_warn (LOGD_DHCP4, "(%s): DHCPv4 timed out or failed", iface->ifname);
 		break;
 	default:
 		break;
@@ -107,7 +177,7 @@ dhcp4_state_changed (NMDhcpClient *client,
 static void
 rdisc_config_changed (NMRDisc *rdisc, NMRDiscConfigMap changed, gpointer user_data)
 {
-	static NMIP6Config *last_config = NULL;
+	ManagedIface *iface = user_data;
 	NMIP6Config *existing;
 	NMIP6Config *ip6_config;
 	static int system_support = -1;
@@ -128,8 +198,8 @@ rdisc_config_changed (NMRDisc *rdisc, NMRDiscConfigMap changed, gpointer user_da
 
 	if (system_support)
 		ifa_flags = IFA_F_NOPREFIXROUTE;
-	if (tempaddr == NM_SETTING_IP6_CONFIG_PRIVACY_PREFER_TEMP_ADDR
-	    || tempaddr == NM_SETTING_IP6_CONFIG_PRIVACY_PREFER_PUBLIC_ADDR)
+	if (iface->tempaddr == NM_SETTING_IP6_CONFIG_PRIVACY_PREFER_TEMP_ADDR
+	    || iface->tempaddr == NM_SETTING_IP6_CONFIG_PRIVACY_PREFER_PUBLIC_ADDR)
 	{
 		/* without system_support, this flag will be ignored. Still set it, doesn't seem to do any harm. */
 		ifa_flags |= IFA_F_MANAGETEMPADDR;
@@ -193,7 +263,7 @@ rdisc_config_changed (NMRDisc *rdisc, NMRDiscConfigMap changed, gpointer user_da
 				route.plen = discovered_route->plen;
 				route.gateway = discovered_route->gateway;
 				route.source = NM_IP_CONFIG_SOURCE_RDISC;
-				route.metric = priority_v6;
+				route.metric = iface->priority_v6;
 
 				nm_ip6_config_add_route (ip6_config, &route);
 			}
@@ -210,39 +280,265 @@ rdisc_config_changed (NMRDisc *rdisc, NMRDiscConfigMap changed, gpointer user_da
 		char val[16];
 
 		g_snprintf (val, sizeof (val), "%d", rdisc->hop_limit);
-		nm_platform_sysctl_set (nm_utils_ip6_property_path (ifname, "hop_limit"), val);
+		nm_platform_sysctl_set (nm_utils_ip6_property_path (iface->ifname, "hop_limit"), val);
 	}
 
 	if (changed & NM_RDISC_CONFIG_MTU) {
 		char val[16];
 
 		g_snprintf (val, sizeof (val), "%d", rdisc->mtu);
-		nm_platform_sysctl_set (nm_utils_ip6_property_path (ifname, "mtu"), val);
+		nm_platform_sysctl_set (nm_utils_ip6_property_path (iface->ifname, "mtu"), val);
 	}
 
-	existing = nm_ip6_config_capture (ifindex, FALSE, tempaddr);
-	if (last_config)
-		nm_ip6_config_subtract (existing, last_config);
+	existing = nm_ip6_config_capture (iface->ifindex, FALSE, iface->tempaddr);
+	if (iface->last_config6)
+		nm_ip6_config_subtract (existing, iface->last_config6);
 
 	nm_ip6_config_merge (existing, ip6_config);
-	if (!nm_ip6_config_commit (existing, ifindex))
-		nm_log_warn (LOGD_IP6, "(%s): failed to apply IPv6 config", ifname);
+	if (!nm_ip6_config_commit (existing, iface->ifindex))
+		nm_log_warn (LOGD_IP6, "(%s): failed to apply IPv6 config", iface->ifname);
 
-	if (last_config) {
-		g_object_unref (last_config);
-		last_config = nm_ip6_config_new ();
-		nm_ip6_config_replace (last_config, ip6_config, NULL);
+	if (iface->last_config6) {
+		g_object_unref (iface->last_config6);
+		iface->last_config6 = nm_ip6_config_new ();
+		nm_ip6_config_replace (iface->last_config6, ip6_config, NULL);
 	}
 }
 
 static void
 rdisc_ra_timeout (NMRDisc *rdisc, gpointer user_data)
 {
-	if (slaac_required) {
-		nm_log_warn (LOGD_IP6, "(%s): IPv6 timed out or failed, quitting...", ifname);
-		g_main_loop_quit (main_loop);
+	ManagedIface *iface = user_data;
+
+	if (iface->slaac_required) {
+		nm_log_warn (LOGD_IP6, "(%s): IPv6 timed out or failed, giving up on interface", iface->ifname);
+		managed_iface_schedule_remove (iface);
 	} else
-		nm_log_warn (LOGD_IP6, "(%s): IPv6 timed out or failed", ifname);
+		nm_log_warn (LOGD_IP6, "(%s): IPv6 timed out or failed", iface->ifname);
+}
+
+static void
+managed_iface_free (ManagedIface *iface)
+{
+	if (iface->remove_id)
+		g_source_remove (iface->remove_id);
+	if (iface->dhcp4_client) {
+		g_signal_handlers_disconnect_by_data (iface->dhcp4_client, iface);
+		g_object_unref (iface->dhcp4_client);
+	}
+	if (iface->rdisc) {
+		g_signal_handlers_disconnect_by_data (iface->rdisc, iface);
+		g_object_unref (iface->rdisc);
+	}
+	g_clear_object (&iface->last_config4);
+	g_clear_object (&iface->last_config6);
+	g_free (iface->ifname);
+	g_slice_free (ManagedIface, iface);
+}
+
+static gboolean
+managed_iface_remove_cb (gpointer user_data)
+{
+	ManagedIface *iface = user_data;
+
+	iface->remove_id = 0;
+	ifaces = g_slist_remove (ifaces, iface);
+	managed_iface_free (iface);
+
+	if (!ifaces) {
+		nm_log_info (LOGD_CORE, "no interfaces left to manage, quitting...");
+		g_main_loop_quit (main_loop);
+	}
+	return G_SOURCE_REMOVE;
+}
+
+static void
+managed_iface_schedule_remove (ManagedIface *iface)
+{
+	/* Called from the DHCP client's or rdisc's own signal handlers, so
+	 * don't destroy them right away.
+	 */
+	if (!iface->remove_id)
+		iface->remove_id = g_idle_add (managed_iface_remove_cb, iface);
+}
+
+/* Starts managing the interface described by the current per-interface
+ * options (see iface_options).
+ */
+static ManagedIface *
+managed_iface_start (void)
+{
+	ManagedIface *iface;
+	GByteArray *hwaddr = NULL;
+	size_t hwaddr_len = 0;
+	gconstpointer tmp;
+	gs_free NMUtilsIPv6IfaceId *iid = NULL;
+	int ifindex;
+
+	if (!opt.ifname || !opt.uuid) {
+		nm_log_warn (LOGD_CORE, "An interface name and UUID are required");
+		return NULL;
+	}
+
+	ifindex = nm_platform_link_get_ifindex (opt.ifname);
+	if (ifindex <= 0) {
+		nm_log_warn (LOGD_CORE, "Failed to find interface index for %s", opt.ifname);
+		return NULL;
+	}
+
+	if (opt.iid_str) {
+		GBytes *bytes;
+		gsize ignored = 0;
+
+		bytes = nm_utils_hexstr2bin (opt.iid_str);
+		if (!bytes || g_bytes_get_size (bytes) != sizeof (*iid)) {
+			nm_log_warn (LOGD_CORE, "(%s): Invalid IID %s", opt.ifname, opt.iid_str);
+			if (bytes)
+				g_bytes_unref (bytes);
+			return NULL;
+		}
+		iid = g_bytes_unref_to_data (bytes, &ignored);
+	}
+
+	iface = g_slice_new0 (ManagedIface);
+	iface->ifname = g_strdup (opt.ifname);
+	iface->ifindex = ifindex;
+	iface->slaac_required = opt.slaac_required;
+	iface->dhcp4_required = opt.dhcp4_required;
+	iface->tempaddr = opt.tempaddr;
+	iface->priority_v4 = NM_PLATFORM_ROUTE_METRIC_DEFAULT_IP4;
+	iface->priority_v6 = NM_PLATFORM_ROUTE_METRIC_DEFAULT_IP6;
+
+	if (opt.priority64_v4 >= 0 && opt.priority64_v4 <= G_MAXUINT32)
+		iface->priority_v4 = (guint32) opt.priority64_v4;
+
+	if (opt.priority64_v6 >= 0 && opt.priority64_v6 <= G_MAXUINT32)
+		iface->priority_v6 = (guint32) opt.priority64_v6;
+
+	tmp = nm_platform_link_get_address (ifindex, &hwaddr_len);
+	if (tmp) {
+		hwaddr = g_byte_array_sized_new (hwaddr_len);
+		g_byte_array_append (hwaddr, tmp, hwaddr_len);
+	}
+
+	if (opt.dhcp4_address) {
+		nm_platform_sysctl_set (nm_utils_ip4_property_path (iface->ifname, "promote_secondaries"), "1");
+
+		iface->dhcp4_client = nm_dhcp_manager_start_ip4 (nm_dhcp_manager_get (),
+		                                                 iface->ifname,
+		                                                 ifindex,
+		                                                 hwaddr,
+		                                                 opt.uuid,
+		                                                 iface->priority_v4,
+		                                                 !!opt.dhcp4_hostname,
+		                                                 opt.dhcp4_hostname,
+		                                                 opt.dhcp4_clientid,
+		                                                 45,
+		                                                 NULL,
+		                                                 opt.dhcp4_address);
+		g_assert (iface->dhcp4_client);
+		g_signal_connect (iface->dhcp4_client,
+		                  NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED,
+		                  G_CALLBACK (dhcp4_state_changed),
+		                  iface);
+	}
+
+	if (opt.slaac) {
+		nm_platform_link_set_user_ipv6ll_enabled (ifindex, TRUE);
+
+		iface->rdisc = nm_lndp_rdisc_new (ifindex, iface->ifname);
+		g_assert (iface->rdisc);
+
+		if (iid)
+			nm_rdisc_set_iid (iface->rdisc, *iid);
+
+		nm_platform_sysctl_set (nm_utils_ip6_property_path (iface->ifname, "accept_ra"), "1");
+		nm_platform_sysctl_set (nm_utils_ip6_property_path (iface->ifname, "accept_ra_defrtr"), "0");
+		nm_platform_sysctl_set (nm_utils_ip6_property_path (iface->ifname, "accept_ra_pinfo"), "0");
+		nm_platform_sysctl_set (nm_utils_ip6_property_path (iface->ifname, "accept_ra_rtr_pref"), "0");
+
+		g_signal_connect (iface->rdisc,
+		                  NM_RDISC_CONFIG_CHANGED,
+		                  G_CALLBACK (rdisc_config_changed),
+		                  iface);
+		g_signal_connect (iface->rdisc,
+		                  NM_RDISC_RA_TIMEOUT,
+		                  G_CALLBACK (rdisc_ra_timeout),
+		                  iface);
+		nm_rdisc_start (iface->rdisc);
+	}
+
+	g_clear_pointer (&hwaddr, g_byte_array_unref);
+
+	nm_log_info (LOGD_CORE, "(%s): managing interface", iface->ifname);
+	return iface;
+}
+
+/* Reads a file written by NetworkManager with one group per interface.
+ * Each group has an "args" key holding the per-interface command line
+ * options exactly as they would be passed to a dedicated helper.
+ */
+static gboolean
+managed_ifaces_start_from_file (const char *path)
+{
+	GKeyFile *keyfile;
+	GError *error = NULL;
+	char **groups;
+	guint i;
+
+	keyfile = g_key_file_new ();
+	if (!g_key_file_load_from_file (keyfile, path, G_KEY_FILE_NONE, &error)) {
+		nm_log_warn (LOGD_CORE, "Failed to read interface list %s: %s", path, error->message);
+		g_error_free (error);
+		g_key_file_free (keyfile);
+		return FALSE;
+	}
+
+	groups = g_key_file_get_groups (keyfile, NULL);
+	for (i = 0; groups[i]; i++) {
+		GOptionContext *opt_ctx;
+		ManagedIface *iface;
+		char **args, **argv;
+		gsize n_args = 0;
+		int argc;
+
+		args = g_key_file_get_string_list (keyfile, groups[i], "args", &n_args, NULL);
+		if (!args) {
+			nm_log_warn (LOGD_CORE, "(%s): no arguments given; ignoring", groups[i]);
+			continue;
+		}
+
+		/* GOptionContext wants a program name in argv[0] */
+		argc = n_args + 1;
+		argv = g_new0 (char *, argc + 1);
+		argv[0] = (char *) "nm-iface-helper";
+		memcpy (&argv[1], args, n_args * sizeof (char *));
+
+		iface_options_reset ();
+		opt_ctx = g_option_context_new (NULL);
+		g_option_context_set_help_enabled (opt_ctx, FALSE);
+		g_option_context_add_main_entries (opt_ctx, iface_options, NULL);
+		if (g_option_context_parse (opt_ctx, &argc, &argv, &error)) {
+			iface = managed_iface_start ();
+			if (iface)
+				ifaces = g_slist_prepend (ifaces, iface);
+		} else {
+			nm_log_warn (LOGD_CORE, "(%s): invalid arguments: %s", groups[i], error->message);
+			g_clear_error (&error);
+		}
+		g_option_context_free (opt_ctx);
+
+		/* The strings are owned by @args; g_option_context_parse() may
+		 * have reordered argv but doesn't free anything in it.
+		 */
+		g_free (argv);
+		g_strfreev (args);
+	}
+	iface_options_reset ();
+
+	g_strfreev (groups);
+	g_key_file_free (keyfile);
+	return ifaces != NULL;
 }
 
 static gboolean
@@ -265,36 +561,18 @@ main (int argc, char *argv[])
 {
 	char *opt_log_level = NULL;
 	char *opt_log_domains = NULL;
+	char *opt_interfaces = NULL;
 	gboolean debug = FALSE, g_fatal_warnings = FALSE, become_daemon = FALSE;
-	gboolean show_version = FALSE, slaac = FALSE;
-	char *bad_domains = NULL, *dhcp4_hostname = NULL, *uuid = NULL;
-	char *iid_str = NULL, *dhcp4_clientid = NULL, *dhcp4_address = NULL;
+	gboolean show_version = FALSE;
+	char *bad_domains = NULL;
 	GError *error = NULL;
 	gboolean wrote_pidfile = FALSE;
 	gs_free char *pidfile = NULL;
-	gs_unref_object NMDhcpClient *dhcp4_client = NULL;
-	gs_unref_object NMRDisc *rdisc = NULL;
-	GByteArray *hwaddr = NULL;
-	size_t hwaddr_len = 0;
-	gconstpointer tmp;
-	gs_free NMUtilsIPv6IfaceId *iid = NULL;
-	gint64 priority64_v4 = -1;
-	gint64 priority64_v6 = -1;
+	ManagedIface *iface;
 
 	GOptionEntry options[] = {
-		/* Interface/IP config */
-		{ "ifname", 'i', 0, G_OPTION_ARG_STRING, &ifname, N_("The interface to manage"), N_("eth0") },
-		{ "uuid", 'u', 0, G_OPTION_ARG_STRING, &uuid, N_("Connection UUID"), N_("661e8cd0-b618-46b8-9dc9-31a52baaa16b") },
-		{ "slaac", 's', 0, G_OPTION_ARG_NONE, &slaac, N_("Whether to manage IPv6 SLAAC"), NULL },
-		{ "slaac-required", '6', 0, G_OPTION_ARG_NONE, &slaac_required, N_("Whether SLAAC must be successful"), NULL },
-		{ "slaac-tempaddr", 't', 0, G_OPTION_ARG_INT, &tempaddr, N_("Use an IPv6 temporary privacy address"), NULL },
-		{ "dhcp4", 'd', 0, G_OPTION_ARG_STRING, &dhcp4_address, N_("Current DHCPv4 address"), NULL },
-		{ "dhcp4-required", '4', 0, G_OPTION_ARG_NONE, &dhcp4_required, N_("Whether DHCPv4 must be successful"), NULL },
-		{ "dhcp4-clientid", 'c', 0, G_OPTION_ARG_STRING, &dhcp4_clientid, N_("Hex-encoded DHCPv4 client ID"), NULL },
-		{ "dhcp4-hostname", 'h', 0, G_OPTION_ARG_STRING, &dhcp4_hostname, N_("Hostname to send to DHCP server"), N_("barbar") },
-		{ "priority4", '\0', 0, G_OPTION_ARG_INT64, &priority64_v4, N_("Route priority for IPv4"), N_("0") },
-		{ "priority6", '\0', 0, G_OPTION_ARG_INT64, &priority64_v6, N_("Route priority for IPv6"), N_("1024") },
-		{ "iid", 'e', 0, G_OPTION_ARG_STRING, &iid_str, N_("Hex-encoded Interface Identifier"), N_("") },
+		/* Multi-interface mode */
+		{ "interfaces", 'f', 0, G_OPTION_ARG_FILENAME, &opt_interfaces, N_("Manage all interfaces listed in the given file"), N_("FILE") },
 
 		/* Logging/debugging */
 		{ "version", 'V', 0, G_OPTION_ARG_NONE, &show_version, N_("Print NetworkManager version and exit"), NULL },
@@ -310,12 +588,15 @@ main (int argc, char *argv[])
 
 	setpgid (getpid (), getpid ());
 
+	iface_options_reset ();
+
 	if (!nm_main_utils_early_setup ("nm-iface-helper",
 	                                &argv,
 	                                &argc,
 	                                options,
-	                                NULL,
-	                                _("nm-iface-helper is a small, standalone process that manages a single network interface.")))
+	                                iface_options,
+	                                _("nm-iface-helper is a small, standalone process that manages a single network interface, "
+	                                  "or with --interfaces, a set of interfaces.")))
 		exit (1);
 
 	if (show_version) {
@@ -323,7 +604,7 @@ main (int argc, char *argv[])
 		exit (0);
 	}
 
-	if (!ifname || !uuid) {
+	if (!opt_interfaces && (!opt.ifname || !opt.uuid)) {
 		fprintf (stderr, _("An interface name and UUID are required\n"));
 		exit (1);
 	}
@@ -343,7 +624,10 @@ main (int argc, char *argv[])
 		g_clear_pointer (&bad_domains, g_free);
 	}
 
-	pidfile = g_strdup_printf (NMIH_PID_FILE_FMT, ifindex);
+	if (opt_interfaces)
+		pidfile = g_strdup (NMIH_SHARED_PID_FILE);
+	else
+		pidfile = g_strdup_printf (NMIH_PID_FILE_FMT, (int) if_nametoindex (opt.ifname));
 	g_assert (pidfile);
 
 	/* check pid file */
@@ -376,7 +660,7 @@ main (int argc, char *argv[])
 		g_log_set_always_fatal (fatal_mask);
 	}
 
-	nm_logging_syslog_openlog (debug);
+	nm_logging_syslog_openlog (NULL, debug);
 
 #if !GLIB_CHECK_VERSION (2, 35, 0)
 	g_type_init ();
@@ -384,89 +668,24 @@ main (int argc, char *argv[])
 
 	nm_log_info (LOGD_CORE, "nm-iface-helper (version " NM_DIST_VERSION ") is starting...");
 
-	/* Set up platform interaction layer */
+	/* Set up platform interaction layer; it is shared by all managed interfaces */
 	nm_linux_platform_setup ();
 
-	ifindex = nm_platform_link_get_ifindex (ifname);
-	if (ifindex <= 0) {
-		fprintf (stderr, _("Failed to find interface index for %s\n"), ifname);
-		exit (1);
-	}
-
-	tmp = nm_platform_link_get_address (ifindex, &hwaddr_len);
-	if (tmp) {
-		hwaddr = g_byte_array_sized_new (hwaddr_len);
-		g_byte_array_append (hwaddr, tmp, hwaddr_len);
-	}
-
-	if (iid_str) {
-		GBytes *bytes;
-		gsize ignored = 0;
-
-		bytes = nm_utils_hexstr2bin (iid_str);
-		if (!bytes || g_bytes_get_size (bytes) != sizeof (*iid)) {
-			fprintf (stderr, _("(%s): Invalid IID %s\n"), ifname, iid_str);
+	if (opt_interfaces) {
+		if (!managed_ifaces_start_from_file (opt_interfaces))
 			exit (1);
-		}
-		iid = g_bytes_unref_to_data (bytes, &ignored);
-	}
-
-	if (priority64_v4 >= 0 && priority64_v4 <= G_MAXUINT32)
-		priority_v4 = (guint32) priority64_v4;
-
-	if (priority64_v6 >= 0 && priority64_v6 <= G_MAXUINT32)
-		priority_v6 = (guint32) priority64_v6;
-
-	if (dhcp4_address) {
-		nm_platform_sysctl_set (nm_utils_ip4_property_path (ifname, "promote_secondaries"), "1");
-
-		dhcp4_client = nm_dhcp_manager_start_ip4 (nm_dhcp_manager_get (),
-		                                          ifname,
-		                                          ifindex,
-		                                          hwaddr,
-		                                          uuid,
-		                                          priority_v4,
-		                                          !!dhcp4_hostname,
-		                                          dhcp4_hostname,
-		                                          dhcp4_clientid,
-		                                          45,
-		                                          NULL,
-		                                          dhcp4_address);
-		g_assert (dhcp4_client);
-		g_signal_connect (dhcp4_client,
-		                  NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED,
-		                  G_CALLBACK (dhcp4_state_changed),
-		                  NULL);
-	}
-
-	if (slaac) {
-		nm_platform_link_set_user_ipv6ll_enabled (ifindex, TRUE);
-
-		rdisc = nm_lndp_rdisc_new (ifindex, ifname);
-		g_assert (rdisc);
-
-		if (iid)
-			nm_rdisc_set_iid (rdisc, *iid);
-
-		nm_platform_sysctl_set (nm_utils_ip6_property_path (ifname, "accept_ra"), "1");
-		nm_platform_sysctl_set (nm_utils_ip6_property_path (ifname, "accept_ra_defrtr"), "0");
-		nm_platform_sysctl_set (nm_utils_ip6_property_path (ifname, "accept_ra_pinfo"), "0");
-		nm_platform_sysctl_set (nm_utils_ip6_property_path (ifname, "accept_ra_rtr_pref"), "0");
-
-		g_signal_connect (rdisc,
-		                  NM_RDISC_CONFIG_CHANGED,
-		                  G_CALLBACK (rdisc_config_changed),
-		                  NULL);
-		g_signal_connect (rdisc,
-		                  NM_RDISC_RA_TIMEOUT,
-		                  G_CALLBACK (rdisc_ra_timeout),
-		                  NULL);
-		nm_rdisc_start (rdisc);
+	} else {
+		iface = managed_iface_start ();
+		if (!iface)
+			exit (1);
+		ifaces = g_slist_prepend (ifaces, iface);
 	}
+	iface_options_reset ();
 
 	g_main_loop_run (main_loop);
 
-	g_clear_pointer (&hwaddr, g_byte_array_unref);
+	g_slist_free_full (ifaces, (GDestroyNotify) managed_iface_free);
+	ifaces = NULL;
 
 	nm_logging_syslog_closelog ();
 
@@ -45,6 +45,10 @@ typedef struct {
 	guint32 gateway;
 	GArray *addresses;
 	GArray *routes;
+	/* @addresses/@routes are shared with other configs or the platform
+	 * and must be copied before they are modified. */
+	gboolean addresses_shared;
+	gboolean routes_shared;
 	GArray *nameservers;
 	GPtrArray *domains;
 	GPtrArray *searches;
@@ -54,6 +58,13 @@ typedef struct {
 	GArray *wins;
 	guint32 mtu;
 	NMIPConfigSource mtu_source;
+
+	/* Exported values of the address and route properties.  Built when
+	 * first read and dropped by _NOTIFY() when the property changes. */
+	GPtrArray *export_address_data;
+	GPtrArray *export_addresses;
+	GPtrArray *export_route_data;
+	GPtrArray *export_routes;
 } NMIP4ConfigPrivate;
 
 /* internal guint32 are assigned to gobject properties of type uint. Ensure, that uint is large enough */
@@ -75,7 +86,48 @@ enum {
 	LAST_PROP
 };
 static GParamSpec *obj_properties[LAST_PROP] = { NULL, };
-#define _NOTIFY(config, prop)    G_STMT_START { g_object_notify_by_pspec (G_OBJECT (config), obj_properties[prop]); } G_STMT_END
+#define _NOTIFY(config, prop)    G_STMT_START { _notify (config, prop); } G_STMT_END
+
+static GPtrArray **
+_export_slot (NMIP4ConfigPrivate *priv, guint prop)
+{
+	switch (prop) {
+	case PROP_ADDRESS_DATA:
+		return &priv->export_address_data;
+	case PROP_ADDRESSES:
+		return &priv->export_addresses;
+	case PROP_ROUTE_DATA:
+		return &priv->export_route_data;
+	case PROP_ROUTES:
+		return &priv->export_routes;
+	default:
+		return NULL;
+	}
+}
+
+static void
+_export_clear (NMIP4ConfigPrivate *priv, guint prop)
+{
+	GPtrArray **slot = _export_slot (priv, prop);
+
+	if (slot && *slot) {
+		g_boxed_free (obj_properties[prop]->value_type, *slot);
+		*slot = NULL;
+	}
+}
+
+static void
+_notify (NMIP4Config *config, guint prop)
+{
+	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
+
+	_export_clear (priv, prop);
+	/* The legacy addresses carry the gateway */
+	if (prop == PROP_GATEWAY)
+		_export_clear (priv, PROP_ADDRESSES);
+
+	g_object_notify_by_pspec (G_OBJECT (config), obj_properties[prop]);
+}
 
 
 NMIP4Config *
@@ -105,6 +157,24 @@ nm_ip4_config_get_dbus_path (const NMIP4Config *config)
 	return priv->path;
 }
 
+static GArray *
+_array_unshare (GArray *array, gboolean *shared)
+{
+	GArray *copy;
+
+	if (!*shared)
+		return array;
+
+	copy = g_array_sized_new (FALSE, FALSE, g_array_get_element_size (array), array->len);
+	g_array_append_vals (copy, array->data, array->len);
+	g_array_unref (array);
+	*shared = FALSE;
+	return copy;
+}
+
+#define _addresses_writable(priv) ((priv)->addresses = _array_unshare ((priv)->addresses, &(priv)->addresses_shared))
+#define _routes_writable(priv)    ((priv)->routes = _array_unshare ((priv)->routes, &(priv)->routes_shared))
+
 static gboolean
 same_prefix (guint32 address1, guint32 address2, int plen)
 {
@@ -175,60 +245,171 @@ routes_are_duplicate (const NMPlatformIP4Route *a, const NMPlatformIP4Route *b,
 	       (!consider_gateway_and_metric || (a->gateway == b->gateway && a->metric == b->metric));
 }
 
-NMIP4Config *
-nm_ip4_config_capture (int ifindex, gboolean capture_resolv_conf)
+/* The routes of a capture only depend on the platform route snapshot, so
+ * remember the filtered result per interface for as long as the snapshot
+ * stays the same. */
+typedef struct {
+	GArray *snapshot;
+	GArray *routes;
+	guint32 gateway;
+	gboolean has_gateway;
+} CapturedRoutes;
+
+static void
+captured_routes_free (gpointer data)
 {
-	NMIP4Config *config;
-	NMIP4ConfigPrivate *priv;
-	guint i;
+	CapturedRoutes *captured = data;
+
+	g_array_unref (captured->snapshot);
+	g_array_unref (captured->routes);
+	g_slice_free (CapturedRoutes, captured);
+}
+
+static GHashTable *captured_routes_cache = NULL;
+static NMPlatform *captured_routes_platform = NULL;
+static guint captured_routes_copies = 0;
+
+static void
+captured_routes_link_changed (NMPlatform *platform, int ifindex, NMPlatformLink *plink,
+                              NMPlatformSignalChangeType change_type, NMPlatformReason reason,
+                              gpointer user_data)
+{
+	/* Don't keep the routes of deleted interfaces around */
+	if (change_type == NM_PLATFORM_SIGNAL_REMOVED)
+		g_hash_table_remove (captured_routes_cache, GINT_TO_POINTER (ifindex));
+}
+
+static GHashTable *
+captured_routes_get_cache (void)
+{
+	NMPlatform *platform = nm_platform_get ();
+
+	if (G_UNLIKELY (!captured_routes_cache))
+		captured_routes_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, captured_routes_free);
+
+	/* Entries are evicted when the platform reports the link as removed,
+	 * so follow the platform singleton if it gets replaced. */
+	if (G_UNLIKELY (captured_routes_platform != platform)) {
+		g_hash_table_remove_all (captured_routes_cache);
+		if (captured_routes_platform) {
+			g_signal_handlers_disconnect_by_func (captured_routes_platform, captured_routes_link_changed, NULL);
+			g_object_remove_weak_pointer (G_OBJECT (captured_routes_platform), (gpointer *) &captured_routes_platform);
+		}
+		captured_routes_platform = platform;
+		g_object_add_weak_pointer (G_OBJECT (platform), (gpointer *) &captured_routes_platform);
+		g_signal_connect (platform, NM_PLATFORM_SIGNAL_LINK_CHANGED,
+		                  G_CALLBACK (captured_routes_link_changed), NULL);
+	}
+	return captured_routes_cache;
+}
+
+static const CapturedRoutes *
+capture_routes (int ifindex)
+{
+	GHashTable *cache = captured_routes_get_cache ();
+	CapturedRoutes *captured;
+	GArray *snapshot;
 	guint32 lowest_metric = G_MAXUINT32;
-	guint32 old_gateway = 0;
-	gboolean has_gateway = FALSE;
+	guint i, n_skip = 0;
 
-	/* Slaves have no IP configuration */
-	if (nm_platform_link_get_master (ifindex) > 0)
+	snapshot = nm_platform_ip4_route_get_snapshot (ifindex);
+	if (!snapshot) {
+		g_hash_table_remove (cache, GINT_TO_POINTER (ifindex));
 		return NULL;
+	}
 
-	config = nm_ip4_config_new ();
-	priv = NM_IP4_CONFIG_GET_PRIVATE (config);
-
-	g_array_unref (priv->addresses);
-	g_array_unref (priv->routes);
+	captured = g_hash_table_lookup (cache, GINT_TO_POINTER (ifindex));
+	if (captured && captured->snapshot == snapshot) {
+		g_array_unref (snapshot);
+		return captured;
+	}
 
-	priv->addresses = nm_platform_ip4_address_get_all (ifindex);
-	priv->routes = nm_platform_ip4_route_get_all (ifindex, NM_PLATFORM_GET_ROUTE_MODE_ALL);
+	captured = g_slice_new0 (CapturedRoutes);
+	captured->snapshot = snapshot;
 
 	/* Extract gateway from default route */
-	old_gateway = priv->gateway;
-	for (i = 0; i < priv->routes->len; i++) {
-		const NMPlatformIP4Route *route = &g_array_index (priv->routes, NMPlatformIP4Route, i);
+	for (i = 0; i < snapshot->len; i++) {
+		const NMPlatformIP4Route *route = &g_array_index (snapshot, NMPlatformIP4Route, i);
 
 		if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route)) {
 			if (route->metric < lowest_metric) {
-				priv->gateway = route->gateway;
+				captured->gateway = route->gateway;
 				lowest_metric = route->metric;
 			}
-			has_gateway = TRUE;
-			/* Remove the default route from the list */
-			g_array_remove_index (priv->routes, i);
-			i--;
+			captured->has_gateway = TRUE;
+			n_skip++;
 		}
 	}
 
-	/* If there is a host route to the gateway, ignore that route.  It is
-	 * automatically added by NetworkManager when needed.
+	/* Drop the default routes and, if there is a host route to the gateway,
+	 * that route too.  It is automatically added by NetworkManager when
+	 * needed.  Only copy when there is anything to drop.
 	 */
-	if (has_gateway) {
-		for (i = 0; i < priv->routes->len; i++) {
-			const NMPlatformIP4Route *route = &g_array_index (priv->routes, NMPlatformIP4Route, i);
+	if (n_skip) {
+		captured->routes = g_array_sized_new (FALSE, FALSE, sizeof (NMPlatformIP4Route), snapshot->len - n_skip);
+		captured_routes_copies++;
+		for (i = 0; i < snapshot->len; i++) {
+			const NMPlatformIP4Route *route = &g_array_index (snapshot, NMPlatformIP4Route, i);
 
+			if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route))
+				continue;
 			if (   (route->plen == 32)
-			    && (route->network == priv->gateway)
-			    && (route->gateway == 0)) {
-				g_array_remove_index (priv->routes, i);
-				i--;
-			}
+			    && (route->network == captured->gateway)
+			    && (route->gateway == 0))
+				continue;
+			g_array_append_val (captured->routes, *route);
 		}
+	} else
+		captured->routes = g_array_ref (snapshot);
+
+	g_hash_table_insert (cache, GINT_TO_POINTER (ifindex), captured);
+	return captured;
+}
+
+/**
+ * nm_ip4_config_capture:
+ * @ifindex: the interface to capture
+ * @capture_resolv_conf: whether to read nameservers from resolv.conf
+ *
+ * Returns a new config with the current addresses and routes of @ifindex.
+ * The address and route lists are shared with the platform cache and with
+ * other captures of the same unchanged interface; they are copied only
+ * once the config is modified.
+ */
+NMIP4Config *
+nm_ip4_config_capture (int ifindex, gboolean capture_resolv_conf)
+{
+	NMIP4Config *config;
+	NMIP4ConfigPrivate *priv;
+	const CapturedRoutes *captured;
+	GArray *addresses;
+	guint32 old_gateway = 0;
+	gboolean has_gateway = FALSE;
+
+	/* Slaves have no IP configuration */
+	if (nm_platform_link_get_master (ifindex) > 0)
+		return NULL;
+
+	config = nm_ip4_config_new ();
+	priv = NM_IP4_CONFIG_GET_PRIVATE (config);
+
+	old_gateway = priv->gateway;
+
+	captured = capture_routes (ifindex);
+	if (captured) {
+		g_array_unref (priv->routes);
+		priv->routes = g_array_ref (captured->routes);
+		priv->routes_shared = TRUE;
+		if (captured->has_gateway)
+			priv->gateway = captured->gateway;
+		has_gateway = captured->has_gateway;
+	}
+
+	addresses = nm_platform_ip4_address_get_snapshot (ifindex);
+	if (addresses) {
+		g_array_unref (priv->addresses);
+		priv->addresses = addresses;
+		priv->addresses_shared = TRUE;
 	}
 
 	/* If the interface has the default route, and has IPv4 addresses, capture
@@ -250,6 +431,12 @@ nm_ip4_config_capture (int ifindex, gboolean capture_resolv_conf)
 	return config;
 }
 
+guint
+nm_ip4_config_get_captured_route_copies (void)
+{
+	return captured_routes_copies;
+}
+
 gboolean
 nm_ip4_config_commit (const NMIP4Config *config, int ifindex, guint32 default_route_metric)
 {
@@ -1125,6 +1312,7 @@ nm_ip4_config_reset_addresses (NMIP4Config *config)
 	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
 
 	if (priv->addresses->len != 0) {
+		_addresses_writable (priv);
 		g_array_set_size (priv->addresses, 0);
 		_NOTIFY (config, PROP_ADDRESS_DATA);
 		_NOTIFY (config, PROP_ADDRESSES);
@@ -1157,6 +1345,9 @@ nm_ip4_config_add_address (NMIP4Config *config, const NMPlatformIP4Address *new)
 			if (nm_platform_ip4_address_cmp (item, new) == 0)
 				return;
 
+			_addresses_writable (priv);
+			item = &g_array_index (priv->addresses, NMPlatformIP4Address, i);
+
 			/* remember the old values. */
 			item_old = *item;
 			/* Copy over old item to get new lifetime, timestamp, preferred */
@@ -1182,6 +1373,7 @@ nm_ip4_config_add_address (NMIP4Config *config, const NMPlatformIP4Address *new)
 		}
 	}
 
+	_addresses_writable (priv);
 	g_array_append_val (priv->addresses, *new);
 NOTIFY:
 	_NOTIFY (config, PROP_ADDRESS_DATA);
@@ -1195,6 +1387,7 @@ nm_ip4_config_del_address (NMIP4Config *config, guint i)
 
 	g_return_if_fail (i < priv->addresses->len);
 
+	_addresses_writable (priv);
 	g_array_remove_index (priv->addresses, i);
 	_NOTIFY (config, PROP_ADDRESS_DATA);
 	_NOTIFY (config, PROP_ADDRESSES);
@@ -1240,6 +1433,7 @@ nm_ip4_config_reset_routes (NMIP4Config *config)
 	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
 
 	if (priv->routes->len != 0) {
+		_routes_writable (priv);
 		g_array_set_size (priv->routes, 0);
 		_NOTIFY (config, PROP_ROUTE_DATA);
 		_NOTIFY (config, PROP_ROUTES);
@@ -1272,6 +1466,8 @@ nm_ip4_config_add_route (NMIP4Config *config, const NMPlatformIP4Route *new)
 		if (routes_are_duplicate (item, new, FALSE)) {
 			if (nm_platform_ip4_route_cmp (item, new) == 0)
 				return;
+			_routes_writable (priv);
+			item = &g_array_index (priv->routes, NMPlatformIP4Route, i);
 			old_source = item->source;
 			memcpy (item, new, sizeof (*item));
 			/* Restore highest priority source */
@@ -1280,6 +1476,7 @@ nm_ip4_config_add_route (NMIP4Config *config, const NMPlatformIP4Route *new)
 		}
 	}
 
+	_routes_writable (priv);
 	g_array_append_val (priv->routes, *new);
 NOTIFY:
 	_NOTIFY (config, PROP_ROUTE_DATA);
@@ -1293,6 +1490,7 @@ nm_ip4_config_del_route (NMIP4Config *config, guint i)
 
 	g_return_if_fail (i < priv->routes->len);
 
+	_routes_writable (priv);
 	g_array_remove_index (priv->routes, i);
 	_NOTIFY (config, PROP_ROUTE_DATA);
 	_NOTIFY (config, PROP_ROUTES);
@@ -1808,13 +2006,24 @@ nm_ip4_config_equal (const NMIP4Config *a, const NMIP4Config *b)
 
 /******************************************************************/
 
+static GArray *empty_addresses = NULL;
+static GArray *empty_routes = NULL;
+
 static void
 nm_ip4_config_init (NMIP4Config *config)
 {
 	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
 
-	priv->addresses = g_array_new (FALSE, FALSE, sizeof (NMPlatformIP4Address));
-	priv->routes = g_array_new (FALSE, FALSE, sizeof (NMPlatformIP4Route));
+	/* Most configs get their lists from nm_ip4_config_capture() or copy
+	 * them on the first change anyway, so start out with shared empty ones. */
+	if (G_UNLIKELY (!empty_addresses)) {
+		empty_addresses = g_array_new (FALSE, FALSE, sizeof (NMPlatformIP4Address));
+		empty_routes = g_array_new (FALSE, FALSE, sizeof (NMPlatformIP4Route));
+	}
+	priv->addresses = g_array_ref (empty_addresses);
+	priv->addresses_shared = TRUE;
+	priv->routes = g_array_ref (empty_routes);
+	priv->routes_shared = TRUE;
 	priv->nameservers = g_array_new (FALSE, FALSE, sizeof (guint32));
 	priv->domains = g_ptr_array_new_with_free_func (g_free);
 	priv->searches = g_ptr_array_new_with_free_func (g_free);
@@ -1826,9 +2035,13 @@ static void
 finalize (GObject *object)
 {
 	NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (object);
+	guint i;
 
 	g_free (priv->path);
 
+	for (i = PROP_0 + 1; i < LAST_PROP; i++)
+		_export_clear (priv, i);
+
 	g_array_unref (priv->addresses);
 	g_array_unref (priv->routes);
 	g_array_unref (priv->nameservers);
@@ -1859,7 +2072,7 @@ get_property (GObject *object, guint prop_id,
 
 	switch (prop_id) {
 	case PROP_ADDRESS_DATA:
-		{
+		if (!priv->export_address_data) {
 			GPtrArray *addresses = g_ptr_array_new ();
 			int naddr = nm_ip4_config_get_num_addresses (config);
 			int i;
@@ -1891,11 +2104,13 @@ get_property (GObject *object, guint prop_id,
 				g_ptr_array_add (addresses, addr_hash);
 			}
 
-			g_value_take_boxed (value, addresses);
+			priv->export_address_data = addresses;
 		}
+		/* Owned by the config until the property changes */
+		g_value_set_static_boxed (value, priv->export_address_data);
 		break;
 	case PROP_ADDRESSES:
-		{
+		if (!priv->export_addresses) {
 			GPtrArray *addresses = g_ptr_array_new ();
 			int naddr = nm_ip4_config_get_num_addresses (config);
 			int i;
@@ -1912,11 +2127,13 @@ get_property (GObject *object, guint prop_id,
 				g_ptr_array_add (addresses, array);
 			}
 
-			g_value_take_boxed (value, addresses);
+			priv->export_addresses = addresses;
 		}
+		/* Owned by the config until the property changes */
+		g_value_set_static_boxed (value, priv->export_addresses);
 		break;
 	case PROP_ROUTE_DATA:
-		{
+		if (!priv->export_route_data) {
 			GPtrArray *routes = g_ptr_array_new ();
 			guint nroutes = nm_ip4_config_get_num_routes (config);
 			int i;
@@ -1953,11 +2170,13 @@ get_property (GObject *object, guint prop_id,
 				g_ptr_array_add (routes, route_hash);
 			}
 
-			g_value_take_boxed (value, routes);
+			priv->export_route_data = routes;
 		}
+		/* Owned by the config until the property changes */
+		g_value_set_static_boxed (value, priv->export_route_data);
 		break;
 	case PROP_ROUTES:
-		{
+		if (!priv->export_routes) {
 			GPtrArray *routes = g_ptr_array_new ();
 			guint nroutes = nm_ip4_config_get_num_routes (config);
 			int i;
@@ -1980,8 +2199,10 @@ get_property (GObject *object, guint prop_id,
 				g_ptr_array_add (routes, array);
 			}
 
-			g_value_take_boxed (value, routes);
+			priv->export_routes = routes;
 		}
+		/* Owned by the config until the property changes */
+		g_value_set_static_boxed (value, priv->export_routes);
 		break;
 	case PROP_GATEWAY:
 		if (priv->gateway)
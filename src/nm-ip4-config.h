@@ -154,5 +154,6 @@ gboolean nm_ip4_config_equal (const NMIP4Config *a, const NMIP4Config *b);
 
 gboolean nm_ip4_config_capture_resolv_conf (GArray *nameservers,
                                             const char *rc_contents);
+guint nm_ip4_config_get_captured_route_copies (void);
 
 #endif /* __NETWORKMANAGER_IP4_CONFIG_H__ */
@@ -45,10 +45,21 @@ typedef struct {
 	struct in6_addr gateway;
 	GArray *addresses;
 	GArray *routes;
+	/* @addresses/@routes are shared with other configs or the platform
+	 * and must be copied before they are modified. */
+	gboolean addresses_shared;
+	gboolean routes_shared;
 	GArray *nameservers;
 	GPtrArray *domains;
 	GPtrArray *searches;
 	guint32 mss;
+
+	/* Exported values of the address and route properties.  Built when
+	 * first read and dropped by _NOTIFY() when the property changes. */
+	GPtrArray *export_address_data;
+	GPtrArray *export_addresses;
+	GPtrArray *export_route_data;
+	GPtrArray *export_routes;
 } NMIP6ConfigPrivate;
 
 
@@ -66,7 +77,48 @@ enum {
 	LAST_PROP
 };
 static GParamSpec *obj_properties[LAST_PROP] = { NULL, };
-#define _NOTIFY(config, prop)    G_STMT_START { g_object_notify_by_pspec (G_OBJECT (config), obj_properties[prop]); } G_STMT_END
+#define _NOTIFY(config, prop)    G_STMT_START { _notify (config, prop); } G_STMT_END
+
+static GPtrArray **
+_export_slot (NMIP6ConfigPrivate *priv, guint prop)
+{
+	switch (prop) {
+	case PROP_ADDRESS_DATA:
+		return &priv->export_address_data;
+	case PROP_ADDRESSES:
+		return &priv->export_addresses;
+	case PROP_ROUTE_DATA:
+		return &priv->export_route_data;
+	case PROP_ROUTES:
+		return &priv->export_routes;
+	default:
+		return NULL;
+	}
+}
+
+static void
+_export_clear (NMIP6ConfigPrivate *priv, guint prop)
+{
+	GPtrArray **slot = _export_slot (priv, prop);
+
+	if (slot && *slot) {
+		g_boxed_free (obj_properties[prop]->value_type, *slot);
+		*slot = NULL;
+	}
+}
+
+static void
+_notify (NMIP6Config *config, guint prop)
+{
+	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (config);
+
+	_export_clear (priv, prop);
+	/* The legacy addresses carry the gateway */
+	if (prop == PROP_GATEWAY)
+		_export_clear (priv, PROP_ADDRESSES);
+
+	g_object_notify_by_pspec (G_OBJECT (config), obj_properties[prop]);
+}
 
 
 NMIP6Config *
@@ -97,6 +149,24 @@ nm_ip6_config_get_dbus_path (const NMIP6Config *config)
 
 /******************************************************************/
 
+static GArray *
+_array_unshare (GArray *array, gboolean *shared)
+{
+	GArray *copy;
+
+	if (!*shared)
+		return array;
+
+	copy = g_array_sized_new (FALSE, TRUE, g_array_get_element_size (array), array->len);
+	g_array_append_vals (copy, array->data, array->len);
+	g_array_unref (array);
+	*shared = FALSE;
+	return copy;
+}
+
+#define _addresses_writable(priv) ((priv)->addresses = _array_unshare ((priv)->addresses, &(priv)->addresses_shared))
+#define _routes_writable(priv)    ((priv)->routes = _array_unshare ((priv)->routes, &(priv)->routes_shared))
+
 static gboolean
 same_prefix (const struct in6_addr *address1, const struct in6_addr *address2, int plen)
 {
@@ -256,43 +326,226 @@ _addresses_sort_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
 	return c != 0 ? c : memcmp (a1, a2, sizeof (*a1));
 }
 
+/* _addresses_sort_cmp() is a total order, so an array that is not sorted
+ * yet always changes when it gets sorted. */
+static gboolean
+_addresses_are_sorted (const GArray *addresses, NMSettingIP6ConfigPrivacy use_temporary)
+{
+	guint i;
+
+	for (i = 1; i < addresses->len; i++) {
+		if (_addresses_sort_cmp (&g_array_index (addresses, NMPlatformIP6Address, i - 1),
+		                         &g_array_index (addresses, NMPlatformIP6Address, i),
+		                         GINT_TO_POINTER (use_temporary)) > 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
 gboolean
 nm_ip6_config_addresses_sort (NMIP6Config *self, NMSettingIP6ConfigPrivacy use_temporary)
 {
 	NMIP6ConfigPrivate *priv;
-	size_t data_len = 0;
-	char *data_pre = NULL;
-	gboolean changed;
 
 	g_return_val_if_fail (NM_IS_IP6_CONFIG (self), FALSE);
 
 	priv = NM_IP6_CONFIG_GET_PRIVATE (self);
-	if (priv->addresses->len > 1) {
-		data_len = priv->addresses->len * g_array_get_element_size (priv->addresses);
-		data_pre = g_new (char, data_len);
-		memcpy (data_pre, priv->addresses->data, data_len);
+	if (_addresses_are_sorted (priv->addresses, use_temporary))
+		return FALSE;
 
-		g_array_sort_with_data (priv->addresses, _addresses_sort_cmp, GINT_TO_POINTER (use_temporary));
+	_addresses_writable (priv);
+	g_array_sort_with_data (priv->addresses, _addresses_sort_cmp, GINT_TO_POINTER (use_temporary));
+	_NOTIFY (self, PROP_ADDRESS_DATA);
+	_NOTIFY (self, PROP_ADDRESSES);
+	return TRUE;
+}
 
-		changed = memcmp (data_pre, priv->addresses->data, data_len) != 0;
-		g_free (data_pre);
+/* Captures only depend on the platform snapshots, so remember the filtered
+ * routes and the sorted addresses per interface for as long as the
+ * snapshots stay the same. */
+typedef struct {
+	GArray *route_snapshot;
+	GArray *routes;
+	struct in6_addr gateway;
+	gboolean has_gateway;
 
-		if (changed) {
-			_NOTIFY (self, PROP_ADDRESS_DATA);
-			_NOTIFY (self, PROP_ADDRESSES);
-			return TRUE;
+	GArray *address_snapshot;
+	GArray *addresses;
+	NMSettingIP6ConfigPrivacy use_temporary;
+} Captured;
+
+static void
+captured_free (gpointer data)
+{
+	Captured *captured = data;
+
+	if (captured->route_snapshot) {
+		g_array_unref (captured->route_snapshot);
+		g_array_unref (captured->routes);
+	}
+	if (captured->address_snapshot) {
+		g_array_unref (captured->address_snapshot);
+		g_array_unref (captured->addresses);
+	}
+	g_slice_free (Captured, captured);
+}
+
+static void
+capture_routes (Captured *captured, GArray *snapshot)
+{
+	guint32 lowest_metric = G_MAXUINT32;
+	guint i, n_skip = 0;
+
+	if (captured->route_snapshot) {
+		g_array_unref (captured->route_snapshot);
+		g_array_unref (captured->routes);
+	}
+	captured->route_snapshot = g_array_ref (snapshot);
+	captured->gateway = in6addr_any;
+	captured->has_gateway = FALSE;
+
+	/* Extract gateway from default route */
+	for (i = 0; i < snapshot->len; i++) {
+		const NMPlatformIP6Route *route = &g_array_index (snapshot, NMPlatformIP6Route, i);
+
+		if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route)) {
+			if (route->metric < lowest_metric) {
+				captured->gateway = route->gateway;
+				lowest_metric = route->metric;
+			}
+			captured->has_gateway = TRUE;
+			n_skip++;
 		}
 	}
-	return FALSE;
+
+	/* Drop the default routes and, if there is a host route to the gateway,
+	 * that route too.  It is automatically added by NetworkManager when
+	 * needed.  Only copy when there is anything to drop.
+	 */
+	if (n_skip) {
+		captured->routes = g_array_sized_new (FALSE, TRUE, sizeof (NMPlatformIP6Route), snapshot->len - n_skip);
+		for (i = 0; i < snapshot->len; i++) {
+			const NMPlatformIP6Route *route = &g_array_index (snapshot, NMPlatformIP6Route, i);
+
+			if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route))
+				continue;
+			if (   route->plen == 128
+			    && IN6_ARE_ADDR_EQUAL (&route->network, &captured->gateway)
+			    && IN6_IS_ADDR_UNSPECIFIED (&route->gateway))
+				continue;
+			g_array_append_val (captured->routes, *route);
+		}
+	} else
+		captured->routes = g_array_ref (snapshot);
 }
 
+static void
+capture_addresses (Captured *captured, GArray *snapshot, NMSettingIP6ConfigPrivacy use_temporary)
+{
+	if (captured->address_snapshot) {
+		g_array_unref (captured->address_snapshot);
+		g_array_unref (captured->addresses);
+	}
+	captured->address_snapshot = g_array_ref (snapshot);
+	captured->use_temporary = use_temporary;
+
+	if (_addresses_are_sorted (snapshot, use_temporary))
+		captured->addresses = g_array_ref (snapshot);
+	else {
+		captured->addresses = g_array_sized_new (FALSE, TRUE, sizeof (NMPlatformIP6Address), snapshot->len);
+		g_array_append_vals (captured->addresses, snapshot->data, snapshot->len);
+		g_array_sort_with_data (captured->addresses, _addresses_sort_cmp, GINT_TO_POINTER (use_temporary));
+	}
+}
+
+static GHashTable *captured_cache = NULL;
+static NMPlatform *captured_platform = NULL;
+
+static void
+captured_link_changed (NMPlatform *platform, int ifindex, NMPlatformLink *plink,
+                       NMPlatformSignalChangeType change_type, NMPlatformReason reason,
+                       gpointer user_data)
+{
+	/* Don't keep the routes and addresses of deleted interfaces around */
+	if (change_type == NM_PLATFORM_SIGNAL_REMOVED)
+		g_hash_table_remove (captured_cache, GINT_TO_POINTER (ifindex));
+}
+
+static GHashTable *
+captured_get_cache (void)
+{
+	NMPlatform *platform = nm_platform_get ();
+
+	if (G_UNLIKELY (!captured_cache))
+		captured_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, captured_free);
+
+	/* Entries are evicted when the platform reports the link as removed,
+	 * so follow the platform singleton if it gets replaced. */
+	if (G_UNLIKELY (captured_platform != platform)) {
+		g_hash_table_remove_all (captured_cache);
+		if (captured_platform) {
+			g_signal_handlers_disconnect_by_func (captured_platform, captured_link_changed, NULL);
+			g_object_remove_weak_pointer (G_OBJECT (captured_platform), (gpointer *) &captured_platform);
+		}
+		captured_platform = platform;
+		g_object_add_weak_pointer (G_OBJECT (platform), (gpointer *) &captured_platform);
+		g_signal_connect (platform, NM_PLATFORM_SIGNAL_LINK_CHANGED,
+		                  G_CALLBACK (captured_link_changed), NULL);
+	}
+	return captured_cache;
+}
+
+static const Captured *
+capture (int ifindex, NMSettingIP6ConfigPrivacy use_temporary)
+{
+	GHashTable *cache = captured_get_cache ();
+	Captured *captured;
+	GArray *route_snapshot, *address_snapshot;
+
+	route_snapshot = nm_platform_ip6_route_get_snapshot (ifindex);
+	address_snapshot = nm_platform_ip6_address_get_snapshot (ifindex);
+	if (!route_snapshot || !address_snapshot) {
+		if (route_snapshot)
+			g_array_unref (route_snapshot);
+		if (address_snapshot)
+			g_array_unref (address_snapshot);
+		g_hash_table_remove (cache, GINT_TO_POINTER (ifindex));
+		return NULL;
+	}
+
+	captured = g_hash_table_lookup (cache, GINT_TO_POINTER (ifindex));
+	if (!captured) {
+		captured = g_slice_new0 (Captured);
+		g_hash_table_insert (cache, GINT_TO_POINTER (ifindex), captured);
+	}
+	if (captured->route_snapshot != route_snapshot)
+		capture_routes (captured, route_snapshot);
+	if (   captured->address_snapshot != address_snapshot
+	    || captured->use_temporary != use_temporary)
+		capture_addresses (captured, address_snapshot, use_temporary);
+
+	g_array_unref (route_snapshot);
+	g_array_unref (address_snapshot);
+	return captured;
+}
+
+/**
+ * nm_ip6_config_capture:
+ * @ifindex: the interface to capture
+ * @capture_resolv_conf: whether to read nameservers from resolv.conf
+ * @use_temporary: how to order temporary addresses
+ *
+ * Returns a new config with the current addresses and routes of @ifindex.
+ * The address and route lists are shared with the platform cache and with
+ * other captures of the same unchanged interface; they are copied only
+ * once the config is modified.
+ */
 NMIP6Config *
 nm_ip6_config_capture (int ifindex, gboolean capture_resolv_conf, NMSettingIP6ConfigPrivacy use_temporary)
 {
 	NMIP6Config *config;
 	NMIP6ConfigPrivate *priv;
-	guint i;
-	guint32 lowest_metric = G_MAXUINT32;
+	const Captured *captured;
 	struct in6_addr old_gateway = IN6ADDR_ANY_INIT;
 	gboolean has_gateway = FALSE;
 	gboolean notify_nameservers = FALSE;
@@ -304,43 +557,19 @@ nm_ip6_config_capture (int ifindex, gboolean capture_resolv_conf, NMSettingIP6Co
 	config = nm_ip6_config_new ();
 	priv = NM_IP6_CONFIG_GET_PRIVATE (config);
 
-	g_array_unref (priv->addresses);
-	g_array_unref (priv->routes);
-
-	priv->addresses = nm_platform_ip6_address_get_all (ifindex);
-	priv->routes = nm_platform_ip6_route_get_all (ifindex, NM_PLATFORM_GET_ROUTE_MODE_ALL);
-
-	/* Extract gateway from default route */
 	old_gateway = priv->gateway;
-	for (i = 0; i < priv->routes->len; i++) {
-		const NMPlatformIP6Route *route = &g_array_index (priv->routes, NMPlatformIP6Route, i);
-
-		if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route)) {
-			if (route->metric < lowest_metric) {
-				priv->gateway = route->gateway;
-				lowest_metric = route->metric;
-			}
-			has_gateway = TRUE;
-			/* Remove the default route from the list */
-			g_array_remove_index (priv->routes, i);
-			i--;
-		}
-	}
 
-	/* If there is a host route to the gateway, ignore that route.  It is
-	 * automatically added by NetworkManager when needed.
-	 */
-	if (has_gateway) {
-		for (i = 0; i < priv->routes->len; i++) {
-			const NMPlatformIP6Route *route = &g_array_index (priv->routes, NMPlatformIP6Route, i);
-
-			if (   route->plen == 128
-			    && IN6_ARE_ADDR_EQUAL (&route->network, &priv->gateway)
-			    && IN6_IS_ADDR_UNSPECIFIED (&route->gateway)) {
-				g_array_remove_index (priv->routes, i);
-				i--;
-			}
-		}
+	captured = capture (ifindex, use_temporary);
+	if (captured) {
+		g_array_unref (priv->addresses);
+		g_array_unref (priv->routes);
+		priv->addresses = g_array_ref (captured->addresses);
+		priv->routes = g_array_ref (captured->routes);
+		priv->addresses_shared = TRUE;
+		priv->routes_shared = TRUE;
+		if (captured->has_gateway)
+			priv->gateway = captured->gateway;
+		has_gateway = captured->has_gateway;
 	}
 
 	/* If the interface has the default route, and has IPv6 addresses, capture
@@ -349,8 +578,6 @@ nm_ip6_config_capture (int ifindex, gboolean capture_resolv_conf, NMSettingIP6Co
 	if (priv->addresses->len && has_gateway && capture_resolv_conf)
 		notify_nameservers = nm_ip6_config_capture_resolv_conf (priv->nameservers, NULL);
 
-	g_array_sort_with_data (priv->addresses, _addresses_sort_cmp, GINT_TO_POINTER (use_temporary));
-
 	/* actually, nobody should be connected to the signal, just to be sure, notify */
 	if (notify_nameservers)
 		_NOTIFY (config, PROP_NAMESERVERS);
@@ -1118,6 +1345,7 @@ nm_ip6_config_reset_addresses (NMIP6Config *config)
 	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (config);
 
 	if (priv->addresses->len != 0) {
+		_addresses_writable (priv);
 		g_array_set_size (priv->addresses, 0);
 		_NOTIFY (config, PROP_ADDRESS_DATA);
 		_NOTIFY (config, PROP_ADDRESSES);
@@ -1150,6 +1378,9 @@ nm_ip6_config_add_address (NMIP6Config *config, const NMPlatformIP6Address *new)
 			if (nm_platform_ip6_address_cmp (item, new) == 0)
 				return;
 
+			_addresses_writable (priv);
+			item = &g_array_index (priv->addresses, NMPlatformIP6Address, i);
+
 			/* remember the old values. */
 			item_old = *item;
 			/* Copy over old item to get new lifetime, timestamp, preferred */
@@ -1175,6 +1406,7 @@ nm_ip6_config_add_address (NMIP6Config *config, const NMPlatformIP6Address *new)
 		}
 	}
 
+	_addresses_writable (priv);
 	g_array_append_val (priv->addresses, *new);
 NOTIFY:
 	_NOTIFY (config, PROP_ADDRESS_DATA);
@@ -1188,6 +1420,7 @@ nm_ip6_config_del_address (NMIP6Config *config, guint i)
 
 	g_return_if_fail (i < priv->addresses->len);
 
+	_addresses_writable (priv);
 	g_array_remove_index (priv->addresses, i);
 	_NOTIFY (config, PROP_ADDRESS_DATA);
 	_NOTIFY (config, PROP_ADDRESSES);
@@ -1234,6 +1467,7 @@ nm_ip6_config_reset_routes (NMIP6Config *config)
 	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (config);
 
 	if (priv->routes->len != 0) {
+		_routes_writable (priv);
 		g_array_set_size (priv->routes, 0);
 		_NOTIFY (config, PROP_ROUTE_DATA);
 		_NOTIFY (config, PROP_ROUTES);
@@ -1266,6 +1500,8 @@ nm_ip6_config_add_route (NMIP6Config *config, const NMPlatformIP6Route *new)
 		if (routes_are_duplicate (item, new, FALSE)) {
 			if (nm_platform_ip6_route_cmp (item, new) == 0)
 				return;
+			_routes_writable (priv);
+			item = &g_array_index (priv->routes, NMPlatformIP6Route, i);
 			old_source = item->source;
 			*item = *new;
 			/* Restore highest priority source */
@@ -1274,6 +1510,7 @@ nm_ip6_config_add_route (NMIP6Config *config, const NMPlatformIP6Route *new)
 		}
 	}
 
+	_routes_writable (priv);
 	g_array_append_val (priv->routes, *new);
 NOTIFY:
 	_NOTIFY (config, PROP_ROUTE_DATA);
@@ -1287,6 +1524,7 @@ nm_ip6_config_del_route (NMIP6Config *config, guint i)
 
 	g_return_if_fail (i < priv->routes->len);
 
+	_routes_writable (priv);
 	g_array_remove_index (priv->routes, i);
 	_NOTIFY (config, PROP_ROUTE_DATA);
 	_NOTIFY (config, PROP_ROUTES);
@@ -1660,13 +1898,23 @@ nm_ip6_config_equal (const NMIP6Config *a, const NMIP6Config *b)
 
 /******************************************************************/
 
+static GArray *empty_addresses = NULL;
+static GArray *empty_routes = NULL;
+
 static void
 nm_ip6_config_init (NMIP6Config *config)
 {
 	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (config);
 
-	priv->addresses = g_array_new (FALSE, TRUE, sizeof (NMPlatformIP6Address));
-	priv->routes = g_array_new (FALSE, TRUE, sizeof (NMPlatformIP6Route));
+	/* Like for NMIP4Config, start out with shared empty lists */
+	if (G_UNLIKELY (!empty_addresses)) {
+		empty_addresses = g_array_new (FALSE, TRUE, sizeof (NMPlatformIP6Address));
+		empty_routes = g_array_new (FALSE, TRUE, sizeof (NMPlatformIP6Route));
+	}
+	priv->addresses = g_array_ref (empty_addresses);
+	priv->addresses_shared = TRUE;
+	priv->routes = g_array_ref (empty_routes);
+	priv->routes_shared = TRUE;
 	priv->nameservers = g_array_new (FALSE, TRUE, sizeof (struct in6_addr));
 	priv->domains = g_ptr_array_new_with_free_func (g_free);
 	priv->searches = g_ptr_array_new_with_free_func (g_free);
@@ -1676,9 +1924,13 @@ static void
 finalize (GObject *object)
 {
 	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (object);
+	guint i;
 
 	g_free (priv->path);
 
+	for (i = PROP_0 + 1; i < LAST_PROP; i++)
+		_export_clear (priv, i);
+
 	g_array_unref (priv->addresses);
 	g_array_unref (priv->routes);
 	g_array_unref (priv->nameservers);
@@ -1727,7 +1979,7 @@ get_property (GObject *object, guint prop_id,
 
 	switch (prop_id) {
 	case PROP_ADDRESS_DATA:
-		{
+		if (!priv->export_address_data) {
 			GPtrArray *addresses = g_ptr_array_new ();
 			int naddr = nm_ip6_config_get_num_addresses (config);
 			int i;
@@ -1752,11 +2004,13 @@ get_property (GObject *object, guint prop_id,
 				g_ptr_array_add (addresses, addr_hash);
 			}
 
-			g_value_take_boxed (value, addresses);
+			priv->export_address_data = addresses;
 		}
+		/* Owned by the config until the property changes */
+		g_value_set_static_boxed (value, priv->export_address_data);
 		break;
 	case PROP_ADDRESSES:
-		{
+		if (!priv->export_addresses) {
 			GPtrArray *addresses = g_ptr_array_new ();
 			const struct in6_addr *gateway = nm_ip6_config_get_gateway (config);
 			int naddr = nm_ip6_config_get_num_addresses (config);
@@ -1794,11 +2048,13 @@ get_property (GObject *object, guint prop_id,
 				g_ptr_array_add (addresses, array);
 			}
 
-			g_value_take_boxed (value, addresses);
+			priv->export_addresses = addresses;
 		}
+		/* Owned by the config until the property changes */
+		g_value_set_static_boxed (value, priv->export_addresses);
 		break;
 	case PROP_ROUTE_DATA:
-		{
+		if (!priv->export_route_data) {
 			GPtrArray *routes = g_ptr_array_new ();
 			guint nroutes = nm_ip6_config_get_num_routes (config);
 			int i;
@@ -1835,11 +2091,13 @@ get_property (GObject *object, guint prop_id,
 				g_ptr_array_add (routes, route_hash);
 			}
 
-			g_value_take_boxed (value, routes);
+			priv->export_route_data = routes;
 		}
+		/* Owned by the config until the property changes */
+		g_value_set_static_boxed (value, priv->export_route_data);
 		break;
 	case PROP_ROUTES:
-		{
+		if (!priv->export_routes) {
 			GPtrArray *routes = g_ptr_array_new ();
 			int nroutes = nm_ip6_config_get_num_routes (config);
 			int i;
@@ -1884,8 +2142,10 @@ get_property (GObject *object, guint prop_id,
 				g_ptr_array_add (routes, array);
 			}
 
-			g_value_take_boxed (value, routes);
+			priv->export_routes = routes;
 		}
+		/* Owned by the config until the property changes */
+		g_value_set_static_boxed (value, priv->export_routes);
 		break;
 	case PROP_GATEWAY:
 		if (!IN6_IS_ADDR_UNSPECIFIED (&priv->gateway))
@@ -29,6 +29,9 @@
 #include <errno.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <strings.h>
 #include <string.h>
 
@@ -46,11 +49,90 @@ nm_log_handler (const gchar *log_domain,
 
 static NMLogLevel log_level = LOGL_INFO;
 static char *log_domains;
-static NMLogDomain logging[LOGL_MAX];
 static gboolean logging_set_up;
 static gboolean syslog_opened;
 static char *logging_domains_to_string;
 
+/* The domains logged per level. Initialized to what
+ * nm_logging_setup ("INFO", "DEFAULT") would set. */
+static NMLogDomain logging[LOGL_MAX] = {
+	[LOGL_INFO] = LOGD_DEFAULT,
+	[LOGL_WARN] = LOGD_DEFAULT,
+	[LOGL_ERR]  = LOGD_DEFAULT,
+};
+
+/* The domains for which messages are generated at all: @logging plus
+ * everything when the debug buffer is enabled.  Kept in sync by
+ * _update_enabled_state(); nm_logging_enabled() only tests this. */
+NMLogDomain _nm_logging_enabled_state[LOGL_MAX] = {
+	[LOGL_INFO] = LOGD_DEFAULT,
+	[LOGL_WARN] = LOGD_DEFAULT,
+	[LOGL_ERR]  = LOGD_DEFAULT,
+};
+
+/* The debug buffer keeps the most recent messages of all levels and
+ * domains in memory, independent of what is logged.  Writers reserve
+ * a sequence number atomically and publish the slot by setting its
+ * sequence number last; readers skip slots that are being rewritten.
+ * Sequence numbers wrap around but skip 0, which marks a slot that is
+ * being written (and lets "since" 0 ask for everything). */
+#define DEBUG_BUFFER_MSG_SIZE 480
+
+typedef struct {
+	volatile gint seq;
+	NMLogLevel level;
+	NMLogDomain domain;
+	gint64 time_usec;
+	const char *file;
+	guint line;
+	const char *func;
+	char msg[DEBUG_BUFFER_MSG_SIZE];
+} DebugRecord;
+
+static DebugRecord *debug_buffer;
+static guint debug_buffer_size;
+static volatile gint debug_buffer_next;   /* the last sequence number handed out */
+
+static inline guint32
+debug_seq_next (guint32 seq)
+{
+	return seq == G_MAXUINT32 ? 1 : seq + 1;
+}
+
+static inline guint32
+debug_seq_prev (guint32 seq)
+{
+	return seq == 1 ? G_MAXUINT32 : seq - 1;
+}
+
+/* Messages are formatted into a per-thread buffer; only messages
+ * that don't fit are formatted into a temporary allocation. */
+#define LOG_BUFFER_SIZE      2048
+
+#define JOURNAL_SOCKET       "/run/systemd/journal/socket"
+#define JOURNAL_BATCH_MAX    16
+#define JOURNAL_BUFFER_SIZE  (16 * 1024)
+
+typedef struct {
+	char msg[LOG_BUFFER_SIZE];
+
+	/* Serialized journal records not yet sent. Only the thread that
+	 * opened the log batches; other threads send each record at once. */
+	char journal[JOURNAL_BUFFER_SIZE];
+	gsize journal_len;
+	struct iovec iov[JOURNAL_BATCH_MAX];
+	guint n_iov;
+} LogBuffer;
+
+static void log_buffer_free (gpointer data);
+static void _update_enabled_state (void);
+
+static GPrivate log_buffer = G_PRIVATE_INIT (log_buffer_free);
+
+static int journal_fd = -1;
+static GThread *journal_thread;
+static guint journal_flush_id;
+
 typedef struct {
 	NMLogDomain num;
 	const char *name;
@@ -248,6 +330,7 @@ nm_logging_setup (const char  *level,
 	log_level = new_log_level;
 	for (i = 0; i < LOGL_MAX; i++)
 		logging[i] = new_logging[i];
+	_update_enabled_state ();
 
 	if (unrecognized)
 		*bad_domains = g_string_free (unrecognized, FALSE);
@@ -349,84 +432,494 @@ nm_logging_all_domains_to_string (void)
 	return str->str;
 }
 
-gboolean
-nm_logging_enabled (NMLogLevel level, NMLogDomain domain)
+static LogBuffer *
+log_buffer_get (void)
 {
-	g_return_val_if_fail (level < LOGL_MAX, FALSE);
+	LogBuffer *buf = g_private_get (&log_buffer);
 
-	_ensure_initialized ();
+	if (G_UNLIKELY (!buf)) {
+		buf = g_malloc (sizeof (LogBuffer));
+		buf->journal_len = 0;
+		buf->n_iov = 0;
+		g_private_set (&log_buffer, buf);
+	}
+	return buf;
+}
+
+static void
+journal_flush (LogBuffer *buf)
+{
+	struct mmsghdr msgs[JOURNAL_BATCH_MAX];
+	guint i, sent = 0;
+
+	memset (msgs, 0, sizeof (msgs));
+	for (i = 0; i < buf->n_iov; i++) {
+		msgs[i].msg_hdr.msg_iov = &buf->iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	while (sent < buf->n_iov) {
+		int r;
+
+		r = sendmmsg (journal_fd, &msgs[sent], buf->n_iov - sent, MSG_NOSIGNAL);
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			/* Nothing sensible to do; drop the batch. */
+			break;
+		}
+		sent += r;
+	}
+
+	buf->journal_len = 0;
+	buf->n_iov = 0;
+}
+
+static void
+log_buffer_free (gpointer data)
+{
+	LogBuffer *buf = data;
+
+	if (buf->n_iov && journal_fd >= 0)
+		journal_flush (buf);
+	g_free (buf);
+}
+
+static gboolean
+journal_flush_idle (gpointer user_data)
+{
+	journal_flush_id = 0;
+	journal_flush (log_buffer_get ());
+	return G_SOURCE_REMOVE;
+}
+
+/* Appends "KEY=value\n", or the binary form if @value contains a newline.
+ * The value is the concatenation of @v1 and @v2. */
+static gboolean
+journal_append (LogBuffer *buf, const char *key, const char *v1, gsize l1, const char *v2, gsize l2)
+{
+	gsize key_len = strlen (key);
+	gboolean binary;
+	char *p;
+
+	binary =    memchr (v1, '\n', l1)
+	         || (l2 && memchr (v2, '\n', l2));
+
+	if (buf->journal_len + key_len + 1 + (binary ? 8 : 0) + l1 + l2 + 1 > sizeof (buf->journal))
+		return FALSE;
+
+	p = &buf->journal[buf->journal_len];
+	memcpy (p, key, key_len);
+	p += key_len;
+	if (binary) {
+		guint64 len = GUINT64_TO_LE (l1 + l2);
+
+		*p++ = '\n';
+		memcpy (p, &len, 8);
+		p += 8;
+	} else
+		*p++ = '=';
+	memcpy (p, v1, l1);
+	p += l1;
+	if (l2) {
+		memcpy (p, v2, l2);
+		p += l2;
+	}
+	*p++ = '\n';
+
+	buf->journal_len = p - buf->journal;
+	return TRUE;
+}
+
+static gboolean
+journal_append_str (LogBuffer *buf, const char *key, const char *value)
+{
+	return journal_append (buf, key, value, strlen (value), NULL, 0);
+}
+
+static gboolean
+journal_append_record (LogBuffer *buf,
+                       const char *file,
+                       guint line,
+                       const char *func,
+                       NMLogLevel level,
+                       NMLogDomain domain,
+                       int syslog_level,
+                       const char *ifname,
+                       int ifindex,
+                       const char *con_uuid,
+                       const char *prefix,
+                       const char *msg)
+{
+	gsize start = buf->journal_len;
+	char num[32];
+	char domains[256];
+	const LogDesc *diter;
+	gsize domains_len = 0;
+	gboolean ok;
+
+	domains[0] = '\0';
+	for (diter = &domain_descs[1]; diter->name; diter++) {
+		if (!(diter->num & domain & logging[level]))
+			continue;
+		domains_len += g_snprintf (&domains[domains_len], sizeof (domains) - domains_len,
+		                           "%s%s", domains_len ? "," : "", diter->name);
+		if (domains_len >= sizeof (domains))
+			break;
+	}
+
+	g_snprintf (num, sizeof (num), "%d", syslog_level);
+	ok = journal_append_str (buf, "PRIORITY", num);
+	ok = ok && journal_append_str (buf, "SYSLOG_IDENTIFIER", G_LOG_DOMAIN);
+	ok = ok && journal_append_str (buf, "NM_LOG_LEVEL", level_names[level]);
+	ok = ok && journal_append_str (buf, "NM_LOG_DOMAINS", domains);
+	ok = ok && journal_append_str (buf, "CODE_FILE", file);
+	g_snprintf (num, sizeof (num), "%u", line);
+	ok = ok && journal_append_str (buf, "CODE_LINE", num);
+	ok = ok && journal_append_str (buf, "CODE_FUNC", func);
+	if (ifname)
+		ok = ok && journal_append_str (buf, "NM_DEVICE", ifname);
+	if (ifindex > 0) {
+		g_snprintf (num, sizeof (num), "%d", ifindex);
+		ok = ok && journal_append_str (buf, "NM_IFINDEX", num);
+	}
+	if (con_uuid)
+		ok = ok && journal_append_str (buf, "NM_CONNECTION_UUID", con_uuid);
+	ok = ok && journal_append (buf, "MESSAGE", prefix, strlen (prefix), msg, strlen (msg));
+
+	if (!ok) {
+		buf->journal_len = start;
+		return FALSE;
+	}
+
+	buf->iov[buf->n_iov].iov_base = &buf->journal[start];
+	buf->iov[buf->n_iov].iov_len = buf->journal_len - start;
+	buf->n_iov++;
+	return TRUE;
+}
+
+static gboolean
+journal_log (const char *file,
+             guint line,
+             const char *func,
+             NMLogLevel level,
+             NMLogDomain domain,
+             int syslog_level,
+             const char *ifname,
+             int ifindex,
+             const char *con_uuid,
+             const char *prefix,
+             const char *msg)
+{
+	LogBuffer *buf = log_buffer_get ();
+	gboolean batch;
+
+	if (!journal_append_record (buf, file, line, func, level, domain, syslog_level,
+	                            ifname, ifindex, con_uuid, prefix, msg)) {
+		if (!buf->n_iov)
+			return FALSE;
+
+		/* No room left; send what we have and try again */
+		journal_flush (buf);
+		if (!journal_append_record (buf, file, line, func, level, domain, syslog_level,
+		                            ifname, ifindex, con_uuid, prefix, msg))
+			return FALSE;
+	}
+
+	/* Batch debug messages of the main thread until it becomes idle;
+	 * warnings and errors go out immediately (together with the pending
+	 * batch, to keep the order). */
+	batch =    g_thread_self () == journal_thread
+	        && level < LOGL_WARN
+	        && buf->n_iov < JOURNAL_BATCH_MAX;
+
+	if (!batch) {
+		journal_flush (buf);
+		return TRUE;
+	}
+
+	if (!journal_flush_id)
+		journal_flush_id = g_idle_add_full (G_PRIORITY_HIGH, journal_flush_idle, NULL, NULL);
+	return TRUE;
+}
+
+static void
+_format_prefix (char *prefix,
+                gsize size,
+                NMLogLevel level,
+                gint64 time_usec,
+                const char *file,
+                guint line,
+                const char *func)
+{
+	static const char *tags[LOGL_MAX] = {
+		[LOGL_TRACE] = "<trace>",
+		[LOGL_DEBUG] = "<debug>",
+		[LOGL_INFO]  = "<info> ",
+		[LOGL_WARN]  = "<warn> ",
+		[LOGL_ERR]   = "<error>",
+	};
 
-	return !!(logging[level] & domain);
+	switch (level) {
+	case LOGL_TRACE:
+	case LOGL_DEBUG:
+	case LOGL_ERR:
+		g_snprintf (prefix, size, "%s [%ld.%06ld] [%s:%u] %s(): ", tags[level],
+		            (long) (time_usec / G_USEC_PER_SEC), (long) (time_usec % G_USEC_PER_SEC),
+		            file, line, func);
+		break;
+	default:
+		g_snprintf (prefix, size, "%s ", tags[level]);
+		break;
+	}
 }
 
+static void
+debug_buffer_add (NMLogLevel level,
+                  NMLogDomain domain,
+                  gint64 time_usec,
+                  const char *file,
+                  guint line,
+                  const char *func,
+                  const char *msg)
+{
+	DebugRecord *r;
+	gint old;
+	guint32 seq;
+
+	do {
+		old = g_atomic_int_get (&debug_buffer_next);
+		seq = debug_seq_next ((guint32) old);
+	} while (!g_atomic_int_compare_and_exchange (&debug_buffer_next, old, (gint) seq));
+	r = &debug_buffer[(seq - 1) % debug_buffer_size];
+
+	g_atomic_int_set (&r->seq, 0);
+	r->level = level;
+	r->domain = domain;
+	r->time_usec = time_usec;
+	r->file = file;
+	r->line = line;
+	r->func = func;
+	g_strlcpy (r->msg, msg, sizeof (r->msg));
+	g_atomic_int_set (&r->seq, (gint) seq);
+}
+
+static void
+_update_enabled_state (void)
+{
+	int i;
+
+	for (i = 0; i < LOGL_MAX; i++)
+		_nm_logging_enabled_state[i] = logging[i] | (debug_buffer ? LOGD_ALL : 0);
+}
+
+/**
+ * nm_logging_debug_buffer_setup:
+ * @size: the number of messages to keep, or 0 to disable the buffer
+ *
+ * Enables the in-memory debug buffer. While enabled, messages of all
+ * levels and domains are generated and the most recent @size of them are
+ * kept, regardless of what is actually logged.
+ */
 void
-_nm_log (const char *file,
-         guint line,
-         const char *func,
-         NMLogLevel level,
-         NMLogDomain domain,
-         const char *fmt,
-         ...)
+nm_logging_debug_buffer_setup (guint size)
 {
-	va_list args;
-	char *msg;
-	char *fullmsg = NULL;
-	GTimeVal tv;
+	if (size == debug_buffer_size)
+		return;
+
+	g_clear_pointer (&debug_buffer, g_free);
+	debug_buffer_size = size;
+	debug_buffer_next = 0;
+	if (size)
+		debug_buffer = g_new0 (DebugRecord, size);
+	_update_enabled_state ();
+}
+
+/* For testcases only: makes the next message get sequence number
+ * debug_seq_next (@last). */
+void
+_nm_logging_debug_buffer_set_last (guint32 last)
+{
+	g_atomic_int_set (&debug_buffer_next, (gint) last);
+}
+
+/**
+ * nm_logging_debug_buffer_get:
+ * @since: only return messages after this sequence number, 0 for all
+ * @out_next: (out): the sequence number to pass as @since to get only
+ *   newer messages
+ *
+ * Returns: (transfer full): the buffered messages, formatted like the
+ * syslog messages, or %NULL if the buffer is disabled. Messages that were
+ * overwritten since @since are silently skipped.
+ */
+char **
+nm_logging_debug_buffer_get (guint32 since, guint32 *out_next)
+{
+	GPtrArray *lines;
+	guint32 next, first, seq;
+	guint n = 0;
+	DebugRecord r;
+	char prefix[512];
+
+	if (!debug_buffer)
+		return NULL;
+
+	/* Walk back from the newest message to @since, but not further
+	 * than the buffer reaches. */
+	next = (guint32) g_atomic_int_get (&debug_buffer_next);
+	first = seq = next;
+	while (seq && seq != since && n < debug_buffer_size) {
+		first = seq;
+		seq = debug_seq_prev (seq);
+		n++;
+	}
+
+	lines = g_ptr_array_new ();
+	for (seq = first; n > 0; n--, seq = debug_seq_next (seq)) {
+		DebugRecord *slot = &debug_buffer[(seq - 1) % debug_buffer_size];
+
+		if ((guint32) g_atomic_int_get (&slot->seq) != seq)
+			continue;
+		memcpy (&r, slot, sizeof (r));
+		/* skip it if a writer reused the slot while we copied it */
+		if ((guint32) g_atomic_int_get (&slot->seq) != seq)
+			continue;
+
+		r.msg[sizeof (r.msg) - 1] = '\0';
+		_format_prefix (prefix, sizeof (prefix), r.level, r.time_usec, r.file, r.line, r.func);
+		g_ptr_array_add (lines, g_strconcat (prefix, r.msg, NULL));
+	}
+	g_ptr_array_add (lines, NULL);
+
+	if (out_next)
+		*out_next = next;
+	return (char **) g_ptr_array_free (lines, FALSE);
+}
+
+static void
+_nm_log_valist (const char *file,
+                guint line,
+                const char *func,
+                NMLogLevel level,
+                NMLogDomain domain,
+                const char *ifname,
+                int ifindex,
+                const char *con_uuid,
+                const char *fmt,
+                va_list args)
+{
+	LogBuffer *buf;
+	va_list args_copy;
+	char prefix[512];
+	const char *msg;
+	char *msg_free = NULL;
+	gint64 now;
 	int syslog_level = LOG_INFO;
 	int g_log_level = G_LOG_LEVEL_INFO;
+	int n, errsv;
 
 	g_return_if_fail (level < LOGL_MAX);
 
-	_ensure_initialized ();
-
-	if (!(logging[level] & domain))
+	if (!(_nm_logging_enabled_state[level] & domain))
 		return;
 
-	va_start (args, fmt);
-	msg = g_strdup_vprintf (fmt, args);
-	va_end (args);
+	/* callers may still want to look at errno after logging */
+	errsv = errno;
+
+	buf = log_buffer_get ();
+
+	va_copy (args_copy, args);
+	n = g_vsnprintf (buf->msg, sizeof (buf->msg), fmt, args_copy);
+	va_end (args_copy);
+	if (G_LIKELY (n >= 0 && n < (int) sizeof (buf->msg)))
+		msg = buf->msg;
+	else
+		msg = msg_free = g_strdup_vprintf (fmt, args);
+
+	now = g_get_real_time ();
+
+	if (debug_buffer)
+		debug_buffer_add (level, domain, now, file, line, func, msg);
+
+	if (!(logging[level] & domain))
+		goto out;
 
 	switch (level) {
 	case LOGL_TRACE:
-		g_get_current_time (&tv);
 		syslog_level = LOG_DEBUG;
 		g_log_level = G_LOG_LEVEL_DEBUG;
-		fullmsg = g_strdup_printf ("<trace> [%ld.%06ld] [%s:%u] %s(): %s", tv.tv_sec, tv.tv_usec, file, line, func, msg);
 		break;
 	case LOGL_DEBUG:
-		g_get_current_time (&tv);
 		syslog_level = LOG_INFO;
 		g_log_level = G_LOG_LEVEL_DEBUG;
-		fullmsg = g_strdup_printf ("<debug> [%ld.%06ld] [%s:%u] %s(): %s", tv.tv_sec, tv.tv_usec, file, line, func, msg);
 		break;
 	case LOGL_INFO:
 		syslog_level = LOG_INFO;
 		g_log_level = G_LOG_LEVEL_MESSAGE;
-		fullmsg = g_strconcat ("<info>  ", msg, NULL);
 		break;
 	case LOGL_WARN:
 		syslog_level = LOG_WARNING;
 		g_log_level = G_LOG_LEVEL_WARNING;
-		fullmsg = g_strconcat ("<warn>  ", msg, NULL);
 		break;
 	case LOGL_ERR:
 		syslog_level = LOG_ERR;
 		/* g_log_level is still WARNING, because ERROR is fatal */
 		g_log_level = G_LOG_LEVEL_WARNING;
-		g_get_current_time (&tv);
-		fullmsg = g_strdup_printf ("<error> [%ld.%06ld] [%s:%u] %s(): %s", tv.tv_sec, tv.tv_usec, file, line, func, msg);
 		break;
 	default:
 		g_assert_not_reached ();
 	}
 
-	if (syslog_opened)
-		syslog (syslog_level, "%s", fullmsg);
-	else
-		g_log (G_LOG_DOMAIN, g_log_level, "%s", fullmsg);
+	_format_prefix (prefix, sizeof (prefix), level, now, file, line, func);
+
+	if (   journal_fd < 0
+	    || !journal_log (file, line, func, level, domain, syslog_level,
+	                     ifname, ifindex, con_uuid, prefix, msg)) {
+		if (syslog_opened)
+			syslog (syslog_level, "%s%s", prefix, msg);
+		else
+			g_log (G_LOG_DOMAIN, g_log_level, "%s%s", prefix, msg);
+	}
+
+out:
+	g_free (msg_free);
+	errno = errsv;
+}
+
+void
+_nm_log (const char *file,
+         guint line,
+         const char *func,
+         NMLogLevel level,
+         NMLogDomain domain,
+         const char *fmt,
+         ...)
+{
+	va_list args;
 
-	g_free (msg);
-	g_free (fullmsg);
+	va_start (args, fmt);
+	_nm_log_valist (file, line, func, level, domain, NULL, 0, NULL, fmt, args);
+	va_end (args);
+}
+
+void
+_nm_log_full (const char *file,
+              guint line,
+              const char *func,
+              NMLogLevel level,
+              NMLogDomain domain,
+              const char *ifname,
+              int ifindex,
+              const char *con_uuid,
+              const char *fmt,
+              ...)
+{
+	va_list args;
+
+	va_start (args, fmt);
+	_nm_log_valist (file, line, func, level, domain, ifname, ifindex, con_uuid, fmt, args);
+	va_end (args);
 }
 
 /************************************************************************/
@@ -464,8 +957,36 @@ nm_log_handler (const gchar *log_domain,
 	syslog (syslog_priority, "%s", message);
 }
 
+static gboolean
+journal_open (void)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX, .sun_path = JOURNAL_SOCKET };
+	int fd;
+
+	fd = socket (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return FALSE;
+	if (connect (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0) {
+		close (fd);
+		return FALSE;
+	}
+
+	journal_fd = fd;
+	journal_thread = g_thread_self ();
+	return TRUE;
+}
+
+/**
+ * nm_logging_syslog_openlog:
+ * @backend: (allow-none): "syslog" or "journal"; %NULL means syslog
+ * @debug: whether to log to stderr too
+ *
+ * With the journal backend, messages are written to the journal
+ * with structured fields, falling back to syslog if the journal is
+ * not available. In @debug mode the backend is always syslog.
+ */
 void
-nm_logging_syslog_openlog (gboolean debug)
+nm_logging_syslog_openlog (const char *backend, gboolean debug)
 {
 	if (debug)
 		openlog (G_LOG_DOMAIN, LOG_CONS | LOG_PERROR | LOG_PID, LOG_USER);
@@ -480,11 +1001,32 @@ nm_logging_syslog_openlog (gboolean debug)
 		                   nm_log_handler,
 		                   NULL);
 	}
+
+	if (debug || !backend || !strcmp (backend, "syslog"))
+		return;
+
+	if (strcmp (backend, "journal") != 0)
+		nm_log_warn (LOGD_CORE, "unknown logging backend '%s'; using syslog", backend);
+	else if (journal_fd < 0 && !journal_open ())
+		nm_log_warn (LOGD_CORE, "could not connect to the journal at " JOURNAL_SOCKET "; using syslog");
 }
 
 void
 nm_logging_syslog_closelog (void)
 {
+	if (journal_fd >= 0) {
+		LogBuffer *buf = g_private_get (&log_buffer);
+
+		if (buf && buf->n_iov)
+			journal_flush (buf);
+		if (journal_flush_id) {
+			g_source_remove (journal_flush_id);
+			journal_flush_id = 0;
+		}
+		close (journal_fd);
+		journal_fd = -1;
+	}
+
 	if (syslog_opened)
 		closelog ();
 }
@@ -110,6 +110,18 @@ typedef enum  { /*< skip >*/
     } G_STMT_END
 
 
+/* Like nm_log(), but also passes the interface and the connection the
+ * message is about. The journal backend stores them as the NM_DEVICE,
+ * NM_IFINDEX and NM_CONNECTION_UUID fields. */
+#define nm_log_full(level, domain, ifname, ifindex, con_uuid, ...) \
+    G_STMT_START { \
+        if (nm_logging_enabled ((level), (domain))) { \
+            _nm_log_full (__FILE__, __LINE__, G_STRFUNC, (level), (domain), \
+                          (ifname), (ifindex), (con_uuid), __VA_ARGS__); \
+        } \
+    } G_STMT_END
+
+
 #define _nm_log_ptr(level, domain, self, ...) \
    nm_log ((level), (domain), "[%p] " _NM_UTILS_MACRO_FIRST(__VA_ARGS__), self _NM_UTILS_MACRO_REST(__VA_ARGS__))
 
@@ -142,9 +154,29 @@ void _nm_log (const char *file,
               const char *fmt,
               ...) __attribute__((__format__ (__printf__, 6, 7)));
 
+void _nm_log_full (const char *file,
+                   guint line,
+                   const char *func,
+                   NMLogLevel level,
+                   NMLogDomain domain,
+                   const char *ifname,
+                   int ifindex,
+                   const char *con_uuid,
+                   const char *fmt,
+                   ...) __attribute__((__format__ (__printf__, 9, 10)));
+
 const char *nm_logging_level_to_string (void);
 const char *nm_logging_domains_to_string (void);
-gboolean nm_logging_enabled (NMLogLevel level, NMLogDomain domain);
+
+extern NMLogDomain _nm_logging_enabled_state[LOGL_MAX];
+
+/* This is checked before every log statement, so keep it
+ * down to a single test. */
+static inline gboolean
+nm_logging_enabled (NMLogLevel level, NMLogDomain domain)
+{
+	return !!(_nm_logging_enabled_state[level] & domain);
+}
 
 const char *nm_logging_all_levels_to_string (void);
 const char *nm_logging_all_domains_to_string (void);
@@ -153,7 +185,14 @@ gboolean nm_logging_setup (const char  *level,
                            const char  *domains,
                            char       **bad_domains,
                            GError     **error);
-void     nm_logging_syslog_openlog   (gboolean debug);
+void     nm_logging_debug_buffer_setup (guint size);
+char   **nm_logging_debug_buffer_get   (guint32 since, guint32 *out_next);
+
+/* For testcases only! */
+void     _nm_logging_debug_buffer_set_last (guint32 last);
+
+void     nm_logging_syslog_openlog   (const char *backend,
+                                      gboolean debug);
 void     nm_logging_syslog_closelog  (void);
 
 #endif /* __NETWORKMANAGER_LOGGING_H__ */
@@ -113,6 +113,10 @@ static void impl_manager_get_logging (NMManager *manager,
                                       char **level,
                                       char **domains);
 
+static void impl_manager_get_debug_log (NMManager *manager,
+                                        guint32 since,
+                                        DBusGMethodInvocation *context);
+
 static void impl_manager_check_connectivity (NMManager *manager,
                                              DBusGMethodInvocation *context);
 
@@ -200,6 +204,9 @@ typedef struct {
 
 	guint timestamp_update_id;
 
+	/* Devices to hand over to nm-iface-helper while stopping */
+	GKeyFile *iface_helper_keyfile;
+
 	gboolean startup;
 } NMManagerPrivate;
 
@@ -655,6 +662,17 @@ manager_device_state_changed (NMDevice *device,
                               gpointer user_data)
 {
 	NMManager *self = NM_MANAGER (user_data);
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	int ifindex;
+
+	/* Check connectivity through each activated device on its own */
+	ifindex = nm_device_get_ip_ifindex (device);
+	if (ifindex > 0) {
+		if (new_state == NM_DEVICE_STATE_ACTIVATED)
+			nm_connectivity_device_add (priv->connectivity, ifindex, nm_device_get_ip_iface (device));
+		else if (old_state == NM_DEVICE_STATE_ACTIVATED)
+			nm_connectivity_device_remove (priv->connectivity, ifindex);
+	}
 
 	switch (new_state) {
 	case NM_DEVICE_STATE_UNMANAGED:
@@ -762,7 +780,10 @@ remove_device (NMManager *manager,
 			else
 				nm_device_set_unmanaged (device, NM_UNMANAGED_INTERNAL, TRUE, NM_DEVICE_STATE_REASON_REMOVED);
 		} else if (quitting && nm_config_get_configure_and_quit (nm_config_get ())) {
-			nm_device_spawn_iface_helper (device);
+			if (priv->iface_helper_keyfile)
+				nm_device_add_iface_helper_config (device, priv->iface_helper_keyfile);
+			else
+				nm_device_spawn_iface_helper (device);
 		}
 	}
 
@@ -842,19 +863,30 @@ static NMDevice *
 get_device_from_hwaddr (NMManager *self, const char *setting_mac)
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
-	const char *device_mac;
+	guint8 setting_bin[NM_UTILS_HWADDR_LEN_MAX];
+	gsize setting_len;
+	const guint8 *device_bin;
+	gsize device_len;
 	GSList *iter;
 
 	if (!setting_mac)
 		return NULL;
 
+	/* Parse once instead of for every device.  Settings hold canonical
+	 * "xx:xx:...:xx" addresses, with three characters per octet. */
+	setting_len = (strlen (setting_mac) + 1) / 3;
+	if (   setting_len == 0
+	    || setting_len > NM_UTILS_HWADDR_LEN_MAX
+	    || !nm_utils_hwaddr_aton (setting_mac, setting_bin, setting_len))
+		return NULL;
+
 	for (iter = priv->devices; iter; iter = g_slist_next (iter)) {
 		NMDevice *device = iter->data;
 
-		device_mac = nm_device_get_hw_address (iter->data);
-		if (!device_mac)
+		device_bin = nm_device_get_hw_address_bin (device, &device_len);
+		if (!device_bin)
 			continue;
-		if (nm_utils_hwaddr_matches (setting_mac, -1, device_mac, -1))
+		if (nm_utils_hwaddr_matches (setting_bin, setting_len, device_bin, device_len))
 			return device;
 	}
 	return NULL;
@@ -4094,6 +4126,49 @@ impl_manager_get_logging (NMManager *manager,
 	*domains = g_strdup (nm_logging_domains_to_string ());
 }
 
+static void
+impl_manager_get_debug_log (NMManager *manager,
+                            guint32 since,
+                            DBusGMethodInvocation *context)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (manager);
+	GError *error = NULL;
+	gulong caller_uid = G_MAXULONG;
+	char **messages;
+	guint32 next = 0;
+
+	if (!nm_dbus_manager_get_caller_info (priv->dbus_mgr, context, NULL, &caller_uid, NULL)) {
+		error = g_error_new_literal (NM_MANAGER_ERROR,
+		                             NM_MANAGER_ERROR_PERMISSION_DENIED,
+		                             "Failed to get request UID.");
+		goto done;
+	}
+
+	if (0 != caller_uid) {
+		error = g_error_new_literal (NM_MANAGER_ERROR,
+		                             NM_MANAGER_ERROR_PERMISSION_DENIED,
+		                             "Permission denied");
+		goto done;
+	}
+
+	messages = nm_logging_debug_buffer_get (since, &next);
+	if (!messages) {
+		error = g_error_new_literal (NM_MANAGER_ERROR,
+		                             NM_MANAGER_ERROR_FAILED,
+		                             "The debug log buffer is disabled");
+		goto done;
+	}
+
+	dbus_g_method_return (context, messages, next);
+	g_strfreev (messages);
+
+done:
+	if (error) {
+		dbus_g_method_return_error (context, error);
+		g_error_free (error);
+	}
+}
+
 static void
 connectivity_check_done (GObject *object,
                          GAsyncResult *result,
@@ -4224,14 +4299,86 @@ nm_manager_start (NMManager *self)
 	check_if_startup_complete (self);
 }
 
+#define IFACE_HELPER_LIST NMRUNDIR "/nm-iface-helper.conf"
+
+/* Spawns one nm-iface-helper for all devices collected in @keyfile, so they
+ * share a single platform cache instead of each helper keeping its own.
+ */
+static void
+spawn_iface_helper (GKeyFile *keyfile)
+{
+	GPtrArray *argv;
+	char **groups;
+	gsize n_groups = 0;
+	GError *error = NULL;
+	GPid pid;
+
+	groups = g_key_file_get_groups (keyfile, &n_groups);
+	if (n_groups == 0) {
+		g_strfreev (groups);
+		return;
+	}
+
+	argv = g_ptr_array_sized_new (10);
+	g_ptr_array_set_free_func (argv, g_free);
+	g_ptr_array_add (argv, g_strdup (LIBEXECDIR "/nm-iface-helper"));
+
+	if (n_groups == 1) {
+		char **args;
+		gsize i, n_args = 0;
+
+		/* No point in going through the file for a single interface */
+		args = g_key_file_get_string_list (keyfile, groups[0], "args", &n_args, NULL);
+		for (i = 0; i < n_args; i++)
+			g_ptr_array_add (argv, g_strdup (args[i]));
+		g_strfreev (args);
+	} else {
+		char *data;
+
+		data = g_key_file_to_data (keyfile, NULL, NULL);
+		if (!g_file_set_contents (IFACE_HELPER_LIST, data, -1, &error)) {
+			nm_log_warn (LOGD_CORE, "failed to write %s: %s", IFACE_HELPER_LIST, error->message);
+			g_clear_error (&error);
+			g_free (data);
+			goto out;
+		}
+		g_free (data);
+
+		g_ptr_array_add (argv, g_strdup ("--interfaces"));
+		g_ptr_array_add (argv, g_strdup (IFACE_HELPER_LIST));
+	}
+	g_ptr_array_add (argv, NULL);
+
+	if (g_spawn_async (NULL, (char **) argv->pdata, NULL,
+	                   G_SPAWN_DO_NOT_REAP_CHILD, NULL, NULL, &pid, &error)) {
+		nm_log_info (LOGD_CORE, "spawned helper PID %u for %u interface(s)",
+		             (guint) pid, (guint) n_groups);
+	} else {
+		nm_log_warn (LOGD_CORE, "failed to spawn helper: %s", error->message);
+		g_error_free (error);
+	}
+
+out:
+	g_ptr_array_unref (argv);
+	g_strfreev (groups);
+}
+
 void
 nm_manager_stop (NMManager *self)
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 
+	if (nm_config_get_configure_and_quit (nm_config_get ()))
+		priv->iface_helper_keyfile = g_key_file_new ();
+
 	/* Remove all devices */
 	while (priv->devices)
 		remove_device (self, NM_DEVICE (priv->devices->data), TRUE, TRUE);
+
+	if (priv->iface_helper_keyfile) {
+		spawn_iface_helper (priv->iface_helper_keyfile);
+		g_clear_pointer (&priv->iface_helper_keyfile, g_key_file_free);
+	}
 }
 
 static gboolean
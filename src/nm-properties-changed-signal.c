@@ -35,7 +35,7 @@ typedef struct {
 } NMPropertiesChangedClassInfo;
 
 typedef struct {
-	GHashTable *hash;
+	GHashTable *hash; /* D-Bus property name -> GParamSpec of changed properties */
 	guint signal_id;
 	guint idle_id;
 } NMPropertiesChangedInfo;
@@ -101,19 +101,38 @@ properties_changed (gpointer data)
 {
 	GObject *object = G_OBJECT (data);
 	NMPropertiesChangedInfo *info = g_object_get_qdata (object, nm_properties_changed_signal_quark ());
+	GHashTable *values;
+	GHashTableIter iter;
+	const char *dbus_property_name;
+	GParamSpec *pspec;
 
 	g_assert (info);
 
+	/* The values are only read now, so a property that changes many times
+	 * before the idle handler runs (like the address and route lists of an
+	 * IP config) is read once instead of once per change.
+	 */
+	values = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, destroy_value);
+	g_hash_table_iter_init (&iter, info->hash);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &dbus_property_name, (gpointer *) &pspec)) {
+		GValue *value = g_slice_new0 (GValue);
+
+		g_value_init (value, pspec->value_type);
+		g_object_get_property (object, pspec->name, value);
+		g_hash_table_insert (values, (char *) dbus_property_name, value);
+	}
+	g_hash_table_remove_all (info->hash);
+
 	if (nm_logging_enabled (LOGL_DEBUG, LOGD_DBUS_PROPS)) {
 		GString *buf = g_string_new (NULL);
 
-		g_hash_table_foreach (info->hash, add_to_string, buf);
+		g_hash_table_foreach (values, add_to_string, buf);
 		nm_log_dbg (LOGD_DBUS_PROPS, "%s -> %s", G_OBJECT_TYPE_NAME (object), buf->str);
 		g_string_free (buf, TRUE);
 	}
 
-	g_signal_emit (object, info->signal_id, 0, info->hash);
-	g_hash_table_remove_all (info->hash);
+	g_signal_emit (object, info->signal_id, 0, values);
+	g_hash_table_destroy (values);
 
 	return FALSE;
 }
@@ -135,7 +154,6 @@ notify (GObject *object, GParamSpec *pspec)
 	NMPropertiesChangedClassInfo *classinfo;
 	NMPropertiesChangedInfo *info;
 	const char *dbus_property_name = NULL;
-	GValue *value;
 	GType type;
 
 	for (type = G_OBJECT_TYPE (object); type; type = g_type_parent (type)) {
@@ -156,18 +174,14 @@ notify (GObject *object, GParamSpec *pspec)
 	info = g_object_get_qdata (object, nm_properties_changed_signal_quark ());
 	if (!info) {
 		info = g_slice_new0 (NMPropertiesChangedInfo);
-		info->hash = g_hash_table_new_full (g_str_hash, g_str_equal,
-		                                    NULL, destroy_value);
+		info->hash = g_hash_table_new (g_str_hash, g_str_equal);
 		info->signal_id = classinfo->signal_id;
 
 		g_object_set_qdata_full (object, nm_properties_changed_signal_quark (),
 		                         info, properties_changed_info_destroy);
 	}
 
-	value = g_slice_new0 (GValue);
-	g_value_init (value, pspec->value_type);
-	g_object_get_property (object, pspec->name, value);
-	g_hash_table_insert (info->hash, (char *) dbus_property_name, value);
+	g_hash_table_insert (info->hash, (char *) dbus_property_name, pspec);
 
 	if (!info->idle_id)
 		info->idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, properties_changed, object, idle_id_reset);
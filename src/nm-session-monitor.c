@@ -24,6 +24,7 @@
 #include <pwd.h>
 #include <errno.h>
 #include <string.h>
+#include <unistd.h>
 #include <sys/stat.h>
 #include <gio/gio.h>
 
@@ -61,6 +62,14 @@ struct _NMSessionMonitor {
 		time_t timestamp;
 	} ck;
 #endif
+
+	struct {
+		GThreadPool *pool;
+		/* uid -> UserEntry */
+		GHashTable *by_uid;
+		/* user name -> UserEntry */
+		GHashTable *by_name;
+	} users;
 };
 
 struct _NMSessionMonitorClass {
@@ -278,10 +287,284 @@ ck_finalize (NMSessionMonitor *monitor)
 
 /********************************************************************/
 
+/* With network-backed NSS (LDAP, SSSD) getpwuid() and getpwnam() can take
+ * seconds, so they are done on a worker thread and the results, including
+ * failed lookups, are cached for a while. */
+
+#define USER_CACHE_TTL          300
+#define USER_CACHE_NEGATIVE_TTL 30
+#define USER_LOOKUP_THREADS     2
+
+typedef struct {
+	NMSessionUserCallback callback;
+	gpointer user_data;
+} UserWaiter;
+
+typedef struct {
+	gboolean found;
+	uid_t uid;
+	char *user;
+	/* in seconds of g_get_monotonic_time(); 0 while the first lookup runs */
+	gint64 expires;
+	/* UserWaiter list of async callers while a lookup runs */
+	GSList *waiters;
+	gboolean pending;
+} UserEntry;
+
+typedef struct {
+	/* Input: @user if set, @uid otherwise */
+	char *user;
+	uid_t uid;
+
+	/* Output */
+	gboolean found;
+	char *found_user;
+	uid_t found_uid;
+} UserLookup;
+
+static void
+user_entry_free (gpointer data)
+{
+	UserEntry *entry = data;
+
+	g_free (entry->user);
+	g_slist_free_full (entry->waiters, g_free);
+	g_slice_free (UserEntry, entry);
+}
+
+static NMSessionLookupFunc test_lookup_func;
+static NMSessionExistsFunc test_session_exists_func;
+static gint64 test_now;
+
+static gint64
+now_s (void)
+{
+	if (test_now)
+		return test_now;
+	return g_get_monotonic_time () / G_USEC_PER_SEC;
+}
+
+static gboolean
+user_entry_is_fresh (const UserEntry *entry)
+{
+	return entry->expires && entry->expires > now_s ();
+}
+
 NMSessionMonitor *nm_session_monitor_get(void);
 
 NM_DEFINE_SINGLETON_GETTER (NMSessionMonitor, nm_session_monitor_get, NM_TYPE_SESSION_MONITOR);
 
+static void
+user_lookup_run (UserLookup *lookup)
+{
+	struct passwd pwd, *result = NULL;
+	long bufsize = sysconf (_SC_GETPW_R_SIZE_MAX);
+	char *buf;
+	int r;
+
+	if (test_lookup_func) {
+		lookup->found = test_lookup_func (lookup->user, lookup->uid,
+		                                  &lookup->found_user, &lookup->found_uid);
+		return;
+	}
+
+	if (bufsize <= 0)
+		bufsize = 16384;
+
+	do {
+		buf = g_malloc (bufsize);
+		if (lookup->user)
+			r = getpwnam_r (lookup->user, &pwd, buf, bufsize, &result);
+		else
+			r = getpwuid_r (lookup->uid, &pwd, buf, bufsize, &result);
+		if (r == 0 && result) {
+			lookup->found = TRUE;
+			lookup->found_user = g_strdup (result->pw_name);
+			lookup->found_uid = result->pw_uid;
+		}
+		g_free (buf);
+		bufsize *= 2;
+	} while (r == ERANGE && bufsize <= 1024 * 1024);
+}
+
+static void
+user_lookup_free (UserLookup *lookup)
+{
+	g_free (lookup->user);
+	g_free (lookup->found_user);
+	g_slice_free (UserLookup, lookup);
+}
+
+static void
+user_entry_update (UserEntry *entry, gboolean found, uid_t uid, const char *user)
+{
+	entry->found = found;
+	entry->expires = now_s () + (found ? USER_CACHE_TTL : USER_CACHE_NEGATIVE_TTL);
+	if (!found)
+		return;
+
+	entry->uid = uid;
+	if (g_strcmp0 (entry->user, user) != 0) {
+		g_free (entry->user);
+		entry->user = g_strdup (user);
+	}
+}
+
+static UserEntry *
+user_entry_get (NMSessionMonitor *monitor, const char *user, uid_t uid)
+{
+	UserEntry *entry;
+
+	if (user)
+		entry = g_hash_table_lookup (monitor->users.by_name, user);
+	else
+		entry = g_hash_table_lookup (monitor->users.by_uid, GUINT_TO_POINTER (uid));
+	if (entry)
+		return entry;
+
+	entry = g_slice_new0 (UserEntry);
+	if (user) {
+		entry->user = g_strdup (user);
+		g_hash_table_insert (monitor->users.by_name, g_strdup (user), entry);
+	} else {
+		entry->uid = uid;
+		g_hash_table_insert (monitor->users.by_uid, GUINT_TO_POINTER (uid), entry);
+	}
+	return entry;
+}
+
+/* A successful lookup answers the reverse question as well */
+static void
+user_cache_fill_reverse (NMSessionMonitor *monitor, const UserLookup *lookup)
+{
+	UserEntry *entry;
+
+	if (!lookup->found)
+		return;
+
+	if (lookup->user)
+		entry = user_entry_get (monitor, NULL, lookup->found_uid);
+	else
+		entry = user_entry_get (monitor, lookup->found_user, 0);
+	if (!entry->pending && !user_entry_is_fresh (entry))
+		user_entry_update (entry, TRUE, lookup->found_uid, lookup->found_user);
+}
+
+static gboolean
+user_lookup_done (gpointer user_data)
+{
+	UserLookup *lookup = user_data;
+	NMSessionMonitor *monitor = singleton_instance;
+	UserEntry *entry;
+	GSList *waiters, *iter;
+
+	if (!monitor) {
+		user_lookup_free (lookup);
+		return FALSE;
+	}
+
+	entry = user_entry_get (monitor, lookup->user, lookup->uid);
+	user_entry_update (entry, lookup->found, lookup->found_uid, lookup->found_user);
+	user_cache_fill_reverse (monitor, lookup);
+
+	if (lookup->user) {
+		nm_log_dbg (LOGD_CORE, "session-monitor: user '%s' %s", lookup->user,
+		            lookup->found ? "resolved" : "not found");
+	} else {
+		nm_log_dbg (LOGD_CORE, "session-monitor: uid %u %s", (guint) lookup->uid,
+		            lookup->found ? "resolved" : "not found");
+	}
+
+	waiters = entry->waiters;
+	entry->waiters = NULL;
+	entry->pending = FALSE;
+	for (iter = waiters; iter; iter = iter->next) {
+		UserWaiter *waiter = iter->data;
+
+		waiter->callback (entry->found, entry->uid, entry->user, waiter->user_data);
+	}
+	g_slist_free_full (waiters, g_free);
+
+	user_lookup_free (lookup);
+	return G_SOURCE_REMOVE;
+}
+
+/* Runs on a worker thread */
+static void
+user_lookup_thread (gpointer data, gpointer user_data)
+{
+	user_lookup_run (data);
+	g_idle_add (user_lookup_done, data);
+}
+
+static void
+user_lookup_start (NMSessionMonitor *monitor, UserEntry *entry, const char *user, uid_t uid)
+{
+	UserLookup *lookup;
+
+	if (entry->pending)
+		return;
+
+	if (!monitor->users.pool) {
+		monitor->users.pool = g_thread_pool_new (user_lookup_thread, NULL,
+		                                         USER_LOOKUP_THREADS, FALSE, NULL);
+	}
+
+	entry->pending = TRUE;
+	lookup = g_slice_new0 (UserLookup);
+	lookup->user = g_strdup (user);
+	lookup->uid = uid;
+	g_thread_pool_push (monitor->users.pool, lookup, NULL);
+}
+
+static void
+user_resolve_async (const char *user, uid_t uid, NMSessionUserCallback callback, gpointer user_data)
+{
+	NMSessionMonitor *monitor = nm_session_monitor_get ();
+	UserEntry *entry;
+	UserWaiter *waiter;
+
+	entry = user_entry_get (monitor, user, uid);
+	if (user_entry_is_fresh (entry)) {
+		if (callback)
+			callback (entry->found, entry->uid, entry->user, user_data);
+		return;
+	}
+
+	if (callback) {
+		waiter = g_new (UserWaiter, 1);
+		waiter->callback = callback;
+		waiter->user_data = user_data;
+		entry->waiters = g_slist_append (entry->waiters, waiter);
+	}
+	user_lookup_start (monitor, entry, user, uid);
+}
+
+/* Answers from the cache if possible.  An expired answer is still used
+ * while it is refreshed in the background; only a user that was never
+ * looked up before blocks. */
+static const UserEntry *
+user_resolve_sync (const char *user, uid_t uid)
+{
+	NMSessionMonitor *monitor = nm_session_monitor_get ();
+	UserEntry *entry;
+	UserLookup lookup = { .user = (char *) user, .uid = uid };
+
+	entry = user_entry_get (monitor, user, uid);
+	if (user_entry_is_fresh (entry))
+		return entry;
+	if (entry->expires) {
+		user_lookup_start (monitor, entry, user, uid);
+		return entry;
+	}
+
+	user_lookup_run (&lookup);
+	user_entry_update (entry, lookup.found, lookup.found_uid, lookup.found_user);
+	user_cache_fill_reverse (monitor, &lookup);
+	g_free (lookup.found_user);
+	return entry;
+}
+
 /**
  * nm_session_monitor_connect:
  * @callback: The callback.
@@ -315,21 +598,25 @@ nm_session_monitor_disconnect (gulong handler_id)
 /**
  * nm_session_monitor_uid_to_user:
  * @uid: UID.
- * @out_user: Return location for user name.
+ * @out_user: Return location for a newly allocated user name.
  *
- * Translates a UID to a user name.
+ * Translates a UID to a user name.  Answers from the cache shared with
+ * nm_session_monitor_uid_to_user_async() and only blocks the first time
+ * @uid is looked up.  The name is copied, since a background refresh
+ * may replace the cached one at any time.
  */
 gboolean
-nm_session_monitor_uid_to_user (uid_t uid, const char **out_user)
+nm_session_monitor_uid_to_user (uid_t uid, char **out_user)
 {
-	struct passwd *pw = getpwuid (uid);
+	const UserEntry *entry;
 
 	g_assert (out_user);
 
-	if (!pw)
+	entry = user_resolve_sync (NULL, uid);
+	if (!entry->found)
 		return FALSE;
 
-	*out_user = pw->pw_name;
+	*out_user = g_strdup (entry->user);
 
 	return TRUE;
 }
@@ -339,23 +626,59 @@ nm_session_monitor_uid_to_user (uid_t uid, const char **out_user)
  * @user: User naee.
  * @out_uid: Return location for UID.
  *
- * Translates a user name to a UID.
+ * Translates a user name to a UID.  Like nm_session_monitor_uid_to_user(),
+ * only blocks the first time @user is looked up.
  */
 gboolean
 nm_session_monitor_user_to_uid (const char *user, uid_t *out_uid)
 {
-	struct passwd *pw = getpwnam (user);
+	const UserEntry *entry;
 
 	g_assert (out_uid);
 
-	if (!pw)
+	entry = user_resolve_sync (user, 0);
+	if (!entry->found)
 		return FALSE;
 
-	*out_uid = pw->pw_uid;
+	*out_uid = entry->uid;
 
 	return TRUE;
 }
 
+/**
+ * nm_session_monitor_uid_to_user_async:
+ * @uid: UID.
+ * @callback: (allow-none): Called with the result.
+ * @user_data: User data for the callback.
+ *
+ * Translates a UID to a user name without blocking the main loop.  If the
+ * answer is cached, @callback is invoked before this function returns;
+ * otherwise the lookup runs on a worker thread and @callback is invoked
+ * from an idle handler.  With a %NULL @callback this only warms the cache.
+ */
+void
+nm_session_monitor_uid_to_user_async (uid_t uid, NMSessionUserCallback callback, gpointer user_data)
+{
+	user_resolve_async (NULL, uid, callback, user_data);
+}
+
+/**
+ * nm_session_monitor_user_to_uid_async:
+ * @user: User name.
+ * @callback: (allow-none): Called with the result.
+ * @user_data: User data for the callback.
+ *
+ * Translates a user name to a UID without blocking the main loop.  See
+ * nm_session_monitor_uid_to_user_async().
+ */
+void
+nm_session_monitor_user_to_uid_async (const char *user, NMSessionUserCallback callback, gpointer user_data)
+{
+	g_return_if_fail (user != NULL);
+
+	user_resolve_async (user, 0, callback, user_data);
+}
+
 /**
  * nm_session_monitor_session_exists:
  * @uid: A user ID.
@@ -374,6 +697,9 @@ nm_session_monitor_session_exists (uid_t uid, gboolean active)
 {
 	NMSessionMonitor *monitor = nm_session_monitor_get ();
 
+	if (test_session_exists_func)
+		return test_session_exists_func (uid, active);
+
 #ifdef SESSION_TRACKING_SYSTEMD
 	if (sd_session_exists (monitor, uid, active))
 		return TRUE;
@@ -387,11 +713,27 @@ nm_session_monitor_session_exists (uid_t uid, gboolean active)
 	return FALSE;
 }
 
+void
+_nm_session_monitor_set_lookup_func (NMSessionLookupFunc lookup, NMSessionExistsFunc session_exists)
+{
+	test_lookup_func = lookup;
+	test_session_exists_func = session_exists;
+}
+
+void
+_nm_session_monitor_set_now (gint64 now)
+{
+	test_now = now;
+}
+
 /********************************************************************/
 
 static void
 nm_session_monitor_init (NMSessionMonitor *monitor)
 {
+	monitor->users.by_uid = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, user_entry_free);
+	monitor->users.by_name = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, user_entry_free);
+
 #ifdef SESSION_TRACKING_SYSTEMD
 	sd_init (monitor);
 #endif
@@ -404,14 +746,22 @@ nm_session_monitor_init (NMSessionMonitor *monitor)
 static void
 nm_session_monitor_finalize (GObject *object)
 {
+	NMSessionMonitor *monitor = NM_SESSION_MONITOR (object);
+
 #ifdef SESSION_TRACKING_SYSTEMD
-	sd_finalize (NM_SESSION_MONITOR (object));
+	sd_finalize (monitor);
 #endif
 
 #ifdef SESSION_TRACKING_CONSOLEKIT
-	ck_finalize (NM_SESSION_MONITOR (object));
+	ck_finalize (monitor);
 #endif
 
+	/* Lookups still queued complete and are dropped by user_lookup_done() */
+	if (monitor->users.pool)
+		g_thread_pool_free (monitor->users.pool, FALSE, TRUE);
+	g_clear_pointer (&monitor->users.by_uid, g_hash_table_unref);
+	g_clear_pointer (&monitor->users.by_name, g_hash_table_unref);
+
 	if (G_OBJECT_CLASS (nm_session_monitor_parent_class)->finalize != NULL)
 		G_OBJECT_CLASS (nm_session_monitor_parent_class)->finalize (object);
 }
@@ -39,16 +39,33 @@ G_BEGIN_DECLS
 typedef struct _NMSessionMonitorClass    NMSessionMonitorClass;
 
 typedef void (*NMSessionCallback) (NMSessionMonitor *monitor, gpointer user_data);
+typedef void (*NMSessionUserCallback) (gboolean found, uid_t uid, const char *user, gpointer user_data);
 
 GType             nm_session_monitor_get_type       (void) G_GNUC_CONST;
 
 gulong            nm_session_monitor_connect        (NMSessionCallback callback, gpointer user_data);
 void              nm_session_monitor_disconnect     (gulong handler_id);
 
-gboolean          nm_session_monitor_uid_to_user    (uid_t uid, const char **out_user);
+gboolean          nm_session_monitor_uid_to_user    (uid_t uid, char **out_user);
 gboolean          nm_session_monitor_user_to_uid    (const char *user, uid_t *out_uid);
 gboolean          nm_session_monitor_session_exists (uid_t uid, gboolean active);
 
+void              nm_session_monitor_uid_to_user_async (uid_t uid,
+                                                        NMSessionUserCallback callback,
+                                                        gpointer user_data);
+void              nm_session_monitor_user_to_uid_async (const char *user,
+                                                        NMSessionUserCallback callback,
+                                                        gpointer user_data);
+
+/* For testcases only! @lookup replaces getpwnam_r()/getpwuid_r() and runs
+ * on the worker thread for asynchronous lookups; @now replaces the clock
+ * of the cache, in seconds.  Pass %NULL and 0 to restore the defaults. */
+typedef gboolean (*NMSessionLookupFunc) (const char *user, uid_t uid, char **out_user, uid_t *out_uid);
+typedef gboolean (*NMSessionExistsFunc) (uid_t uid, gboolean active);
+
+void _nm_session_monitor_set_lookup_func (NMSessionLookupFunc lookup, NMSessionExistsFunc session_exists);
+void _nm_session_monitor_set_now (gint64 now);
+
 G_END_DECLS
 
 #endif /* __NETWORKMANAGER_SESSION_MONITOR_H__ */
@@ -88,11 +88,18 @@ typedef struct {
 	GIOChannel *event_channel;
 	guint event_id;
 
+	/* Requested receive buffer size of the event socket; grown on overflow */
+	int event_rcvbuf;
+	NMPlatformNetlinkStats netlink_stats;
+
 	GUdevClient *udev_client;
 	GHashTable *udev_devices;
 
 	GHashTable *wifi_data;
 
+	/* directory path -> SysctlDir for per-interface sysctl directories */
+	GHashTable *sysctl_dirs;
+
 	int support_kernel_extended_ifa_flags;
 	int support_user_ipv6ll;
 } NMLinuxPlatformPrivate;
@@ -499,23 +506,32 @@ add_kernel_object (struct nl_sock *sock, struct nl_object *object)
 
 /* nm_rtnl_link_parse_info_data(): Re-fetches a link from the kernel
  * and parses its IFLA_INFO_DATA using a caller-provided parser.
+ * nm_rtnl_link_parse_info_slave_data() does the same for the
+ * IFLA_INFO_SLAVE_DATA the master reports for its ports.
  *
  * Code is stolen from rtnl_link_get_kernel(), nl_pickup(), and link_msg_parser().
  */
 
+/* Older kernel headers don't know about slave data; the values are ABI. */
+#define NM_IFLA_INFO_SLAVE_KIND 4
+#define NM_IFLA_INFO_SLAVE_DATA 5
+#define NM_IFLA_INFO_MAX        NM_IFLA_INFO_SLAVE_DATA
+
 typedef int (*NMNLInfoDataParser) (struct nlattr *info_data, gpointer parser_data);
 
 typedef struct {
 	NMNLInfoDataParser parser;
 	gpointer parser_data;
+	int info_type;
 } NMNLInfoDataClosure;
 
 static struct nla_policy info_data_link_policy[IFLA_MAX + 1] = {
 	[IFLA_LINKINFO] = { .type = NLA_NESTED },
 };
 
-static struct nla_policy info_data_link_info_policy[IFLA_INFO_MAX + 1] = {
-	[IFLA_INFO_DATA] = { .type = NLA_NESTED },
+static struct nla_policy info_data_link_info_policy[NM_IFLA_INFO_MAX + 1] = {
+	[IFLA_INFO_DATA]          = { .type = NLA_NESTED },
+	[NM_IFLA_INFO_SLAVE_DATA] = { .type = NLA_NESTED },
 };
 
 static int
@@ -524,7 +540,7 @@ info_data_parser (struct nl_msg *msg, void *arg)
 	NMNLInfoDataClosure *closure = arg;
 	struct nlmsghdr *n = nlmsg_hdr (msg);
 	struct nlattr *tb[IFLA_MAX + 1];
-	struct nlattr *li[IFLA_INFO_MAX + 1];
+	struct nlattr *li[NM_IFLA_INFO_MAX + 1];
 	int err;
 
 	if (!nlmsg_valid_hdr (n, sizeof (struct ifinfomsg)))
@@ -537,21 +553,21 @@ info_data_parser (struct nl_msg *msg, void *arg)
 	if (!tb[IFLA_LINKINFO])
 		return -NLE_MISSING_ATTR;
 
-	err = nla_parse_nested (li, IFLA_INFO_MAX, tb[IFLA_LINKINFO], info_data_link_info_policy);
+	err = nla_parse_nested (li, NM_IFLA_INFO_MAX, tb[IFLA_LINKINFO], info_data_link_info_policy);
 	if (err < 0)
 		return err;
 
-	if (!li[IFLA_INFO_DATA])
+	if (!li[closure->info_type])
 		return -NLE_MISSING_ATTR;
 
-	return closure->parser (li[IFLA_INFO_DATA], closure->parser_data);
+	return closure->parser (li[closure->info_type], closure->parser_data);
 }
 
 static int
-nm_rtnl_link_parse_info_data (struct nl_sock *sk, int ifindex,
-                              NMNLInfoDataParser parser, gpointer parser_data)
+_rtnl_link_parse_info (struct nl_sock *sk, int ifindex, int info_type,
+                       NMNLInfoDataParser parser, gpointer parser_data)
 {
-	NMNLInfoDataClosure data = { .parser = parser, .parser_data = parser_data };
+	NMNLInfoDataClosure data = { .parser = parser, .parser_data = parser_data, .info_type = info_type };
 	struct nl_msg *msg = NULL;
 	struct nl_cb *cb;
 	int err;
@@ -579,6 +595,20 @@ nm_rtnl_link_parse_info_data (struct nl_sock *sk, int ifindex,
 	return 0;
 }
 
+static int
+nm_rtnl_link_parse_info_data (struct nl_sock *sk, int ifindex,
+                              NMNLInfoDataParser parser, gpointer parser_data)
+{
+	return _rtnl_link_parse_info (sk, ifindex, IFLA_INFO_DATA, parser, parser_data);
+}
+
+static int
+nm_rtnl_link_parse_info_slave_data (struct nl_sock *sk, int ifindex,
+                                    NMNLInfoDataParser parser, gpointer parser_data)
+{
+	return _rtnl_link_parse_info (sk, ifindex, NM_IFLA_INFO_SLAVE_DATA, parser, parser_data);
+}
+
 /******************************************************************/
 
 static gboolean
@@ -2111,6 +2141,77 @@ _log_dbg_sysctl_set_impl (const char *path, const char *value)
 		} \
 	} G_STMT_END
 
+/* Per-interface sysctls are opened relative to a cached handle of their
+ * directory, which saves the kernel the path walk on every access.  The
+ * handles are dropped when the interface goes away or is renamed; a handle
+ * that went stale without us noticing fails with ENOENT, in which case the
+ * path is opened directly.
+ */
+typedef struct {
+	int fd;
+	char ifname[IFNAMSIZ];
+} SysctlDir;
+
+static void
+sysctl_dir_free (gpointer data)
+{
+	SysctlDir *dir = data;
+
+	close (dir->fd);
+	g_slice_free (SysctlDir, dir);
+}
+
+static int
+sysctl_open (NMPlatform *platform, const char *path, int flags)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	char ifname[IFNAMSIZ];
+	char dirpath[64];
+	SysctlDir *dir;
+	gsize dirlen;
+	int fd;
+
+	if (   !nm_platform_sysctl_split_iface_path (path, ifname, &dirlen)
+	    || dirlen >= sizeof (dirpath))
+		return open (path, flags);
+
+	memcpy (dirpath, path, dirlen);
+	dirpath[dirlen] = '\0';
+
+	dir = g_hash_table_lookup (priv->sysctl_dirs, dirpath);
+	if (!dir) {
+		fd = open (dirpath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (fd == -1)
+			return open (path, flags);
+
+		dir = g_slice_new (SysctlDir);
+		dir->fd = fd;
+		g_strlcpy (dir->ifname, ifname, sizeof (dir->ifname));
+		g_hash_table_insert (priv->sysctl_dirs, g_strdup (dirpath), dir);
+	}
+
+	fd = openat (dir->fd, path + dirlen + 1, flags);
+	if (fd == -1 && errno == ENOENT) {
+		g_hash_table_remove (priv->sysctl_dirs, dirpath);
+		fd = open (path, flags);
+	}
+	return fd;
+}
+
+static void
+sysctl_flush_iface (NMPlatform *platform, const char *ifname)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	GHashTableIter iter;
+	SysctlDir *dir;
+
+	g_hash_table_iter_init (&iter, priv->sysctl_dirs);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &dir)) {
+		if (!strcmp (dir->ifname, ifname))
+			g_hash_table_iter_remove (&iter);
+	}
+}
+
 static gboolean
 sysctl_set (NMPlatform *platform, const char *path, const char *value)
 {
@@ -2126,7 +2227,7 @@ sysctl_set (NMPlatform *platform, const char *path, const char *value)
 	/* Don't write to suspicious locations */
 	g_assert (!strstr (path, "/../"));
 
-	fd = open (path, O_WRONLY | O_TRUNC);
+	fd = sysctl_open (platform, path, O_WRONLY | O_TRUNC);
 	if (fd == -1) {
 		if (errno == ENOENT) {
 			debug ("sysctl: failed to open '%s': (%d) %s",
@@ -2213,11 +2314,50 @@ _log_dbg_sysctl_get_impl (const char *path, const char *contents)
 		} \
 	} G_STMT_END
 
+static char *
+sysctl_read_iface_option (NMPlatform *platform, const char *path)
+{
+	GString *contents;
+	char buf[256];
+	ssize_t n;
+	int fd, errsv;
+
+	fd = sysctl_open (platform, path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		goto fail;
+
+	contents = g_string_sized_new (32);
+	for (;;) {
+		n = read (fd, buf, sizeof (buf));
+		if (n > 0)
+			g_string_append_len (contents, buf, n);
+		else if (n == 0)
+			break;
+		else if (errno != EINTR) {
+			errsv = errno;
+			g_string_free (contents, TRUE);
+			close (fd);
+			errno = errsv;
+			goto fail;
+		}
+	}
+	close (fd);
+	return g_string_free (contents, FALSE);
+
+fail:
+	if (errno == ENOENT || errno == EOPNOTSUPP)
+		debug ("error reading %s: %s", path, strerror (errno));
+	else
+		error ("error reading %s: %s", path, strerror (errno));
+	return NULL;
+}
+
 static char *
 sysctl_get (NMPlatform *platform, const char *path)
 {
 	GError *error = NULL;
 	char *contents;
+	char ifname[IFNAMSIZ];
 
 	/* Don't write outside known locations */
 	g_assert (g_str_has_prefix (path, "/proc/sys/")
@@ -2225,7 +2365,11 @@ sysctl_get (NMPlatform *platform, const char *path)
 	/* Don't write to suspicious locations */
 	g_assert (!strstr (path, "/../"));
 
-	if (!g_file_get_contents (path, &contents, NULL, &error)) {
+	if (nm_platform_sysctl_split_iface_path (path, ifname, NULL)) {
+		contents = sysctl_read_iface_option (platform, path);
+		if (!contents)
+			return NULL;
+	} else if (!g_file_get_contents (path, &contents, NULL, &error)) {
 		/* We assume FAILED means EOPNOTSUP */
 		if (   g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)
 		    || g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_FAILED))
@@ -2950,6 +3094,395 @@ slave_get_option (NMPlatform *platform, int slave, const char *option)
 	return link_get_option (slave, slave_category (platform, slave), option);
 }
 
+/* Bond and bridge options that can be programmed with a single RTM_NEWLINK
+ * through IFLA_INFO_DATA, or IFLA_INFO_SLAVE_DATA for bridge ports.  The
+ * attribute numbers are kernel ABI and are spelled out here because older
+ * kernel headers lack some or all of them.  Options without an entry (like
+ * the bond's "primary" and "arp_ip_target") always go through sysfs.
+ */
+#define NM_IFLA_BOND_MODE              1
+#define NM_IFLA_BOND_MIIMON            3
+#define NM_IFLA_BOND_UPDELAY           4
+#define NM_IFLA_BOND_DOWNDELAY         5
+#define NM_IFLA_BOND_USE_CARRIER       6
+#define NM_IFLA_BOND_ARP_INTERVAL      7
+#define NM_IFLA_BOND_ARP_VALIDATE      9
+#define NM_IFLA_BOND_PRIMARY_RESELECT 12
+#define NM_IFLA_BOND_FAIL_OVER_MAC    13
+#define NM_IFLA_BOND_XMIT_HASH_POLICY 14
+#define NM_IFLA_BOND_RESEND_IGMP      15
+#define NM_IFLA_BOND_AD_LACP_RATE     21
+#define NM_IFLA_BOND_AD_SELECT        22
+
+#define NM_IFLA_BR_FORWARD_DELAY       1
+#define NM_IFLA_BR_HELLO_TIME          2
+#define NM_IFLA_BR_MAX_AGE             3
+#define NM_IFLA_BR_AGEING_TIME         4
+#define NM_IFLA_BR_STP_STATE           5
+#define NM_IFLA_BR_PRIORITY            6
+
+#define NM_IFLA_BRPORT_PRIORITY        2
+#define NM_IFLA_BRPORT_COST            3
+#define NM_IFLA_BRPORT_MODE            4
+
+typedef struct {
+	const char *option;
+	int attr;
+	int type;
+	/* value names as sysfs accepts and prints them, indexed by value */
+	const char *const *names;
+} LinkOptionAttr;
+
+static const char *const bond_mode_names[] = {
+	"balance-rr", "active-backup", "balance-xor", "broadcast",
+	"802.3ad", "balance-tlb", "balance-alb", NULL
+};
+static const char *const bond_arp_validate_names[] = {
+	"none", "active", "backup", "all",
+	"filter", "filter_active", "filter_backup", NULL
+};
+static const char *const bond_primary_reselect_names[] = { "always", "better", "failure", NULL };
+static const char *const bond_fail_over_mac_names[] = { "none", "active", "follow", NULL };
+static const char *const bond_xmit_hash_policy_names[] = {
+	"layer2", "layer3+4", "layer2+3", "encap2+3", "encap3+4", NULL
+};
+static const char *const bond_lacp_rate_names[] = { "slow", "fast", NULL };
+static const char *const bond_ad_select_names[] = { "stable", "bandwidth", "count", NULL };
+
+static const LinkOptionAttr bond_option_attrs[] = {
+	{ "mode",             NM_IFLA_BOND_MODE,             NLA_U8,  bond_mode_names },
+	{ "miimon",           NM_IFLA_BOND_MIIMON,           NLA_U32 },
+	{ "updelay",          NM_IFLA_BOND_UPDELAY,          NLA_U32 },
+	{ "downdelay",        NM_IFLA_BOND_DOWNDELAY,        NLA_U32 },
+	{ "use_carrier",      NM_IFLA_BOND_USE_CARRIER,      NLA_U8 },
+	{ "arp_interval",     NM_IFLA_BOND_ARP_INTERVAL,     NLA_U32 },
+	{ "arp_validate",     NM_IFLA_BOND_ARP_VALIDATE,     NLA_U32, bond_arp_validate_names },
+	{ "primary_reselect", NM_IFLA_BOND_PRIMARY_RESELECT, NLA_U8,  bond_primary_reselect_names },
+	{ "fail_over_mac",    NM_IFLA_BOND_FAIL_OVER_MAC,    NLA_U8,  bond_fail_over_mac_names },
+	{ "xmit_hash_policy", NM_IFLA_BOND_XMIT_HASH_POLICY, NLA_U8,  bond_xmit_hash_policy_names },
+	{ "resend_igmp",      NM_IFLA_BOND_RESEND_IGMP,      NLA_U32 },
+	{ "lacp_rate",        NM_IFLA_BOND_AD_LACP_RATE,     NLA_U8,  bond_lacp_rate_names },
+	{ "ad_select",        NM_IFLA_BOND_AD_SELECT,        NLA_U8,  bond_ad_select_names },
+	{ NULL }
+};
+
+static const LinkOptionAttr bridge_option_attrs[] = {
+	{ "forward_delay",    NM_IFLA_BR_FORWARD_DELAY,      NLA_U32 },
+	{ "hello_time",       NM_IFLA_BR_HELLO_TIME,         NLA_U32 },
+	{ "max_age",          NM_IFLA_BR_MAX_AGE,            NLA_U32 },
+	{ "ageing_time",      NM_IFLA_BR_AGEING_TIME,        NLA_U32 },
+	{ "stp_state",        NM_IFLA_BR_STP_STATE,          NLA_U32 },
+	{ "priority",         NM_IFLA_BR_PRIORITY,           NLA_U16 },
+	{ NULL }
+};
+
+static const LinkOptionAttr brport_option_attrs[] = {
+	{ "priority",         NM_IFLA_BRPORT_PRIORITY,       NLA_U16 },
+	{ "path_cost",        NM_IFLA_BRPORT_COST,           NLA_U32 },
+	{ "hairpin_mode",     NM_IFLA_BRPORT_MODE,           NLA_U8 },
+	{ NULL }
+};
+
+#define LINK_OPTION_ATTR_BIT(attr) (G_GUINT64_CONSTANT (1) << (attr)->attr)
+
+static const LinkOptionAttr *
+link_option_attrs (const char *category, const char **out_kind)
+{
+	if (!g_strcmp0 (category, "bonding")) {
+		*out_kind = "bond";
+		return bond_option_attrs;
+	} else if (!g_strcmp0 (category, "bridge")) {
+		*out_kind = "bridge";
+		return bridge_option_attrs;
+	} else if (!g_strcmp0 (category, "brport")) {
+		*out_kind = "bridge";
+		return brport_option_attrs;
+	}
+	return NULL;
+}
+
+static const LinkOptionAttr *
+link_option_attr_by_name (const LinkOptionAttr *attrs, const char *option)
+{
+	for (; attrs->option; attrs++) {
+		if (!strcmp (attrs->option, option))
+			return attrs;
+	}
+	return NULL;
+}
+
+static const LinkOptionAttr *
+link_option_attr_by_type (const LinkOptionAttr *attrs, int type)
+{
+	for (; attrs->option; attrs++) {
+		if (attrs->attr == type)
+			return attrs;
+	}
+	return NULL;
+}
+
+/* Converts a sysfs-style value to the number the kernel expects.  Values we
+ * can't convert are left to sysfs, which validates them itself.
+ */
+static gboolean
+link_option_encode (const LinkOptionAttr *attr, const char *value, guint32 *out_value)
+{
+	guint64 num, max;
+	char *end;
+	guint i;
+
+	if (attr->names) {
+		for (i = 0; attr->names[i]; i++) {
+			if (!strcmp (attr->names[i], value)) {
+				*out_value = i;
+				return TRUE;
+			}
+		}
+	}
+
+	if (!g_ascii_isdigit (value[0]))
+		return FALSE;
+	errno = 0;
+	num = g_ascii_strtoull (value, &end, 10);
+	if (errno || *end)
+		return FALSE;
+
+	switch (attr->type) {
+	case NLA_U8:
+		max = G_MAXUINT8;
+		break;
+	case NLA_U16:
+		max = G_MAXUINT16;
+		break;
+	default:
+		max = G_MAXUINT32;
+		break;
+	}
+	if (num > max)
+		return FALSE;
+
+	*out_value = num;
+	return TRUE;
+}
+
+/* Formats a value the way the corresponding sysfs file prints it. */
+static char *
+link_option_decode (const LinkOptionAttr *attr, guint32 value)
+{
+	if (attr->names && value < g_strv_length ((char **) attr->names))
+		return g_strdup_printf ("%s %u", attr->names[value], value);
+	return g_strdup_printf ("%u", value);
+}
+
+typedef struct {
+	const LinkOptionAttr *attrs;
+	GHashTable *values;
+	guint64 present;
+} LinkOptionsParseData;
+
+static int
+link_options_parser (struct nlattr *info_data, gpointer parser_data)
+{
+	LinkOptionsParseData *data = parser_data;
+	const LinkOptionAttr *attr;
+	struct nlattr *nla;
+	guint32 value;
+	int rem;
+
+	nla_for_each_nested (nla, info_data, rem) {
+		attr = link_option_attr_by_type (data->attrs, nla_type (nla));
+		if (!attr)
+			continue;
+
+		switch (attr->type) {
+		case NLA_U8:
+			if (nla_len (nla) < (int) sizeof (guint8))
+				continue;
+			value = nla_get_u8 (nla);
+			break;
+		case NLA_U16:
+			if (nla_len (nla) < (int) sizeof (guint16))
+				continue;
+			value = nla_get_u16 (nla);
+			break;
+		default:
+			if (nla_len (nla) < (int) sizeof (guint32))
+				continue;
+			value = nla_get_u32 (nla);
+			break;
+		}
+
+		data->present |= LINK_OPTION_ATTR_BIT (attr);
+		if (data->values)
+			g_hash_table_insert (data->values, (char *) attr->option, link_option_decode (attr, value));
+	}
+	return 0;
+}
+
+static gboolean
+link_read_options (NMPlatform *platform, int ifindex, gboolean slave, LinkOptionsParseData *data)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	int err;
+
+	if (slave)
+		err = nm_rtnl_link_parse_info_slave_data (priv->nlh, ifindex, link_options_parser, data);
+	else
+		err = nm_rtnl_link_parse_info_data (priv->nlh, ifindex, link_options_parser, data);
+	if (err < 0) {
+		debug ("link: could not read options of %d: %s", ifindex, nl_geterror (err));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static GHashTable *
+link_get_options (NMPlatform *platform, int ifindex, const char *category, gboolean slave)
+{
+	LinkOptionsParseData data = { 0 };
+	const char *kind;
+
+	data.attrs = link_option_attrs (category, &kind);
+	if (!data.attrs)
+		return NULL;
+
+	data.values = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+	if (!link_read_options (platform, ifindex, slave, &data)) {
+		g_hash_table_unref (data.values);
+		return NULL;
+	}
+	return data.values;
+}
+
+/* Sends all options that have a netlink attribute in one RTM_NEWLINK.
+ * Kernels without changelink support for the link type reject the whole
+ * request, and kernels that predate a single attribute silently ignore it,
+ * so afterwards the options are read back and whatever the kernel did not
+ * report is written through sysfs, together with the options that have no
+ * attribute at all.
+ */
+static gboolean
+link_set_options (NMPlatform *platform,
+                  int ifindex,
+                  const char *category,
+                  gboolean slave,
+                  const NMPlatformLinkOption *options,
+                  guint n_options)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	struct ifinfomsg ifi = { .ifi_family = AF_UNSPEC, .ifi_index = ifindex };
+	LinkOptionsParseData data = { 0 };
+	gs_free gboolean *sent = g_new0 (gboolean, n_options);
+	const LinkOptionAttr *attr;
+	struct nlattr *linkinfo, *info_data;
+	struct nl_msg *msg = NULL;
+	const char *kind = NULL;
+	gboolean success = TRUE;
+	guint i, n_sent = 0;
+	guint32 value;
+	int nle;
+
+	data.attrs = category ? link_option_attrs (category, &kind) : NULL;
+	if (!data.attrs)
+		goto sysfs;
+
+	msg = nlmsg_alloc_simple (RTM_NEWLINK, 0);
+	if (!msg)
+		goto sysfs;
+	if (nlmsg_append (msg, &ifi, sizeof (ifi), NLMSG_ALIGNTO) < 0)
+		goto nla_put_failure;
+	if (!(linkinfo = nla_nest_start (msg, IFLA_LINKINFO)))
+		goto nla_put_failure;
+	if (!slave && nla_put_string (msg, IFLA_INFO_KIND, kind) < 0)
+		goto nla_put_failure;
+	if (!(info_data = nla_nest_start (msg, slave ? NM_IFLA_INFO_SLAVE_DATA : IFLA_INFO_DATA)))
+		goto nla_put_failure;
+
+	for (i = 0; i < n_options; i++) {
+		attr = link_option_attr_by_name (data.attrs, options[i].option);
+		if (!attr || !link_option_encode (attr, options[i].value, &value))
+			continue;
+
+		switch (attr->type) {
+		case NLA_U8:
+			nle = nla_put_u8 (msg, attr->attr, value);
+			break;
+		case NLA_U16:
+			nle = nla_put_u16 (msg, attr->attr, value);
+			break;
+		default:
+			nle = nla_put_u32 (msg, attr->attr, value);
+			break;
+		}
+		if (nle < 0)
+			goto nla_put_failure;
+		sent[i] = TRUE;
+		n_sent++;
+	}
+
+	nla_nest_end (msg, info_data);
+	nla_nest_end (msg, linkinfo);
+
+	if (n_sent) {
+		nle = nl_send_sync (priv->nlh, msg);
+		msg = NULL;
+		if (nle < 0) {
+			debug ("link: could not set %s options on %d via netlink: %s",
+			       category, ifindex, nl_geterror (nle));
+			memset (sent, 0, sizeof (gboolean) * n_options);
+		} else {
+			link_read_options (platform, ifindex, slave, &data);
+			for (i = 0; i < n_options; i++) {
+				attr = link_option_attr_by_name (data.attrs, options[i].option);
+				if (sent[i] && !(data.present & LINK_OPTION_ATTR_BIT (attr)))
+					sent[i] = FALSE;
+			}
+		}
+	}
+	goto sysfs;
+
+nla_put_failure:
+	memset (sent, 0, sizeof (gboolean) * n_options);
+sysfs:
+	if (msg)
+		nlmsg_free (msg);
+
+	for (i = 0; i < n_options; i++) {
+		if (sent[i])
+			continue;
+		if (!link_set_option (ifindex, category, options[i].option, options[i].value)) {
+			debug ("link: failed to set %s option '%s' to '%s' on %d",
+			       category ? category : "(unknown)", options[i].option, options[i].value, ifindex);
+			success = FALSE;
+		}
+	}
+	return success;
+}
+
+static gboolean
+master_set_options (NMPlatform *platform, int master, const NMPlatformLinkOption *options, guint n_options)
+{
+	return link_set_options (platform, master, master_category (platform, master), FALSE, options, n_options);
+}
+
+static GHashTable *
+master_get_options (NMPlatform *platform, int master)
+{
+	return link_get_options (platform, master, master_category (platform, master), FALSE);
+}
+
+static gboolean
+slave_set_options (NMPlatform *platform, int slave, const NMPlatformLinkOption *options, guint n_options)
+{
+	return link_set_options (platform, slave, slave_category (platform, slave), TRUE, options, n_options);
+}
+
+static GHashTable *
+slave_get_options (NMPlatform *platform, int slave)
+{
+	return link_get_options (platform, slave, slave_category (platform, slave), TRUE);
+}
+
 static gboolean
 infiniband_partition_add (NMPlatform *platform, int parent, int p_key)
 {
@@ -3426,6 +3959,29 @@ wifi_get_mode (NMPlatform *platform, int ifindex)
 	return wifi_utils_get_mode (wifi_data);
 }
 
+static gboolean
+wifi_get_link_info (NMPlatform *platform, int ifindex, NMPlatformWifiLinkInfo *info)
+{
+	WifiData *wifi_data = wifi_get_wifi_data (platform, ifindex);
+	WifiLinkInfo link_info;
+
+	if (!wifi_data)
+		return FALSE;
+
+	if (!wifi_utils_get_link_info (wifi_data, &link_info))
+		return FALSE;
+
+	info->mode = link_info.mode;
+	info->associated = link_info.associated;
+	memcpy (info->bssid, link_info.bssid, sizeof (info->bssid));
+	memcpy (info->ssid, link_info.ssid, link_info.ssid_len);
+	info->ssid_len = link_info.ssid_len;
+	info->frequency = link_info.freq;
+	info->rate = link_info.rate;
+	info->quality = link_info.qual;
+	return TRUE;
+}
+
 static void
 wifi_set_mode (NMPlatform *platform, int ifindex, NM80211Mode mode)
 {
@@ -4143,35 +4699,43 @@ init_link_cache (NMPlatform *platform)
 
 /* Calls announce_object with appropriate arguments for all objects
  * which are not coherent between old and new caches and deallocates
- * the old cache. */
-static void
+ * the old cache. Objects that did not change while we were out of sync
+ * are not announced again. Returns the number of announced objects. */
+static guint
 cache_announce_changes (NMPlatform *platform, struct nl_cache *new, struct nl_cache *old)
 {
 	struct nl_object *object;
+	guint announced = 0;
 
 	if (!old)
-		return;
+		return 0;
 
 	for (object = nl_cache_get_first (new); object; object = nl_cache_get_next (object)) {
 		struct nl_object *cached_object = nm_nl_cache_search (old, object);
 
 		if (cached_object) {
 			ObjectType type = object_type_from_nl_object (object);
-			if (nm_nl_object_diff (type, object, cached_object))
+			if (nm_nl_object_diff (type, object, cached_object)) {
 				announce_object (platform, object, NM_PLATFORM_SIGNAL_CHANGED, NM_PLATFORM_REASON_EXTERNAL);
+				announced++;
+			}
+			/* Drop the match from the old cache, so that whatever remains
+			 * there afterwards is exactly the set of removed objects and
+			 * we don't need a second round of lookups. */
+			nl_cache_remove (cached_object);
 			nl_object_put (cached_object);
-		} else
+		} else {
 			announce_object (platform, object, NM_PLATFORM_SIGNAL_ADDED, NM_PLATFORM_REASON_EXTERNAL);
+			announced++;
+		}
 	}
 	for (object = nl_cache_get_first (old); object; object = nl_cache_get_next (object)) {
-		struct nl_object *cached_object = nm_nl_cache_search (new, object);
-		if (cached_object)
-			nl_object_put (cached_object);
-		else
-			announce_object (platform, object, NM_PLATFORM_SIGNAL_REMOVED, NM_PLATFORM_REASON_EXTERNAL);
+		announce_object (platform, object, NM_PLATFORM_SIGNAL_REMOVED, NM_PLATFORM_REASON_EXTERNAL);
+		announced++;
 	}
 
 	nl_cache_free (old);
+	return announced;
 }
 
 /* The cache should always avoid containing objects not handled by NM, like
@@ -4213,6 +4777,9 @@ cache_repopulate_all (NMPlatform *platform)
 	struct nl_cache *old_address_cache = priv->address_cache;
 	struct nl_cache *old_route_cache = priv->route_cache;
 	struct nl_object *object;
+	gint64 start = g_get_monotonic_time ();
+	guint announced = 0;
+	guint64 duration;
 
 	debug ("platform: %spopulate platform cache", old_link_cache ? "re" : "");
 
@@ -4232,9 +4799,30 @@ cache_repopulate_all (NMPlatform *platform)
 	}
 
 	/* Make sure all changes we've missed are announced. */
-	cache_announce_changes (platform, priv->link_cache, old_link_cache);
-	cache_announce_changes (platform, priv->address_cache, old_address_cache);
-	cache_announce_changes (platform, priv->route_cache, old_route_cache);
+	announced += cache_announce_changes (platform, priv->link_cache, old_link_cache);
+	announced += cache_announce_changes (platform, priv->address_cache, old_address_cache);
+	announced += cache_announce_changes (platform, priv->route_cache, old_route_cache);
+
+	if (!old_link_cache)
+		return;
+
+	duration = g_get_monotonic_time () - start;
+	priv->netlink_stats.resyncs++;
+	priv->netlink_stats.resync_last_usec = duration;
+	priv->netlink_stats.resync_max_usec = MAX (priv->netlink_stats.resync_max_usec, duration);
+	priv->netlink_stats.resync_last_announced = announced;
+
+	nm_log_info (LOGD_PLATFORM, "platform: resynchronized cache in %" G_GUINT64_FORMAT " ms, "
+	             "%u objects changed (resync #%u, longest %" G_GUINT64_FORMAT " ms)",
+	             duration / 1000, announced, priv->netlink_stats.resyncs,
+	             priv->netlink_stats.resync_max_usec / 1000);
+}
+
+static gboolean
+get_netlink_stats (NMPlatform *platform, NMPlatformNetlinkStats *stats)
+{
+	*stats = NM_LINUX_PLATFORM_GET_PRIVATE (platform)->netlink_stats;
+	return TRUE;
 }
 
 /******************************************************************/
@@ -4243,6 +4831,33 @@ cache_repopulate_all (NMPlatform *platform)
 #define ERROR_CONDITIONS      ((GIOCondition) (G_IO_ERR | G_IO_NVAL))
 #define DISCONNECT_CONDITIONS ((GIOCondition) (G_IO_HUP))
 
+/* The event socket starts with a buffer that is enough for a handful of
+ * interfaces and doubles on every overflow, up to this limit. */
+#define EVENT_RCVBUF_INITIAL  (256 * 1024)
+#define EVENT_RCVBUF_MAX      (8 * 1024 * 1024)
+
+/* Sets the receive buffer of the event socket. SO_RCVBUFFORCE lets a
+ * privileged process exceed net.core.rmem_max; without CAP_NET_ADMIN fall
+ * back to SO_RCVBUF, which the kernel silently caps. */
+static void
+event_socket_set_rcvbuf (NMLinuxPlatformPrivate *priv, int size)
+{
+	int fd = nl_socket_get_fd (priv->nlh_event);
+	int actual = 0;
+	socklen_t len = sizeof (actual);
+
+	if (setsockopt (fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof (size)) < 0) {
+		if (setsockopt (fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof (size)) < 0)
+			warning ("netlink: failed to set receive buffer size to %d: %s", size, strerror (errno));
+	}
+	priv->event_rcvbuf = size;
+
+	/* The kernel doubles the value to account for bookkeeping overhead */
+	if (getsockopt (fd, SOL_SOCKET, SO_RCVBUF, &actual, &len) == 0)
+		priv->netlink_stats.rcvbuf_size = actual;
+	debug ("netlink: event socket receive buffer is %d bytes (requested %d)", actual, size);
+}
+
 static int
 verify_source (struct nl_msg *msg, gpointer user_data)
 {
@@ -4279,7 +4894,13 @@ event_handler (GIOChannel *channel,
 			debug ("Uncritical failure to retrieve incoming events: %s (%d)", nl_geterror (nle), nle);
 			break;
 		case -NLE_NOMEM:
-			warning ("Too many netlink events. Need to resynchronize platform cache");
+			priv->netlink_stats.overflows++;
+			warning ("Too many netlink events (overflow #%u). Need to resynchronize platform cache",
+			         priv->netlink_stats.overflows);
+			/* Grow the buffer first, so that the events generated while we
+			 * dump the kernel state don't overflow it right away again. */
+			if (priv->event_rcvbuf < EVENT_RCVBUF_MAX)
+				event_socket_set_rcvbuf (priv, MIN (priv->event_rcvbuf * 2, EVENT_RCVBUF_MAX));
 			/* Drain the event queue, we've lost events and are out of sync anyway and we'd
 			 * like to free up some space. We'll read in the status synchronously. */
 			nl_socket_modify_cb (priv->nlh_event, NL_CB_VALID, NL_CB_DEFAULT, NULL, NULL);
@@ -4458,6 +5079,9 @@ handle_udev_event (GUdevClient *client,
 static void
 nm_linux_platform_init (NMLinuxPlatform *platform)
 {
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	priv->sysctl_dirs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, sysctl_dir_free);
 }
 
 static gboolean
@@ -4482,12 +5106,9 @@ setup (NMPlatform *platform)
 	/* Initialize netlink socket for events */
 	priv->nlh_event = setup_socket (TRUE, platform);
 	g_assert (priv->nlh_event);
-	/* The default buffer size wasn't enough for the testsuites. It might just
-	 * as well happen with NetworkManager itself. For now let's hope 128KB is
-	 * good enough.
-	 */
-	nle = nl_socket_set_buffer_size (priv->nlh_event, 131072, 0);
-	g_assert (!nle);
+	/* The default buffer size isn't enough for the testsuites nor for hosts
+	 * with many interfaces or routes; start bigger and grow on overflow. */
+	event_socket_set_rcvbuf (priv, EVENT_RCVBUF_INITIAL);
 	nle = nl_socket_add_memberships (priv->nlh_event,
 	                                 RTNLGRP_LINK,
 	                                 RTNLGRP_IPV4_IFADDR, RTNLGRP_IPV6_IFADDR,
@@ -4574,6 +5195,7 @@ nm_linux_platform_finalize (GObject *object)
 	g_object_unref (priv->udev_client);
 	g_hash_table_unref (priv->udev_devices);
 	g_hash_table_unref (priv->wifi_data);
+	g_hash_table_unref (priv->sysctl_dirs);
 
 	G_OBJECT_CLASS (nm_linux_platform_parent_class)->finalize (object);
 }
@@ -4595,6 +5217,7 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 
 	platform_class->sysctl_set = sysctl_set;
 	platform_class->sysctl_get = sysctl_get;
+	platform_class->sysctl_flush_iface = sysctl_flush_iface;
 
 	platform_class->link_get = _nm_platform_link_get;
 	platform_class->link_get_all = link_get_all;
@@ -4638,6 +5261,10 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	platform_class->master_get_option = master_get_option;
 	platform_class->slave_set_option = slave_set_option;
 	platform_class->slave_get_option = slave_get_option;
+	platform_class->master_set_options = master_set_options;
+	platform_class->master_get_options = master_get_options;
+	platform_class->slave_set_options = slave_set_options;
+	platform_class->slave_get_options = slave_get_options;
 
 	platform_class->vlan_add = vlan_add;
 	platform_class->vlan_get_info = vlan_get_info;
@@ -4659,6 +5286,7 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	platform_class->wifi_get_quality = wifi_get_quality;
 	platform_class->wifi_get_rate = wifi_get_rate;
 	platform_class->wifi_get_mode = wifi_get_mode;
+	platform_class->wifi_get_link_info = wifi_get_link_info;
 	platform_class->wifi_set_mode = wifi_set_mode;
 	platform_class->wifi_set_powersave = wifi_set_powersave;
 	platform_class->wifi_find_frequency = wifi_find_frequency;
@@ -4689,5 +5317,6 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	platform_class->ip6_route_exists = ip6_route_exists;
 
 	platform_class->check_support_kernel_extended_ifa_flags = check_support_kernel_extended_ifa_flags;
+	platform_class->get_netlink_stats = get_netlink_stats;
 	platform_class->check_support_user_ipv6ll = check_support_user_ipv6ll;
 }
@@ -40,6 +40,26 @@
 
 #define NM_PLATFORM_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_PLATFORM, NMPlatformPrivate))
 
+typedef struct {
+	char name[IFNAMSIZ];
+	guint mtu;
+} SysctlLink;
+
+typedef struct {
+	/* Last value written or read for per-interface sysctls, as
+	 * interface name -> (path -> value).
+	 */
+	GHashTable *sysctl_cache;
+	/* ifindex -> SysctlLink, to notice renames and MTU changes */
+	GHashTable *sysctl_links;
+	guint sysctl_writes_skipped;
+
+	/* ifindex -> IPSnapshot */
+	GHashTable *ip_snapshots;
+	guint ip_snapshot_hits;
+	guint ip_snapshot_misses;
+} NMPlatformPrivate;
+
 G_DEFINE_TYPE (NMPlatform, nm_platform, G_TYPE_OBJECT)
 
 /* NMPlatform signals */
@@ -233,8 +253,391 @@ nm_platform_check_support_user_ipv6ll (void)
 	return !!supported;
 }
 
+/**
+ * nm_platform_get_netlink_stats:
+ * @stats: (out): location for the event socket counters
+ *
+ * Returns: %TRUE if the platform implementation keeps such counters and
+ * @stats was filled, %FALSE otherwise.
+ */
+gboolean
+nm_platform_get_netlink_stats (NMPlatformNetlinkStats *stats)
+{
+	g_return_val_if_fail (NM_IS_PLATFORM (platform), FALSE);
+	g_return_val_if_fail (stats, FALSE);
+
+	memset (stats, 0, sizeof (*stats));
+	if (!klass->get_netlink_stats)
+		return FALSE;
+
+	return klass->get_netlink_stats (platform, stats);
+}
+
 /******************************************************************/
 
+/* Per-interface sysctls that the kernel changes on its own, for example
+ * from router advertisements or when the link MTU changes.  Their values
+ * are never cached.
+ */
+static const char *sysctl_volatile_options[] = {
+	"forwarding",
+	"hop_limit",
+	"mtu",
+};
+
+/**
+ * nm_platform_sysctl_split_iface_path:
+ * @path: Absolute sysctl path
+ * @out_ifname: buffer of at least %IFNAMSIZ bytes for the interface name
+ * @out_dirlen: (allow-none): location for the length of the directory part
+ *
+ * Checks whether @path is a per-interface IPv4 or IPv6 option like
+ * /proc/sys/net/ipv6/conf/eth0/accept_ra.  The "all" and "default"
+ * directories don't belong to an interface.
+ *
+ * Returns: %TRUE if @path is a per-interface option.
+ */
+gboolean
+nm_platform_sysctl_split_iface_path (const char *path, char *out_ifname, gsize *out_dirlen)
+{
+	static const char *prefixes[] = {
+		"/proc/sys/net/ipv4/conf/",
+		"/proc/sys/net/ipv6/conf/",
+	};
+	const char *ifname = NULL, *slash;
+	gsize len;
+	guint i;
+
+	g_return_val_if_fail (path, FALSE);
+	g_return_val_if_fail (out_ifname, FALSE);
+
+	for (i = 0; i < G_N_ELEMENTS (prefixes); i++) {
+		if (g_str_has_prefix (path, prefixes[i])) {
+			ifname = path + strlen (prefixes[i]);
+			break;
+		}
+	}
+	if (!ifname)
+		return FALSE;
+
+	slash = strchr (ifname, '/');
+	if (!slash || !slash[1] || strchr (slash + 1, '/'))
+		return FALSE;
+	len = slash - ifname;
+	if (len == 0 || len >= IFNAMSIZ)
+		return FALSE;
+
+	memcpy (out_ifname, ifname, len);
+	out_ifname[len] = '\0';
+	if (!strcmp (out_ifname, "all") || !strcmp (out_ifname, "default"))
+		return FALSE;
+
+	if (out_dirlen)
+		*out_dirlen = slash - path;
+	return TRUE;
+}
+
+static gboolean
+sysctl_cache_path (const char *path, char *out_ifname)
+{
+	const char *option;
+	guint i;
+
+	if (!nm_platform_sysctl_split_iface_path (path, out_ifname, NULL))
+		return FALSE;
+
+	option = strrchr (path, '/') + 1;
+	for (i = 0; i < G_N_ELEMENTS (sysctl_volatile_options); i++) {
+		if (!strcmp (option, sysctl_volatile_options[i]))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static const char *
+sysctl_cache_lookup (const char *ifname, const char *path)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (platform);
+	GHashTable *values;
+
+	values = g_hash_table_lookup (priv->sysctl_cache, ifname);
+	return values ? g_hash_table_lookup (values, path) : NULL;
+}
+
+static void
+sysctl_cache_update (const char *ifname, const char *path, const char *value)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (platform);
+	GHashTable *values;
+
+	values = g_hash_table_lookup (priv->sysctl_cache, ifname);
+	if (!value) {
+		if (values)
+			g_hash_table_remove (values, path);
+		return;
+	}
+
+	if (!values) {
+		values = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+		g_hash_table_insert (priv->sysctl_cache, g_strdup (ifname), values);
+	}
+	g_hash_table_insert (values, g_strdup (path), g_strdup (value));
+}
+
+/* Forgets cached values of @ifname, or of all interfaces if @ifname is %NULL. */
+static void
+sysctl_cache_flush (const char *ifname)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (platform);
+
+	if (ifname)
+		g_hash_table_remove (priv->sysctl_cache, ifname);
+	else
+		g_hash_table_remove_all (priv->sysctl_cache);
+}
+
+/* Cached values and directory handles of an interface become invalid when
+ * the name refers to a different interface or the kernel recreates the
+ * interface's IPv6 configuration, as happens when the MTU drops below the
+ * IPv6 minimum.
+ */
+static void
+sysctl_cache_flush_iface (NMPlatform *self, const char *ifname)
+{
+	NMPlatformClass *platform_class = NM_PLATFORM_GET_CLASS (self);
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+
+	g_hash_table_remove (priv->sysctl_cache, ifname);
+	if (platform_class->sysctl_flush_iface)
+		platform_class->sysctl_flush_iface (self, ifname);
+}
+
+static void
+sysctl_cache_link_changed (NMPlatform *self, NMPlatformLink *device, NMPlatformSignalChangeType change_type)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+	SysctlLink *link;
+
+	link = g_hash_table_lookup (priv->sysctl_links, GINT_TO_POINTER (device->ifindex));
+
+	switch (change_type) {
+	case NM_PLATFORM_SIGNAL_ADDED:
+	case NM_PLATFORM_SIGNAL_CHANGED:
+		if (link && !strcmp (link->name, device->name) && link->mtu == device->mtu)
+			return;
+		if (link)
+			sysctl_cache_flush_iface (self, link->name);
+		else {
+			link = g_slice_new0 (SysctlLink);
+			g_hash_table_insert (priv->sysctl_links, GINT_TO_POINTER (device->ifindex), link);
+		}
+		sysctl_cache_flush_iface (self, device->name);
+		g_strlcpy (link->name, device->name, sizeof (link->name));
+		link->mtu = device->mtu;
+		break;
+	case NM_PLATFORM_SIGNAL_REMOVED:
+		sysctl_cache_flush_iface (self, device->name);
+		if (link) {
+			if (strcmp (link->name, device->name))
+				sysctl_cache_flush_iface (self, link->name);
+			g_hash_table_remove (priv->sysctl_links, GINT_TO_POINTER (device->ifindex));
+		}
+		break;
+	}
+}
+
+static void
+sysctl_link_free (gpointer data)
+{
+	g_slice_free (SysctlLink, data);
+}
+
+/******************************************************************/
+
+/* Immutable per-interface copies of the addresses and routes in the
+ * platform cache.  They are filled on first use and dropped by the
+ * invalidate_*() handlers of the change signals, which run before any
+ * subscriber, so a subscriber never sees a stale snapshot.
+ */
+
+typedef enum {
+	IP_SNAPSHOT_IP4_ADDRESSES,
+	IP_SNAPSHOT_IP6_ADDRESSES,
+	IP_SNAPSHOT_IP4_ROUTES,
+	IP_SNAPSHOT_IP6_ROUTES,
+	_IP_SNAPSHOT_NUM
+} IPSnapshotType;
+
+typedef struct {
+	GArray *arrays[_IP_SNAPSHOT_NUM];
+} IPSnapshot;
+
+static void
+ip_snapshot_free (gpointer data)
+{
+	IPSnapshot *snapshot = data;
+	guint i;
+
+	for (i = 0; i < _IP_SNAPSHOT_NUM; i++) {
+		if (snapshot->arrays[i])
+			g_array_unref (snapshot->arrays[i]);
+	}
+	g_slice_free (IPSnapshot, snapshot);
+}
+
+static void
+ip_snapshot_invalidate (NMPlatform *self, int ifindex, IPSnapshotType type)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+	IPSnapshot *snapshot;
+
+	snapshot = g_hash_table_lookup (priv->ip_snapshots, GINT_TO_POINTER (ifindex));
+	if (snapshot && snapshot->arrays[type]) {
+		g_array_unref (snapshot->arrays[type]);
+		snapshot->arrays[type] = NULL;
+	}
+}
+
+static GArray *
+ip_snapshot_get (int ifindex, IPSnapshotType type)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (platform);
+	IPSnapshot *snapshot;
+	GArray *array;
+
+	snapshot = g_hash_table_lookup (priv->ip_snapshots, GINT_TO_POINTER (ifindex));
+	if (snapshot && snapshot->arrays[type]) {
+		priv->ip_snapshot_hits++;
+		return g_array_ref (snapshot->arrays[type]);
+	}
+
+	switch (type) {
+	case IP_SNAPSHOT_IP4_ADDRESSES:
+		array = klass->ip4_address_get_all (platform, ifindex);
+		break;
+	case IP_SNAPSHOT_IP6_ADDRESSES:
+		array = klass->ip6_address_get_all (platform, ifindex);
+		break;
+	case IP_SNAPSHOT_IP4_ROUTES:
+		array = klass->ip4_route_get_all (platform, ifindex, NM_PLATFORM_GET_ROUTE_MODE_ALL);
+		break;
+	case IP_SNAPSHOT_IP6_ROUTES:
+		array = klass->ip6_route_get_all (platform, ifindex, NM_PLATFORM_GET_ROUTE_MODE_ALL);
+		break;
+	default:
+		g_return_val_if_reached (NULL);
+	}
+	if (!array)
+		return NULL;
+
+	if (!snapshot) {
+		snapshot = g_slice_new0 (IPSnapshot);
+		g_hash_table_insert (priv->ip_snapshots, GINT_TO_POINTER (ifindex), snapshot);
+	}
+	snapshot->arrays[type] = array;
+	priv->ip_snapshot_misses++;
+	return g_array_ref (array);
+}
+
+/**
+ * nm_platform_ip4_address_get_snapshot:
+ * @ifindex: the interface index
+ *
+ * Like nm_platform_ip4_address_get_all(), but returns a reference to an
+ * array shared with the platform and with other callers.  As long as the
+ * addresses of @ifindex don't change, the same array is returned again.
+ *
+ * Returns: (transfer full): the addresses of @ifindex; the array must not
+ * be modified.  Release it with g_array_unref().
+ */
+GArray *
+nm_platform_ip4_address_get_snapshot (int ifindex)
+{
+	reset_error ();
+
+	g_return_val_if_fail (ifindex > 0, NULL);
+	g_return_val_if_fail (klass->ip4_address_get_all, NULL);
+
+	return ip_snapshot_get (ifindex, IP_SNAPSHOT_IP4_ADDRESSES);
+}
+
+GArray *
+nm_platform_ip6_address_get_snapshot (int ifindex)
+{
+	reset_error ();
+
+	g_return_val_if_fail (ifindex > 0, NULL);
+	g_return_val_if_fail (klass->ip6_address_get_all, NULL);
+
+	return ip_snapshot_get (ifindex, IP_SNAPSHOT_IP6_ADDRESSES);
+}
+
+/**
+ * nm_platform_ip4_route_get_snapshot:
+ * @ifindex: the interface index
+ *
+ * Like nm_platform_ip4_route_get_all() with %NM_PLATFORM_GET_ROUTE_MODE_ALL,
+ * but returns a shared, immutable array.  See
+ * nm_platform_ip4_address_get_snapshot().
+ *
+ * Returns: (transfer full): the routes of @ifindex; the array must not be
+ * modified.  Release it with g_array_unref().
+ */
+GArray *
+nm_platform_ip4_route_get_snapshot (int ifindex)
+{
+	reset_error ();
+
+	g_return_val_if_fail (ifindex > 0, NULL);
+	g_return_val_if_fail (klass->ip4_route_get_all, NULL);
+
+	return ip_snapshot_get (ifindex, IP_SNAPSHOT_IP4_ROUTES);
+}
+
+GArray *
+nm_platform_ip6_route_get_snapshot (int ifindex)
+{
+	reset_error ();
+
+	g_return_val_if_fail (ifindex > 0, NULL);
+	g_return_val_if_fail (klass->ip6_route_get_all, NULL);
+
+	return ip_snapshot_get (ifindex, IP_SNAPSHOT_IP6_ROUTES);
+}
+
+/**
+ * nm_platform_ip_snapshot_get_stats:
+ * @out_hits: (out) (allow-none): number of snapshot requests served from
+ *   an existing snapshot
+ * @out_misses: (out) (allow-none): number of snapshots that had to be
+ *   built from the platform cache
+ */
+void
+nm_platform_ip_snapshot_get_stats (guint *out_hits, guint *out_misses)
+{
+	NMPlatformPrivate *priv;
+
+	g_return_if_fail (NM_IS_PLATFORM (platform));
+
+	priv = NM_PLATFORM_GET_PRIVATE (platform);
+	if (out_hits)
+		*out_hits = priv->ip_snapshot_hits;
+	if (out_misses)
+		*out_misses = priv->ip_snapshot_misses;
+}
+
+/**
+ * nm_platform_sysctl_get_skipped_writes:
+ *
+ * Returns: the number of nm_platform_sysctl_set() calls that were skipped
+ * because the option was already known to have the requested value.
+ */
+guint
+nm_platform_sysctl_get_skipped_writes (void)
+{
+	return NM_PLATFORM_GET_PRIVATE (platform)->sysctl_writes_skipped;
+}
+
 /**
  * nm_platform_sysctl_set:
  * @path: Absolute option path
@@ -249,13 +652,39 @@ nm_platform_check_support_user_ipv6ll (void)
 gboolean
 nm_platform_sysctl_set (const char *path, const char *value)
 {
+	char ifname[IFNAMSIZ];
+	gboolean cacheable;
+	const char *cached;
+	gboolean success;
+
 	reset_error ();
 
 	g_return_val_if_fail (path, FALSE);
 	g_return_val_if_fail (value, FALSE);
 	g_return_val_if_fail (klass->sysctl_set, FALSE);
 
-	return klass->sysctl_set (platform, path, value);
+	cacheable = sysctl_cache_path (path, ifname);
+	if (cacheable) {
+		cached = sysctl_cache_lookup (ifname, path);
+		if (cached && !strcmp (cached, value)) {
+			NM_PLATFORM_GET_PRIVATE (platform)->sysctl_writes_skipped++;
+			debug ("sysctl: not setting '%s' to '%s' (cached value is identical)", path, value);
+			return TRUE;
+		}
+	}
+
+	success = klass->sysctl_set (platform, path, value);
+
+	if (cacheable)
+		sysctl_cache_update (ifname, path, success ? value : NULL);
+	else if (g_str_has_prefix (path, "/proc/sys/net/")) {
+		/* Global options like ipv4/ip_forward or ipv6/conf/all/forwarding
+		 * change per-interface values as well.
+		 */
+		sysctl_cache_flush (NULL);
+	}
+
+	return success;
 }
 
 /**
@@ -267,12 +696,18 @@ nm_platform_sysctl_set (const char *path, const char *value)
 char *
 nm_platform_sysctl_get (const char *path)
 {
+	char ifname[IFNAMSIZ];
+	char *value;
+
 	reset_error ();
 
 	g_return_val_if_fail (path, NULL);
 	g_return_val_if_fail (klass->sysctl_get, NULL);
 
-	return klass->sysctl_get (platform, path);
+	value = klass->sysctl_get (platform, path);
+	if (sysctl_cache_path (path, ifname))
+		sysctl_cache_update (ifname, path, value);
+	return value;
 }
 
 /**
@@ -1216,6 +1651,110 @@ nm_platform_slave_get_option (int ifindex, const char *option)
 	return klass->slave_get_option (platform, ifindex, option);
 }
 
+static gboolean
+set_options_one_by_one (int ifindex,
+                        gboolean slave,
+                        const NMPlatformLinkOption *options,
+                        guint n_options)
+{
+	gboolean success = TRUE;
+	guint i;
+
+	for (i = 0; i < n_options; i++) {
+		gboolean set;
+
+		if (slave)
+			set = klass->slave_set_option (platform, ifindex, options[i].option, options[i].value);
+		else
+			set = klass->master_set_option (platform, ifindex, options[i].option, options[i].value);
+		if (!set) {
+			debug ("link: failed to set %s option '%s' to '%s' on %d",
+			       slave ? "slave" : "master", options[i].option, options[i].value, ifindex);
+			success = FALSE;
+		}
+	}
+	return success;
+}
+
+/**
+ * nm_platform_master_set_options:
+ * @ifindex: Interface index of the bond or bridge
+ * @options: (array length=n_options): options to set, in order
+ * @n_options: number of entries in @options
+ *
+ * Sets several master options at once.  Platforms that can program the
+ * whole set in a single request do so; otherwise the options are written
+ * one after another like nm_platform_master_set_option() would.
+ *
+ * Returns: %TRUE if all options were set.
+ */
+gboolean
+nm_platform_master_set_options (int ifindex, const NMPlatformLinkOption *options, guint n_options)
+{
+	reset_error ();
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (options || !n_options, FALSE);
+	g_return_val_if_fail (klass->master_set_option, FALSE);
+
+	if (!n_options)
+		return TRUE;
+	if (klass->master_set_options)
+		return klass->master_set_options (platform, ifindex, options, n_options);
+	return set_options_one_by_one (ifindex, FALSE, options, n_options);
+}
+
+/**
+ * nm_platform_master_get_options:
+ * @ifindex: Interface index of the bond or bridge
+ *
+ * Reads all master options the platform can fetch with a single request.
+ * Options missing from the returned table must be read individually with
+ * nm_platform_master_get_option().
+ *
+ * Returns: (transfer full): a table mapping option names to values in the
+ * same format nm_platform_master_get_option() uses, or %NULL.
+ */
+GHashTable *
+nm_platform_master_get_options (int ifindex)
+{
+	reset_error ();
+
+	g_return_val_if_fail (ifindex > 0, NULL);
+
+	if (!klass->master_get_options)
+		return NULL;
+	return klass->master_get_options (platform, ifindex);
+}
+
+gboolean
+nm_platform_slave_set_options (int ifindex, const NMPlatformLinkOption *options, guint n_options)
+{
+	reset_error ();
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (options || !n_options, FALSE);
+	g_return_val_if_fail (klass->slave_set_option, FALSE);
+
+	if (!n_options)
+		return TRUE;
+	if (klass->slave_set_options)
+		return klass->slave_set_options (platform, ifindex, options, n_options);
+	return set_options_one_by_one (ifindex, TRUE, options, n_options);
+}
+
+GHashTable *
+nm_platform_slave_get_options (int ifindex)
+{
+	reset_error ();
+
+	g_return_val_if_fail (ifindex > 0, NULL);
+
+	if (!klass->slave_get_options)
+		return NULL;
+	return klass->slave_get_options (platform, ifindex);
+}
+
 gboolean
 nm_platform_vlan_get_info (int ifindex, int *parent, int *vlanid)
 {
@@ -1414,6 +1953,49 @@ nm_platform_wifi_get_mode (int ifindex)
 	return klass->wifi_get_mode (platform, ifindex);
 }
 
+/**
+ * nm_platform_wifi_get_link_info:
+ * @ifindex: Wi-Fi interface index
+ * @info: (out): location for the snapshot
+ *
+ * Fetches the interface mode and, when associated, the BSSID, SSID,
+ * frequency, bitrate and signal quality of the current BSS together.
+ * Callers that need more than one of these should prefer this over the
+ * individual getters, each of which queries the driver on its own.
+ *
+ * Returns: %TRUE if @info was filled in
+ */
+gboolean
+nm_platform_wifi_get_link_info (int ifindex, NMPlatformWifiLinkInfo *info)
+{
+	GByteArray *ssid;
+
+	reset_error ();
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (info != NULL, FALSE);
+
+	memset (info, 0, sizeof (*info));
+	if (klass->wifi_get_link_info)
+		return klass->wifi_get_link_info (platform, ifindex, info);
+
+	info->mode = klass->wifi_get_mode (platform, ifindex);
+	info->associated = klass->wifi_get_bssid (platform, ifindex, info->bssid);
+	if (!info->associated)
+		return TRUE;
+
+	ssid = klass->wifi_get_ssid (platform, ifindex);
+	if (ssid) {
+		info->ssid_len = MIN (ssid->len, sizeof (info->ssid));
+		memcpy (info->ssid, ssid->data, info->ssid_len);
+		g_byte_array_free (ssid, TRUE);
+	}
+	info->frequency = klass->wifi_get_frequency (platform, ifindex);
+	info->rate = klass->wifi_get_rate (platform, ifindex);
+	info->quality = klass->wifi_get_quality (platform, ifindex);
+	return TRUE;
+}
+
 void
 nm_platform_wifi_set_mode (int ifindex, NM80211Mode mode)
 {
@@ -2780,9 +3362,79 @@ log_ip6_route (NMPlatform *p, int ifindex, NMPlatformIP6Route *route, NMPlatform
 
 /******************************************************************/
 
+/* Cache invalidation.  These handlers are connected from nm_platform_init(),
+ * before anybody else can connect, so they run right after the logging
+ * class handlers and ahead of all other subscribers.
+ */
+
+static void
+invalidate_link (NMPlatform *p, int ifindex, NMPlatformLink *device, NMPlatformSignalChangeType change_type, NMPlatformReason reason, gpointer user_data)
+{
+	sysctl_cache_link_changed (p, device, change_type);
+
+	/* The kernel flushes routes of links going down and everything of
+	 * removed links, without necessarily telling us about each object. */
+	if (change_type == NM_PLATFORM_SIGNAL_REMOVED)
+		g_hash_table_remove (NM_PLATFORM_GET_PRIVATE (p)->ip_snapshots, GINT_TO_POINTER (ifindex));
+	else {
+		ip_snapshot_invalidate (p, ifindex, IP_SNAPSHOT_IP4_ROUTES);
+		ip_snapshot_invalidate (p, ifindex, IP_SNAPSHOT_IP6_ROUTES);
+	}
+}
+
+static void
+invalidate_ip4_address (NMPlatform *p, int ifindex, NMPlatformIP4Address *address, NMPlatformSignalChangeType change_type, NMPlatformReason reason, gpointer user_data)
+{
+	ip_snapshot_invalidate (p, ifindex, IP_SNAPSHOT_IP4_ADDRESSES);
+}
+
+static void
+invalidate_ip6_address (NMPlatform *p, int ifindex, NMPlatformIP6Address *address, NMPlatformSignalChangeType change_type, NMPlatformReason reason, gpointer user_data)
+{
+	ip_snapshot_invalidate (p, ifindex, IP_SNAPSHOT_IP6_ADDRESSES);
+}
+
+static void
+invalidate_ip4_route (NMPlatform *p, int ifindex, NMPlatformIP4Route *route, NMPlatformSignalChangeType change_type, NMPlatformReason reason, gpointer user_data)
+{
+	ip_snapshot_invalidate (p, ifindex, IP_SNAPSHOT_IP4_ROUTES);
+}
+
+static void
+invalidate_ip6_route (NMPlatform *p, int ifindex, NMPlatformIP6Route *route, NMPlatformSignalChangeType change_type, NMPlatformReason reason, gpointer user_data)
+{
+	ip_snapshot_invalidate (p, ifindex, IP_SNAPSHOT_IP6_ROUTES);
+}
+
+/******************************************************************/
+
 static void
 nm_platform_init (NMPlatform *object)
 {
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (object);
+
+	priv->sysctl_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+	                                            (GDestroyNotify) g_hash_table_unref);
+	priv->sysctl_links = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, sysctl_link_free);
+	priv->ip_snapshots = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, ip_snapshot_free);
+
+	g_signal_connect (object, NM_PLATFORM_SIGNAL_LINK_CHANGED, G_CALLBACK (invalidate_link), NULL);
+	g_signal_connect (object, NM_PLATFORM_SIGNAL_IP4_ADDRESS_CHANGED, G_CALLBACK (invalidate_ip4_address), NULL);
+	g_signal_connect (object, NM_PLATFORM_SIGNAL_IP6_ADDRESS_CHANGED, G_CALLBACK (invalidate_ip6_address), NULL);
+	g_signal_connect (object, NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, G_CALLBACK (invalidate_ip4_route), NULL);
+	g_signal_connect (object, NM_PLATFORM_SIGNAL_IP6_ROUTE_CHANGED, G_CALLBACK (invalidate_ip6_route), NULL);
+}
+
+static void
+finalize (GObject *object)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (object);
+
+	g_hash_table_unref (priv->sysctl_cache);
+	g_hash_table_unref (priv->sysctl_links);
+	g_hash_table_unref (priv->ip_snapshots);
+
+	G_OBJECT_CLASS (nm_platform_parent_class)->finalize (object);
 }
 
 #define SIGNAL(signal_id, method) signals[signal_id] = \
@@ -2798,6 +3450,10 @@ nm_platform_class_init (NMPlatformClass *platform_class)
 {
 	GObjectClass *object_class = G_OBJECT_CLASS (platform_class);
 
+	g_type_class_add_private (platform_class, sizeof (NMPlatformPrivate));
+
+	object_class->finalize = finalize;
+
 	platform_class->wifi_set_powersave = wifi_set_powersave;
 
 	/* Signals */
@@ -246,6 +246,11 @@ typedef union {
 #undef __NMPlatformObject_COMMON
 
 
+typedef struct {
+	const char *option;
+	const char *value;
+} NMPlatformLinkOption;
+
 typedef struct {
 	int peer;
 } NMPlatformVethProperties;
@@ -299,6 +304,34 @@ typedef struct {
 	gboolean path_mtu_discovery;
 } NMPlatformGreProperties;
 
+/* Snapshot of a Wi-Fi link's mode and current association */
+typedef struct {
+	NM80211Mode mode;
+	gboolean associated;
+	/* The following are only valid when @associated is TRUE */
+	guint8 bssid[6];
+	guint8 ssid[32];
+	guint32 ssid_len;
+	guint32 frequency;
+	guint32 rate;
+	int quality;
+} NMPlatformWifiLinkInfo;
+
+/* Counters of the kernel event socket.  An overflow means the kernel
+ * dropped notifications and the platform cache had to be resynchronized
+ * with a full dump. */
+typedef struct {
+	guint overflows;
+	guint resyncs;
+	/* Current receive buffer size of the event socket, in bytes */
+	guint rcvbuf_size;
+	/* Duration of the last and the longest resync, in microseconds */
+	guint64 resync_last_usec;
+	guint64 resync_max_usec;
+	/* Objects found added, changed or removed by the last resync */
+	guint resync_last_announced;
+} NMPlatformNetlinkStats;
+
 /******************************************************************/
 
 /* NMPlatform abstract class and its implementations provide a layer between
@@ -342,6 +375,7 @@ typedef struct {
 
 	gboolean (*sysctl_set) (NMPlatform *, const char *path, const char *value);
 	char * (*sysctl_get) (NMPlatform *, const char *path);
+	void (*sysctl_flush_iface) (NMPlatform *, const char *ifname);
 
 	gboolean (*link_get) (NMPlatform *platform, int ifindex, NMPlatformLink *link);
 	GArray *(*link_get_all) (NMPlatform *);
@@ -385,6 +419,10 @@ typedef struct {
 	char * (*master_get_option) (NMPlatform *, int ifindex, const char *option);
 	gboolean (*slave_set_option) (NMPlatform *, int ifindex, const char *option, const char *value);
 	char * (*slave_get_option) (NMPlatform *, int ifindex, const char *option);
+	gboolean (*master_set_options) (NMPlatform *, int ifindex, const NMPlatformLinkOption *options, guint n_options);
+	GHashTable * (*master_get_options) (NMPlatform *, int ifindex);
+	gboolean (*slave_set_options) (NMPlatform *, int ifindex, const NMPlatformLinkOption *options, guint n_options);
+	GHashTable * (*slave_get_options) (NMPlatform *, int ifindex);
 
 	gboolean (*vlan_add) (NMPlatform *, const char *name, int parent, int vlanid, guint32 vlanflags);
 	gboolean (*vlan_get_info) (NMPlatform *, int ifindex, int *parent, int *vlan_id);
@@ -406,6 +444,7 @@ typedef struct {
 	int         (*wifi_get_quality)      (NMPlatform *, int ifindex);
 	guint32     (*wifi_get_rate)         (NMPlatform *, int ifindex);
 	NM80211Mode (*wifi_get_mode)         (NMPlatform *, int ifindex);
+	gboolean    (*wifi_get_link_info)    (NMPlatform *, int ifindex, NMPlatformWifiLinkInfo *info);
 	void        (*wifi_set_mode)         (NMPlatform *, int ifindex, NM80211Mode mode);
 	void        (*wifi_set_powersave)    (NMPlatform *, int ifindex, guint32 powersave);
 	guint32     (*wifi_find_frequency)   (NMPlatform *, int ifindex, const guint32 *freqs);
@@ -446,6 +485,8 @@ typedef struct {
 
 	gboolean (*check_support_kernel_extended_ifa_flags) (NMPlatform *);
 	gboolean (*check_support_user_ipv6ll) (NMPlatform *);
+
+	gboolean (*get_netlink_stats) (NMPlatform *, NMPlatformNetlinkStats *stats);
 } NMPlatformClass;
 
 /* NMPlatform signals
@@ -485,6 +526,8 @@ gboolean nm_platform_sysctl_set (const char *path, const char *value);
 char *nm_platform_sysctl_get (const char *path);
 gint32 nm_platform_sysctl_get_int32 (const char *path, gint32 fallback);
 gint64 nm_platform_sysctl_get_int_checked (const char *path, guint base, gint64 min, gint64 max, gint64 fallback);
+gboolean nm_platform_sysctl_split_iface_path (const char *path, char *out_ifname, gsize *out_dirlen);
+guint nm_platform_sysctl_get_skipped_writes (void);
 
 gboolean nm_platform_link_get (int ifindex, NMPlatformLink *link);
 GArray *nm_platform_link_get_all (void);
@@ -534,6 +577,10 @@ gboolean nm_platform_master_set_option (int ifindex, const char *option, const c
 char *nm_platform_master_get_option (int ifindex, const char *option);
 gboolean nm_platform_slave_set_option (int ifindex, const char *option, const char *value);
 char *nm_platform_slave_get_option (int ifindex, const char *option);
+gboolean nm_platform_master_set_options (int ifindex, const NMPlatformLinkOption *options, guint n_options);
+GHashTable *nm_platform_master_get_options (int ifindex);
+gboolean nm_platform_slave_set_options (int ifindex, const NMPlatformLinkOption *options, guint n_options);
+GHashTable *nm_platform_slave_get_options (int ifindex);
 
 gboolean nm_platform_vlan_add (const char *name, int parent, int vlanid, guint32 vlanflags);
 gboolean nm_platform_vlan_get_info (int ifindex, int *parent, int *vlanid);
@@ -555,6 +602,7 @@ guint32     nm_platform_wifi_get_frequency    (int ifindex);
 int         nm_platform_wifi_get_quality      (int ifindex);
 guint32     nm_platform_wifi_get_rate         (int ifindex);
 NM80211Mode nm_platform_wifi_get_mode         (int ifindex);
+gboolean    nm_platform_wifi_get_link_info    (int ifindex, NMPlatformWifiLinkInfo *info);
 void        nm_platform_wifi_set_mode         (int ifindex, NM80211Mode mode);
 void        nm_platform_wifi_set_powersave    (int ifindex, guint32 powersave);
 guint32     nm_platform_wifi_find_frequency   (int ifindex, const guint32 *freqs);
@@ -566,6 +614,9 @@ gboolean    nm_platform_mesh_set_ssid         (int ifindex, const guint8 *ssid,
 
 GArray *nm_platform_ip4_address_get_all (int ifindex);
 GArray *nm_platform_ip6_address_get_all (int ifindex);
+GArray *nm_platform_ip4_address_get_snapshot (int ifindex);
+GArray *nm_platform_ip6_address_get_snapshot (int ifindex);
+void nm_platform_ip_snapshot_get_stats (guint *out_hits, guint *out_misses);
 gboolean nm_platform_ip4_address_add (int ifindex,
                                       in_addr_t address, in_addr_t peer_address, int plen,
                                       guint32 lifetime, guint32 preferred_lft,
@@ -583,6 +634,8 @@ gboolean nm_platform_address_flush (int ifindex);
 
 gboolean nm_platform_ip4_check_reinstall_device_route (int ifindex, const NMPlatformIP4Address *address, guint32 device_route_metric);
 
+GArray *nm_platform_ip4_route_get_snapshot (int ifindex);
+GArray *nm_platform_ip6_route_get_snapshot (int ifindex);
 GArray *nm_platform_ip4_route_get_all (int ifindex, NMPlatformGetRouteMode mode);
 GArray *nm_platform_ip6_route_get_all (int ifindex, NMPlatformGetRouteMode mode);
 gboolean nm_platform_ip4_route_add (int ifindex, NMIPConfigSource source,
@@ -615,6 +668,8 @@ gboolean nm_platform_check_support_libnl_extended_ifa_flags (void);
 gboolean nm_platform_check_support_kernel_extended_ifa_flags (void);
 gboolean nm_platform_check_support_user_ipv6ll (void);
 
+gboolean nm_platform_get_netlink_stats (NMPlatformNetlinkStats *stats);
+
 void nm_platform_addr_flags2str (int flags, char *buf, size_t size);
 
 int nm_platform_ip_address_cmp_expiry (const NMPlatformIPAddress *a, const NMPlatformIPAddress *b);
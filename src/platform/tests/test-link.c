@@ -250,6 +250,49 @@ test_slave (int master, int type, SignalData *master_changed)
 	free_signal (link_removed);
 }
 
+static void
+check_option (int ifindex, GHashTable *options, const char *option, const char *expected)
+{
+	char *value;
+
+	value = nm_platform_master_get_option (ifindex, option);
+	no_error ();
+	g_assert (g_str_has_prefix (value, expected));
+	g_free (value);
+
+	if (options) {
+		value = g_hash_table_lookup (options, option);
+		if (value)
+			g_assert (g_str_has_prefix (value, expected));
+	}
+}
+
+static void
+test_master_options (int ifindex,
+                     const char *option1, const char *value1,
+                     const char *option2, const char *value2,
+                     const char *expected1, const char *expected2)
+{
+	NMPlatformLinkOption options[] = {
+		{ option1, value1 },
+		{ option2, value2 },
+	};
+	GHashTable *kernel_options;
+
+	g_assert (nm_platform_master_set_options (ifindex, options, G_N_ELEMENTS (options)));
+	no_error ();
+
+	/* The bulk read may only know some options (or none at all); whatever
+	 * it returns must agree with the single option read.
+	 */
+	kernel_options = nm_platform_master_get_options (ifindex);
+	no_error ();
+	check_option (ifindex, kernel_options, option1, expected1);
+	check_option (ifindex, kernel_options, option2, expected2);
+	if (kernel_options)
+		g_hash_table_unref (kernel_options);
+}
+
 static void
 test_software (NMLinkType link_type, const char *link_typename)
 {
@@ -314,6 +357,18 @@ test_software (NMLinkType link_type, const char *link_typename)
 		break;
 	}
 
+	/* Set several master options at once */
+	switch (link_type) {
+	case NM_LINK_TYPE_BRIDGE:
+		test_master_options (ifindex, "hello_time", "300", "max_age", "2100", "300", "2100");
+		break;
+	case NM_LINK_TYPE_BOND:
+		test_master_options (ifindex, "miimon", "150", "xmit_hash_policy", "layer2+3", "150", "layer2+3");
+		break;
+	default:
+		break;
+	}
+
 	/* Enslave and release */
 	switch (link_type) {
 	case NM_LINK_TYPE_BRIDGE:
@@ -474,6 +529,76 @@ test_internal (void)
 	free_signal (link_removed);
 }
 
+static void
+test_sysctl_cache (void)
+{
+	SignalData *link_added = add_signal_ifname (NM_PLATFORM_SIGNAL_LINK_CHANGED, NM_PLATFORM_SIGNAL_ADDED, link_callback, DEVICE_NAME);
+	SignalData *link_removed;
+	const char *path = "/proc/sys/net/ipv6/conf/" DEVICE_NAME "/accept_ra_defrtr";
+	guint skipped;
+	char *value;
+	int ifindex;
+
+	g_assert (nm_platform_dummy_add (DEVICE_NAME));
+	no_error ();
+	accept_signal (link_added);
+	ifindex = nm_platform_link_get_ifindex (DEVICE_NAME);
+	g_assert (ifindex > 0);
+	link_removed = add_signal_ifindex (NM_PLATFORM_SIGNAL_LINK_CHANGED, NM_PLATFORM_SIGNAL_REMOVED, link_callback, ifindex);
+
+	/* Identical writes are skipped */
+	skipped = nm_platform_sysctl_get_skipped_writes ();
+	g_assert (nm_platform_sysctl_set (path, "0"));
+	g_assert_cmpint (nm_platform_sysctl_get_skipped_writes (), ==, skipped);
+	g_assert (nm_platform_sysctl_set (path, "0"));
+	g_assert_cmpint (nm_platform_sysctl_get_skipped_writes (), ==, skipped + 1);
+	value = nm_platform_sysctl_get (path);
+	g_assert_cmpstr (value, ==, "0");
+	g_free (value);
+
+	/* Different values are written */
+	g_assert (nm_platform_sysctl_set (path, "1"));
+	g_assert_cmpint (nm_platform_sysctl_get_skipped_writes (), ==, skipped + 1);
+	g_assert (nm_platform_sysctl_set (path, "1"));
+	g_assert_cmpint (nm_platform_sysctl_get_skipped_writes (), ==, skipped + 2);
+
+	/* Options the kernel changes on its own are never cached */
+	g_assert (nm_platform_sysctl_set ("/proc/sys/net/ipv6/conf/" DEVICE_NAME "/hop_limit", "64"));
+	g_assert (nm_platform_sysctl_set ("/proc/sys/net/ipv6/conf/" DEVICE_NAME "/hop_limit", "64"));
+	g_assert_cmpint (nm_platform_sysctl_get_skipped_writes (), ==, skipped + 2);
+
+	/* A new interface with the same name starts with an empty cache */
+	g_assert (nm_platform_link_delete (ifindex));
+	no_error ();
+	accept_signal (link_removed);
+	free_signal (link_removed);
+
+	g_assert (nm_platform_dummy_add (DEVICE_NAME));
+	no_error ();
+	accept_signal (link_added);
+	ifindex = nm_platform_link_get_ifindex (DEVICE_NAME);
+	g_assert (ifindex > 0);
+	link_removed = add_signal_ifindex (NM_PLATFORM_SIGNAL_LINK_CHANGED, NM_PLATFORM_SIGNAL_REMOVED, link_callback, ifindex);
+
+	g_assert (nm_platform_sysctl_set (path, "1"));
+	g_assert_cmpint (nm_platform_sysctl_get_skipped_writes (), ==, skipped + 2);
+	g_assert (nm_platform_sysctl_set (path, "1"));
+	g_assert_cmpint (nm_platform_sysctl_get_skipped_writes (), ==, skipped + 3);
+
+	/* Changing the MTU invalidates the interface's values */
+	g_assert (nm_platform_link_set_mtu (ifindex, MTU));
+	no_error ();
+	g_assert (nm_platform_sysctl_set (path, "1"));
+	g_assert_cmpint (nm_platform_sysctl_get_skipped_writes (), ==, skipped + 3);
+
+	g_assert (nm_platform_link_delete (ifindex));
+	no_error ();
+	accept_signal (link_removed);
+
+	free_signal (link_added);
+	free_signal (link_removed);
+}
+
 static void
 test_external (void)
 {
@@ -550,6 +675,7 @@ setup_tests (void)
 	g_test_add_func ("/link/bogus", test_bogus);
 	g_test_add_func ("/link/loopback", test_loopback);
 	g_test_add_func ("/link/internal", test_internal);
+	g_test_add_func ("/link/sysctl-cache", test_sysctl_cache);
 	g_test_add_func ("/link/software/bridge", test_bridge);
 	g_test_add_func ("/link/software/bond", test_bond);
 	g_test_add_func ("/link/software/team", test_team);
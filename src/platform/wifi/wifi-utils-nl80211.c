@@ -544,27 +544,29 @@ nl80211_station_handler (struct nl_msg *msg, void *arg)
 	return NL_SKIP;
 }
 
+/* Queries the station entry of the BSS in @bss_info, which the caller
+ * already fetched with nl80211_get_bss_info().
+ */
 static void
-nl80211_get_ap_info (WifiDataNl80211 *nl80211,
-                     struct nl80211_station_info *sta_info)
+nl80211_get_station_info (WifiDataNl80211 *nl80211,
+                          const struct nl80211_bss_info *bss_info,
+                          struct nl80211_station_info *sta_info)
 {
 	struct nl_msg *msg;
-	struct nl80211_bss_info bss_info;
 
 	memset(sta_info, 0, sizeof (*sta_info));
 
-	nl80211_get_bss_info (nl80211, &bss_info);
-	if (!bss_info.valid)
+	if (!bss_info->valid)
 		return;
 
 	msg = nl80211_alloc_msg (nl80211, NL80211_CMD_GET_STATION, 0);
 	if (msg) {
-		NLA_PUT (msg, NL80211_ATTR_MAC, ETH_ALEN, bss_info.bssid);
+		NLA_PUT (msg, NL80211_ATTR_MAC, ETH_ALEN, bss_info->bssid);
 
 		nl80211_send_and_recv (nl80211, msg, nl80211_station_handler, sta_info);
 		if (!sta_info->signal_valid) {
 			/* Fall back to bss_info signal quality (both are in percent) */
-			sta_info->signal = bss_info.beacon_signal;
+			sta_info->signal = bss_info->beacon_signal;
 		}
 	}
 
@@ -575,6 +577,16 @@ nl80211_get_ap_info (WifiDataNl80211 *nl80211,
 	return;
 }
 
+static void
+nl80211_get_ap_info (WifiDataNl80211 *nl80211,
+                     struct nl80211_station_info *sta_info)
+{
+	struct nl80211_bss_info bss_info;
+
+	nl80211_get_bss_info (nl80211, &bss_info);
+	nl80211_get_station_info (nl80211, &bss_info, sta_info);
+}
+
 static guint32
 wifi_nl80211_get_rate (WifiData *data)
 {
@@ -596,6 +608,35 @@ wifi_nl80211_get_qual (WifiData *data)
 	return sta_info.signal;
 }
 
+static gboolean
+wifi_nl80211_get_link_info (WifiData *data, WifiLinkInfo *info)
+{
+	WifiDataNl80211 *nl80211 = (WifiDataNl80211 *) data;
+	struct nl80211_bss_info bss_info;
+	struct nl80211_station_info sta_info;
+
+	/* One GET_INTERFACE, one GET_SCAN dump and one GET_STATION request,
+	 * instead of a scan dump for each of the individual getters.
+	 */
+	info->mode = wifi_nl80211_get_mode (data);
+
+	nl80211_get_bss_info (nl80211, &bss_info);
+	if (!bss_info.valid)
+		return TRUE;
+
+	info->associated = TRUE;
+	memcpy (info->bssid, bss_info.bssid, ETH_ALEN);
+	memcpy (info->ssid, bss_info.ssid, bss_info.ssid_len);
+	info->ssid_len = bss_info.ssid_len;
+	info->freq = bss_info.freq;
+
+	nl80211_get_station_info (nl80211, &bss_info, &sta_info);
+	info->rate = sta_info.txrate;
+	info->qual = sta_info.signal;
+
+	return TRUE;
+}
+
 #if HAVE_NL80211_CRITICAL_PROTOCOL_CMDS
 static gboolean
 wifi_nl80211_indicate_addressing_running (WifiData *data, gboolean running)
@@ -867,6 +908,7 @@ wifi_nl80211_init (const char *iface, int ifindex)
 	nl80211->parent.get_bssid = wifi_nl80211_get_bssid;
 	nl80211->parent.get_rate = wifi_nl80211_get_rate;
 	nl80211->parent.get_qual = wifi_nl80211_get_qual;
+	nl80211->parent.get_link_info = wifi_nl80211_get_link_info;
 #if HAVE_NL80211_CRITICAL_PROTOCOL_CMDS
 	nl80211->parent.indicate_addressing_running = wifi_nl80211_indicate_addressing_running;
 #endif
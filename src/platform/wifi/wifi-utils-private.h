@@ -57,6 +57,11 @@ struct WifiData {
 	 */
 	int (*get_qual) (WifiData *data);
 
+	/* Optional; fetch everything in WifiLinkInfo at once.  When unset,
+	 * wifi_utils_get_link_info() uses the individual getters.
+	 */
+	gboolean (*get_link_info) (WifiData *data, WifiLinkInfo *info);
+
 	void (*deinit) (WifiData *data);
 
 	gboolean (*get_wowlan) (WifiData *data);
@@ -152,6 +152,35 @@ wifi_utils_get_qual (WifiData *data)
 	return data->get_qual (data);
 }
 
+gboolean
+wifi_utils_get_link_info (WifiData *data, WifiLinkInfo *info)
+{
+	GByteArray *ssid;
+
+	g_return_val_if_fail (data != NULL, FALSE);
+	g_return_val_if_fail (info != NULL, FALSE);
+
+	memset (info, 0, sizeof (*info));
+	if (data->get_link_info)
+		return data->get_link_info (data, info);
+
+	info->mode = data->get_mode (data);
+	info->associated = data->get_bssid (data, info->bssid);
+	if (!info->associated)
+		return TRUE;
+
+	ssid = data->get_ssid (data);
+	if (ssid) {
+		info->ssid_len = MIN (ssid->len, sizeof (info->ssid));
+		memcpy (info->ssid, ssid->data, info->ssid_len);
+		g_byte_array_free (ssid, TRUE);
+	}
+	info->freq = data->get_freq (data);
+	info->rate = data->get_rate (data);
+	info->qual = data->get_qual (data);
+	return TRUE;
+}
+
 gboolean
 wifi_utils_get_wowlan (WifiData *data)
 {
@@ -29,6 +29,18 @@
 
 typedef struct WifiData WifiData;
 
+typedef struct {
+	NM80211Mode mode;
+	/* The remaining fields are only set when associated */
+	gboolean associated;
+	guint8 bssid[ETH_ALEN];
+	guint8 ssid[32];
+	guint32 ssid_len;
+	guint32 freq;
+	guint32 rate;
+	int qual;
+} WifiLinkInfo;
+
 gboolean wifi_utils_is_wifi (const char *iface, const char *sysfs_path, const char *devtype);
 
 WifiData *wifi_utils_init (const char *iface, int ifindex, gboolean check_scan);
@@ -59,6 +71,11 @@ guint32 wifi_utils_get_rate (WifiData *data);
 /* Returns quality 0 - 100% on succes, or -1 on error */
 int wifi_utils_get_qual (WifiData *data);
 
+/* Fills @info with the mode and current association in as few driver
+ * requests as possible.
+ */
+gboolean wifi_utils_get_link_info (WifiData *data, WifiLinkInfo *info);
+
 /* Tells the driver DHCP or SLAAC is running */
 gboolean wifi_utils_indicate_addressing_running (WifiData *data, gboolean running);
 
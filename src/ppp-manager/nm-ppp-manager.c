@@ -86,6 +86,10 @@ typedef struct {
 	guint32 ppp_watch_id;
 	guint32 ppp_timeout_handler;
 
+	/* pppd command line while ppp_generic is being loaded */
+	guint modprobe_id;
+	char **pppd_argv;
+
 	/* Monitoring */
 	char *ip_iface;
 	int monitor_fd;
@@ -703,18 +707,6 @@ nm_cmd_line_destroy (NMCmdLine *cmd)
 	g_slice_free (NMCmdLine, cmd);
 }
 
-static char *
-nm_cmd_line_to_str (NMCmdLine *cmd)
-{
-	char *str;
-
-	g_ptr_array_add (cmd->array, NULL);
-	str = g_strjoinv (" ", (gchar **) cmd->array->pdata);
-	g_ptr_array_remove_index (cmd->array, cmd->array->len - 1);
-
-	return str;
-}
-
 static void
 nm_cmd_line_add_string (NMCmdLine *cmd, const char *str)
 {
@@ -1055,6 +1047,65 @@ pppoe_fill_defaults (NMSettingPpp *setting)
 #endif
 }
 
+static gboolean
+ppp_spawn (NMPPPManager *manager, char **argv, GError **err)
+{
+	NMPPPManagerPrivate *priv = NM_PPP_MANAGER_GET_PRIVATE (manager);
+	char *cmd_str;
+
+	nm_log_info (LOGD_PPP, "starting PPP connection");
+
+	cmd_str = g_strjoinv (" ", argv);
+	nm_log_dbg (LOGD_PPP, "command line: %s", cmd_str);
+	g_free (cmd_str);
+
+	priv->pid = 0;
+	if (!g_spawn_async (NULL, argv, NULL,
+	                    G_SPAWN_DO_NOT_REAP_CHILD,
+	                    nm_utils_setpgid, NULL,
+	                    &priv->pid, err))
+		return FALSE;
+
+	nm_log_info (LOGD_PPP, "pppd started with pid %d", priv->pid);
+
+	priv->ppp_watch_id = g_child_watch_add (priv->pid, (GChildWatchFunc) ppp_watch_cb, manager);
+	return TRUE;
+}
+
+#define PPP_MODPROBE_TIMEOUT_MSEC 10000
+
+static void
+modprobe_done (int child_status, const char *out, const char *err,
+               GError *error, gpointer user_data)
+{
+	NMPPPManager *manager = NM_PPP_MANAGER (user_data);
+	NMPPPManagerPrivate *priv = NM_PPP_MANAGER_GET_PRIVATE (manager);
+	char **argv = priv->pppd_argv;
+	GError *spawn_error = NULL;
+
+	priv->modprobe_id = 0;
+	priv->pppd_argv = NULL;
+
+	/* Try anyway; pppd complains about a missing /dev/ppp itself */
+	if (error)
+		nm_log_warn (LOGD_PPP, "modprobe: 'ppp_generic' failed: %s", error->message);
+	else if (WIFEXITED (child_status)) {
+		if (WEXITSTATUS (child_status) != 0)
+			nm_log_warn (LOGD_PPP, "modprobe: 'ppp_generic' exited with error %d", WEXITSTATUS (child_status));
+	} else if (WIFSIGNALED (child_status))
+		nm_log_warn (LOGD_PPP, "modprobe: 'ppp_generic' died with signal %d", WTERMSIG (child_status));
+	else
+		nm_log_warn (LOGD_PPP, "modprobe: 'ppp_generic' died from an unknown cause");
+
+	if (!ppp_spawn (manager, argv, &spawn_error)) {
+		nm_log_warn (LOGD_PPP, "could not start pppd: %s", spawn_error->message);
+		g_error_free (spawn_error);
+		_ppp_cleanup (manager);
+		g_signal_emit (manager, signals[STATE_CHANGED], 0, NM_PPP_STATUS_DEAD);
+	}
+	g_strfreev (argv);
+}
+
 gboolean
 nm_ppp_manager_start (NMPPPManager *manager,
                       NMActRequest *req,
@@ -1069,8 +1120,8 @@ nm_ppp_manager_start (NMPPPManager *manager,
 	NMSettingPppoe *pppoe_setting;
 	NMSettingAdsl *adsl_setting;
 	NMCmdLine *ppp_cmd;
-	char *cmd_str;
 	struct stat st;
+	gboolean success = FALSE;
 
 	g_return_val_if_fail (NM_IS_PPP_MANAGER (manager), FALSE);
 	g_return_val_if_fail (NM_IS_ACT_REQUEST (req), FALSE);
@@ -1088,10 +1139,6 @@ nm_ppp_manager_start (NMPPPManager *manager,
 
 	priv->pid = 0;
 
-	/* Make sure /dev/ppp exists (bgo #533064) */
-	if (stat ("/dev/ppp", &st) || !S_ISCHR (st.st_mode))
-		nm_utils_modprobe (NULL, "ppp_generic", NULL);
-
 	connection = nm_act_request_get_connection (req);
 	g_assert (connection);
 
@@ -1116,25 +1163,21 @@ nm_ppp_manager_start (NMPPPManager *manager,
 
 	g_ptr_array_add (ppp_cmd->array, NULL);
 
-	nm_log_info (LOGD_PPP, "starting PPP connection");
-
-	cmd_str = nm_cmd_line_to_str (ppp_cmd);
-	nm_log_dbg (LOGD_PPP, "command line: %s", cmd_str);
-	g_free (cmd_str);
-
-	priv->pid = 0;
-	if (!g_spawn_async (NULL, (char **) ppp_cmd->array->pdata, NULL,
-	                    G_SPAWN_DO_NOT_REAP_CHILD,
-	                    nm_utils_setpgid, NULL,
-	                    &priv->pid, err)) {
+	/* Make sure /dev/ppp exists (bgo #533064) */
+	if (stat ("/dev/ppp", &st) || !S_ISCHR (st.st_mode)) {
+		const char *argv[] = { "/sbin/modprobe", "ppp_generic", NULL };
+
+		/* pppd is started by modprobe_done(); the timeout covers both */
+		priv->pppd_argv = g_strdupv ((char **) ppp_cmd->array->pdata);
+		priv->modprobe_id = nm_utils_spawn_async (argv, NM_UTILS_SPAWN_FLAGS_NONE,
+		                                          PPP_MODPROBE_TIMEOUT_MSEC, LOGD_PPP,
+		                                          modprobe_done, manager, NULL);
+	} else if (!ppp_spawn (manager, (char **) ppp_cmd->array->pdata, err))
 		goto out;
-	}
-
-	nm_log_info (LOGD_PPP, "pppd started with pid %d", priv->pid);
 
-	priv->ppp_watch_id = g_child_watch_add (priv->pid, (GChildWatchFunc) ppp_watch_cb, manager);
 	priv->ppp_timeout_handler = g_timeout_add_seconds (timeout_secs, pppd_timed_out, manager);
 	priv->act_req = g_object_ref (req);
+	success = TRUE;
 
 out:
 	if (s_ppp_created)
@@ -1143,7 +1186,7 @@ out:
 	if (ppp_cmd)
 		nm_cmd_line_destroy (ppp_cmd);
 
-	return priv->pid > 0;
+	return success;
 }
 
 static void
@@ -1193,6 +1236,13 @@ _ppp_cleanup (NMPPPManager *manager)
 		g_source_remove (priv->ppp_watch_id);
 		priv->ppp_watch_id = 0;
 	}
+
+	if (priv->modprobe_id) {
+		nm_utils_spawn_cancel (priv->modprobe_id);
+		priv->modprobe_id = 0;
+	}
+	g_strfreev (priv->pppd_argv);
+	priv->pppd_argv = NULL;
 }
 
 /***********************************************************/
@@ -59,8 +59,7 @@ delayed_start (NMRDisc *rdisc)
 		NM_RDISC_CONFIG_DNS_SERVERS | NM_RDISC_CONFIG_DNS_DOMAINS;
 	debug ("%d", rdisc->dhcp_level);
 
-	g_signal_emit_by_name (
-			rdisc, NM_RDISC_CONFIG_CHANGED, changed);
+	nm_rdisc_emit_config_changed (rdisc, changed);
 }
 
 static void
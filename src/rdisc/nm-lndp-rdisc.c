@@ -46,6 +46,9 @@ typedef struct {
 	guint ra_timeout_id;  /* first RA timeout */
 
 	int solicitations_left;
+
+	GHashTable *index;  /* IndexEntry of every item, by key */
+	GPtrArray *heap;    /* IndexEntry with a finite lifetime, by deadline */
 } NMLNDPRDiscPrivate;
 
 #define NM_LNDP_RDISC_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_LNDP_RDISC, NMLNDPRDiscPrivate))
@@ -89,47 +92,362 @@ nm_lndp_rdisc_new (int ifindex, const char *ifname)
 	return rdisc;
 }
 
-static gboolean
-add_gateway (NMRDisc *rdisc, const NMRDiscGateway *new)
+/* Every item in the NMRDisc arrays has an entry in priv->index, looked
+ * up by the item's key, so that a router advertisement that only
+ * refreshes known items does not scan the arrays.  Entries with a finite
+ * lifetime also sit in priv->heap, ordered by their next deadline, so that
+ * only items that are due are looked at when the timeout fires.
+ */
+
+typedef enum {
+	ITEM_GATEWAY,
+	ITEM_ADDRESS,
+	ITEM_ROUTE,
+	ITEM_DNS_SERVER,
+	ITEM_DNS_DOMAIN,
+	ITEM_LAST
+} ItemType;
+
+static const struct {
+	NMRDiscConfigMap changed;
+	glong array_offset;
+	glong timestamp_offset;
+	glong lifetime_offset;
+	/* Solicit new router advertisements at half the lifetime */
+	gboolean refresh;
+} item_info[ITEM_LAST] = {
+	[ITEM_GATEWAY] = {
+		NM_RDISC_CONFIG_GATEWAYS, G_STRUCT_OFFSET (NMRDisc, gateways),
+		G_STRUCT_OFFSET (NMRDiscGateway, timestamp), G_STRUCT_OFFSET (NMRDiscGateway, lifetime), FALSE,
+	},
+	[ITEM_ADDRESS] = {
+		NM_RDISC_CONFIG_ADDRESSES, G_STRUCT_OFFSET (NMRDisc, addresses),
+		G_STRUCT_OFFSET (NMRDiscAddress, timestamp), G_STRUCT_OFFSET (NMRDiscAddress, lifetime), FALSE,
+	},
+	[ITEM_ROUTE] = {
+		NM_RDISC_CONFIG_ROUTES, G_STRUCT_OFFSET (NMRDisc, routes),
+		G_STRUCT_OFFSET (NMRDiscRoute, timestamp), G_STRUCT_OFFSET (NMRDiscRoute, lifetime), FALSE,
+	},
+	[ITEM_DNS_SERVER] = {
+		NM_RDISC_CONFIG_DNS_SERVERS, G_STRUCT_OFFSET (NMRDisc, dns_servers),
+		G_STRUCT_OFFSET (NMRDiscDNSServer, timestamp), G_STRUCT_OFFSET (NMRDiscDNSServer, lifetime), TRUE,
+	},
+	[ITEM_DNS_DOMAIN] = {
+		NM_RDISC_CONFIG_DNS_DOMAINS, G_STRUCT_OFFSET (NMRDisc, dns_domains),
+		G_STRUCT_OFFSET (NMRDiscDNSDomain, timestamp), G_STRUCT_OFFSET (NMRDiscDNSDomain, lifetime), TRUE,
+	},
+};
+
+#define DEADLINE_NEVER G_MAXUINT64
+#define HEAP_NONE      G_MAXUINT
+
+typedef struct {
+	ItemType type;
+	union {
+		struct in6_addr address;
+		struct {
+			struct in6_addr network;
+			int plen;
+		} route;
+		/* Borrowed from the NMRDiscDNSDomain item */
+		const char *domain;
+	} key;
+
+	guint index;        /* position in the NMRDisc array */
+	guint heap_index;   /* position in priv->heap, or HEAP_NONE */
+	guint64 deadline;   /* next expiry or refresh */
+} IndexEntry;
+
+static guint
+in6_addr_hash (const struct in6_addr *addr)
 {
+	guint h = 5381;
 	int i;
 
-	for (i = 0; i < rdisc->gateways->len; i++) {
-		NMRDiscGateway *item = &g_array_index (rdisc->gateways, NMRDiscGateway, i);
+	for (i = 0; i < 16; i++)
+		h = (h << 5) + h + addr->s6_addr[i];
+	return h;
+}
 
-		if (IN6_ARE_ADDR_EQUAL (&item->address, &new->address)) {
-			if (item->preference != new->preference) {
-				g_array_remove_index (rdisc->gateways, i--);
-				continue;
-			}
-			memcpy (item, new, sizeof (*new));
-			return FALSE;
-		}
+static guint
+index_entry_hash (gconstpointer ptr)
+{
+	const IndexEntry *entry = ptr;
+
+	switch (entry->type) {
+	case ITEM_ROUTE:
+		return (in6_addr_hash (&entry->key.route.network) ^ entry->key.route.plen) * ITEM_LAST + entry->type;
+	case ITEM_DNS_DOMAIN:
+		return g_str_hash (entry->key.domain) * ITEM_LAST + entry->type;
+	default:
+		return in6_addr_hash (&entry->key.address) * ITEM_LAST + entry->type;
+	}
+}
+
+static gboolean
+index_entry_equal (gconstpointer a, gconstpointer b)
+{
+	const IndexEntry *entry_a = a, *entry_b = b;
+
+	if (entry_a->type != entry_b->type)
+		return FALSE;
+
+	switch (entry_a->type) {
+	case ITEM_ROUTE:
+		return    entry_a->key.route.plen == entry_b->key.route.plen
+		       && IN6_ARE_ADDR_EQUAL (&entry_a->key.route.network, &entry_b->key.route.network);
+	case ITEM_DNS_DOMAIN:
+		return !strcmp (entry_a->key.domain, entry_b->key.domain);
+	default:
+		return IN6_ARE_ADDR_EQUAL (&entry_a->key.address, &entry_b->key.address);
+	}
+}
+
+static void
+index_entry_free (gpointer entry)
+{
+	g_slice_free (IndexEntry, entry);
+}
+
+static GArray *
+item_array (NMRDisc *rdisc, ItemType type)
+{
+	return G_STRUCT_MEMBER (GArray *, rdisc, item_info[type].array_offset);
+}
+
+static gpointer
+item_get (NMRDisc *rdisc, ItemType type, guint index)
+{
+	GArray *array = item_array (rdisc, type);
+
+	return array->data + index * g_array_get_element_size (array);
+}
+
+static void
+index_entry_set_key (IndexEntry *entry, ItemType type, gconstpointer item)
+{
+	entry->type = type;
+	switch (type) {
+	case ITEM_GATEWAY:
+		entry->key.address = ((const NMRDiscGateway *) item)->address;
+		break;
+	case ITEM_ADDRESS:
+		entry->key.address = ((const NMRDiscAddress *) item)->address;
+		break;
+	case ITEM_ROUTE:
+		entry->key.route.network = ((const NMRDiscRoute *) item)->network;
+		entry->key.route.plen = ((const NMRDiscRoute *) item)->plen;
+		break;
+	case ITEM_DNS_SERVER:
+		entry->key.address = ((const NMRDiscDNSServer *) item)->address;
+		break;
+	case ITEM_DNS_DOMAIN:
+		entry->key.domain = ((const NMRDiscDNSDomain *) item)->domain;
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+}
+
+static IndexEntry *
+index_lookup (NMRDisc *rdisc, ItemType type, gconstpointer item)
+{
+	NMLNDPRDiscPrivate *priv = NM_LNDP_RDISC_GET_PRIVATE (rdisc);
+	IndexEntry needle;
+
+	index_entry_set_key (&needle, type, item);
+	return g_hash_table_lookup (priv->index, &needle);
+}
+
+/* Moves the index entries of the items from @from on by @delta positions */
+static void
+index_shift (NMRDisc *rdisc, ItemType type, guint from, int delta)
+{
+	GArray *array = item_array (rdisc, type);
+	guint i;
+
+	for (i = from; i < array->len; i++)
+		index_lookup (rdisc, type, item_get (rdisc, type, i))->index += delta;
+}
+
+static void
+heap_swap (GPtrArray *heap, guint a, guint b)
+{
+	IndexEntry *entry_a = heap->pdata[a];
+	IndexEntry *entry_b = heap->pdata[b];
+
+	heap->pdata[a] = entry_b;
+	heap->pdata[b] = entry_a;
+	entry_a->heap_index = b;
+	entry_b->heap_index = a;
+}
+
+static void
+heap_sift (GPtrArray *heap, guint i)
+{
+	IndexEntry **entries = (IndexEntry **) heap->pdata;
 
-		/* Put before less preferable gateways. */
-		if (item->preference < new->preference)
+	while (i > 0 && entries[(i - 1) / 2]->deadline > entries[i]->deadline) {
+		heap_swap (heap, i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+
+	for (;;) {
+		guint smallest = i, child;
+
+		for (child = 2 * i + 1; child <= 2 * i + 2 && child < heap->len; child++) {
+			if (entries[child]->deadline < entries[smallest]->deadline)
+				smallest = child;
+		}
+		if (smallest == i)
 			break;
+		heap_swap (heap, i, smallest);
+		i = smallest;
 	}
+}
 
-	g_array_insert_val (rdisc->gateways, i, *new);
-	return TRUE;
+static void
+heap_remove (GPtrArray *heap, IndexEntry *entry)
+{
+	guint i = entry->heap_index;
+
+	if (i == HEAP_NONE)
+		return;
+
+	heap_swap (heap, i, heap->len - 1);
+	g_ptr_array_set_size (heap, heap->len - 1);
+	entry->heap_index = HEAP_NONE;
+	if (i < heap->len)
+		heap_sift (heap, i);
 }
 
-static gboolean
-add_address (NMRDisc *rdisc, const NMRDiscAddress *new)
+static void
+index_entry_set_deadline (NMRDisc *rdisc, IndexEntry *entry, guint32 now)
 {
-	int i;
+	NMLNDPRDiscPrivate *priv = NM_LNDP_RDISC_GET_PRIVATE (rdisc);
+	gpointer item = item_get (rdisc, entry->type, entry->index);
+	guint32 timestamp = G_STRUCT_MEMBER (guint32, item, item_info[entry->type].timestamp_offset);
+	guint32 lifetime = G_STRUCT_MEMBER (guint32, item, item_info[entry->type].lifetime_offset);
+	guint64 refresh = (guint64) timestamp + lifetime / 2;
+
+	if (lifetime == G_MAXUINT32)
+		entry->deadline = DEADLINE_NEVER;
+	else if (item_info[entry->type].refresh && refresh > now)
+		entry->deadline = refresh;
+	else
+		entry->deadline = (guint64) timestamp + lifetime;
+
+	if (entry->deadline == DEADLINE_NEVER)
+		heap_remove (priv->heap, entry);
+	else if (entry->heap_index == HEAP_NONE) {
+		entry->heap_index = priv->heap->len;
+		g_ptr_array_add (priv->heap, entry);
+		heap_sift (priv->heap, entry->heap_index);
+	} else
+		heap_sift (priv->heap, entry->heap_index);
+}
 
-	for (i = 0; i < rdisc->addresses->len; i++) {
-		NMRDiscAddress *item = &g_array_index (rdisc->addresses, NMRDiscAddress, i);
+static void
+item_insert (NMRDisc *rdisc, ItemType type, guint index, gconstpointer item, guint32 now)
+{
+	NMLNDPRDiscPrivate *priv = NM_LNDP_RDISC_GET_PRIVATE (rdisc);
+	IndexEntry *entry;
+
+	g_array_insert_vals (item_array (rdisc, type), index, item, 1);
+	index_shift (rdisc, type, index + 1, 1);
+
+	entry = g_slice_new0 (IndexEntry);
+	index_entry_set_key (entry, type, item_get (rdisc, type, index));
+	entry->index = index;
+	entry->heap_index = HEAP_NONE;
+	g_hash_table_add (priv->index, entry);
+	index_entry_set_deadline (rdisc, entry, now);
+
+	if (type == ITEM_ADDRESS)
+		nm_rdisc_changes_add_address (rdisc, item, FALSE);
+	else if (type == ITEM_ROUTE)
+		nm_rdisc_changes_add_route (rdisc, item, FALSE);
+}
+
+static void
+item_remove (NMRDisc *rdisc, IndexEntry *entry)
+{
+	NMLNDPRDiscPrivate *priv = NM_LNDP_RDISC_GET_PRIVATE (rdisc);
+	ItemType type = entry->type;
+	guint index = entry->index;
+	gpointer item = item_get (rdisc, type, index);
+
+	if (type == ITEM_ADDRESS)
+		nm_rdisc_changes_add_address (rdisc, item, TRUE);
+	else if (type == ITEM_ROUTE)
+		nm_rdisc_changes_add_route (rdisc, item, TRUE);
+
+	heap_remove (priv->heap, entry);
+	g_hash_table_remove (priv->index, entry);
+	if (type == ITEM_DNS_DOMAIN)
+		g_free (((NMRDiscDNSDomain *) item)->domain);
+
+	g_array_remove_index (item_array (rdisc, type), index);
+	index_shift (rdisc, type, index, -1);
+}
+
+/* Gateways and routes are sorted by descending preference.  Returns the
+ * position after the last item that is at least as preferable. */
+static guint
+preference_position (NMRDisc *rdisc, ItemType type, glong preference_offset, NMRDiscPreference preference)
+{
+	GArray *array = item_array (rdisc, type);
+	guint lo = 0, hi = array->len;
+
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+
+		if (G_STRUCT_MEMBER (NMRDiscPreference, item_get (rdisc, type, mid), preference_offset) < preference)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
 
-		if (IN6_ARE_ADDR_EQUAL (&item->address, &new->address)) {
-			gboolean changed = item->timestamp + item->lifetime  != new->timestamp + new->lifetime ||
-			                   item->timestamp + item->preferred != new->timestamp + new->preferred;
+static gboolean
+add_gateway (NMRDisc *rdisc, const NMRDiscGateway *new)
+{
+	IndexEntry *entry = index_lookup (rdisc, ITEM_GATEWAY, new);
+
+	if (entry) {
+		NMRDiscGateway *item = item_get (rdisc, ITEM_GATEWAY, entry->index);
 
+		if (item->preference == new->preference) {
 			*item = *new;
-			return changed;
+			index_entry_set_deadline (rdisc, entry, new->timestamp);
+			return FALSE;
 		}
+		item_remove (rdisc, entry);
+	}
+
+	/* Put before less preferable gateways. */
+	item_insert (rdisc, ITEM_GATEWAY,
+	             preference_position (rdisc, ITEM_GATEWAY, G_STRUCT_OFFSET (NMRDiscGateway, preference), new->preference),
+	             new, new->timestamp);
+	return TRUE;
+}
+
+static gboolean
+add_address (NMRDisc *rdisc, const NMRDiscAddress *new)
+{
+	IndexEntry *entry = index_lookup (rdisc, ITEM_ADDRESS, new);
+
+	if (entry) {
+		NMRDiscAddress *item = item_get (rdisc, ITEM_ADDRESS, entry->index);
+		gboolean changed = item->timestamp + item->lifetime  != new->timestamp + new->lifetime ||
+		                   item->timestamp + item->preferred != new->timestamp + new->preferred;
+
+		*item = *new;
+		index_entry_set_deadline (rdisc, entry, new->timestamp);
+		if (changed)
+			nm_rdisc_changes_add_address (rdisc, item, FALSE);
+		return changed;
 	}
 
 	/* we create at most max_addresses autoconf addresses. This is different from
@@ -139,63 +457,58 @@ add_address (NMRDisc *rdisc, const NMRDiscAddress *new)
 	if (rdisc->max_addresses && rdisc->addresses->len >= rdisc->max_addresses)
 		return FALSE;
 
-	g_array_insert_val (rdisc->addresses, i, *new);
+	item_insert (rdisc, ITEM_ADDRESS, rdisc->addresses->len, new, new->timestamp);
 	return TRUE;
 }
 
 static gboolean
 add_route (NMRDisc *rdisc, const NMRDiscRoute *new)
 {
-	int i;
+	IndexEntry *entry = index_lookup (rdisc, ITEM_ROUTE, new);
 
-	for (i = 0; i < rdisc->routes->len; i++) {
-		NMRDiscRoute *item = &g_array_index (rdisc->routes, NMRDiscRoute, i);
+	if (entry) {
+		NMRDiscRoute *item = item_get (rdisc, ITEM_ROUTE, entry->index);
 
-		if (IN6_ARE_ADDR_EQUAL (&item->network, &new->network) && item->plen == new->plen) {
-			if (item->preference != new->preference) {
-				g_array_remove_index (rdisc->routes, i--);
-				continue;
-			}
-			memcpy (item, new, sizeof (*new));
+		if (item->preference == new->preference) {
+			*item = *new;
+			index_entry_set_deadline (rdisc, entry, new->timestamp);
 			return FALSE;
 		}
-
-		/* Put before less preferable routes. */
-		if (item->preference < new->preference)
-			break;
+		item_remove (rdisc, entry);
 	}
 
-	g_array_insert_val (rdisc->routes, i, *new);
+	/* Put before less preferable routes. */
+	item_insert (rdisc, ITEM_ROUTE,
+	             preference_position (rdisc, ITEM_ROUTE, G_STRUCT_OFFSET (NMRDiscRoute, preference), new->preference),
+	             new, new->timestamp);
 	return TRUE;
 }
 
 static gboolean
 add_dns_server (NMRDisc *rdisc, const NMRDiscDNSServer *new)
 {
-	int i;
-
-	for (i = 0; i < rdisc->dns_servers->len; i++) {
-		NMRDiscDNSServer *item = &g_array_index (rdisc->dns_servers, NMRDiscDNSServer, i);
+	IndexEntry *entry = index_lookup (rdisc, ITEM_DNS_SERVER, new);
 
-		if (IN6_ARE_ADDR_EQUAL (&item->address, &new->address)) {
-			gboolean changed;
+	if (entry) {
+		NMRDiscDNSServer *item = item_get (rdisc, ITEM_DNS_SERVER, entry->index);
+		gboolean changed;
 
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdisc->dns_servers, i);
-				return TRUE;
-			}
+		if (new->lifetime == 0) {
+			item_remove (rdisc, entry);
+			return TRUE;
+		}
 
-			changed = (item->timestamp != new->timestamp ||
-			           item->lifetime != new->lifetime);
-			if (changed) {
-				item->timestamp = new->timestamp;
-				item->lifetime = new->lifetime;
-			}
-			return changed;
+		changed = (item->timestamp != new->timestamp ||
+		           item->lifetime != new->lifetime);
+		if (changed) {
+			item->timestamp = new->timestamp;
+			item->lifetime = new->lifetime;
+			index_entry_set_deadline (rdisc, entry, new->timestamp);
 		}
+		return changed;
 	}
 
-	g_array_insert_val (rdisc->dns_servers, i, *new);
+	item_insert (rdisc, ITEM_DNS_SERVER, rdisc->dns_servers->len, new, new->timestamp);
 	return TRUE;
 }
 
@@ -203,33 +516,31 @@ add_dns_server (NMRDisc *rdisc, const NMRDiscDNSServer *new)
 static gboolean
 add_dns_domain (NMRDisc *rdisc, const NMRDiscDNSDomain *new)
 {
-	NMRDiscDNSDomain *item;
-	int i;
+	IndexEntry *entry = index_lookup (rdisc, ITEM_DNS_DOMAIN, new);
+	NMRDiscDNSDomain item_new;
 
-	for (i = 0; i < rdisc->dns_domains->len; i++) {
-		item = &g_array_index (rdisc->dns_domains, NMRDiscDNSDomain, i);
+	if (entry) {
+		NMRDiscDNSDomain *item = item_get (rdisc, ITEM_DNS_DOMAIN, entry->index);
+		gboolean changed;
 
-		if (!g_strcmp0 (item->domain, new->domain)) {
-			gboolean changed;
-
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdisc->dns_domains, i);
-				return TRUE;
-			}
+		if (new->lifetime == 0) {
+			item_remove (rdisc, entry);
+			return TRUE;
+		}
 
-			changed = (item->timestamp != new->timestamp ||
-			           item->lifetime != new->lifetime);
-			if (changed) {
-				item->timestamp = new->timestamp;
-				item->lifetime = new->lifetime;
-			}
-			return changed;
+		changed = (item->timestamp != new->timestamp ||
+		           item->lifetime != new->lifetime);
+		if (changed) {
+			item->timestamp = new->timestamp;
+			item->lifetime = new->lifetime;
+			index_entry_set_deadline (rdisc, entry, new->timestamp);
 		}
+		return changed;
 	}
 
-	g_array_insert_val (rdisc->dns_domains, i, *new);
-	item = &g_array_index (rdisc->dns_domains, NMRDiscDNSDomain, i);
-	item->domain = g_strdup (new->domain);
+	item_new = *new;
+	item_new.domain = g_strdup (new->domain);
+	item_insert (rdisc, ITEM_DNS_DOMAIN, rdisc->dns_domains->len, &item_new, new->timestamp);
 	return TRUE;
 }
 
@@ -280,142 +591,50 @@ solicit (NMRDisc *rdisc)
 	}
 }
 
-static void
-clean_gateways (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap *changed, guint32 *nextevent)
-{
-	int i;
-
-	for (i = 0; i < rdisc->gateways->len; i++) {
-		NMRDiscGateway *item = &g_array_index (rdisc->gateways, NMRDiscGateway, i);
-		guint64 expiry = (guint64) item->timestamp + item->lifetime;
-
-		if (item->lifetime == G_MAXUINT32)
-			continue;
-
-		if (now >= expiry) {
-			g_array_remove_index (rdisc->gateways, i--);
-			*changed |= NM_RDISC_CONFIG_GATEWAYS;
-		} else if (*nextevent > expiry)
-			*nextevent = expiry;
-	}
-}
-
-static void
-clean_addresses (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap *changed, guint32 *nextevent)
-{
-	int i;
-
-	for (i = 0; i < rdisc->addresses->len; i++) {
-		NMRDiscAddress *item = &g_array_index (rdisc->addresses, NMRDiscAddress, i);
-		guint64 expiry = (guint64) item->timestamp + item->lifetime;
-
-		if (item->lifetime == G_MAXUINT32)
-			continue;
-
-		if (now >= expiry) {
-			g_array_remove_index (rdisc->addresses, i--);
-			*changed |= NM_RDISC_CONFIG_ADDRESSES;
-		} else if (*nextevent > expiry)
-			*nextevent = expiry;
-	}
-}
-
-static void
-clean_routes (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap *changed, guint32 *nextevent)
-{
-	int i;
-
-	for (i = 0; i < rdisc->routes->len; i++) {
-		NMRDiscRoute *item = &g_array_index (rdisc->routes, NMRDiscRoute, i);
-		guint64 expiry = (guint64) item->timestamp + item->lifetime;
-
-		if (item->lifetime == G_MAXUINT32)
-			continue;
-
-		if (now >= expiry) {
-			g_array_remove_index (rdisc->routes, i--);
-			*changed |= NM_RDISC_CONFIG_ROUTES;
-		} else if (*nextevent > expiry)
-			*nextevent = expiry;
-	}
-}
-
-static void
-clean_dns_servers (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap *changed, guint32 *nextevent)
-{
-	int i;
-
-	for (i = 0; i < rdisc->dns_servers->len; i++) {
-		NMRDiscDNSServer *item = &g_array_index (rdisc->dns_servers, NMRDiscDNSServer, i);
-		guint64 expiry = (guint64) item->timestamp + item->lifetime;
-		guint64 refresh = (guint64) item->timestamp + item->lifetime / 2;
-
-		if (item->lifetime == G_MAXUINT32)
-			continue;
-
-		if (now >= expiry) {
-			g_array_remove_index (rdisc->dns_servers, i--);
-			*changed |= NM_RDISC_CONFIG_DNS_SERVERS;
-		} else if (now >= refresh)
-			solicit (rdisc);
-		else if (*nextevent > refresh)
-			*nextevent = refresh;
-	}
-}
-
-static void
-clean_dns_domains (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap *changed, guint32 *nextevent)
-{
-	int i;
-
-	for (i = 0; i < rdisc->dns_domains->len; i++) {
-		NMRDiscDNSDomain *item = &g_array_index (rdisc->dns_domains, NMRDiscDNSDomain, i);
-		guint64 expiry = (guint64) item->timestamp + item->lifetime;
-		guint64 refresh = (guint64) item->timestamp + item->lifetime / 2;
-
-		if (item->lifetime == G_MAXUINT32)
-			continue;
-
-		if (now >= expiry) {
-			g_free (item->domain);
-			g_array_remove_index (rdisc->dns_domains, i--);
-			*changed |= NM_RDISC_CONFIG_DNS_DOMAINS;
-		} else if (now >= refresh)
-			solicit (rdisc);
-		else if (*nextevent > refresh)
-			*nextevent = refresh;
-	}
-}
-
 static gboolean timeout_cb (gpointer user_data);
 
 static void
 check_timestamps (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap changed)
 {
 	NMLNDPRDiscPrivate *priv = NM_LNDP_RDISC_GET_PRIVATE (rdisc);
-	/* Use a magic date in the distant future (~68 years) */
-	guint32 never = G_MAXINT32;
-	guint32 nextevent = never;
 
 	if (priv->timeout_id) {
 		g_source_remove (priv->timeout_id);
 		priv->timeout_id = 0;
 	}
 
-	clean_gateways (rdisc, now, &changed, &nextevent);
-	clean_addresses (rdisc, now, &changed, &nextevent);
-	clean_routes (rdisc, now, &changed, &nextevent);
-	clean_dns_servers (rdisc, now, &changed, &nextevent);
-	clean_dns_domains (rdisc, now, &changed, &nextevent);
+	while (priv->heap->len) {
+		IndexEntry *entry = priv->heap->pdata[0];
+		gpointer item;
+		guint64 expiry;
+
+		if (entry->deadline > now)
+			break;
+
+		item = item_get (rdisc, entry->type, entry->index);
+		expiry = (guint64) G_STRUCT_MEMBER (guint32, item, item_info[entry->type].timestamp_offset)
+		         + G_STRUCT_MEMBER (guint32, item, item_info[entry->type].lifetime_offset);
+		if (now >= expiry) {
+			changed |= item_info[entry->type].changed;
+			item_remove (rdisc, entry);
+		} else {
+			/* Half of the lifetime passed */
+			solicit (rdisc);
+			index_entry_set_deadline (rdisc, entry, now);
+		}
+	}
 
 	if (changed)
-		g_signal_emit_by_name (rdisc, NM_RDISC_CONFIG_CHANGED, changed);
+		nm_rdisc_emit_config_changed (rdisc, changed);
+
+	if (priv->heap->len) {
+		guint64 nextevent = ((IndexEntry *) priv->heap->pdata[0])->deadline;
 
-	if (nextevent != never) {
 		g_return_if_fail (nextevent > now);
+		nextevent = MIN (nextevent - now, G_MAXINT32);
 		debug ("(%s): scheduling next now/lifetime check: %u seconds",
-		       rdisc->ifname, nextevent - now);
-		priv->timeout_id = g_timeout_add_seconds (nextevent - now, timeout_cb, rdisc);
+		       rdisc->ifname, (guint) nextevent);
+		priv->timeout_id = g_timeout_add_seconds (nextevent, timeout_cb, rdisc);
 	}
 }
 
@@ -694,9 +913,58 @@ start (NMRDisc *rdisc)
 
 /******************************************************************/
 
+static void
+flush_addresses (NMRDisc *rdisc)
+{
+	while (rdisc->addresses->len) {
+		NMRDiscAddress *item = &g_array_index (rdisc->addresses, NMRDiscAddress, rdisc->addresses->len - 1);
+
+		item_remove (rdisc, index_lookup (rdisc, ITEM_ADDRESS, item));
+	}
+}
+
+/******************************************************************/
+
+gboolean
+_nm_lndp_rdisc_add_item (NMRDisc *rdisc, NMRDiscConfigMap type, gconstpointer item)
+{
+	switch (type) {
+	case NM_RDISC_CONFIG_GATEWAYS:
+		return add_gateway (rdisc, item);
+	case NM_RDISC_CONFIG_ADDRESSES:
+		return add_address (rdisc, item);
+	case NM_RDISC_CONFIG_ROUTES:
+		return add_route (rdisc, item);
+	case NM_RDISC_CONFIG_DNS_SERVERS:
+		return add_dns_server (rdisc, item);
+	case NM_RDISC_CONFIG_DNS_DOMAINS:
+		return add_dns_domain (rdisc, item);
+	default:
+		g_return_val_if_reached (FALSE);
+	}
+}
+
+void
+_nm_lndp_rdisc_check_timestamps (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap changed)
+{
+	check_timestamps (rdisc, now, changed);
+}
+
+gboolean
+_nm_lndp_rdisc_get_solicit_pending (NMRDisc *rdisc)
+{
+	return NM_LNDP_RDISC_GET_PRIVATE (rdisc)->send_rs_id != 0;
+}
+
+/******************************************************************/
+
 static void
 nm_lndp_rdisc_init (NMLNDPRDisc *lndp_rdisc)
 {
+	NMLNDPRDiscPrivate *priv = NM_LNDP_RDISC_GET_PRIVATE (lndp_rdisc);
+
+	priv->index = g_hash_table_new_full (index_entry_hash, index_entry_equal, index_entry_free, NULL);
+	priv->heap = g_ptr_array_new ();
 }
 
 static void
@@ -723,6 +991,19 @@ dispose (GObject *object)
 		ndp_close (priv->ndp);
 		priv->ndp = NULL;
 	}
+
+	G_OBJECT_CLASS (nm_lndp_rdisc_parent_class)->dispose (object);
+}
+
+static void
+finalize (GObject *object)
+{
+	NMLNDPRDiscPrivate *priv = NM_LNDP_RDISC_GET_PRIVATE (object);
+
+	g_ptr_array_unref (priv->heap);
+	g_hash_table_unref (priv->index);
+
+	G_OBJECT_CLASS (nm_lndp_rdisc_parent_class)->finalize (object);
 }
 
 static void
@@ -734,5 +1015,7 @@ nm_lndp_rdisc_class_init (NMLNDPRDiscClass *klass)
 	g_type_class_add_private (klass, sizeof (NMLNDPRDiscPrivate));
 
 	object_class->dispose = dispose;
+	object_class->finalize = finalize;
 	rdisc_class->start = start;
+	rdisc_class->flush_addresses = flush_addresses;
 }
@@ -46,4 +46,10 @@ GType nm_lndp_rdisc_get_type (void);
 
 NMRDisc *nm_lndp_rdisc_new (int ifindex, const char *ifname);
 
+/* For testcases only! The router discovery itself is not started, items
+ * are added as if they were received in a router advertisement. */
+gboolean _nm_lndp_rdisc_add_item (NMRDisc *rdisc, NMRDiscConfigMap type, gconstpointer item);
+void _nm_lndp_rdisc_check_timestamps (NMRDisc *rdisc, guint32 now, NMRDiscConfigMap changed);
+gboolean _nm_lndp_rdisc_get_solicit_pending (NMRDisc *rdisc);
+
 #endif /* __NETWORKMANAGER_LNDP_RDISC_H__ */
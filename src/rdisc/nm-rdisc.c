@@ -21,12 +21,15 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <arpa/inet.h>
 
 #include "nm-rdisc.h"
 
 #include "nm-logging.h"
 #include "nm-utils.h"
+#include "nm-ip6-config.h"
+#include "nm-platform.h"
 
 #define debug(...) nm_log_dbg (LOGD_IP6, __VA_ARGS__)
 
@@ -67,8 +70,8 @@ nm_rdisc_set_iid (NMRDisc *rdisc, const NMUtilsIPv6IfaceId iid)
 		rdisc->iid = iid;
 		if (rdisc->addresses->len) {
 			debug ("(%s) IPv6 interface identifier changed, flushing addresses", rdisc->ifname);
-			g_array_remove_range (rdisc->addresses, 0, rdisc->addresses->len);
-			g_signal_emit_by_name (rdisc, NM_RDISC_CONFIG_CHANGED, NM_RDISC_CONFIG_ADDRESSES);
+			NM_RDISC_GET_CLASS (rdisc)->flush_addresses (rdisc);
+			nm_rdisc_emit_config_changed (rdisc, NM_RDISC_CONFIG_ADDRESSES);
 		}
 		return TRUE;
 	}
@@ -89,6 +92,246 @@ nm_rdisc_start (NMRDisc *rdisc)
 		klass->start (rdisc);
 }
 
+/* Drops a pending change of the item with the same key, which is the
+ * first @key_len bytes of the item. */
+static void
+changes_forget (GArray *changes, gconstpointer item, gsize key_len)
+{
+	guint size = g_array_get_element_size (changes);
+	guint i;
+
+	for (i = 0; i < changes->len; i++) {
+		if (!memcmp (changes->data + i * size, item, key_len))
+			g_array_remove_index_fast (changes, i--);
+	}
+}
+
+/**
+ * nm_rdisc_changes_add_address:
+ * @rdisc: the #NMRDisc
+ * @address: the address that was added, updated or removed
+ * @removed: whether @address was removed
+ *
+ * Records a change of @rdisc->addresses for the next "config-changed"
+ * signal.  Implementations that record every change of the addresses
+ * let listeners update their configuration incrementally.
+ */
+void
+nm_rdisc_changes_add_address (NMRDisc *rdisc, const NMRDiscAddress *address, gboolean removed)
+{
+	NMRDiscChanges *changes = &rdisc->changes;
+
+	changes->tracked |= NM_RDISC_CONFIG_ADDRESSES;
+	if (removed) {
+		changes_forget (changes->addresses, address, sizeof (address->address));
+		g_array_append_val (changes->addresses_removed, *address);
+	} else
+		g_array_append_val (changes->addresses, *address);
+}
+
+/**
+ * nm_rdisc_changes_add_route:
+ * @rdisc: the #NMRDisc
+ * @route: the route that was added, updated or removed
+ * @removed: whether @route was removed
+ *
+ * Like nm_rdisc_changes_add_address(), for @rdisc->routes.
+ */
+void
+nm_rdisc_changes_add_route (NMRDisc *rdisc, const NMRDiscRoute *route, gboolean removed)
+{
+	NMRDiscChanges *changes = &rdisc->changes;
+
+	changes->tracked |= NM_RDISC_CONFIG_ROUTES;
+	if (removed) {
+		/* Routes are identified by network and prefix length */
+		changes_forget (changes->routes, route,
+		                G_STRUCT_OFFSET (NMRDiscRoute, plen) + sizeof (route->plen));
+		g_array_append_val (changes->routes_removed, *route);
+	} else
+		g_array_append_val (changes->routes, *route);
+}
+
+/**
+ * nm_rdisc_emit_config_changed:
+ * @rdisc: the #NMRDisc
+ * @changed: the sections that changed
+ *
+ * Emits "config-changed" with the changes recorded since the previous
+ * emission and starts a new change set.
+ */
+void
+nm_rdisc_emit_config_changed (NMRDisc *rdisc, NMRDiscConfigMap changed)
+{
+	NMRDiscChanges *changes = &rdisc->changes;
+
+	changes->tracked &= changed;
+	g_signal_emit (rdisc, signals[CONFIG_CHANGED], 0, changed);
+
+	changes->tracked = 0;
+	g_array_set_size (changes->addresses, 0);
+	g_array_set_size (changes->addresses_removed, 0);
+	g_array_set_size (changes->routes, 0);
+	g_array_set_size (changes->routes_removed, 0);
+}
+
+/******************************************************************/
+
+static void
+ip6_config_add_address (NMIP6Config *config, const NMRDiscAddress *discovered_address,
+                        gboolean system_support, guint ifa_flags)
+{
+	NMPlatformIP6Address address;
+
+	memset (&address, 0, sizeof (address));
+	address.address = discovered_address->address;
+	address.plen = system_support ? 64 : 128;
+	address.timestamp = discovered_address->timestamp;
+	address.lifetime = discovered_address->lifetime;
+	address.preferred = discovered_address->preferred;
+	if (address.preferred > address.lifetime)
+		address.preferred = address.lifetime;
+	address.source = NM_IP_CONFIG_SOURCE_RDISC;
+	address.flags = ifa_flags;
+
+	nm_ip6_config_add_address (config, &address);
+}
+
+static void
+ip6_config_remove_address (NMIP6Config *config, const NMRDiscAddress *discovered_address)
+{
+	guint i;
+
+	for (i = 0; i < nm_ip6_config_get_num_addresses (config); i++) {
+		const NMPlatformIP6Address *address = nm_ip6_config_get_address (config, i);
+
+		if (IN6_ARE_ADDR_EQUAL (&address->address, &discovered_address->address)) {
+			nm_ip6_config_del_address (config, i);
+			return;
+		}
+	}
+}
+
+static void
+ip6_config_add_route (NMIP6Config *config, const NMRDiscRoute *discovered_route, guint32 metric)
+{
+	NMPlatformIP6Route route;
+
+	/* Only accept non-default routes.  The router has no idea what the
+	 * local configuration or user preferences are, so sending routes
+	 * with a prefix length of 0 is quite rude and thus ignored.
+	 */
+	if (discovered_route->plen > 0) {
+		memset (&route, 0, sizeof (route));
+		route.network = discovered_route->network;
+		route.plen = discovered_route->plen;
+		route.gateway = discovered_route->gateway;
+		route.source = NM_IP_CONFIG_SOURCE_RDISC;
+		route.metric = metric;
+
+		nm_ip6_config_add_route (config, &route);
+	}
+}
+
+static void
+ip6_config_remove_route (NMIP6Config *config, const NMRDiscRoute *discovered_route)
+{
+	guint i;
+
+	for (i = 0; i < nm_ip6_config_get_num_routes (config); i++) {
+		const NMPlatformIP6Route *route = nm_ip6_config_get_route (config, i);
+
+		if (   route->plen == discovered_route->plen
+		    && IN6_ARE_ADDR_EQUAL (&route->network, &discovered_route->network)) {
+			nm_ip6_config_del_route (config, i);
+			return;
+		}
+	}
+}
+
+/**
+ * nm_rdisc_apply_addresses:
+ * @rdisc: the #NMRDisc
+ * @config: the configuration to update
+ * @incremental: whether @config already holds the addresses of the
+ *   previous "config-changed" signal and only @rdisc->changes are applied
+ * @system_support: whether the kernel supports IFA_F_NOPREFIXROUTE; if
+ *   not, the addresses are added as /128
+ * @ifa_flags: flags of the added addresses
+ *
+ * Updates the addresses of @config from within a "config-changed" handler.
+ */
+void
+nm_rdisc_apply_addresses (NMRDisc *rdisc, NMIP6Config *config, gboolean incremental,
+                          gboolean system_support, guint ifa_flags)
+{
+	guint i;
+
+	if (incremental) {
+		/* Apply only what changed since the last signal. */
+		for (i = 0; i < rdisc->changes.addresses_removed->len; i++) {
+			ip6_config_remove_address (config,
+			                           &g_array_index (rdisc->changes.addresses_removed, NMRDiscAddress, i));
+		}
+		for (i = 0; i < rdisc->changes.addresses->len; i++) {
+			const NMRDiscAddress *address = &g_array_index (rdisc->changes.addresses, NMRDiscAddress, i);
+
+			/* nm_ip6_config_add_address() keeps the longer lifetime of an
+			 * existing address, but the router may shorten it. */
+			ip6_config_remove_address (config, address);
+			ip6_config_add_address (config, address, system_support, ifa_flags);
+		}
+	} else {
+		/* Rebuild address list from router discovery cache. */
+		nm_ip6_config_reset_addresses (config);
+
+		/* rdisc->addresses contains at most max_addresses entries.
+		 * This is different from what the kernel does, which
+		 * also counts static and temporary addresses when checking
+		 * max_addresses.
+		 **/
+		for (i = 0; i < rdisc->addresses->len; i++) {
+			ip6_config_add_address (config,
+			                        &g_array_index (rdisc->addresses, NMRDiscAddress, i),
+			                        system_support, ifa_flags);
+		}
+	}
+}
+
+/**
+ * nm_rdisc_apply_routes:
+ * @rdisc: the #NMRDisc
+ * @config: the configuration to update
+ * @incremental: like for nm_rdisc_apply_addresses()
+ * @metric: metric of the added routes
+ *
+ * Updates the routes of @config from within a "config-changed" handler.
+ */
+void
+nm_rdisc_apply_routes (NMRDisc *rdisc, NMIP6Config *config, gboolean incremental, guint32 metric)
+{
+	guint i;
+
+	if (incremental) {
+		/* Apply only what changed since the last signal. */
+		for (i = 0; i < rdisc->changes.routes_removed->len; i++) {
+			ip6_config_remove_route (config,
+			                         &g_array_index (rdisc->changes.routes_removed, NMRDiscRoute, i));
+		}
+		for (i = 0; i < rdisc->changes.routes->len; i++) {
+			ip6_config_add_route (config,
+			                      &g_array_index (rdisc->changes.routes, NMRDiscRoute, i),
+			                      metric);
+		}
+	} else {
+		/* Rebuild route list from router discovery cache. */
+		nm_ip6_config_reset_routes (config);
+
+		for (i = 0; i < rdisc->routes->len; i++)
+			ip6_config_add_route (config, &g_array_index (rdisc->routes, NMRDiscRoute, i), metric);
+	}
+}
+
 #define CONFIG_MAP_MAX_STR 7
 
 static void
@@ -171,6 +414,16 @@ config_changed (NMRDisc *rdisc, NMRDiscConfigMap changed)
 	}
 }
 
+static void
+flush_addresses (NMRDisc *rdisc)
+{
+	guint i;
+
+	for (i = 0; i < rdisc->addresses->len; i++)
+		nm_rdisc_changes_add_address (rdisc, &g_array_index (rdisc->addresses, NMRDiscAddress, i), TRUE);
+	g_array_set_size (rdisc->addresses, 0);
+}
+
 /******************************************************************/
 
 static void
@@ -182,6 +435,11 @@ nm_rdisc_init (NMRDisc *rdisc)
 	rdisc->dns_servers = g_array_new (FALSE, FALSE, sizeof (NMRDiscDNSServer));
 	rdisc->dns_domains = g_array_new (FALSE, FALSE, sizeof (NMRDiscDNSDomain));
 	rdisc->hop_limit = 64;
+
+	rdisc->changes.addresses = g_array_new (FALSE, FALSE, sizeof (NMRDiscAddress));
+	rdisc->changes.addresses_removed = g_array_new (FALSE, FALSE, sizeof (NMRDiscAddress));
+	rdisc->changes.routes = g_array_new (FALSE, FALSE, sizeof (NMRDiscRoute));
+	rdisc->changes.routes_removed = g_array_new (FALSE, FALSE, sizeof (NMRDiscRoute));
 }
 
 static void
@@ -195,6 +453,11 @@ nm_rdisc_finalize (GObject *object)
 	g_array_unref (rdisc->routes);
 	g_array_unref (rdisc->dns_servers);
 	g_array_unref (rdisc->dns_domains);
+
+	g_array_unref (rdisc->changes.addresses);
+	g_array_unref (rdisc->changes.addresses_removed);
+	g_array_unref (rdisc->changes.routes);
+	g_array_unref (rdisc->changes.routes_removed);
 }
 
 static void
@@ -204,6 +467,7 @@ nm_rdisc_class_init (NMRDiscClass *klass)
 
 	object_class->finalize = nm_rdisc_finalize;
 
+	klass->flush_addresses = flush_addresses;
 	klass->config_changed = config_changed;
 
 	signals[CONFIG_CHANGED] = g_signal_new (
@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <netinet/in.h>
 
+#include "nm-types.h"
 #include "NetworkManagerUtils.h"
 
 #define NM_TYPE_RDISC            (nm_rdisc_get_type ())
@@ -98,6 +99,27 @@ typedef enum {
 	NM_RDISC_CONFIG_MTU                                 = 1 << 7,
 } NMRDiscConfigMap;
 
+/**
+ * NMRDiscChanges:
+ * @tracked: sections whose changes are completely listed here; other
+ *   changed sections have to be re-read from the #NMRDisc arrays
+ * @addresses: #NMRDiscAddress items added or updated
+ * @addresses_removed: #NMRDiscAddress items removed
+ * @routes: #NMRDiscRoute items added or updated
+ * @routes_removed: #NMRDiscRoute items removed
+ *
+ * Items that changed since the previous "config-changed" signal.  Only
+ * valid while the signal is emitted.  Removals are to be applied before
+ * additions.
+ */
+typedef struct {
+	NMRDiscConfigMap tracked;
+	GArray *addresses;
+	GArray *addresses_removed;
+	GArray *routes;
+	GArray *routes_removed;
+} NMRDiscChanges;
+
 #define NM_RDISC_MAX_ADDRESSES_DEFAULT 16
 #define NM_RDISC_RTR_SOLICITATIONS_DEFAULT 3
 #define NM_RDISC_RTR_SOLICITATION_INTERVAL_DEFAULT 4
@@ -127,12 +149,15 @@ typedef struct {
 	GArray *dns_domains;
 	int hop_limit;
 	guint32 mtu;
+
+	NMRDiscChanges changes;
 } NMRDisc;
 
 typedef struct {
 	GObjectClass parent;
 
 	void (*start) (NMRDisc *rdisc);
+	void (*flush_addresses) (NMRDisc *rdisc);
 	void (*config_changed) (NMRDisc *rdisc, NMRDiscConfigMap changed);
 	void (*ra_timeout) (NMRDisc *rdisc);
 } NMRDiscClass;
@@ -142,4 +167,12 @@ GType nm_rdisc_get_type (void);
 gboolean nm_rdisc_set_iid (NMRDisc *rdisc, const NMUtilsIPv6IfaceId iid);
 void nm_rdisc_start (NMRDisc *rdisc);
 
+void nm_rdisc_changes_add_address (NMRDisc *rdisc, const NMRDiscAddress *address, gboolean removed);
+void nm_rdisc_changes_add_route (NMRDisc *rdisc, const NMRDiscRoute *route, gboolean removed);
+void nm_rdisc_emit_config_changed (NMRDisc *rdisc, NMRDiscConfigMap changed);
+
+void nm_rdisc_apply_addresses (NMRDisc *rdisc, NMIP6Config *config, gboolean incremental,
+                               gboolean system_support, guint ifa_flags);
+void nm_rdisc_apply_routes (NMRDisc *rdisc, NMIP6Config *config, gboolean incremental, guint32 metric);
+
 #endif /* __NETWORKMANAGER_RDISC_H__ */
@@ -0,0 +1,534 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "nm-rdisc.h"
+#include "nm-lndp-rdisc.h"
+#include "nm-ip6-config.h"
+#include "nm-platform.h"
+#include "nm-logging.h"
+
+#include "nm-test-utils.h"
+
+#define METRIC 1024
+
+typedef struct {
+	NMRDisc *rdisc;
+	/* Updated from rdisc->changes, like the device's ac_ip6_config */
+	NMIP6Config *config;
+	guint emitted;
+	NMRDiscConfigMap changed;
+} TestData;
+
+static guint64
+expiry (guint32 timestamp, guint32 lifetime)
+{
+	if (lifetime == NM_PLATFORM_LIFETIME_PERMANENT)
+		return G_MAXUINT64;
+	return (guint64) timestamp + lifetime;
+}
+
+/* The order of the addresses and routes is not significant */
+static void
+assert_config_equal (NMIP6Config *a, NMIP6Config *b)
+{
+	guint i, j;
+
+	g_assert_cmpint (nm_ip6_config_get_num_addresses (a), ==, nm_ip6_config_get_num_addresses (b));
+	for (i = 0; i < nm_ip6_config_get_num_addresses (a); i++) {
+		const NMPlatformIP6Address *addr_a = nm_ip6_config_get_address (a, i);
+		const NMPlatformIP6Address *addr_b = NULL;
+
+		for (j = 0; j < nm_ip6_config_get_num_addresses (b); j++) {
+			addr_b = nm_ip6_config_get_address (b, j);
+			if (IN6_ARE_ADDR_EQUAL (&addr_a->address, &addr_b->address))
+				break;
+			addr_b = NULL;
+		}
+		g_assert (addr_b);
+		g_assert_cmpint (addr_a->plen, ==, addr_b->plen);
+		g_assert_cmpint (addr_a->flags, ==, addr_b->flags);
+		g_assert_cmpint (expiry (addr_a->timestamp, addr_a->lifetime), ==, expiry (addr_b->timestamp, addr_b->lifetime));
+		g_assert_cmpint (expiry (addr_a->timestamp, addr_a->preferred), ==, expiry (addr_b->timestamp, addr_b->preferred));
+	}
+
+	g_assert_cmpint (nm_ip6_config_get_num_routes (a), ==, nm_ip6_config_get_num_routes (b));
+	for (i = 0; i < nm_ip6_config_get_num_routes (a); i++) {
+		const NMPlatformIP6Route *route_a = nm_ip6_config_get_route (a, i);
+		const NMPlatformIP6Route *route_b = NULL;
+
+		for (j = 0; j < nm_ip6_config_get_num_routes (b); j++) {
+			route_b = nm_ip6_config_get_route (b, j);
+			if (   route_a->plen == route_b->plen
+			    && IN6_ARE_ADDR_EQUAL (&route_a->network, &route_b->network))
+				break;
+			route_b = NULL;
+		}
+		g_assert (route_b);
+		g_assert (IN6_ARE_ADDR_EQUAL (&route_a->gateway, &route_b->gateway));
+		g_assert_cmpint (route_a->metric, ==, route_b->metric);
+	}
+}
+
+static void
+config_changed (NMRDisc *rdisc, NMRDiscConfigMap changed, TestData *data)
+{
+	NMIP6Config *rebuilt;
+
+	/* NMLNDPRDisc records every change of the addresses and routes */
+	if (changed & NM_RDISC_CONFIG_ADDRESSES) {
+		g_assert (rdisc->changes.tracked & NM_RDISC_CONFIG_ADDRESSES);
+		nm_rdisc_apply_addresses (rdisc, data->config, TRUE, TRUE, IFA_F_NOPREFIXROUTE);
+	}
+	if (changed & NM_RDISC_CONFIG_ROUTES) {
+		g_assert (rdisc->changes.tracked & NM_RDISC_CONFIG_ROUTES);
+		nm_rdisc_apply_routes (rdisc, data->config, TRUE, METRIC);
+	}
+
+	rebuilt = nm_ip6_config_new ();
+	nm_rdisc_apply_addresses (rdisc, rebuilt, FALSE, TRUE, IFA_F_NOPREFIXROUTE);
+	nm_rdisc_apply_routes (rdisc, rebuilt, FALSE, METRIC);
+	assert_config_equal (data->config, rebuilt);
+	g_object_unref (rebuilt);
+
+	data->emitted++;
+	data->changed |= changed;
+}
+
+static void
+test_data_init (TestData *data)
+{
+	memset (data, 0, sizeof (*data));
+
+	data->rdisc = g_object_new (NM_TYPE_LNDP_RDISC, NULL);
+	data->rdisc->ifindex = 1;
+	data->rdisc->ifname = g_strdup ("eth0");
+	data->rdisc->max_addresses = NM_RDISC_MAX_ADDRESSES_DEFAULT;
+	data->config = nm_ip6_config_new ();
+
+	g_signal_connect (data->rdisc, NM_RDISC_CONFIG_CHANGED, G_CALLBACK (config_changed), data);
+}
+
+static void
+test_data_clear (TestData *data)
+{
+	g_object_unref (data->rdisc);
+	g_object_unref (data->config);
+}
+
+/* Runs the timestamp check that ends every router advertisement and
+ * returns the sections of the emitted "config-changed" signal. */
+static NMRDiscConfigMap
+check (TestData *data, guint32 now, NMRDiscConfigMap changed)
+{
+	data->changed = 0;
+	_nm_lndp_rdisc_check_timestamps (data->rdisc, now, changed);
+	return data->changed;
+}
+
+/*******************************************/
+
+static NMRDiscGateway
+gateway (const char *address, guint32 timestamp, guint32 lifetime, NMRDiscPreference preference)
+{
+	NMRDiscGateway item;
+
+	memset (&item, 0, sizeof (item));
+	item.address = *nmtst_inet6_from_string (address);
+	item.timestamp = timestamp;
+	item.lifetime = lifetime;
+	item.preference = preference;
+	return item;
+}
+
+static NMRDiscAddress
+address (const char *address, guint32 timestamp, guint32 lifetime, guint32 preferred)
+{
+	NMRDiscAddress item;
+
+	memset (&item, 0, sizeof (item));
+	item.address = *nmtst_inet6_from_string (address);
+	item.timestamp = timestamp;
+	item.lifetime = lifetime;
+	item.preferred = preferred;
+	return item;
+}
+
+static NMRDiscRoute
+route (const char *network, guint32 timestamp, guint32 lifetime, NMRDiscPreference preference)
+{
+	NMRDiscRoute item;
+
+	memset (&item, 0, sizeof (item));
+	item.network = *nmtst_inet6_from_string (network);
+	item.plen = 64;
+	item.gateway = *nmtst_inet6_from_string ("fe80::1");
+	item.timestamp = timestamp;
+	item.lifetime = lifetime;
+	item.preference = preference;
+	return item;
+}
+
+static NMRDiscDNSServer
+dns_server (const char *address, guint32 timestamp, guint32 lifetime)
+{
+	NMRDiscDNSServer item;
+
+	memset (&item, 0, sizeof (item));
+	item.address = *nmtst_inet6_from_string (address);
+	item.timestamp = timestamp;
+	item.lifetime = lifetime;
+	return item;
+}
+
+#define add_item(data, type, item) \
+	({ \
+		typeof (item) _item = (item); \
+		\
+		_nm_lndp_rdisc_add_item ((data)->rdisc, (type), &_item); \
+	})
+
+static void
+assert_gateways (NMRDisc *rdisc, ...)
+{
+	const char *str;
+	guint i = 0;
+	va_list ap;
+
+	va_start (ap, rdisc);
+	while ((str = va_arg (ap, const char *))) {
+		g_assert_cmpint (i, <, rdisc->gateways->len);
+		g_assert (IN6_ARE_ADDR_EQUAL (&g_array_index (rdisc->gateways, NMRDiscGateway, i).address,
+		                              nmtst_inet6_from_string (str)));
+		i++;
+	}
+	va_end (ap);
+	g_assert_cmpint (i, ==, rdisc->gateways->len);
+}
+
+static void
+assert_routes (NMRDisc *rdisc, ...)
+{
+	const char *str;
+	guint i = 0;
+	va_list ap;
+
+	va_start (ap, rdisc);
+	while ((str = va_arg (ap, const char *))) {
+		g_assert_cmpint (i, <, rdisc->routes->len);
+		g_assert (IN6_ARE_ADDR_EQUAL (&g_array_index (rdisc->routes, NMRDiscRoute, i).network,
+		                              nmtst_inet6_from_string (str)));
+		i++;
+	}
+	va_end (ap);
+	g_assert_cmpint (i, ==, rdisc->routes->len);
+}
+
+static void
+assert_addresses (NMRDisc *rdisc, ...)
+{
+	const char *str;
+	guint i = 0;
+	va_list ap;
+
+	va_start (ap, rdisc);
+	while ((str = va_arg (ap, const char *))) {
+		g_assert_cmpint (i, <, rdisc->addresses->len);
+		g_assert (IN6_ARE_ADDR_EQUAL (&g_array_index (rdisc->addresses, NMRDiscAddress, i).address,
+		                              nmtst_inet6_from_string (str)));
+		i++;
+	}
+	va_end (ap);
+	g_assert_cmpint (i, ==, rdisc->addresses->len);
+}
+
+/*******************************************/
+
+static void
+test_preference (void)
+{
+	TestData data;
+	NMRDiscConfigMap changed = 0;
+
+	test_data_init (&data);
+
+	g_assert (add_item (&data, NM_RDISC_CONFIG_GATEWAYS, gateway ("fe80::1", 100, 1800, NM_RDISC_PREFERENCE_MEDIUM)));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_GATEWAYS, gateway ("fe80::2", 100, 1800, NM_RDISC_PREFERENCE_HIGH)));
+	assert_gateways (data.rdisc, "fe80::2", "fe80::1", NULL);
+
+	changed |= add_item (&data, NM_RDISC_CONFIG_ROUTES, route ("2001:db8:1::", 100, 1800, NM_RDISC_PREFERENCE_MEDIUM));
+	changed |= add_item (&data, NM_RDISC_CONFIG_ROUTES, route ("2001:db8:2::", 100, 1800, NM_RDISC_PREFERENCE_MEDIUM));
+	changed |= add_item (&data, NM_RDISC_CONFIG_ROUTES, route ("2001:db8:3::", 100, 1800, NM_RDISC_PREFERENCE_HIGH));
+	g_assert (changed);
+	assert_routes (data.rdisc, "2001:db8:3::", "2001:db8:1::", "2001:db8:2::", NULL);
+	g_assert_cmpint (check (&data, 100, NM_RDISC_CONFIG_GATEWAYS | NM_RDISC_CONFIG_ROUTES), ==,
+	                 NM_RDISC_CONFIG_GATEWAYS | NM_RDISC_CONFIG_ROUTES);
+	g_assert_cmpint (nm_ip6_config_get_num_routes (data.config), ==, 3);
+
+	/* Same preference: updated in place */
+	g_assert (!add_item (&data, NM_RDISC_CONFIG_ROUTES, route ("2001:db8:2::", 200, 1800, NM_RDISC_PREFERENCE_MEDIUM)));
+	g_assert (!add_item (&data, NM_RDISC_CONFIG_GATEWAYS, gateway ("fe80::1", 200, 1800, NM_RDISC_PREFERENCE_MEDIUM)));
+	assert_routes (data.rdisc, "2001:db8:3::", "2001:db8:1::", "2001:db8:2::", NULL);
+	g_assert_cmpint (check (&data, 200, 0), ==, 0);
+
+	/* A changed preference re-inserts the item behind the items that are
+	 * at least as preferable */
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ROUTES, route ("2001:db8:1::", 300, 1800, NM_RDISC_PREFERENCE_HIGH)));
+	assert_routes (data.rdisc, "2001:db8:3::", "2001:db8:1::", "2001:db8:2::", NULL);
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ROUTES, route ("2001:db8:3::", 300, 1800, NM_RDISC_PREFERENCE_LOW)));
+	assert_routes (data.rdisc, "2001:db8:1::", "2001:db8:2::", "2001:db8:3::", NULL);
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ROUTES, route ("2001:db8:3::", 300, 1800, NM_RDISC_PREFERENCE_MEDIUM)));
+	assert_routes (data.rdisc, "2001:db8:1::", "2001:db8:2::", "2001:db8:3::", NULL);
+	g_assert (add_item (&data, NM_RDISC_CONFIG_GATEWAYS, gateway ("fe80::1", 300, 1800, NM_RDISC_PREFERENCE_HIGH)));
+	assert_gateways (data.rdisc, "fe80::2", "fe80::1", NULL);
+	g_assert (add_item (&data, NM_RDISC_CONFIG_GATEWAYS, gateway ("fe80::2", 300, 1800, NM_RDISC_PREFERENCE_LOW)));
+	assert_gateways (data.rdisc, "fe80::1", "fe80::2", NULL);
+	g_assert_cmpint (check (&data, 300, NM_RDISC_CONFIG_GATEWAYS | NM_RDISC_CONFIG_ROUTES), ==,
+	                 NM_RDISC_CONFIG_GATEWAYS | NM_RDISC_CONFIG_ROUTES);
+	g_assert_cmpint (nm_ip6_config_get_num_routes (data.config), ==, 3);
+
+	/* The re-inserted items expire with their new timestamp */
+	g_assert_cmpint (check (&data, 1900, 0), ==, 0);
+	g_assert_cmpint (check (&data, 2000, 0), ==, NM_RDISC_CONFIG_ROUTES);
+	assert_routes (data.rdisc, "2001:db8:1::", "2001:db8:3::", NULL);
+	assert_gateways (data.rdisc, "fe80::1", "fe80::2", NULL);
+	g_assert_cmpint (nm_ip6_config_get_num_routes (data.config), ==, 2);
+
+	test_data_clear (&data);
+}
+
+static void
+test_lifetime_zero (void)
+{
+	TestData data;
+	NMRDiscDNSDomain domain = { (char *) "example.com", 100, 7200 };
+
+	test_data_init (&data);
+
+	g_assert (add_item (&data, NM_RDISC_CONFIG_DNS_SERVERS, dns_server ("2001:db8::53", 100, 7200)));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_DNS_SERVERS, dns_server ("2001:db8::54", 100, 7200)));
+	g_assert (_nm_lndp_rdisc_add_item (data.rdisc, NM_RDISC_CONFIG_DNS_DOMAINS, &domain));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8::1", 100, 3600, 1800)));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ROUTES, route ("2001:db8::", 100, 3600, NM_RDISC_PREFERENCE_MEDIUM)));
+	check (&data, 100, NM_RDISC_CONFIG_DNS_SERVERS | NM_RDISC_CONFIG_DNS_DOMAINS |
+	                   NM_RDISC_CONFIG_ADDRESSES | NM_RDISC_CONFIG_ROUTES);
+	g_assert_cmpint (nm_ip6_config_get_num_addresses (data.config), ==, 1);
+	g_assert_cmpint (nm_ip6_config_get_num_routes (data.config), ==, 1);
+
+	/* DNS items with lifetime 0 are removed right away */
+	g_assert (add_item (&data, NM_RDISC_CONFIG_DNS_SERVERS, dns_server ("2001:db8::53", 200, 0)));
+	g_assert_cmpint (data.rdisc->dns_servers->len, ==, 1);
+	g_assert (IN6_ARE_ADDR_EQUAL (&g_array_index (data.rdisc->dns_servers, NMRDiscDNSServer, 0).address,
+	                              nmtst_inet6_from_string ("2001:db8::54")));
+	domain.timestamp = 200;
+	domain.lifetime = 0;
+	g_assert (_nm_lndp_rdisc_add_item (data.rdisc, NM_RDISC_CONFIG_DNS_DOMAINS, &domain));
+	g_assert_cmpint (data.rdisc->dns_domains->len, ==, 0);
+
+	/* Addresses and routes expire at the end of the advertisement */
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8::1", 200, 0, 0)));
+	g_assert (!add_item (&data, NM_RDISC_CONFIG_ROUTES, route ("2001:db8::", 200, 0, NM_RDISC_PREFERENCE_MEDIUM)));
+	g_assert_cmpint (check (&data, 200, NM_RDISC_CONFIG_DNS_SERVERS | NM_RDISC_CONFIG_DNS_DOMAINS |
+	                                    NM_RDISC_CONFIG_ADDRESSES), ==,
+	                 NM_RDISC_CONFIG_DNS_SERVERS | NM_RDISC_CONFIG_DNS_DOMAINS |
+	                 NM_RDISC_CONFIG_ADDRESSES | NM_RDISC_CONFIG_ROUTES);
+	g_assert_cmpint (data.rdisc->addresses->len, ==, 0);
+	g_assert_cmpint (data.rdisc->routes->len, ==, 0);
+	g_assert_cmpint (nm_ip6_config_get_num_addresses (data.config), ==, 0);
+	g_assert_cmpint (nm_ip6_config_get_num_routes (data.config), ==, 0);
+
+	test_data_clear (&data);
+}
+
+static void
+test_dns_refresh (void)
+{
+	TestData data;
+	guint emitted;
+
+	test_data_init (&data);
+
+	g_assert (add_item (&data, NM_RDISC_CONFIG_DNS_SERVERS, dns_server ("2001:db8::53", 100, 7200)));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8::1", 100, 3600, 3600)));
+	check (&data, 100, NM_RDISC_CONFIG_DNS_SERVERS | NM_RDISC_CONFIG_ADDRESSES);
+	emitted = data.emitted;
+
+	/* Only DNS items are refreshed, at half of their lifetime */
+	g_assert_cmpint (check (&data, 1900, 0), ==, 0);
+	g_assert (!_nm_lndp_rdisc_get_solicit_pending (data.rdisc));
+	g_assert_cmpint (check (&data, 3699, 0), ==, 0);
+	g_assert (!_nm_lndp_rdisc_get_solicit_pending (data.rdisc));
+
+	/* The address expires, the DNS server is refreshed */
+	g_assert_cmpint (check (&data, 3700, 0), ==, NM_RDISC_CONFIG_ADDRESSES);
+	g_assert (_nm_lndp_rdisc_get_solicit_pending (data.rdisc));
+	g_assert_cmpint (data.rdisc->addresses->len, ==, 0);
+	g_assert_cmpint (data.rdisc->dns_servers->len, ==, 1);
+	g_assert_cmpint (data.emitted, ==, emitted + 1);
+
+	/* Without a new advertisement, the DNS server expires */
+	g_assert_cmpint (check (&data, 7299, 0), ==, 0);
+	g_assert_cmpint (data.rdisc->dns_servers->len, ==, 1);
+	g_assert_cmpint (check (&data, 7300, 0), ==, NM_RDISC_CONFIG_DNS_SERVERS);
+	g_assert_cmpint (data.rdisc->dns_servers->len, ==, 0);
+
+	test_data_clear (&data);
+}
+
+static void
+test_expiry_order (void)
+{
+	TestData data;
+
+	test_data_init (&data);
+
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8::a", 10, 300, 300)));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8::b", 10, 100, 100)));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8::c", 10, 200, 200)));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8::d", 10,
+	                                                               NM_PLATFORM_LIFETIME_PERMANENT,
+	                                                               NM_PLATFORM_LIFETIME_PERMANENT)));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ROUTES, route ("2001:db8:1::", 10, 150, NM_RDISC_PREFERENCE_MEDIUM)));
+	g_assert_cmpint (check (&data, 10, NM_RDISC_CONFIG_ADDRESSES | NM_RDISC_CONFIG_ROUTES), ==,
+	                 NM_RDISC_CONFIG_ADDRESSES | NM_RDISC_CONFIG_ROUTES);
+	g_assert_cmpint (nm_ip6_config_get_num_addresses (data.config), ==, 4);
+
+	g_assert_cmpint (check (&data, 109, 0), ==, 0);
+	g_assert_cmpint (check (&data, 110, 0), ==, NM_RDISC_CONFIG_ADDRESSES);
+	assert_addresses (data.rdisc, "2001:db8::a", "2001:db8::c", "2001:db8::d", NULL);
+
+	g_assert_cmpint (check (&data, 160, 0), ==, NM_RDISC_CONFIG_ROUTES);
+	g_assert_cmpint (data.rdisc->routes->len, ==, 0);
+
+	/* A refreshed address moves back in the expiry order */
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8::c", 200, 400, 400)));
+	g_assert_cmpint (check (&data, 200, NM_RDISC_CONFIG_ADDRESSES), ==, NM_RDISC_CONFIG_ADDRESSES);
+	g_assert_cmpint (check (&data, 310, 0), ==, NM_RDISC_CONFIG_ADDRESSES);
+	assert_addresses (data.rdisc, "2001:db8::c", "2001:db8::d", NULL);
+	g_assert_cmpint (check (&data, 599, 0), ==, 0);
+	g_assert_cmpint (check (&data, 1000000, 0), ==, NM_RDISC_CONFIG_ADDRESSES);
+	assert_addresses (data.rdisc, "2001:db8::d", NULL);
+	g_assert_cmpint (nm_ip6_config_get_num_addresses (data.config), ==, 1);
+
+	test_data_clear (&data);
+}
+
+static void
+test_flush_iid (void)
+{
+	TestData data;
+	NMUtilsIPv6IfaceId iid = NM_UTILS_IPV6_IFACE_ID_INIT;
+
+	test_data_init (&data);
+
+	iid.id = 1;
+	g_assert (nm_rdisc_set_iid (data.rdisc, iid));
+	g_assert_cmpint (data.emitted, ==, 0);
+
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8:1::1", 100, 3600, 3600)));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8:2::1", 100, 3600, 3600)));
+	check (&data, 100, NM_RDISC_CONFIG_ADDRESSES);
+	g_assert_cmpint (nm_ip6_config_get_num_addresses (data.config), ==, 2);
+
+	/* Changing the identifier flushes the addresses built from the old one */
+	g_assert (!nm_rdisc_set_iid (data.rdisc, iid));
+	iid.id = 2;
+	data.changed = 0;
+	g_assert (nm_rdisc_set_iid (data.rdisc, iid));
+	g_assert_cmpint (data.changed, ==, NM_RDISC_CONFIG_ADDRESSES);
+	g_assert_cmpint (data.rdisc->addresses->len, ==, 0);
+	g_assert_cmpint (nm_ip6_config_get_num_addresses (data.config), ==, 0);
+
+	/* The flushed addresses left nothing behind in the expiry order */
+	g_assert_cmpint (check (&data, 3700, 0), ==, 0);
+
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8:1::2", 200, 3600, 3600)));
+	check (&data, 200, NM_RDISC_CONFIG_ADDRESSES);
+	assert_addresses (data.rdisc, "2001:db8:1::2", NULL);
+	g_assert_cmpint (nm_ip6_config_get_num_addresses (data.config), ==, 1);
+
+	test_data_clear (&data);
+}
+
+static void
+test_incremental (void)
+{
+	TestData data;
+	const NMPlatformIP6Address *addr;
+
+	test_data_init (&data);
+
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8::1", 100, 7200, 3600)));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8::2", 100, 7200, 3600)));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ROUTES, route ("2001:db8:1::", 100, 7200, NM_RDISC_PREFERENCE_MEDIUM)));
+	check (&data, 100, NM_RDISC_CONFIG_ADDRESSES | NM_RDISC_CONFIG_ROUTES);
+
+	/* Same expiry, nothing to update */
+	g_assert (!add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8::1", 200, 7100, 3500)));
+
+	/* The router shortens the lifetime of an address */
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8::2", 200, 3000, 1000)));
+	g_assert_cmpint (check (&data, 200, NM_RDISC_CONFIG_ADDRESSES), ==, NM_RDISC_CONFIG_ADDRESSES);
+	addr = nm_ip6_config_get_address (data.config, 1);
+	g_assert (IN6_ARE_ADDR_EQUAL (&addr->address, nmtst_inet6_from_string ("2001:db8::2")));
+	g_assert_cmpint (addr->timestamp + addr->lifetime, ==, 3200);
+	g_assert_cmpint (addr->timestamp + addr->preferred, ==, 1200);
+	g_assert_cmpint (addr->plen, ==, 64);
+	g_assert_cmpint (addr->flags, ==, IFA_F_NOPREFIXROUTE);
+
+	/* Removed and added again within one change set */
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ROUTES, route ("2001:db8:1::", 300, 7200, NM_RDISC_PREFERENCE_HIGH)));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ROUTES, route ("2001:db8:1::", 300, 7200, NM_RDISC_PREFERENCE_LOW)));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ROUTES, route ("2001:db8:2::", 300, 7200, NM_RDISC_PREFERENCE_LOW)));
+	g_assert_cmpint (check (&data, 300, NM_RDISC_CONFIG_ROUTES), ==, NM_RDISC_CONFIG_ROUTES);
+	g_assert_cmpint (nm_ip6_config_get_num_routes (data.config), ==, 2);
+
+	/* Added and expired within one change set */
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8::3", 400, 0, 0)));
+	g_assert (add_item (&data, NM_RDISC_CONFIG_ADDRESSES, address ("2001:db8::1", 400, 7200, 7200)));
+	g_assert_cmpint (check (&data, 400, NM_RDISC_CONFIG_ADDRESSES), ==, NM_RDISC_CONFIG_ADDRESSES);
+	g_assert_cmpint (nm_ip6_config_get_num_addresses (data.config), ==, 2);
+
+	test_data_clear (&data);
+}
+
+/*******************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv);
+
+	g_test_add_func ("/rdisc/preference", test_preference);
+	g_test_add_func ("/rdisc/lifetime-zero", test_lifetime_zero);
+	g_test_add_func ("/rdisc/dns-refresh", test_dns_refresh);
+	g_test_add_func ("/rdisc/expiry-order", test_expiry_order);
+	g_test_add_func ("/rdisc/flush-iid", test_flush_iid);
+	g_test_add_func ("/rdisc/incremental", test_incremental);
+
+	return g_test_run ();
+}
@@ -21,7 +21,6 @@
 #include "config.h"
 
 #include <string.h>
-#include <pwd.h>
 
 #include <glib.h>
 #include <dbus/dbus-glib.h>
@@ -41,6 +40,7 @@
 #include "nm-dbus-manager.h"
 #include "nm-session-monitor.h"
 #include "nm-simple-connection.h"
+#include "nm-core-internal.h"
 #include "NetworkManagerUtils.h"
 
 G_DEFINE_TYPE (NMAgentManager, nm_agent_manager, G_TYPE_OBJECT)
@@ -263,42 +263,50 @@ find_agent_by_identifier_and_uid (NMAgentManager *self,
 	return NULL;
 }
 
+typedef struct {
+	NMAgentManager *self;
+	NMAuthSubject *subject;
+	char *identifier;
+	NMSecretAgentCapabilities capabilities;
+	DBusGMethodInvocation *context;
+} RegisterInfo;
+
 static void
-impl_agent_manager_register_with_capabilities (NMAgentManager *self,
-                                               const char *identifier,
-                                               NMSecretAgentCapabilities capabilities,
-                                               DBusGMethodInvocation *context)
+register_info_free (RegisterInfo *info)
+{
+	g_object_unref (info->self);
+	g_object_unref (info->subject);
+	g_free (info->identifier);
+	g_slice_free (RegisterInfo, info);
+}
+
+static void
+agent_register_user_resolved (gboolean found, uid_t uid, const char *user, gpointer user_data)
 {
+	RegisterInfo *info = user_data;
+	NMAgentManager *self = info->self;
 	NMAgentManagerPrivate *priv = NM_AGENT_MANAGER_GET_PRIVATE (self);
-	NMAuthSubject *subject;
-	gulong sender_uid = G_MAXULONG;
+	gulong sender_uid = nm_auth_subject_get_unix_process_uid (info->subject);
 	GError *error = NULL;
 	NMSecretAgent *agent;
 	NMAuthChain *chain;
 
-	subject = nm_auth_subject_new_unix_process_from_context (context);
-	if (!subject) {
+	if (!priv->agents) {
 		error = g_error_new_literal (NM_AGENT_MANAGER_ERROR,
-		                             NM_AGENT_MANAGER_ERROR_PERMISSION_DENIED,
-		                             "Unable to determine request sender and UID.");
+		                             NM_AGENT_MANAGER_ERROR_FAILED,
+		                             "Agent manager is shutting down.");
 		goto done;
 	}
-	sender_uid = nm_auth_subject_get_unix_process_uid (subject);
 
-	if (   0 != sender_uid
-	    && !nm_session_monitor_session_exists (sender_uid, FALSE)) {
-		error = g_error_new_literal (NM_AGENT_MANAGER_ERROR,
-		                             NM_AGENT_MANAGER_ERROR_PERMISSION_DENIED,
-		                             "Session not found");
+	if (!found || !user || !user[0]) {
+		error = g_error_new (NM_AGENT_MANAGER_ERROR,
+		                     NM_AGENT_MANAGER_ERROR_PERMISSION_DENIED,
+		                     "Could not determine username for uid %lu", sender_uid);
 		goto done;
 	}
 
-	/* Validate the identifier */
-	if (!validate_identifier (identifier, &error))
-		goto done;
-
-	/* Only one agent for each identifier is allowed per user */
-	if (find_agent_by_identifier_and_uid (self, identifier, sender_uid)) {
+	/* Another registration may have completed while the user was resolved */
+	if (find_agent_by_identifier_and_uid (self, info->identifier, sender_uid)) {
 		error = g_error_new_literal (NM_AGENT_MANAGER_ERROR,
 		                             NM_AGENT_MANAGER_ERROR_PERMISSION_DENIED,
 		                             "An agent with this ID is already registered for this user.");
@@ -306,7 +314,8 @@ impl_agent_manager_register_with_capabilities (NMAgentManager *self,
 	}
 
 	/* Success, add the new agent */
-	agent = nm_secret_agent_new (context, subject, identifier, capabilities);
+	agent = nm_secret_agent_new (info->context, info->subject, info->identifier,
+	                             user, info->capabilities);
 	if (!agent) {
 		error = g_error_new_literal (NM_AGENT_MANAGER_ERROR,
 		                             NM_AGENT_MANAGER_ERROR_FAILED,
@@ -318,7 +327,7 @@ impl_agent_manager_register_with_capabilities (NMAgentManager *self,
 	            nm_secret_agent_get_description (agent));
 
 	/* Kick off permissions requests for this agent */
-	chain = nm_auth_chain_new_subject (subject, context, agent_register_permissions_done, self);
+	chain = nm_auth_chain_new_subject (info->subject, info->context, agent_register_permissions_done, self);
 	if (chain) {
 		nm_auth_chain_set_data (chain, "agent", agent, g_object_unref);
 		nm_auth_chain_add_call (chain, NM_AUTH_PERMISSION_WIFI_SHARE_PROTECTED, FALSE);
@@ -326,11 +335,70 @@ impl_agent_manager_register_with_capabilities (NMAgentManager *self,
 
 		priv->chains = g_slist_append (priv->chains, chain);
 	} else {
+		g_object_unref (agent);
 		error = g_error_new_literal (NM_AGENT_MANAGER_ERROR,
 		                             NM_AGENT_MANAGER_ERROR_FAILED,
 		                             "Unable to start agent authentication.");
 	}
 
+done:
+	if (error)
+		dbus_g_method_return_error (info->context, error);
+	g_clear_error (&error);
+	register_info_free (info);
+}
+
+static void
+impl_agent_manager_register_with_capabilities (NMAgentManager *self,
+                                               const char *identifier,
+                                               NMSecretAgentCapabilities capabilities,
+                                               DBusGMethodInvocation *context)
+{
+	NMAuthSubject *subject;
+	gulong sender_uid = G_MAXULONG;
+	GError *error = NULL;
+	RegisterInfo *info;
+
+	subject = nm_auth_subject_new_unix_process_from_context (context);
+	if (!subject) {
+		error = g_error_new_literal (NM_AGENT_MANAGER_ERROR,
+		                             NM_AGENT_MANAGER_ERROR_PERMISSION_DENIED,
+		                             "Unable to determine request sender and UID.");
+		goto done;
+	}
+	sender_uid = nm_auth_subject_get_unix_process_uid (subject);
+
+	if (   0 != sender_uid
+	    && !nm_session_monitor_session_exists (sender_uid, FALSE)) {
+		error = g_error_new_literal (NM_AGENT_MANAGER_ERROR,
+		                             NM_AGENT_MANAGER_ERROR_PERMISSION_DENIED,
+		                             "Session not found");
+		goto done;
+	}
+
+	/* Validate the identifier */
+	if (!validate_identifier (identifier, &error))
+		goto done;
+
+	/* Only one agent for each identifier is allowed per user */
+	if (find_agent_by_identifier_and_uid (self, identifier, sender_uid)) {
+		error = g_error_new_literal (NM_AGENT_MANAGER_ERROR,
+		                             NM_AGENT_MANAGER_ERROR_PERMISSION_DENIED,
+		                             "An agent with this ID is already registered for this user.");
+		goto done;
+	}
+
+	/* The agent keeps its user name for the connection ACL checks of later
+	 * secrets requests.  Resolving it may need a slow NSS lookup, so the
+	 * registration continues once the name is known. */
+	info = g_slice_new0 (RegisterInfo);
+	info->self = g_object_ref (self);
+	info->subject = g_object_ref (subject);
+	info->identifier = g_strdup (identifier);
+	info->capabilities = capabilities;
+	info->context = context;
+	nm_session_monitor_uid_to_user_async (sender_uid, agent_register_user_resolved, info);
+
 done:
 	if (error)
 		dbus_g_method_return_error (context, error);
@@ -787,8 +855,7 @@ get_done_cb (NMSecretAgent *agent,
 	ConnectionRequest *req = user_data;
 	GHashTable *setting_secrets;
 	const char *agent_dbus_owner;
-	struct passwd *pw;
-	char *agent_uname = NULL;
+	const char *agent_uname;
 
 	g_return_if_fail (call_id == parent->current_call_id);
 
@@ -827,17 +894,14 @@ get_done_cb (NMSecretAgent *agent,
 	            nm_secret_agent_get_description (agent),
 	            req, parent->detail, req->setting_name);
 
-	/* Get the agent's username */
-	pw = getpwuid (nm_secret_agent_get_owner_uid (agent));
-	if (pw && strlen (pw->pw_name)) {
-		/* Needs to be UTF-8 valid since it may be pushed through D-Bus */
-		if (g_utf8_validate (pw->pw_name, -1, NULL))
-			agent_uname = g_strdup (pw->pw_name);
-	}
+	/* The agent's username was resolved when it registered.  It needs to
+	 * be UTF-8 valid since it may be pushed through D-Bus. */
+	agent_uname = nm_secret_agent_get_owner_username (agent);
+	if (agent_uname && !g_utf8_validate (agent_uname, -1, NULL))
+		agent_uname = NULL;
 
 	agent_dbus_owner = nm_secret_agent_get_dbus_owner (agent);
 	req_complete_success (parent, secrets, agent_dbus_owner, agent_uname);
-	g_free (agent_uname);
 }
 
 static void
@@ -886,7 +950,7 @@ get_agent_request_secrets (ConnectionRequest *req, gboolean include_system_secre
 	Request *parent = (Request *) req;
 	NMConnection *tmp;
 
-	tmp = nm_simple_connection_new_clone (req->connection);
+	tmp = _nm_simple_connection_new_clone_shared (req->connection);
 	nm_connection_clear_secrets (tmp);
 	if (include_system_secrets) {
 		if (req->existing_secrets) {
@@ -1077,7 +1141,7 @@ get_start (gpointer user_data)
 		 * ask a secret agent for more.  This allows admins to provide generic
 		 * secrets but allow additional user-specific ones as well.
 		 */
-		tmp = nm_simple_connection_new_clone (req->connection);
+		tmp = _nm_simple_connection_new_clone_shared (req->connection);
 		g_assert (tmp);
 
 		secrets_dict = nm_utils_connection_hash_to_dict (req->existing_secrets);
@@ -21,7 +21,6 @@
 #include "config.h"
 
 #include <sys/types.h>
-#include <pwd.h>
 
 #include <glib.h>
 #include <dbus/dbus-glib.h>
@@ -469,28 +468,24 @@ NMSecretAgent *
 nm_secret_agent_new (DBusGMethodInvocation *context,
                      NMAuthSubject *subject,
                      const char *identifier,
+                     const char *owner_username,
                      NMSecretAgentCapabilities capabilities)
 {
 	NMSecretAgent *self;
 	NMSecretAgentPrivate *priv;
-	char *hash_str, *username;
-	struct passwd *pw;
+	char *hash_str;
 
 	g_return_val_if_fail (context != NULL, NULL);
 	g_return_val_if_fail (NM_IS_AUTH_SUBJECT (subject), NULL);
 	g_return_val_if_fail (nm_auth_subject_is_unix_process (subject), NULL);
 	g_return_val_if_fail (identifier != NULL, NULL);
-
-	pw = getpwuid (nm_auth_subject_get_unix_process_uid (subject));
-	g_return_val_if_fail (pw != NULL, NULL);
-	g_return_val_if_fail (pw->pw_name[0] != '\0', NULL);
-	username = g_strdup (pw->pw_name);
+	g_return_val_if_fail (owner_username && owner_username[0], NULL);
 
 	self = (NMSecretAgent *) g_object_new (NM_TYPE_SECRET_AGENT, NULL);
 	priv = NM_SECRET_AGENT_GET_PRIVATE (self);
 
 	priv->identifier = g_strdup (identifier);
-	priv->owner_username = g_strdup (username);
+	priv->owner_username = g_strdup (owner_username);
 	priv->capabilities = capabilities;
 	priv->subject = g_object_ref (subject);
 
@@ -507,7 +502,6 @@ nm_secret_agent_new (DBusGMethodInvocation *context,
 	priv->proxy_destroy_id = g_signal_connect_swapped (priv->proxy, "destroy",
 	                                                   G_CALLBACK (proxy_cleanup), self);
 
-	g_free (username);
 	return self;
 }
 
@@ -47,6 +47,7 @@ GType nm_secret_agent_get_type (void);
 NMSecretAgent *nm_secret_agent_new (DBusGMethodInvocation *context,
                                     NMAuthSubject *subject,
                                     const char *identifier,
+                                    const char *owner_username,
                                     NMSecretAgentCapabilities capabilities);
 
 const char *nm_secret_agent_get_description (NMSecretAgent *agent);
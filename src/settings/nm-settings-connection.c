@@ -39,8 +39,11 @@
 #include "nm-core-internal.h"
 #include "nm-glib-compat.h"
 
-#define SETTINGS_TIMESTAMPS_FILE  NMSTATEDIR "/timestamps"
-#define SETTINGS_SEEN_BSSIDS_FILE NMSTATEDIR "/seen-bssids"
+static const char *settings_timestamps_file = NMSTATEDIR "/timestamps";
+static const char *settings_seen_bssids_file = NMSTATEDIR "/seen-bssids";
+
+#define SETTINGS_TIMESTAMPS_FILE  settings_timestamps_file
+#define SETTINGS_SEEN_BSSIDS_FILE settings_seen_bssids_file
 
 static void impl_settings_connection_get_settings (NMSettingsConnection *connection,
                                                    DBusGMethodInvocation *context);
@@ -106,6 +109,7 @@ typedef struct {
 
 	GSList *pending_auths; /* List of pending authentication requests */
 	gboolean visible; /* Is this connection is visible by some session? */
+	guint visibility_check_id; /* Identifies the latest visibility recheck */
 	GSList *reqs;  /* in-progress secrets requests */
 
 	/* Caches secrets from on-disk connections; were they not cached any
@@ -127,6 +131,11 @@ typedef struct {
 	gboolean timestamp_set;
 	GHashTable *seen_bssids; /* Up-to-date BSSIDs that's been seen for the connection */
 
+	/* GetSettings() reply, built on first use and dropped whenever the
+	 * connection, its timestamp or its seen BSSIDs change.
+	 */
+	GHashTable *settings_hash;
+
 	int autoconnect_retries;
 	gint32 autoconnect_retry_time;
 	NMDeviceStateReason autoconnect_blocked_reason;
@@ -243,11 +252,43 @@ nm_settings_connection_is_visible (NMSettingsConnection *self)
 	return NM_SETTINGS_CONNECTION_GET_PRIVATE (self)->visible;
 }
 
+typedef struct {
+	NMSettingsConnection *self;
+	guint id;
+	guint pending;
+	gboolean visible;
+} VisibilityCheck;
+
+static void
+visibility_check_unref (VisibilityCheck *check)
+{
+	if (--check->pending)
+		return;
+
+	/* A newer recheck supersedes this one */
+	if (check->id == NM_SETTINGS_CONNECTION_GET_PRIVATE (check->self)->visibility_check_id)
+		set_visible (check->self, check->visible);
+
+	g_object_unref (check->self);
+	g_slice_free (VisibilityCheck, check);
+}
+
+static void
+visibility_check_user_cb (gboolean found, uid_t uid, const char *user, gpointer user_data)
+{
+	VisibilityCheck *check = user_data;
+
+	if (found && nm_session_monitor_session_exists (uid, FALSE))
+		check->visible = TRUE;
+	visibility_check_unref (check);
+}
+
 void
 nm_settings_connection_recheck_visibility (NMSettingsConnection *self)
 {
 	NMSettingsConnectionPrivate *priv;
 	NMSettingConnection *s_con;
+	VisibilityCheck *check;
 	guint32 num, i;
 
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (self));
@@ -257,6 +298,8 @@ nm_settings_connection_recheck_visibility (NMSettingsConnection *self)
 	s_con = nm_connection_get_setting_connection (NM_CONNECTION (self));
 	g_assert (s_con);
 
+	priv->visibility_check_id++;
+
 	/* Check every user in the ACL for a session */
 	num = nm_setting_connection_get_num_permissions (s_con);
 	if (num == 0) {
@@ -265,22 +308,24 @@ nm_settings_connection_recheck_visibility (NMSettingsConnection *self)
 		return;
 	}
 
+	/* User names are resolved without blocking; with cached names the
+	 * callbacks run right away and the result is set before returning. */
+	check = g_slice_new0 (VisibilityCheck);
+	check->self = g_object_ref (self);
+	check->id = priv->visibility_check_id;
+	check->pending = 1;
+
 	for (i = 0; i < num; i++) {
 		const char *user;
-		uid_t uid;
 
 		if (!nm_setting_connection_get_permission (s_con, i, NULL, &user, NULL))
 			continue;
-		if (!nm_session_monitor_user_to_uid (user, &uid))
-			continue;
-		if (!nm_session_monitor_session_exists (uid, FALSE))
-			continue;
 
-		set_visible (self, TRUE);
-		return;
+		check->pending++;
+		nm_session_monitor_user_to_uid_async (user, visibility_check_user_cb, check);
 	}
 
-	set_visible (self, FALSE);
+	visibility_check_unref (check);
 }
 
 static void
@@ -366,6 +411,9 @@ update_system_secrets_cache (NMSettingsConnection *self)
 {
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
 
+	/* The cache lives as long as the connection.  A shared clone would
+	 * make every nm_connection_get_setting() on @self copy the setting,
+	 * so take a full copy here. */
 	if (priv->system_secrets)
 		g_object_unref (priv->system_secrets);
 	priv->system_secrets = nm_simple_connection_new_clone (NM_CONNECTION (self));
@@ -382,6 +430,7 @@ update_agent_secrets_cache (NMSettingsConnection *self, NMConnection *new)
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
 	NMSettingSecretFlags filter_flags = NM_SETTING_SECRET_FLAG_NOT_SAVED | NM_SETTING_SECRET_FLAG_AGENT_OWNED;
 
+	/* Like the system secrets cache, not a shared clone */
 	if (priv->agent_secrets)
 		g_object_unref (priv->agent_secrets);
 	priv->agent_secrets = nm_simple_connection_new_clone (new ? new : NM_CONNECTION (self));
@@ -437,6 +486,7 @@ changed_cb (NMSettingsConnection *self, gpointer user_data)
 
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
 
+	g_clear_pointer (&priv->settings_hash, g_hash_table_unref);
 	if (update_unsaved)
 		set_unsaved (self, TRUE);
 	if (priv->updated_idle_id == 0)
@@ -673,7 +723,7 @@ do_delete (NMSettingsConnection *connection,
 	set_visible (connection, FALSE);
 
 	/* Tell agents to remove secrets for this connection */
-	for_agents = nm_simple_connection_new_clone (NM_CONNECTION (connection));
+	for_agents = _nm_simple_connection_new_clone_shared (NM_CONNECTION (connection));
 	nm_connection_clear_secrets (for_agents);
 	nm_agent_manager_delete_secrets (priv->agent_mgr, for_agents);
 	g_object_unref (for_agents);
@@ -1166,6 +1216,71 @@ check_writable (NMConnection *connection, GError **error)
 	return TRUE;
 }
 
+/**
+ * nm_settings_connection_get_settings_hash:
+ * @self: the #NMSettingsConnection
+ *
+ * Returns the connection's settings as returned by the GetSettings() D-Bus
+ * method: without secrets, but with the connection's current timestamp and
+ * seen BSSIDs.  The result is cached until the connection changes.
+ *
+ * Returns: (transfer none): a hash table of hash tables of #GValue
+ **/
+GHashTable *
+nm_settings_connection_get_settings_hash (NMSettingsConnection *self)
+{
+	NMSettingsConnectionPrivate *priv;
+	GVariant *settings;
+	NMConnection *dupl_con;
+	NMSettingConnection *s_con;
+	NMSettingWireless *s_wifi;
+	guint64 timestamp = 0;
+	char **bssids;
+
+	g_return_val_if_fail (NM_IS_SETTINGS_CONNECTION (self), NULL);
+
+	priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+	if (priv->settings_hash)
+		return priv->settings_hash;
+
+	dupl_con = _nm_simple_connection_new_clone_shared (NM_CONNECTION (self));
+	g_assert (dupl_con);
+
+	/* Timestamp is not updated in connection's 'timestamp' property,
+	 * because it would force updating the connection and in turn
+	 * writing to /etc periodically, which we want to avoid. Rather real
+	 * timestamps are kept track of in a private variable. So, substitute
+	 * timestamp property with the real one here before returning the settings.
+	 */
+	nm_settings_connection_get_timestamp (self, &timestamp);
+	if (timestamp) {
+		s_con = nm_connection_get_setting_connection (NM_CONNECTION (dupl_con));
+		g_assert (s_con);
+		g_object_set (s_con, NM_SETTING_CONNECTION_TIMESTAMP, timestamp, NULL);
+	}
+	/* Seen BSSIDs are not updated in 802-11-wireless 'seen-bssids' property
+	 * from the same reason as timestamp. Thus we put it here to GetSettings()
+	 * return settings too.
+	 */
+	bssids = nm_settings_connection_get_seen_bssids (self);
+	s_wifi = nm_connection_get_setting_wireless (NM_CONNECTION (dupl_con));
+	if (bssids && bssids[0] && s_wifi)
+		g_object_set (s_wifi, NM_SETTING_WIRELESS_SEEN_BSSIDS, bssids, NULL);
+	g_free (bssids);
+
+	/* Secrets should *never* be returned by the GetSettings method, they
+	 * get returned by the GetSecrets method which can be better
+	 * protected against leakage of secrets to unprivileged callers.
+	 */
+	settings = nm_connection_to_dbus (NM_CONNECTION (dupl_con), NM_CONNECTION_SERIALIZE_NO_SECRETS);
+	g_assert (settings);
+	priv->settings_hash = nm_utils_connection_dict_to_hash (settings);
+	g_variant_unref (settings);
+	g_object_unref (dupl_con);
+
+	return priv->settings_hash;
+}
+
 static void
 get_settings_auth_cb (NMSettingsConnection *self, 
                       DBusGMethodInvocation *context,
@@ -1175,52 +1290,8 @@ get_settings_auth_cb (NMSettingsConnection *self,
 {
 	if (error)
 		dbus_g_method_return_error (context, error);
-	else {
-		GVariant *settings;
-		GHashTable *settings_hash;
-		NMConnection *dupl_con;
-		NMSettingConnection *s_con;
-		NMSettingWireless *s_wifi;
-		guint64 timestamp = 0;
-		char **bssids;
-
-		dupl_con = nm_simple_connection_new_clone (NM_CONNECTION (self));
-		g_assert (dupl_con);
-
-		/* Timestamp is not updated in connection's 'timestamp' property,
-		 * because it would force updating the connection and in turn
-		 * writing to /etc periodically, which we want to avoid. Rather real
-		 * timestamps are kept track of in a private variable. So, substitute
-		 * timestamp property with the real one here before returning the settings.
-		 */
-		nm_settings_connection_get_timestamp (self, &timestamp);
-		if (timestamp) {
-			s_con = nm_connection_get_setting_connection (NM_CONNECTION (dupl_con));
-			g_assert (s_con);
-			g_object_set (s_con, NM_SETTING_CONNECTION_TIMESTAMP, timestamp, NULL);
-		}
-		/* Seen BSSIDs are not updated in 802-11-wireless 'seen-bssids' property
-		 * from the same reason as timestamp. Thus we put it here to GetSettings()
-		 * return settings too.
-		 */
-		bssids = nm_settings_connection_get_seen_bssids (self);
-		s_wifi = nm_connection_get_setting_wireless (NM_CONNECTION (dupl_con));
-		if (bssids && bssids[0] && s_wifi)
-			g_object_set (s_wifi, NM_SETTING_WIRELESS_SEEN_BSSIDS, bssids, NULL);
-		g_free (bssids);
-
-		/* Secrets should *never* be returned by the GetSettings method, they
-		 * get returned by the GetSecrets method which can be better
-		 * protected against leakage of secrets to unprivileged callers.
-		 */
-		settings = nm_connection_to_dbus (NM_CONNECTION (dupl_con), NM_CONNECTION_SERIALIZE_NO_SECRETS);
-		g_assert (settings);
-		settings_hash = nm_utils_connection_dict_to_hash (settings);
-		dbus_g_method_return (context, settings_hash);
-		g_hash_table_destroy (settings_hash);
-		g_variant_unref (settings);
-		g_object_unref (dupl_con);
-	}
+	else
+		dbus_g_method_return (context, nm_settings_connection_get_settings_hash (self));
 }
 
 static void
@@ -1332,7 +1403,7 @@ con_update_cb (NMSettingsConnection *self,
 		 * as agent-owned secrets are the only ones we send back be saved.
 		 * Only send secrets to agents of the same UID that called update too.
 		 */
-		for_agent = nm_simple_connection_new_clone (NM_CONNECTION (self));
+		for_agent = _nm_simple_connection_new_clone_shared (NM_CONNECTION (self));
 		nm_connection_clear_secrets_with_flags (for_agent,
 		                                        secrets_filter_cb,
 		                                        GUINT_TO_POINTER (NM_SETTING_SECRET_FLAG_AGENT_OWNED));
@@ -1853,6 +1924,7 @@ nm_settings_connection_update_timestamp (NMSettingsConnection *connection,
 	/* Update timestamp in private storage */
 	priv->timestamp = timestamp;
 	priv->timestamp_set = TRUE;
+	g_clear_pointer (&priv->settings_hash, g_hash_table_unref);
 
 	if (flush_to_disk == FALSE)
 		return;
@@ -1915,6 +1987,7 @@ nm_settings_connection_read_and_fill_timestamp (NMSettingsConnection *connection
 	if (!err) {
 		priv->timestamp = timestamp;
 		priv->timestamp_set = TRUE;
+		g_clear_pointer (&priv->settings_hash, g_hash_table_unref);
 	} else {
 		nm_log_dbg (LOGD_SETTINGS, "failed to read connection timestamp for '%s': (%d) %s",
 		            connection_uuid, err->code, err->message);
@@ -2000,6 +2073,7 @@ nm_settings_connection_add_seen_bssid (NMSettingsConnection *connection,
 	/* Add the new BSSID; let the hash take ownership of the allocated BSSID string */
 	bssid_str = g_strdup (seen_bssid);
 	g_hash_table_insert (priv->seen_bssids, bssid_str, bssid_str);
+	g_clear_pointer (&priv->settings_hash, g_hash_table_unref);
 
 	/* Build up a list of all the BSSIDs in string form */
 	n = 0;
@@ -2064,6 +2138,7 @@ nm_settings_connection_read_and_fill_seen_bssids (NMSettingsConnection *connecti
 	g_key_file_free (seen_bssids_file);
 
 	/* Update connection's seen-bssids */
+	g_clear_pointer (&priv->settings_hash, g_hash_table_unref);
 	if (tmp_strv) {
 		g_hash_table_remove_all (priv->seen_bssids);
 		for (i = 0; i < len; i++)
@@ -2305,6 +2380,7 @@ dispose (GObject *object)
 	priv->reqs = NULL;
 
 	g_clear_pointer (&priv->seen_bssids, (GDestroyNotify) g_hash_table_destroy);
+	g_clear_pointer (&priv->settings_hash, g_hash_table_unref);
 
 	set_visible (self, FALSE);
 
@@ -2463,3 +2539,12 @@ nm_settings_connection_connection_interface_init (NMConnectionInterface *iface)
 {
 }
 
+/**************************************************************/
+
+void
+_nm_settings_connection_set_state_files (const char *timestamps_file,
+                                         const char *seen_bssids_file)
+{
+	settings_timestamps_file = timestamps_file;
+	settings_seen_bssids_file = seen_bssids_file;
+}
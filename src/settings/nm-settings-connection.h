@@ -178,6 +178,8 @@ void nm_settings_connection_update_timestamp (NMSettingsConnection *connection,
 
 void nm_settings_connection_read_and_fill_timestamp (NMSettingsConnection *connection);
 
+GHashTable *nm_settings_connection_get_settings_hash (NMSettingsConnection *self);
+
 char **nm_settings_connection_get_seen_bssids (NMSettingsConnection *connection);
 
 gboolean nm_settings_connection_has_seen_bssid (NMSettingsConnection *connection,
@@ -212,6 +214,11 @@ void        nm_settings_connection_set_filename (NMSettingsConnection *connectio
                                                  const char *filename);
 const char *nm_settings_connection_get_filename (NMSettingsConnection *connection);
 
+/* For testcases only! Replaces the timestamps and seen-bssids files in
+ * NMSTATEDIR; the strings must stay valid. */
+void _nm_settings_connection_set_state_files (const char *timestamps_file,
+                                              const char *seen_bssids_file);
+
 G_END_DECLS
 
 #endif /* __NETWORKMANAGER_SETTINGS_CONNECTION_H__ */
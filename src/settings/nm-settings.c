@@ -31,6 +31,7 @@
 #include <string.h>
 #include <gmodule.h>
 #include <pwd.h>
+#include <net/ethernet.h>
 #include <dbus/dbus.h>
 #include <dbus/dbus-glib-lowlevel.h>
 
@@ -102,6 +103,9 @@ static gboolean impl_settings_list_connections (NMSettings *self,
                                                 GPtrArray **connections,
                                                 GError **error);
 
+static void impl_settings_get_all_connection_settings (NMSettings *self,
+                                                       DBusGMethodInvocation *context);
+
 static void impl_settings_get_connection_by_uuid (NMSettings *self,
                                                   const char *uuid,
                                                   DBusGMethodInvocation *context);
@@ -360,6 +364,63 @@ error:
 	g_clear_object (&subject);
 }
 
+/**
+ * _nm_settings_get_all_connection_settings:
+ * @connections: the connections by D-Bus path
+ * @subject: the caller
+ *
+ * Builds the reply of GetAllConnectionSettings(): the same as calling
+ * GetSettings() on each connection, without one round trip per connection.
+ * Connections @subject may not view are left out instead of failing the
+ * whole request.
+ *
+ * Returns: a new hash table of D-Bus path to settings hash.  The settings
+ * hashes are cached by the connections and only borrowed.
+ */
+GHashTable *
+_nm_settings_get_all_connection_settings (GHashTable *connections, NMAuthSubject *subject)
+{
+	GHashTable *all_settings;
+	GHashTableIter iter;
+	const char *path;
+	NMSettingsConnection *connection;
+
+	all_settings = g_hash_table_new (g_str_hash, g_str_equal);
+	g_hash_table_iter_init (&iter, connections);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &path, (gpointer *) &connection)) {
+		if (!nm_auth_is_subject_in_acl (NM_CONNECTION (connection), subject, NULL))
+			continue;
+		g_hash_table_insert (all_settings, (gpointer) path,
+		                     nm_settings_connection_get_settings_hash (connection));
+	}
+	return all_settings;
+}
+
+static void
+impl_settings_get_all_connection_settings (NMSettings *self,
+                                           DBusGMethodInvocation *context)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	NMAuthSubject *subject;
+	GHashTable *all_settings;
+	GError *error = NULL;
+
+	subject = nm_auth_subject_new_unix_process_from_context (context);
+	if (!subject) {
+		error = g_error_new_literal (NM_SETTINGS_ERROR,
+		                             NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                             "Unable to determine UID of request.");
+		dbus_g_method_return_error (context, error);
+		g_error_free (error);
+		return;
+	}
+
+	all_settings = _nm_settings_get_all_connection_settings (priv->connections, subject);
+	dbus_g_method_return (context, all_settings);
+	g_hash_table_destroy (all_settings);
+	g_object_unref (subject);
+}
+
 static int
 connection_sort (gconstpointer pa, gconstpointer pb)
 {
@@ -928,7 +989,10 @@ claim_connection (NMSettings *self,
 	/* Read seen-bssids from look-aside file and put it into the connection's data */
 	nm_settings_connection_read_and_fill_seen_bssids (connection);
 
-	/* Ensure it's initial visibility is up-to-date */
+	/* Ensure it's initial visibility is up-to-date.  ACL users that are not
+	 * cached yet are resolved asynchronously; the connection then stays
+	 * invisible until the lookup finishes and the change is announced
+	 * through connection_visibility_changed(). */
 	nm_settings_connection_recheck_visibility (connection);
 
 	/* Evil openconnect migration hack */
@@ -1085,7 +1149,7 @@ send_agent_owned_secrets (NMSettings *self,
 	 * as agent-owned secrets are the only ones we send back to be saved.
 	 * Only send secrets to agents of the same UID that called update too.
 	 */
-	for_agent = nm_simple_connection_new_clone (NM_CONNECTION (connection));
+	for_agent = _nm_simple_connection_new_clone_shared (NM_CONNECTION (connection));
 	nm_connection_clear_secrets_with_flags (for_agent,
 	                                        secrets_filter_cb,
 	                                        GUINT_TO_POINTER (NM_SETTING_SECRET_FLAG_AGENT_OWNED));
@@ -1561,12 +1625,14 @@ have_connection_for_device (NMSettings *self, NMDevice *device)
 	gpointer data;
 	NMSettingConnection *s_con;
 	NMSettingWired *s_wired;
-	const char *setting_hwaddr;
-	const char *device_hwaddr;
+	const guint8 *device_hwaddr;
+	gsize device_hwaddr_len = 0;
 
 	g_return_val_if_fail (NM_IS_SETTINGS (self), FALSE);
 
-	device_hwaddr = nm_device_get_hw_address (device);
+	device_hwaddr = nm_device_get_hw_address_bin (device, &device_hwaddr_len);
+	if (device_hwaddr_len != ETH_ALEN)
+		device_hwaddr = NULL;
 
 	/* Find a wired connection locked to the given MAC address, if any */
 	g_hash_table_iter_init (&iter, priv->connections);
@@ -1594,11 +1660,10 @@ have_connection_for_device (NMSettings *self, NMDevice *device)
 
 		g_assert (s_wired != NULL);
 
-		setting_hwaddr = nm_setting_wired_get_mac_address (s_wired);
-		if (setting_hwaddr) {
+		if (nm_setting_wired_get_mac_address (s_wired)) {
 			/* A connection mac-locked to this device */
 			if (   device_hwaddr
-			    && nm_utils_hwaddr_matches (setting_hwaddr, -1, device_hwaddr, -1))
+			    && _nm_setting_wired_mac_address_matches (s_wired, device_hwaddr))
 				return TRUE;
 		} else {
 			/* A connection that applies to any wired device */
@@ -123,4 +123,8 @@ gint nm_settings_sort_connections (gconstpointer a, gconstpointer b);
 
 gboolean nm_settings_get_startup_complete (NMSettings *self);
 
+/* For testcases only! */
+GHashTable *_nm_settings_get_all_connection_settings (GHashTable *connections,
+                                                      NMAuthSubject *subject);
+
 #endif  /* __NM_SETTINGS_H__ */
@@ -43,6 +43,8 @@
 
 #define PARSE_WARNING(msg...) nm_log_warn (LOGD_SETTINGS, "    " msg)
 
+#define IBFT_ISCSIADM_TIMEOUT_MSEC 20000
+
 /* Removes trailing whitespace and whitespace before and immediately after the '=' */
 static char *
 remove_most_whitespace (const char *src)
@@ -97,7 +99,6 @@ read_ibft_blocks (const char *iscsiadm_path,
                   GError **error)
 {
 	const char *argv[4] = { iscsiadm_path, "-m", "fw", NULL };
-	const char *envp[1] = { NULL };
 	GSList *blocks = NULL;
 	char *out = NULL, *err = NULL;
 	gint status = 0;
@@ -108,8 +109,10 @@ read_ibft_blocks (const char *iscsiadm_path,
 	g_return_val_if_fail (iscsiadm_path != NULL, FALSE);
 	g_return_val_if_fail (out_blocks != NULL && *out_blocks == NULL, FALSE);
 
-	if (!g_spawn_sync ("/", (char **) argv, (char **) envp, 0,
-	                   NULL, NULL, &out, &err, &status, error))
+	if (!nm_utils_spawn_sync (argv,
+	                          NM_UTILS_SPAWN_FLAGS_CAPTURE_STDOUT | NM_UTILS_SPAWN_FLAGS_CAPTURE_STDERR,
+	                          IBFT_ISCSIADM_TIMEOUT_MSEC, LOGD_SETTINGS,
+	                          &status, &out, &err, error))
 		goto done;
 
 	if (!WIFEXITED (status)) {
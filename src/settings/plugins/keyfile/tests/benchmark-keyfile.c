@@ -0,0 +1,99 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ */
+
+/* Writing and parsing keyfiles, like the plugin does when it loads or
+ * saves connections.
+ *
+ * Usage: benchmark-keyfile [N_CONNECTIONS] [N_ROUNDS]
+ *
+ * The keyfiles are written to a temporary directory that is removed
+ * again afterwards.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <glib/gstdio.h>
+
+#include "nm-core-internal.h"
+
+#include "reader.h"
+#include "writer.h"
+
+#include "nm-test-utils.h"
+
+int
+main (int argc, char **argv)
+{
+	guint n_connections = nmtst_perf_arg (argc, argv, 1, 200);
+	guint n_rounds = nmtst_perf_arg (argc, argv, 2, 10);
+	GPtrArray *connections, *paths;
+	GError *error = NULL;
+	char *dir;
+	gint64 start;
+	guint i, r;
+
+	nmtst_perf_init (argc, argv);
+
+	dir = g_dir_make_tmp ("nm-benchmark-keyfile-XXXXXX", &error);
+	g_assert_no_error (error);
+
+	connections = g_ptr_array_new_with_free_func (g_object_unref);
+	for (i = 0; i < n_connections; i++) {
+		NMConnection *connection = nmtst_perf_create_connection (NULL, i);
+
+		nmtst_connection_normalize (connection);
+		g_ptr_array_add (connections, connection);
+	}
+
+	paths = g_ptr_array_new_with_free_func (g_free);
+	start = g_get_monotonic_time ();
+	for (i = 0; i < connections->len; i++) {
+		char *path = NULL;
+
+		nm_keyfile_plugin_write_test_connection (connections->pdata[i], dir, geteuid (), getegid (), &path, &error);
+		g_assert_no_error (error);
+		g_ptr_array_add (paths, path);
+	}
+	nmtst_perf_report_time ("write", n_connections, 1, start);
+
+	start = g_get_monotonic_time ();
+	for (r = 0; r < n_rounds; r++) {
+		for (i = 0; i < paths->len; i++) {
+			NMConnection *connection;
+
+			connection = nm_keyfile_plugin_connection_from_file (paths->pdata[i], &error);
+			g_assert_no_error (error);
+			g_object_unref (connection);
+		}
+	}
+	nmtst_perf_report_time ("read", n_connections, n_rounds, start);
+
+	for (i = 0; i < paths->len; i++)
+		g_unlink (paths->pdata[i]);
+	g_rmdir (dir);
+	g_free (dir);
+	g_ptr_array_unref (paths);
+	g_ptr_array_unref (connections);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ */
+
+/* Comparing, serializing, looking up and sorting connections the way the
+ * daemon does for every device and settings change.
+ *
+ * Usage: benchmark-connection [N_CONNECTIONS] [N_ROUNDS]
+ *
+ * Connections are generated from a fixed seed, so runs are comparable.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <stdlib.h>
+
+#include "nm-simple-connection.h"
+#include "nm-setting-connection.h"
+#include "nm-setting-ip4-config.h"
+#include "nm-setting-wired.h"
+#include "nm-core-internal.h"
+#include "NetworkManagerUtils.h"
+
+#include "nm-test-utils.h"
+
+int
+main (int argc, char **argv)
+{
+	guint n_connections = nmtst_perf_arg (argc, argv, 1, 1000);
+	guint n_rounds = nmtst_perf_arg (argc, argv, 2, 20);
+	GRand *rand;
+	GPtrArray *connections, *sorted;
+	gint64 start;
+	guint i, r, found = 0;
+
+	nmtst_perf_init (argc, argv);
+
+	rand = g_rand_new_with_seed (42);
+	connections = g_ptr_array_new_with_free_func (g_object_unref);
+	start = g_get_monotonic_time ();
+	for (i = 0; i < n_connections; i++)
+		g_ptr_array_add (connections, nmtst_perf_create_connection (rand, i));
+	nmtst_perf_report_time ("build", n_connections, 1, start);
+
+	start = g_get_monotonic_time ();
+	for (r = 0; r < n_rounds; r++) {
+		for (i = 0; i < connections->len; i++) {
+			NMConnection *clone = nm_simple_connection_new_clone (connections->pdata[i]);
+
+			found += nm_connection_compare (connections->pdata[i], clone, NM_SETTING_COMPARE_FLAG_EXACT);
+			g_object_unref (clone);
+		}
+	}
+	nmtst_perf_report_time ("clone-compare", n_connections, n_rounds, start);
+
+	start = g_get_monotonic_time ();
+	for (r = 0; r < n_rounds; r++) {
+		for (i = 1; i < connections->len; i++) {
+			GHashTable *diff = NULL;
+
+			nm_connection_diff (connections->pdata[i - 1], connections->pdata[i],
+			                    NM_SETTING_COMPARE_FLAG_EXACT, &diff);
+			if (diff)
+				g_hash_table_unref (diff);
+		}
+	}
+	nmtst_perf_report_time ("diff", n_connections, n_rounds, start);
+
+	start = g_get_monotonic_time ();
+	for (r = 0; r < n_rounds; r++) {
+		for (i = 0; i < connections->len; i++) {
+			GVariant *dict = nm_connection_to_dbus (connections->pdata[i], NM_CONNECTION_SERIALIZE_ALL);
+			NMConnection *copy = nm_simple_connection_new_from_dbus (dict, NULL);
+
+			g_assert (copy);
+			g_object_unref (copy);
+			g_variant_unref (dict);
+		}
+	}
+	nmtst_perf_report_time ("dbus-roundtrip", n_connections, n_rounds, start);
+
+	/* What the settings do when they look up a connection by UUID */
+	start = g_get_monotonic_time ();
+	for (r = 0; r < n_rounds; r++) {
+		char uuid[37];
+
+		g_snprintf (uuid, sizeof (uuid), "%08x-0000-4000-8000-000000000000", (r * 7919) % n_connections);
+		for (i = 0; i < connections->len; i++) {
+			if (!g_strcmp0 (uuid, nm_connection_get_uuid (connections->pdata[i]))) {
+				found++;
+				break;
+			}
+		}
+	}
+	nmtst_perf_report_time ("uuid-lookup", n_connections, n_rounds, start);
+
+	start = g_get_monotonic_time ();
+	for (r = 0; r < n_rounds; r++) {
+		for (i = 0; i < connections->len; i++) {
+			found += !!nm_connection_get_setting_connection (connections->pdata[i]);
+			found += !!nm_connection_get_setting_ip4_config (connections->pdata[i]);
+			found += !!nm_connection_get_setting_by_name (connections->pdata[i], NM_SETTING_WIRED_SETTING_NAME);
+		}
+	}
+	nmtst_perf_report_time ("setting-lookup", n_connections, n_rounds, start);
+
+	/* Ordering of autoconnect candidates, as done by the policy */
+	start = g_get_monotonic_time ();
+	for (r = 0; r < n_rounds; r++) {
+		sorted = g_ptr_array_sized_new (connections->len);
+		for (i = 0; i < connections->len; i++)
+			g_ptr_array_add (sorted, connections->pdata[i]);
+		g_ptr_array_sort (sorted, (GCompareFunc) nm_utils_cmp_connection_by_autoconnect_priority);
+		g_ptr_array_unref (sorted);
+	}
+	nmtst_perf_report_time ("autoconnect-sort", n_connections, n_rounds, start);
+
+	g_ptr_array_unref (connections);
+	g_rand_free (rand);
+
+	/* Keep the loops from being optimized away */
+	return found == G_MAXUINT ? EXIT_FAILURE : EXIT_SUCCESS;
+}
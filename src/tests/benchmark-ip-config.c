@@ -0,0 +1,302 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ */
+
+/* Address/route sync, capture, merge and subtract of IPv4 configurations
+ * on the fake platform.
+ *
+ * Usage: benchmark-ip-config [N_ADDRESSES] [N_ROUTES] [N_ROUNDS] [CHANGE_EVERY]
+ *
+ * The capture measurements compare copying the platform lists (what
+ * nm_ip4_config_capture() used to do) with capturing from shared platform
+ * snapshots.  Every CHANGE_EVERY captures an address is added, like an
+ * external change would.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "nm-ip4-config.h"
+#include "nm-platform.h"
+#include "nm-fake-platform.h"
+
+#include "nm-test-utils.h"
+
+#define IFNAME "nm-bench0"
+
+static guint32
+nth_addr (guint32 base, guint n)
+{
+	return htonl (ntohl (base) + n);
+}
+
+static void
+change (int ifindex, guint n)
+{
+	nm_platform_ip4_address_add (ifindex, nth_addr (inet_addr ("10.128.0.0"), n), 0, 32,
+	                             NM_PLATFORM_LIFETIME_PERMANENT, NM_PLATFORM_LIFETIME_PERMANENT, NULL);
+}
+
+static GArray *
+build_addresses (int ifindex, guint n, guint first)
+{
+	GArray *addresses = g_array_sized_new (FALSE, TRUE, sizeof (NMPlatformIP4Address), n);
+	guint i;
+
+	for (i = 0; i < n; i++) {
+		NMPlatformIP4Address address;
+
+		memset (&address, 0, sizeof (address));
+		address.ifindex = ifindex;
+		address.address = nth_addr (inet_addr ("10.0.0.1"), first + i);
+		address.plen = 32;
+		address.lifetime = NM_PLATFORM_LIFETIME_PERMANENT;
+		address.preferred = NM_PLATFORM_LIFETIME_PERMANENT;
+		address.source = NM_IP_CONFIG_SOURCE_USER;
+		g_array_append_val (addresses, address);
+	}
+	return addresses;
+}
+
+static GArray *
+build_routes (int ifindex, guint n, guint first)
+{
+	GArray *routes = g_array_sized_new (FALSE, TRUE, sizeof (NMPlatformIP4Route), n);
+	guint i;
+
+	for (i = 0; i < n; i++) {
+		NMPlatformIP4Route route;
+
+		memset (&route, 0, sizeof (route));
+		route.ifindex = ifindex;
+		route.network = nth_addr (inet_addr ("172.16.0.0"), (first + i) * 256);
+		route.plen = 24;
+		route.metric = 100;
+		route.source = NM_IP_CONFIG_SOURCE_USER;
+		g_array_append_val (routes, route);
+	}
+	return routes;
+}
+
+static NMIP4Config *
+build_config (int ifindex, guint n_addresses, guint n_routes, guint first)
+{
+	NMIP4Config *config = nm_ip4_config_new ();
+	GArray *addresses = build_addresses (ifindex, n_addresses, first);
+	GArray *routes = build_routes (ifindex, n_routes, first);
+	guint i;
+
+	for (i = 0; i < addresses->len; i++)
+		nm_ip4_config_add_address (config, &g_array_index (addresses, NMPlatformIP4Address, i));
+	for (i = 0; i < routes->len; i++)
+		nm_ip4_config_add_route (config, &g_array_index (routes, NMPlatformIP4Route, i));
+
+	g_array_unref (addresses);
+	g_array_unref (routes);
+	return config;
+}
+
+static void
+bench_sync (int ifindex, guint n_addresses, guint n_routes, guint n_rounds)
+{
+	GArray *addresses[2], *routes[2];
+	gint64 start;
+	guint r;
+
+	/* The second set differs from the first by one item */
+	addresses[0] = build_addresses (ifindex, n_addresses, 0);
+	addresses[1] = build_addresses (ifindex, n_addresses, 1);
+	routes[0] = build_routes (ifindex, n_routes, 0);
+	routes[1] = build_routes (ifindex, n_routes, 1);
+
+	g_assert (nm_platform_ip4_address_sync (ifindex, addresses[0], 0));
+	start = g_get_monotonic_time ();
+	for (r = 0; r < n_rounds; r++)
+		nm_platform_ip4_address_sync (ifindex, addresses[0], 0);
+	nmtst_perf_report_time ("address-sync", n_addresses, n_rounds, start);
+
+	start = g_get_monotonic_time ();
+	for (r = 0; r < n_rounds; r++)
+		nm_platform_ip4_address_sync (ifindex, addresses[r % 2], 0);
+	nmtst_perf_report_time ("address-sync-change", n_addresses, n_rounds, start);
+
+	g_assert (nm_platform_ip4_route_sync (ifindex, routes[0]));
+	start = g_get_monotonic_time ();
+	for (r = 0; r < n_rounds; r++)
+		nm_platform_ip4_route_sync (ifindex, routes[0]);
+	nmtst_perf_report_time ("route-sync", n_routes, n_rounds, start);
+
+	start = g_get_monotonic_time ();
+	for (r = 0; r < n_rounds; r++)
+		nm_platform_ip4_route_sync (ifindex, routes[r % 2]);
+	nmtst_perf_report_time ("route-sync-change", n_routes, n_rounds, start);
+
+	g_array_unref (addresses[0]);
+	g_array_unref (addresses[1]);
+	g_array_unref (routes[0]);
+	g_array_unref (routes[1]);
+}
+
+static void
+bench_merge_subtract (int ifindex, guint n_addresses, guint n_routes, guint n_rounds)
+{
+	NMIP4Config *src = build_config (ifindex, n_addresses, n_routes, 0);
+	gint64 merge = 0, subtract = 0, start;
+	guint r;
+
+	for (r = 0; r < n_rounds; r++) {
+		NMIP4Config *dst = build_config (ifindex, n_addresses, n_routes, n_addresses + n_routes);
+
+		start = g_get_monotonic_time ();
+		nm_ip4_config_merge (dst, src);
+		merge += g_get_monotonic_time () - start;
+
+		start = g_get_monotonic_time ();
+		nm_ip4_config_subtract (dst, src);
+		subtract += g_get_monotonic_time () - start;
+
+		g_object_unref (dst);
+	}
+
+	nmtst_perf_report ("config-merge", n_addresses + n_routes, n_rounds,
+	                   (double) merge * 1000 / ((n_addresses + n_routes) * n_rounds), "nsec/item");
+	nmtst_perf_report ("config-subtract", n_addresses + n_routes, n_rounds,
+	                   (double) subtract * 1000 / ((n_addresses + n_routes) * n_rounds), "nsec/item");
+	g_object_unref (src);
+}
+
+/* What nm_ip4_config_capture() used to do: a new config plus fresh copies
+ * of the platform lists, with the default routes stripped in place. */
+static NMIP4Config *
+capture_copy (int ifindex)
+{
+	NMIP4Config *config;
+	GArray *addresses, *routes;
+	guint32 lowest_metric = G_MAXUINT32, gateway = 0;
+	gboolean has_gateway = FALSE;
+	guint i;
+
+	if (nm_platform_link_get_master (ifindex) > 0)
+		return NULL;
+
+	config = nm_ip4_config_new ();
+	addresses = nm_platform_ip4_address_get_all (ifindex);
+	routes = nm_platform_ip4_route_get_all (ifindex, NM_PLATFORM_GET_ROUTE_MODE_ALL);
+	for (i = 0; i < routes->len; i++) {
+		const NMPlatformIP4Route *route = &g_array_index (routes, NMPlatformIP4Route, i);
+
+		if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (route)) {
+			if (route->metric < lowest_metric) {
+				gateway = route->gateway;
+				lowest_metric = route->metric;
+			}
+			has_gateway = TRUE;
+			g_array_remove_index (routes, i--);
+		}
+	}
+	if (has_gateway) {
+		nm_ip4_config_set_gateway (config, gateway);
+		for (i = 0; i < routes->len; i++) {
+			const NMPlatformIP4Route *route = &g_array_index (routes, NMPlatformIP4Route, i);
+
+			if (route->plen == 32 && route->network == gateway && route->gateway == 0)
+				g_array_remove_index (routes, i--);
+		}
+	}
+	g_array_unref (addresses);
+	g_array_unref (routes);
+	return config;
+}
+
+static void
+bench_capture (int ifindex, guint n_routes, guint n_captures, guint change_every)
+{
+	guint i, arrays, misses_before, misses_after, copies_before;
+	gint64 start;
+
+	/* Copying: two fresh arrays per capture */
+	arrays = 0;
+	start = g_get_monotonic_time ();
+	for (i = 0; i < n_captures; i++) {
+		NMIP4Config *config;
+
+		if (change_every && i % change_every == 0)
+			change (ifindex, i);
+
+		config = capture_copy (ifindex);
+		arrays += 2;
+		g_object_unref (config);
+	}
+	nmtst_perf_report_time ("capture-copy", n_routes, n_captures, start);
+	nmtst_perf_report ("capture-copy-arrays", n_routes, n_captures, (double) arrays / n_captures, "arrays/round");
+
+	/* Snapshots: arrays are only built after a change.  New configs start
+	 * out with shared empty lists, so the only arrays are the platform
+	 * snapshots and the route lists with the default route dropped. */
+	nm_platform_ip_snapshot_get_stats (NULL, &misses_before);
+	copies_before = nm_ip4_config_get_captured_route_copies ();
+	start = g_get_monotonic_time ();
+	for (i = 0; i < n_captures; i++) {
+		NMIP4Config *config;
+
+		if (change_every && i % change_every == 0)
+			change (ifindex, n_captures + i);
+
+		config = nm_ip4_config_capture (ifindex, FALSE);
+		g_object_unref (config);
+	}
+	nmtst_perf_report_time ("capture-snapshot", n_routes, n_captures, start);
+	nm_platform_ip_snapshot_get_stats (NULL, &misses_after);
+	arrays = (misses_after - misses_before)
+	         + (nm_ip4_config_get_captured_route_copies () - copies_before);
+	nmtst_perf_report ("capture-snapshot-arrays", n_routes, n_captures, (double) arrays / n_captures, "arrays/round");
+}
+
+int
+main (int argc, char **argv)
+{
+	guint n_addresses = nmtst_perf_arg (argc, argv, 1, 16);
+	guint n_routes = nmtst_perf_arg (argc, argv, 2, 256);
+	guint n_rounds = nmtst_perf_arg (argc, argv, 3, 10000);
+	guint change_every = nmtst_perf_arg (argc, argv, 4, 100);
+	int ifindex;
+
+	nmtst_perf_init (argc, argv);
+
+	nm_fake_platform_setup ();
+	nm_platform_dummy_add (IFNAME);
+	ifindex = nm_platform_link_get_ifindex (IFNAME);
+	nm_platform_link_set_up (ifindex);
+
+	bench_sync (ifindex, n_addresses, n_routes, n_rounds / 10);
+	bench_merge_subtract (ifindex, n_addresses, n_routes, n_rounds / 10);
+
+	/* Default route for the capture measurements */
+	nm_platform_ip4_route_add (ifindex, NM_IP_CONFIG_SOURCE_USER, 0, 0,
+	                           inet_addr ("10.0.0.254"), 0, 100, 0);
+	bench_capture (ifindex, n_routes, n_rounds, change_every);
+
+	nm_platform_link_delete (ifindex);
+	nm_platform_free ();
+	return EXIT_SUCCESS;
+}
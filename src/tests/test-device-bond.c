@@ -0,0 +1,163 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <string.h>
+
+#include "nm-device-bond.h"
+#include "nm-platform.h"
+#include "nm-core-internal.h"
+
+#include "nm-test-utils.h"
+
+/* Options that are written in every mode, with their defaults */
+#define TAIL "primary_reselect=0 fail_over_mac=0 use_carrier=1 ad_select=0 xmit_hash_policy=0 resend_igmp=1"
+
+static void
+check_options (const char *expected, ...)
+{
+	NMSettingBond *s_bond;
+	GArray *options;
+	GString *str;
+	const char *name, *value;
+	va_list ap;
+	guint i;
+
+	s_bond = (NMSettingBond *) nm_setting_bond_new ();
+
+	va_start (ap, expected);
+	while ((name = va_arg (ap, const char *))) {
+		value = va_arg (ap, const char *);
+		g_assert (nm_setting_bond_add_option (s_bond, name, value));
+	}
+	va_end (ap);
+
+	options = nm_device_bond_build_options (s_bond);
+	str = g_string_new (NULL);
+	for (i = 0; i < options->len; i++) {
+		const NMPlatformLinkOption *option = &g_array_index (options, NMPlatformLinkOption, i);
+
+		g_string_append_printf (str, "%s%s=%s", i ? " " : "", option->option, option->value);
+	}
+	g_assert_cmpstr (str->str, ==, expected);
+
+	g_string_free (str, TRUE);
+	g_array_free (options, TRUE);
+	g_object_unref (s_bond);
+}
+
+static void
+test_options_miimon (void)
+{
+	check_options ("arp_interval=0 miimon=100 updelay=0 downdelay=0 mode=balance-rr arp_validate=0 " TAIL,
+	               NM_SETTING_BOND_OPTION_MODE, "balance-rr",
+	               NM_SETTING_BOND_OPTION_MIIMON, "100",
+	               NULL);
+	check_options ("arp_interval=0 miimon=100 updelay=0 downdelay=0 mode=0 arp_validate=0 " TAIL,
+	               NM_SETTING_BOND_OPTION_MODE, "0",
+	               NM_SETTING_BOND_OPTION_MIIMON, "100",
+	               NULL);
+	check_options ("arp_interval=0 miimon=100 updelay=0 downdelay=0 mode=active-backup arp_validate=0 primary= " TAIL,
+	               NM_SETTING_BOND_OPTION_MODE, "active-backup",
+	               NM_SETTING_BOND_OPTION_MIIMON, "100",
+	               NULL);
+}
+
+static void
+test_options_8023ad (void)
+{
+	check_options ("miimon=100 updelay=0 downdelay=0 mode=802.3ad " TAIL " lacp_rate=0",
+	               NM_SETTING_BOND_OPTION_MODE, "802.3ad",
+	               NM_SETTING_BOND_OPTION_MIIMON, "100",
+	               NULL);
+	check_options ("miimon=100 updelay=0 downdelay=0 mode=4 " TAIL " lacp_rate=0",
+	               NM_SETTING_BOND_OPTION_MODE, "4",
+	               NM_SETTING_BOND_OPTION_MIIMON, "100",
+	               NULL);
+}
+
+static void
+test_options_tlb_alb (void)
+{
+	check_options ("miimon=100 updelay=0 downdelay=0 mode=balance-tlb primary= " TAIL,
+	               NM_SETTING_BOND_OPTION_MODE, "balance-tlb",
+	               NM_SETTING_BOND_OPTION_MIIMON, "100",
+	               NULL);
+	check_options ("miimon=100 updelay=0 downdelay=0 mode=5 primary= " TAIL,
+	               NM_SETTING_BOND_OPTION_MODE, "5",
+	               NM_SETTING_BOND_OPTION_MIIMON, "100",
+	               NULL);
+	check_options ("miimon=100 updelay=0 downdelay=0 mode=balance-alb primary= " TAIL,
+	               NM_SETTING_BOND_OPTION_MODE, "balance-alb",
+	               NM_SETTING_BOND_OPTION_MIIMON, "100",
+	               NULL);
+	check_options ("miimon=100 updelay=0 downdelay=0 mode=6 primary= " TAIL,
+	               NM_SETTING_BOND_OPTION_MODE, "6",
+	               NM_SETTING_BOND_OPTION_MIIMON, "100",
+	               NULL);
+
+	/* ARP monitoring is dropped rather than rejected by the kernel */
+	check_options ("mode=balance-alb primary= " TAIL,
+	               NM_SETTING_BOND_OPTION_MODE, "balance-alb",
+	               NM_SETTING_BOND_OPTION_ARP_INTERVAL, "1000",
+	               NM_SETTING_BOND_OPTION_ARP_VALIDATE, "all",
+	               NULL);
+}
+
+static void
+test_options_arp (void)
+{
+	check_options ("mode=active-backup arp_interval=1000 arp_validate=all primary= " TAIL,
+	               NM_SETTING_BOND_OPTION_MODE, "active-backup",
+	               NM_SETTING_BOND_OPTION_ARP_INTERVAL, "1000",
+	               NM_SETTING_BOND_OPTION_ARP_VALIDATE, "all",
+	               NULL);
+	check_options ("mode=1 arp_interval=1000 arp_validate=all primary= " TAIL,
+	               NM_SETTING_BOND_OPTION_MODE, "1",
+	               NM_SETTING_BOND_OPTION_ARP_INTERVAL, "1000",
+	               NM_SETTING_BOND_OPTION_ARP_VALIDATE, "all",
+	               NULL);
+
+	/* arp_validate needs active-backup */
+	check_options ("mode=balance-xor arp_interval=1000 arp_validate=0 " TAIL,
+	               NM_SETTING_BOND_OPTION_MODE, "balance-xor",
+	               NM_SETTING_BOND_OPTION_ARP_INTERVAL, "1000",
+	               NM_SETTING_BOND_OPTION_ARP_VALIDATE, "all",
+	               NULL);
+}
+
+/*******************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv);
+
+	g_test_add_func ("/bond/options/miimon", test_options_miimon);
+	g_test_add_func ("/bond/options/802.3ad", test_options_8023ad);
+	g_test_add_func ("/bond/options/tlb-alb", test_options_tlb_alb);
+	g_test_add_func ("/bond/options/arp", test_options_arp);
+
+	return g_test_run ();
+}
@@ -21,6 +21,7 @@
 #include "config.h"
 
 #include <glib.h>
+#include <gio/gio.h>
 #include <string.h>
 #include <errno.h>
 #include <netinet/ether.h>
@@ -29,6 +30,7 @@
 
 #include "NetworkManagerUtils.h"
 #include "nm-logging.h"
+#include "gsystem-local-alloc.h"
 
 #include "nm-test-utils.h"
 
@@ -331,6 +333,103 @@ test_nm_utils_kill_child (void)
 }
 
 
+/*******************************************/
+
+static void
+test_nm_utils_spawn_sync (void)
+{
+	const char *argv[] = { "/bin/sh", "-c", "echo out; echo err >&2; exit 3", NULL };
+	const char *argv_sleep[] = { "/bin/sleep", "5", NULL };
+	gs_free char *out = NULL;
+	gs_free char *err = NULL;
+	GError *error = NULL;
+	int status = 0;
+	gboolean success;
+
+	success = nm_utils_spawn_sync (argv,
+	                               NM_UTILS_SPAWN_FLAGS_CAPTURE_STDOUT | NM_UTILS_SPAWN_FLAGS_CAPTURE_STDERR,
+	                               5000, LOGD_CORE, &status, &out, &err, &error);
+	g_assert_no_error (error);
+	g_assert (success);
+	g_assert (WIFEXITED (status));
+	g_assert_cmpint (WEXITSTATUS (status), ==, 3);
+	g_assert_cmpstr (out, ==, "out\n");
+	g_assert_cmpstr (err, ==, "err\n");
+
+	g_test_expect_message ("NetworkManager", G_LOG_LEVEL_WARNING, "*spawn: '/bin/sleep' (*) timed out after 100 ms");
+	success = nm_utils_spawn_sync (argv_sleep, NM_UTILS_SPAWN_FLAGS_NONE,
+	                               100, LOGD_CORE, &status, NULL, NULL, &error);
+	g_test_assert_expected_messages ();
+	g_assert (!success);
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+	g_assert_cmpint (status, ==, -1);
+	g_clear_error (&error);
+}
+
+typedef struct {
+	GMainLoop *loop;
+	guint pending;
+	GString *seen;
+} SpawnAsyncData;
+
+static void
+test_spawn_async_cb (int child_status, const char *out, const char *err,
+                     GError *error, gpointer user_data)
+{
+	SpawnAsyncData *data = user_data;
+
+	g_assert_no_error (error);
+	g_assert (WIFEXITED (child_status));
+	g_assert_cmpint (WEXITSTATUS (child_status), ==, 0);
+	g_assert (out);
+	g_assert (!err);
+
+	g_string_append (data->seen, out);
+	if (--data->pending == 0)
+		g_main_loop_quit (data->loop);
+}
+
+static void
+test_nm_utils_spawn_async (void)
+{
+	SpawnAsyncData data;
+	guint ids[8];
+	guint i;
+
+	data.loop = g_main_loop_new (NULL, FALSE);
+	data.seen = g_string_new (NULL);
+	data.pending = 0;
+
+	/* More requests than may run at once; the last one gets cancelled
+	 * while it is still queued.
+	 */
+	for (i = 0; i < G_N_ELEMENTS (ids); i++) {
+		gs_free char *cmd = g_strdup_printf ("sleep 0.1; echo %u", i);
+		const char *argv[] = { "/bin/sh", "-c", cmd, NULL };
+
+		ids[i] = nm_utils_spawn_async (argv, NM_UTILS_SPAWN_FLAGS_CAPTURE_STDOUT,
+		                               5000, LOGD_CORE, test_spawn_async_cb, &data, NULL);
+		g_assert (ids[i]);
+		data.pending++;
+	}
+	nm_utils_spawn_cancel (ids[G_N_ELEMENTS (ids) - 1]);
+	data.pending--;
+
+	g_main_loop_run (data.loop);
+
+	g_assert_cmpint (data.pending, ==, 0);
+	g_assert_cmpint (data.seen->len, ==, 2 * (G_N_ELEMENTS (ids) - 1));
+	for (i = 0; i < G_N_ELEMENTS (ids) - 1; i++) {
+		char line[3] = { '0' + i, '\n', '\0' };
+
+		g_assert (strstr (data.seen->str, line));
+	}
+	g_assert (!strchr (data.seen->str, '0' + G_N_ELEMENTS (ids) - 1));
+
+	g_string_free (data.seen, TRUE);
+	g_main_loop_unref (data.loop);
+}
+
 /*******************************************/
 
 NMTST_DEFINE ();
@@ -343,6 +442,8 @@ main (int argc, char **argv)
 	nm_logging_setup ("DEBUG", "DEFAULT", NULL, NULL);
 
 	g_test_add_func ("/general/nm_utils_kill_child", test_nm_utils_kill_child);
+	g_test_add_func ("/general/nm_utils_spawn_sync", test_nm_utils_spawn_sync);
+	g_test_add_func ("/general/nm_utils_spawn_async", test_nm_utils_spawn_async);
 
 	return g_test_run ();
 }
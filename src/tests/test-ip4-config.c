@@ -26,6 +26,7 @@
 
 #include "nm-ip4-config.h"
 #include "nm-platform.h"
+#include "nm-fake-platform.h"
 
 static void
 addr_init (NMPlatformIP4Address *a, const char *addr, const char *peer, guint plen)
@@ -336,6 +337,50 @@ test_merge_subtract_mss_mtu (void)
 	g_object_unref (cfg3);
 }
 
+static void
+test_capture_shared (void)
+{
+	NMIP4Config *cfg1, *cfg2, *cfg3;
+	NMPlatformIP4Address addr;
+	int ifindex;
+
+	g_assert (nm_platform_dummy_add ("nm-test-cow"));
+	ifindex = nm_platform_link_get_ifindex ("nm-test-cow");
+	g_assert_cmpint (ifindex, >, 0);
+	g_assert (nm_platform_ip4_address_add (ifindex, addr_to_num ("192.168.1.5"), 0, 24,
+	                                       NM_PLATFORM_LIFETIME_PERMANENT, NM_PLATFORM_LIFETIME_PERMANENT, NULL));
+	g_assert (nm_platform_ip4_route_add (ifindex, NM_IP_CONFIG_SOURCE_USER, 0, 0,
+	                                     addr_to_num ("192.168.1.1"), 0, 100, 0));
+
+	/* Captures of an unchanged interface share the platform snapshot */
+	cfg1 = nm_ip4_config_capture (ifindex, FALSE);
+	cfg2 = nm_ip4_config_capture (ifindex, FALSE);
+	g_assert_cmpuint (nm_ip4_config_get_num_addresses (cfg1), ==, 1);
+	g_assert (nm_ip4_config_get_address (cfg1, 0) == nm_ip4_config_get_address (cfg2, 0));
+	g_assert_cmpuint (nm_ip4_config_get_gateway (cfg1), ==, addr_to_num ("192.168.1.1"));
+	g_assert_cmpuint (nm_ip4_config_get_num_routes (cfg1), ==, nm_ip4_config_get_num_routes (cfg2));
+
+	/* Modifying one copies its list and leaves the other alone */
+	addr = *nm_ip4_config_get_address (cfg1, 0);
+	addr.address = addr_to_num ("192.168.1.6");
+	nm_ip4_config_add_address (cfg1, &addr);
+	g_assert_cmpuint (nm_ip4_config_get_num_addresses (cfg1), ==, 2);
+	g_assert_cmpuint (nm_ip4_config_get_num_addresses (cfg2), ==, 1);
+	nm_ip4_config_del_address (cfg2, 0);
+	g_assert_cmpuint (nm_ip4_config_get_num_addresses (cfg2), ==, 0);
+
+	/* A platform change results in a new snapshot */
+	g_assert (nm_platform_ip4_address_add (ifindex, addr_to_num ("192.168.1.7"), 0, 24,
+	                                       NM_PLATFORM_LIFETIME_PERMANENT, NM_PLATFORM_LIFETIME_PERMANENT, NULL));
+	cfg3 = nm_ip4_config_capture (ifindex, FALSE);
+	g_assert_cmpuint (nm_ip4_config_get_num_addresses (cfg3), ==, 2);
+
+	g_object_unref (cfg1);
+	g_object_unref (cfg2);
+	g_object_unref (cfg3);
+	g_assert (nm_platform_link_delete (ifindex));
+}
+
 /*******************************************/
 
 int
@@ -353,6 +398,9 @@ main (int argc, char **argv)
 	g_test_add_func ("/ip4-config/add-route-with-source", test_add_route_with_source);
 	g_test_add_func ("/ip4-config/merge-subtract-mss-mtu", test_merge_subtract_mss_mtu);
 
+	nm_fake_platform_setup ();
+	g_test_add_func ("/ip4-config/capture-shared", test_capture_shared);
+
 	return g_test_run ();
 }
 
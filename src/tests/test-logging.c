@@ -0,0 +1,131 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <string.h>
+
+#include "nm-logging.h"
+
+#include "nm-test-utils.h"
+
+/* Checks that the buffer returns exactly the messages in the
+ * NULL-terminated list, oldest first, and that "next" is @expected_next. */
+static void
+check_buffer (guint32 since, guint32 expected_next, ...)
+{
+	char **lines;
+	const char *msg;
+	guint32 next = 0;
+	guint i = 0;
+	va_list ap;
+
+	lines = nm_logging_debug_buffer_get (since, &next);
+	g_assert (lines);
+
+	va_start (ap, expected_next);
+	while ((msg = va_arg (ap, const char *))) {
+		g_assert (lines[i]);
+		if (!g_str_has_suffix (lines[i], msg))
+			g_error ("line %u: '%s' does not end with '%s'", i, lines[i], msg);
+		i++;
+	}
+	va_end (ap);
+	g_assert_cmpstr (lines[i], ==, NULL);
+	g_assert_cmpuint (next, ==, expected_next);
+
+	g_strfreev (lines);
+}
+
+static void
+test_debug_buffer_disabled (void)
+{
+	guint32 next = 42;
+
+	nm_logging_debug_buffer_setup (0);
+	g_assert (nm_logging_debug_buffer_get (0, &next) == NULL);
+	g_assert_cmpuint (next, ==, 42);
+}
+
+static void
+test_debug_buffer_overwrite (void)
+{
+	nm_logging_debug_buffer_setup (0);
+	nm_logging_debug_buffer_setup (3);
+
+	check_buffer (0, 0, NULL);
+
+	nm_log_dbg (LOGD_CORE, "msg 1");
+	nm_log_dbg (LOGD_CORE, "msg 2");
+	check_buffer (0, 2, "msg 1", "msg 2", NULL);
+	check_buffer (1, 2, "msg 2", NULL);
+	check_buffer (2, 2, NULL);
+
+	/* msg 1 and msg 2 get overwritten */
+	nm_log_dbg (LOGD_CORE, "msg 3");
+	nm_log_dbg (LOGD_CORE, "msg 4");
+	nm_log_dbg (LOGD_CORE, "msg 5");
+	check_buffer (0, 5, "msg 3", "msg 4", "msg 5", NULL);
+	check_buffer (1, 5, "msg 3", "msg 4", "msg 5", NULL);
+	check_buffer (4, 5, "msg 5", NULL);
+	check_buffer (5, 5, NULL);
+}
+
+static void
+test_debug_buffer_wrap (void)
+{
+	/* 3 divides G_MAXUINT32, so the slots stay contiguous across the wrap */
+	nm_logging_debug_buffer_setup (0);
+	nm_logging_debug_buffer_setup (3);
+	_nm_logging_debug_buffer_set_last (G_MAXUINT32 - 1);
+
+	nm_log_dbg (LOGD_CORE, "msg a");   /* G_MAXUINT32 */
+	nm_log_dbg (LOGD_CORE, "msg b");   /* 0 is skipped, so 1 */
+	nm_log_dbg (LOGD_CORE, "msg c");   /* 2 */
+	check_buffer (0, 2, "msg a", "msg b", "msg c", NULL);
+	check_buffer (G_MAXUINT32 - 1, 2, "msg a", "msg b", "msg c", NULL);
+	check_buffer (G_MAXUINT32, 2, "msg b", "msg c", NULL);
+	check_buffer (1, 2, "msg c", NULL);
+	check_buffer (2, 2, NULL);
+
+	/* overwrites msg a */
+	nm_log_dbg (LOGD_CORE, "msg d");   /* 3 */
+	check_buffer (0, 3, "msg b", "msg c", "msg d", NULL);
+	check_buffer (G_MAXUINT32, 3, "msg b", "msg c", "msg d", NULL);
+	check_buffer (2, 3, "msg d", NULL);
+}
+
+/*******************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	/* Only the debug buffer sees the debug messages */
+	nmtst_init_with_logging (&argc, &argv, "ERR", "ALL");
+
+	g_test_add_func ("/logging/debug-buffer/disabled", test_debug_buffer_disabled);
+	g_test_add_func ("/logging/debug-buffer/overwrite", test_debug_buffer_overwrite);
+	g_test_add_func ("/logging/debug-buffer/wrap", test_debug_buffer_wrap);
+
+	return g_test_run ();
+}
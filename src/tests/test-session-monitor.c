@@ -0,0 +1,382 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <string.h>
+
+#include "nm-session-monitor.h"
+#include "nm-auth-manager.h"
+#include "nm-settings-connection.h"
+#include "nm-setting-connection.h"
+#include "nm-setting-wired.h"
+#include "nm-utils.h"
+#include "nm-logging.h"
+
+#include "nm-test-utils.h"
+
+/* Cache lifetimes of nm-session-monitor.c */
+#define TTL          300
+#define NEGATIVE_TTL 30
+
+typedef struct {
+	const char *user;
+	uid_t uid;
+	gboolean session;
+} User;
+
+/* Each test uses its own users, since the cache lives as long as the
+ * session monitor singleton. */
+static User users[] = {
+	{ "alice",    1000, TRUE },
+	{ "bob",      1001, FALSE },
+	{ "carol",    1002, TRUE },
+	{ "erin",     1004, FALSE },
+	{ "frank",    1005, TRUE },
+	{ "grace",    1006, FALSE },
+	{ NULL },
+};
+
+/* Only accessed with atomic operations, lookups run on a worker thread */
+static volatile gint lookups;
+
+/* The name currently returned for uid 1002 */
+G_LOCK_DEFINE_STATIC (renamed);
+static const char *renamed_user = "carol";
+
+static gboolean
+lookup_func (const char *user, uid_t uid, char **out_user, uid_t *out_uid)
+{
+	guint i;
+
+	g_atomic_int_inc (&lookups);
+
+	for (i = 0; users[i].user; i++) {
+		if (user ? strcmp (user, users[i].user) != 0 : uid != users[i].uid)
+			continue;
+
+		if (users[i].uid == 1002) {
+			G_LOCK (renamed);
+			*out_user = g_strdup (renamed_user);
+			G_UNLOCK (renamed);
+		} else
+			*out_user = g_strdup (users[i].user);
+		*out_uid = users[i].uid;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static gboolean
+session_exists_func (uid_t uid, gboolean active)
+{
+	guint i;
+
+	for (i = 0; users[i].user; i++) {
+		if (users[i].uid == uid)
+			return users[i].session;
+	}
+	return FALSE;
+}
+
+/*******************************************/
+
+typedef struct {
+	guint calls;
+	gboolean found;
+	uid_t uid;
+	char *user;
+} Result;
+
+static void
+result_cb (gboolean found, uid_t uid, const char *user, gpointer user_data)
+{
+	Result *result = user_data;
+
+	result->calls++;
+	result->found = found;
+	result->uid = uid;
+	g_free (result->user);
+	result->user = g_strdup (found ? user : NULL);
+}
+
+static void
+result_clear (Result *result)
+{
+	g_free (result->user);
+	memset (result, 0, sizeof (*result));
+}
+
+static void
+wait_for_result (Result *result, guint calls)
+{
+	while (result->calls < calls)
+		g_main_context_iteration (NULL, TRUE);
+	g_assert_cmpint (result->calls, ==, calls);
+}
+
+/*******************************************/
+
+static void
+test_ttl (void)
+{
+	Result result = { 0 };
+	gint start = g_atomic_int_get (&lookups);
+
+	_nm_session_monitor_set_now (1000);
+
+	/* Not cached yet, the callback comes from the main loop */
+	nm_session_monitor_uid_to_user_async (1000, result_cb, &result);
+	g_assert_cmpint (result.calls, ==, 0);
+	wait_for_result (&result, 1);
+	g_assert (result.found);
+	g_assert_cmpstr (result.user, ==, "alice");
+	g_assert_cmpint (g_atomic_int_get (&lookups), ==, start + 1);
+
+	/* Cached: answered before returning */
+	nm_session_monitor_uid_to_user_async (1000, result_cb, &result);
+	g_assert_cmpint (result.calls, ==, 2);
+	g_assert_cmpstr (result.user, ==, "alice");
+
+	/* The lookup filled the reverse direction too */
+	nm_session_monitor_user_to_uid_async ("alice", result_cb, &result);
+	g_assert_cmpint (result.calls, ==, 3);
+	g_assert_cmpint (result.uid, ==, 1000);
+	g_assert_cmpint (g_atomic_int_get (&lookups), ==, start + 1);
+
+	_nm_session_monitor_set_now (1000 + TTL - 1);
+	nm_session_monitor_uid_to_user_async (1000, result_cb, &result);
+	g_assert_cmpint (result.calls, ==, 4);
+	g_assert_cmpint (g_atomic_int_get (&lookups), ==, start + 1);
+
+	/* Expired */
+	_nm_session_monitor_set_now (1000 + TTL + 1);
+	nm_session_monitor_uid_to_user_async (1000, result_cb, &result);
+	g_assert_cmpint (result.calls, ==, 4);
+	wait_for_result (&result, 5);
+	g_assert_cmpstr (result.user, ==, "alice");
+	g_assert_cmpint (g_atomic_int_get (&lookups), ==, start + 2);
+
+	result_clear (&result);
+}
+
+static void
+test_negative (void)
+{
+	Result result = { 0 };
+	gint start = g_atomic_int_get (&lookups);
+
+	_nm_session_monitor_set_now (2000);
+
+	nm_session_monitor_uid_to_user_async (4242, result_cb, &result);
+	wait_for_result (&result, 1);
+	g_assert (!result.found);
+	g_assert_cmpint (g_atomic_int_get (&lookups), ==, start + 1);
+
+	/* The failure is cached as well, for a shorter time */
+	nm_session_monitor_uid_to_user_async (4242, result_cb, &result);
+	g_assert_cmpint (result.calls, ==, 2);
+	g_assert (!result.found);
+
+	_nm_session_monitor_set_now (2000 + NEGATIVE_TTL - 1);
+	nm_session_monitor_uid_to_user_async (4242, result_cb, &result);
+	g_assert_cmpint (result.calls, ==, 3);
+	g_assert_cmpint (g_atomic_int_get (&lookups), ==, start + 1);
+
+	_nm_session_monitor_set_now (2000 + NEGATIVE_TTL + 1);
+	nm_session_monitor_uid_to_user_async (4242, result_cb, &result);
+	wait_for_result (&result, 4);
+	g_assert (!result.found);
+	g_assert_cmpint (g_atomic_int_get (&lookups), ==, start + 2);
+
+	/* The same for names */
+	nm_session_monitor_user_to_uid_async ("nobody-here", result_cb, &result);
+	wait_for_result (&result, 5);
+	g_assert (!result.found);
+	nm_session_monitor_user_to_uid_async ("nobody-here", result_cb, &result);
+	g_assert_cmpint (result.calls, ==, 6);
+	g_assert_cmpint (g_atomic_int_get (&lookups), ==, start + 3);
+
+	result_clear (&result);
+}
+
+static void
+test_shared_lookup (void)
+{
+	Result a = { 0 }, b = { 0 }, c = { 0 };
+	gint start = g_atomic_int_get (&lookups);
+
+	_nm_session_monitor_set_now (3000);
+
+	nm_session_monitor_user_to_uid_async ("bob", result_cb, &a);
+	nm_session_monitor_user_to_uid_async ("bob", result_cb, &b);
+	nm_session_monitor_user_to_uid_async ("bob", NULL, NULL);
+	nm_session_monitor_user_to_uid_async ("bob", result_cb, &c);
+	g_assert_cmpint (a.calls + b.calls + c.calls, ==, 0);
+
+	wait_for_result (&c, 1);
+	g_assert_cmpint (a.calls, ==, 1);
+	g_assert_cmpint (b.calls, ==, 1);
+	g_assert_cmpint (a.uid, ==, 1001);
+	g_assert_cmpint (b.uid, ==, 1001);
+	g_assert_cmpint (c.uid, ==, 1001);
+	g_assert_cmpint (g_atomic_int_get (&lookups), ==, start + 1);
+
+	result_clear (&a);
+	result_clear (&b);
+	result_clear (&c);
+}
+
+static void
+test_sync_copy (void)
+{
+	Result result = { 0 };
+	gint start = g_atomic_int_get (&lookups);
+	char *user1 = NULL, *user2 = NULL, *user3 = NULL;
+
+	_nm_session_monitor_set_now (4000);
+
+	/* The first lookup of a user is done right away */
+	g_assert (nm_session_monitor_uid_to_user (1002, &user1));
+	g_assert_cmpstr (user1, ==, "carol");
+	g_assert_cmpint (g_atomic_int_get (&lookups), ==, start + 1);
+
+	G_LOCK (renamed);
+	renamed_user = "caroline";
+	G_UNLOCK (renamed);
+
+	/* An expired name is returned while it is refreshed in the background */
+	_nm_session_monitor_set_now (4000 + TTL + 1);
+	g_assert (nm_session_monitor_uid_to_user (1002, &user2));
+	g_assert_cmpstr (user2, ==, "carol");
+
+	/* Wait for the refresh, which replaces the cached name */
+	nm_session_monitor_uid_to_user_async (1002, result_cb, &result);
+	wait_for_result (&result, 1);
+	g_assert_cmpstr (result.user, ==, "caroline");
+	g_assert_cmpint (g_atomic_int_get (&lookups), ==, start + 2);
+
+	/* Names returned earlier are copies and still valid */
+	g_assert_cmpstr (user1, ==, "carol");
+	g_assert_cmpstr (user2, ==, "carol");
+
+	g_assert (nm_session_monitor_uid_to_user (1002, &user3));
+	g_assert_cmpstr (user3, ==, "caroline");
+
+	g_free (user1);
+	g_free (user2);
+	g_free (user3);
+	result_clear (&result);
+}
+
+/*******************************************/
+
+static void
+set_acl (NMSettingsConnection *connection, const char *user)
+{
+	NMSettingConnection *s_con = nm_connection_get_setting_connection (NM_CONNECTION (connection));
+
+	while (nm_setting_connection_get_num_permissions (s_con))
+		nm_setting_connection_remove_permission (s_con, 0);
+	nm_setting_connection_add_permission (s_con, "user", user, NULL);
+}
+
+static void
+test_visibility (void)
+{
+	NMSettingsConnection *connection;
+	NMSettingConnection *s_con;
+	Result result = { 0 };
+	char *uuid;
+
+	_nm_session_monitor_set_now (5000);
+
+	connection = g_object_new (NM_TYPE_SETTINGS_CONNECTION, NULL);
+	s_con = (NMSettingConnection *) nm_setting_connection_new ();
+	uuid = nm_utils_uuid_generate ();
+	g_object_set (s_con,
+	              NM_SETTING_CONNECTION_ID, "test-visibility",
+	              NM_SETTING_CONNECTION_UUID, uuid,
+	              NM_SETTING_CONNECTION_TYPE, NM_SETTING_WIRED_SETTING_NAME,
+	              NULL);
+	g_free (uuid);
+	nm_connection_add_setting (NM_CONNECTION (connection), NM_SETTING (s_con));
+
+	/* Visible to all */
+	nm_settings_connection_recheck_visibility (connection);
+	g_assert (nm_settings_connection_is_visible (connection));
+
+	/* erin has no session; not cached yet, so the result comes later */
+	set_acl (connection, "erin");
+	nm_settings_connection_recheck_visibility (connection);
+	g_assert (nm_settings_connection_is_visible (connection));
+	nm_session_monitor_user_to_uid_async ("erin", result_cb, &result);
+	wait_for_result (&result, 1);
+	g_assert (!nm_settings_connection_is_visible (connection));
+
+	/* frank has a session, but before his name is resolved the ACL changes
+	 * to erin, who is cached.  The older check must not win. */
+	set_acl (connection, "frank");
+	nm_settings_connection_recheck_visibility (connection);
+	set_acl (connection, "erin");
+	nm_settings_connection_recheck_visibility (connection);
+	g_assert (!nm_settings_connection_is_visible (connection));
+	nm_session_monitor_user_to_uid_async ("frank", result_cb, &result);
+	wait_for_result (&result, 2);
+	g_assert (result.found);
+	g_assert (!nm_settings_connection_is_visible (connection));
+
+	/* Now frank is cached and the check completes right away */
+	set_acl (connection, "frank");
+	nm_settings_connection_recheck_visibility (connection);
+	g_assert (nm_settings_connection_is_visible (connection));
+
+	/* One user with a session is enough */
+	nm_setting_connection_add_permission (s_con, "user", "grace", NULL);
+	nm_settings_connection_recheck_visibility (connection);
+	nm_session_monitor_user_to_uid_async ("grace", result_cb, &result);
+	wait_for_result (&result, 3);
+	g_assert (nm_settings_connection_is_visible (connection));
+
+	g_object_unref (connection);
+	result_clear (&result);
+}
+
+/*******************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "ALL");
+
+	_nm_session_monitor_set_lookup_func (lookup_func, session_exists_func);
+	nm_auth_manager_setup (FALSE);
+
+	g_test_add_func ("/session-monitor/ttl", test_ttl);
+	g_test_add_func ("/session-monitor/negative", test_negative);
+	g_test_add_func ("/session-monitor/shared-lookup", test_shared_lookup);
+	g_test_add_func ("/session-monitor/sync-copy", test_sync_copy);
+	g_test_add_func ("/session-monitor/visibility", test_visibility);
+
+	return g_test_run ();
+}
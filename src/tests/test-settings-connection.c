@@ -0,0 +1,327 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2015 Red Hat, Inc.
+ *
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nm-settings-connection.h"
+#include "nm-settings.h"
+#include "nm-session-monitor.h"
+#include "nm-auth-manager.h"
+#include "nm-auth-subject.h"
+#include "nm-setting-connection.h"
+#include "nm-setting-wireless.h"
+#include "nm-utils.h"
+#include "nm-logging.h"
+
+#include "nm-test-utils.h"
+
+static char *timestamps_file;
+static char *seen_bssids_file;
+
+/* alice and bob are logged in */
+static gboolean
+lookup_func (const char *user, uid_t uid, char **out_user, uid_t *out_uid)
+{
+	if (user ? !strcmp (user, "alice") : uid == 1000) {
+		*out_user = g_strdup ("alice");
+		*out_uid = 1000;
+		return TRUE;
+	}
+	if (user ? !strcmp (user, "bob") : uid == 1001) {
+		*out_user = g_strdup ("bob");
+		*out_uid = 1001;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static gboolean
+session_exists_func (uid_t uid, gboolean active)
+{
+	return uid == 1000 || uid == 1001;
+}
+
+/*******************************************/
+
+static NMSettingsConnection *
+create_connection (const char *id, const char *acl_user)
+{
+	NMSettingsConnection *connection;
+	NMSettingConnection *s_con;
+	NMSettingWireless *s_wifi;
+	GBytes *ssid;
+	char *uuid;
+
+	connection = g_object_new (NM_TYPE_SETTINGS_CONNECTION, NULL);
+
+	s_con = (NMSettingConnection *) nm_setting_connection_new ();
+	uuid = nm_utils_uuid_generate ();
+	g_object_set (s_con,
+	              NM_SETTING_CONNECTION_ID, id,
+	              NM_SETTING_CONNECTION_UUID, uuid,
+	              NM_SETTING_CONNECTION_TYPE, NM_SETTING_WIRELESS_SETTING_NAME,
+	              NULL);
+	g_free (uuid);
+	if (acl_user)
+		nm_setting_connection_add_permission (s_con, "user", acl_user, NULL);
+	nm_connection_add_setting (NM_CONNECTION (connection), NM_SETTING (s_con));
+
+	s_wifi = (NMSettingWireless *) nm_setting_wireless_new ();
+	ssid = g_bytes_new ("test", 4);
+	g_object_set (s_wifi, NM_SETTING_WIRELESS_SSID, ssid, NULL);
+	g_bytes_unref (ssid);
+	nm_connection_add_setting (NM_CONNECTION (connection), NM_SETTING (s_wifi));
+
+	return connection;
+}
+
+static const GValue *
+hash_get (GHashTable *hash, const char *setting_name, const char *key)
+{
+	GHashTable *setting_hash;
+
+	setting_hash = g_hash_table_lookup (hash, setting_name);
+	g_assert (setting_hash);
+	return g_hash_table_lookup (setting_hash, key);
+}
+
+static const char *
+hash_get_id (GHashTable *hash)
+{
+	const GValue *value = hash_get (hash, NM_SETTING_CONNECTION_SETTING_NAME, NM_SETTING_CONNECTION_ID);
+
+	g_assert (value && G_VALUE_HOLDS_STRING (value));
+	return g_value_get_string (value);
+}
+
+static guint64
+hash_get_timestamp (GHashTable *hash)
+{
+	const GValue *value = hash_get (hash, NM_SETTING_CONNECTION_SETTING_NAME, NM_SETTING_CONNECTION_TIMESTAMP);
+
+	if (!value)
+		return 0;
+	g_assert (G_VALUE_HOLDS (value, G_TYPE_UINT64));
+	return g_value_get_uint64 (value);
+}
+
+static gboolean
+hash_has_seen_bssid (GHashTable *hash, const char *bssid)
+{
+	const GValue *value = hash_get (hash, NM_SETTING_WIRELESS_SETTING_NAME, NM_SETTING_WIRELESS_SEEN_BSSIDS);
+	const char *const *bssids;
+
+	if (!value)
+		return FALSE;
+	g_assert (G_VALUE_HOLDS (value, G_TYPE_STRV));
+	for (bssids = g_value_get_boxed (value); bssids && *bssids; bssids++) {
+		if (!strcmp (*bssids, bssid))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+write_state_file (const char *path, const char *group, const char *key, const char *value)
+{
+	char *contents;
+
+	contents = g_strdup_printf ("[%s]\n%s=%s\n", group, key, value);
+	g_assert (g_file_set_contents (path, contents, -1, NULL));
+	g_free (contents);
+}
+
+/*******************************************/
+
+static void
+test_settings_hash_cache (void)
+{
+	NMSettingsConnection *connection;
+	NMSettingConnection *s_con;
+	GHashTable *hash;
+	const char *uuid;
+
+	connection = create_connection ("cache", NULL);
+	uuid = nm_connection_get_uuid (NM_CONNECTION (connection));
+
+	hash = nm_settings_connection_get_settings_hash (connection);
+	g_assert_cmpstr (hash_get_id (hash), ==, "cache");
+	g_assert_cmpint (hash_get_timestamp (hash), ==, 0);
+	g_assert (nm_settings_connection_get_settings_hash (connection) == hash);
+
+	/* Changing a setting emits "changed" */
+	s_con = nm_connection_get_setting_connection (NM_CONNECTION (connection));
+	g_object_set (s_con, NM_SETTING_CONNECTION_ID, "cache-changed", NULL);
+	hash = nm_settings_connection_get_settings_hash (connection);
+	g_assert_cmpstr (hash_get_id (hash), ==, "cache-changed");
+	g_assert (nm_settings_connection_get_settings_hash (connection) == hash);
+
+	/* The timestamp is kept outside of the connection */
+	nm_settings_connection_update_timestamp (connection, 1234, FALSE);
+	hash = nm_settings_connection_get_settings_hash (connection);
+	g_assert_cmpint (hash_get_timestamp (hash), ==, 1234);
+
+	nm_settings_connection_update_timestamp (connection, 2345, TRUE);
+	hash = nm_settings_connection_get_settings_hash (connection);
+	g_assert_cmpint (hash_get_timestamp (hash), ==, 2345);
+
+	write_state_file (timestamps_file, "timestamps", uuid, "3456");
+	nm_settings_connection_read_and_fill_timestamp (connection);
+	hash = nm_settings_connection_get_settings_hash (connection);
+	g_assert_cmpint (hash_get_timestamp (hash), ==, 3456);
+
+	/* So are the seen BSSIDs */
+	g_assert (!hash_has_seen_bssid (hash, "00:11:22:33:44:55"));
+	nm_settings_connection_add_seen_bssid (connection, "00:11:22:33:44:55");
+	hash = nm_settings_connection_get_settings_hash (connection);
+	g_assert (hash_has_seen_bssid (hash, "00:11:22:33:44:55"));
+
+	write_state_file (seen_bssids_file, "seen-bssids", uuid, "66:77:88:99:AA:BB,");
+	nm_settings_connection_read_and_fill_seen_bssids (connection);
+	hash = nm_settings_connection_get_settings_hash (connection);
+	g_assert (hash_has_seen_bssid (hash, "66:77:88:99:AA:BB"));
+	g_assert (!hash_has_seen_bssid (hash, "00:11:22:33:44:55"));
+
+	g_object_unref (connection);
+}
+
+static NMAuthSubject *
+create_subject (gulong uid)
+{
+	return g_object_new (NM_TYPE_AUTH_SUBJECT,
+	                     NM_AUTH_SUBJECT_SUBJECT_TYPE, NM_AUTH_SUBJECT_TYPE_UNIX_PROCESS,
+	                     NM_AUTH_SUBJECT_UNIX_PROCESS_DBUS_SENDER, ":1.42",
+	                     NM_AUTH_SUBJECT_UNIX_PROCESS_PID, (gulong) getpid (),
+	                     NM_AUTH_SUBJECT_UNIX_PROCESS_UID, uid,
+	                     NULL);
+}
+
+static void
+assert_all_settings (GHashTable *connections, NMAuthSubject *subject, ...)
+{
+	GHashTable *all_settings;
+	const char *path;
+	guint n = 0;
+	va_list ap;
+
+	all_settings = _nm_settings_get_all_connection_settings (connections, subject);
+
+	va_start (ap, subject);
+	while ((path = va_arg (ap, const char *))) {
+		NMSettingsConnection *connection = g_hash_table_lookup (connections, path);
+
+		/* Same reply as GetSettings() on the connection */
+		g_assert (connection);
+		g_assert (g_hash_table_lookup (all_settings, path) == nm_settings_connection_get_settings_hash (connection));
+		n++;
+	}
+	va_end (ap);
+	g_assert_cmpint (g_hash_table_size (all_settings), ==, n);
+
+	g_hash_table_destroy (all_settings);
+}
+
+static void
+test_get_all_connection_settings (void)
+{
+	GHashTable *connections;
+	NMSettingsConnection *open, *alice, *bob;
+	NMAuthSubject *subject;
+	GHashTable *all_settings;
+	NMSettingConnection *s_con;
+
+	connections = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+	open = create_connection ("open", NULL);
+	alice = create_connection ("alice", "alice");
+	bob = create_connection ("bob", "bob");
+	g_hash_table_insert (connections, "/Settings/0", open);
+	g_hash_table_insert (connections, "/Settings/1", alice);
+	g_hash_table_insert (connections, "/Settings/2", bob);
+
+	subject = create_subject (1000);
+	assert_all_settings (connections, subject, "/Settings/0", "/Settings/1", NULL);
+	g_object_unref (subject);
+
+	subject = create_subject (1001);
+	assert_all_settings (connections, subject, "/Settings/0", "/Settings/2", NULL);
+	g_object_unref (subject);
+
+	/* No session, no connections */
+	subject = create_subject (1002);
+	assert_all_settings (connections, subject, NULL);
+	g_object_unref (subject);
+
+	subject = create_subject (0);
+	assert_all_settings (connections, subject, "/Settings/0", "/Settings/1", "/Settings/2", NULL);
+	g_object_unref (subject);
+
+	subject = nm_auth_subject_new_internal ();
+	assert_all_settings (connections, subject, "/Settings/0", "/Settings/1", "/Settings/2", NULL);
+
+	/* Changes are reflected in the next reply */
+	s_con = nm_connection_get_setting_connection (NM_CONNECTION (open));
+	g_object_set (s_con, NM_SETTING_CONNECTION_ID, "open-changed", NULL);
+	all_settings = _nm_settings_get_all_connection_settings (connections, subject);
+	g_assert_cmpstr (hash_get_id (g_hash_table_lookup (all_settings, "/Settings/0")), ==, "open-changed");
+	g_hash_table_destroy (all_settings);
+	g_object_unref (subject);
+
+	g_hash_table_destroy (connections);
+}
+
+/*******************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	char *dir;
+	int result;
+
+	nmtst_init_with_logging (&argc, &argv, NULL, "ALL");
+
+	dir = g_dir_make_tmp ("test-settings-connection-XXXXXX", NULL);
+	g_assert (dir);
+	timestamps_file = g_build_filename (dir, "timestamps", NULL);
+	seen_bssids_file = g_build_filename (dir, "seen-bssids", NULL);
+	_nm_settings_connection_set_state_files (timestamps_file, seen_bssids_file);
+
+	_nm_session_monitor_set_lookup_func (lookup_func, session_exists_func);
+	nm_auth_manager_setup (FALSE);
+
+	g_test_add_func ("/settings-connection/settings-hash-cache", test_settings_hash_cache);
+	g_test_add_func ("/settings-connection/get-all-connection-settings", test_get_all_connection_settings);
+
+	result = g_test_run ();
+
+	g_unlink (timestamps_file);
+	g_unlink (seen_bssids_file);
+	g_rmdir (dir);
+	g_free (timestamps_file);
+	g_free (seen_bssids_file);
+	g_free (dir);
+	return result;
+}
@@ -0,0 +1,100 @@
+#!/bin/bash
+
+# Compares the memory used by one nm-iface-helper per interface with a
+# single "nm-iface-helper --interfaces" process managing all of them.
+#
+# Usage: iface-helper-memory-benchmark.sh [HELPER] [N_IFACES]
+#
+# Must run as root; creates N dummy interfaces named nmihbenchN and removes
+# them again on exit.  Prints one line per mode in the format of the other
+# benchmarks ("benchmark operation size rounds value unit"), with the
+# number of interfaces as size and the summed PSS as value.  Not run by
+# "make check-perf" because it needs root.
+
+HELPER="${1:-$(dirname "$0")/../src/nm-iface-helper}"
+N="${2:-50}"
+SETTLE="${SETTLE:-3}"
+PREFIX=nmihbench
+LIST="$(mktemp)"
+PIDS=()
+
+if [[ $UID != 0 ]]; then
+    echo "$0 must run as root" >&2
+    exit 1
+fi
+if [[ ! -x "$HELPER" ]]; then
+    echo "nm-iface-helper not found at '$HELPER'" >&2
+    exit 1
+fi
+
+cleanup() {
+    stop_helpers
+    for i in $(seq 1 "$N"); do
+        ip link del "$PREFIX$i" 2>/dev/null
+    done
+    rm -f "$LIST"
+}
+trap cleanup EXIT
+
+stop_helpers() {
+    if [[ ${#PIDS[@]} -gt 0 ]]; then
+        kill "${PIDS[@]}" 2>/dev/null
+        wait "${PIDS[@]}" 2>/dev/null
+    fi
+    PIDS=()
+}
+
+# Proportional set size of a process in kB, so that pages shared between
+# the per-interface helpers are not counted N times.
+pss_kb() {
+    local pid="$1"
+
+    if [[ -r "/proc/$pid/smaps_rollup" ]]; then
+        awk '/^Pss:/ { sum += $2 } END { print sum + 0 }' "/proc/$pid/smaps_rollup"
+    else
+        awk '/^Pss:/ { sum += $2 } END { print sum + 0 }' "/proc/$pid/smaps"
+    fi
+}
+
+report() {
+    local mode="$1"
+    local total=0
+    local pid
+
+    sleep "$SETTLE"
+    for pid in "${PIDS[@]}"; do
+        total=$((total + $(pss_kb "$pid")))
+    done
+    echo "iface-helper-memory $mode $N 1 $total kB"
+}
+
+iface_args() {
+    local i="$1"
+
+    echo "--ifname $PREFIX$i --uuid 00000000-0000-0000-0000-$(printf '%012d' "$i") --slaac"
+}
+
+for i in $(seq 1 "$N"); do
+    ip link add "$PREFIX$i" type dummy || exit 1
+    ip link set "$PREFIX$i" up
+done
+
+echo "# benchmark operation size rounds value unit"
+
+# One helper per interface
+for i in $(seq 1 "$N"); do
+    "$HELPER" --no-daemon --log-level=ERR $(iface_args "$i") &
+    PIDS+=($!)
+done
+report per-device
+stop_helpers
+
+# One helper for all interfaces
+: > "$LIST"
+for i in $(seq 1 "$N"); do
+    printf '[%s%d]\nargs=%s;\n' "$PREFIX" "$i" "$(iface_args "$i" | tr ' ' ';')" >> "$LIST"
+done
+"$HELPER" --no-daemon --log-level=ERR --interfaces "$LIST" &
+PIDS+=($!)
+report shared
+stop_helpers